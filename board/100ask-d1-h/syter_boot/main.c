@@ -7,6 +7,7 @@
 
 #include <config.h>
 #include <log.h>
+#include <profile.h>
 #include <timer.h>
 
 #include <common.h>
@@ -46,6 +47,9 @@
 
 #define CONFIG_DEFAULT_BOOTDELAY 5
 
+/* Sampling profiler histogram, taken from the heap */
+#define CONFIG_PROFILE_BUF_SIZE (64 * 1024)
+
 #define FILENAME_MAX_LEN 64
 typedef struct {
 	uint8_t *dest;
@@ -511,6 +515,11 @@ int cmd_boot(int argc, const char **argv) {
 		abort();
 	}
 
+#ifdef CONFIG_PROFILE
+	profile_stop();
+	profile_dump();
+#endif
+
 	/* Disable MMU, data cache, instruction cache, interrupts */
 	clean_syterkit_data();
 
@@ -549,6 +558,11 @@ int main(void) {
 	/* Initialize the system clock. */
 	sunxi_clk_init();
 
+#ifdef CONFIG_PROFILE
+	/* Sample DRAM init too, the histogram moves to DRAM once it is up */
+	profile_start(0);
+#endif
+
 	/* Initialize the DRAM and enable memory management unit (MMU). */
 	uint32_t dram_size = sunxi_dram_init(&dram_para);
 
@@ -558,6 +572,10 @@ int main(void) {
 	/* Initialize the small memory allocator. */
 	smalloc_init(CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
 
+#ifdef CONFIG_PROFILE
+	profile_set_buffer(smalloc(CONFIG_PROFILE_BUF_SIZE), CONFIG_PROFILE_BUF_SIZE);
+#endif
+
 	/* Dump information about the system clocks. */
 	sunxi_clk_dump();
 
@@ -623,6 +641,10 @@ int main(void) {
 	cmd_boot(0, NULL);
 
 _shell:
+#ifdef CONFIG_PROFILE
+	/* Keep the shell idle loop out of the boot profile, "profile dump" shows it */
+	profile_stop();
+#endif
 	syterkit_shell_attach(commands);
 
 	/* Return 0 to indicate successful execution. */
@@ -226,6 +226,7 @@ dram_para_t dram_para = {
 };
 
 void clean_syterkit_data(void) {
+	log_flush();
 	/* Disable MMU, data cache, instruction cache, interrupts */
 	arm32_mmu_disable();
 	printk_info("disable mmu ok...\n");
@@ -235,4 +236,5 @@ void clean_syterkit_data(void) {
 	printk_info("disable icache ok...\n");
 	arm32_interrupt_disable();
 	printk_info("free interrupt ok...\n");
+	log_flush();
 }
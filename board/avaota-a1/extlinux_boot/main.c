@@ -7,10 +7,14 @@
 
 #include <config.h>
 #include <log.h>
+#include <bootstage.h>
+#include <log_persist.h>
 #include <timer.h>
 
+#include <arena.h>
 #include <common.h>
 #include <jmp.h>
+#include <meminfo.h>
 #include <mmu.h>
 #include <smalloc.h>
 #include <sstdlib.h>
@@ -58,6 +62,14 @@
 #define CONFIG_HEAP_BASE (0x50800000)
 #define CONFIG_HEAP_SIZE (16 * 1024 * 1024)
 
+/* Boot-phase temporaries, released in one go once the kernel is prepared */
+#define CONFIG_ARENA_BASE (0x51800000)
+#define CONFIG_ARENA_SIZE (1 * 1024 * 1024)
+
+/* Boot log kept across warm resets, handed to Linux as a ramoops console zone */
+#define CONFIG_LOG_PERSIST_BASE (0x51f00000)
+#define CONFIG_LOG_PERSIST_SIZE (1 * 1024 * 1024)
+
 extern sunxi_serial_t uart_dbg;
 
 extern sunxi_i2c_t i2c_pmu;
@@ -140,6 +152,8 @@ typedef struct image_header {
 
 image_info_t image;
 
+static arena_t boot_arena;
+
 #define CHUNK_SIZE 0x160000
 
 static int fatfs_loadimage_size(char *filename, BYTE *dest, uint32_t *file_size) {
@@ -150,6 +164,7 @@ static int fatfs_loadimage_size(char *filename, BYTE *dest, uint32_t *file_size)
 	FRESULT fret;
 	int ret = 1;
 	uint32_t start, time;
+	BYTE *base = dest;
 
 	fret = f_open(&file, filename, FA_OPEN_EXISTING | FA_READ);
 	if (fret != FR_OK) {
@@ -175,7 +190,10 @@ static int fatfs_loadimage_size(char *filename, BYTE *dest, uint32_t *file_size)
 		goto read_fail;
 	}
 	ret = 0;
-	*file_size = total_read;
+	if (file_size)
+		*file_size = total_read;
+	meminfo_claim(filename, (unsigned long) base, total_read);
+	bootstage_mark(BOOTSTAGE_LOAD, filename);
 
 read_fail:
 	fret = f_close(&file);
@@ -284,7 +302,7 @@ static char *copy_until_newline_or_end(char *source) {
 	} else {
 		len = strlen(source);
 	}
-	char *dest = smalloc(len + 1);
+	char *dest = arena_alloc(&boot_arena, len + 1, 1);
 	if (!dest)
 		return NULL;
 
@@ -412,6 +430,7 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 	FATFS fs;
 	FRESULT fret;
 	ext_linux_data_t data = {0};
+	arena_mark_t mark = arena_mark(&boot_arena);
 	int ret, err = -1;
 	uint32_t start;
 
@@ -498,7 +517,7 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 		goto _error;
 	}
 
-	uint8_t *tmp_buf = (uint8_t *) smalloc(16 * sizeof(uint8_t));
+	uint8_t *tmp_buf = (uint8_t *) arena_alloc(&boot_arena, 16 * sizeof(uint8_t), sizeof(uint64_t));
 
 	/* fix up memory region */
 	int len = fdt_pack_reg(image->of_dest, tmp_buf, SDRAM_BASE, ((uint64_t) dram_size * 1024 * 1024));
@@ -558,7 +577,7 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 	}
 	len = 0;
 	/* Get bootargs string */
-	char *bootargs = (char *) smalloc(4096);
+	char *bootargs = (char *) arena_alloc(&boot_arena, 4096, 1);
 	memset(bootargs, 0, 4096);
 	char *bootargs_str = (void *) fdt_getprop(image->of_dest, chosen_node, "bootargs", &len);
 	if (bootargs_str == NULL) {
@@ -617,6 +636,11 @@ _add_dts_size:
 		goto _error;
 	}
 
+#ifdef CONFIG_LOG_PERSIST
+	/* Let Linux show the boot log in /sys/fs/pstore */
+	log_persist_fdt_fixup(image->of_dest);
+#endif
+
 	/* Check and load dtbo */
 	if (data.dtbo != NULL) {
 		printk_info("FATFS: read %s addr=%x\n", data.dtbo, (uint32_t) image->of_overlay_dest);
@@ -641,6 +665,8 @@ _add_dts_size:
 
 	err = 0;
 _error:
+	/* Everything parsed or built here has been copied into the FDT by now */
+	arena_reset(&boot_arena, mark);
 	return err;
 }
 
@@ -675,6 +701,8 @@ static int abortboot_single_key(int bootdelay) {
 }
 
 int main(void) {
+	bootstage_mark(BOOTSTAGE_START, NULL);
+
 	sunxi_serial_init(&uart_dbg);
 
 	arm32_dcache_enable();
@@ -686,6 +714,8 @@ int main(void) {
 
 	sunxi_clk_init();
 
+	bootstage_mark(BOOTSTAGE_CLOCK, NULL);
+
 	set_rpio_power_mode();
 
 	sunxi_clk_dump();
@@ -713,6 +743,8 @@ int main(void) {
 	pmu_axp2202_dump(&i2c_pmu);
 	pmu_axp1530_dump(&i2c_pmu);
 
+	bootstage_mark(BOOTSTAGE_PMU, NULL);
+
 	sunxi_clk_set_cpu_pll(1416);
 
 	enable_sram_a3();
@@ -720,6 +752,8 @@ int main(void) {
 	/* Initialize the DRAM and enable memory management unit (MMU). */
 	uint32_t dram_size = sunxi_dram_init((void *) dram_para);
 
+	bootstage_mark(BOOTSTAGE_DRAM, NULL);
+
 	printk_debug("DRAM Size = %dM\n", dram_size);
 
 	sunxi_clk_dump();
@@ -728,6 +762,17 @@ int main(void) {
 
 	/* Initialize the small memory allocator. */
 	smalloc_init(CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
+	meminfo_claim("heap", CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
+
+	/* Initialize the arena for boot-phase temporaries. */
+	arena_init(&boot_arena, (void *) CONFIG_ARENA_BASE, CONFIG_ARENA_SIZE);
+	meminfo_claim("arena", CONFIG_ARENA_BASE, CONFIG_ARENA_SIZE);
+
+#ifdef CONFIG_LOG_PERSIST
+	/* Move the log captured so far to DRAM, it survives warm resets from here on */
+	log_persist_init(CONFIG_LOG_PERSIST_BASE, CONFIG_LOG_PERSIST_SIZE);
+	meminfo_claim("log", CONFIG_LOG_PERSIST_BASE, CONFIG_LOG_PERSIST_SIZE);
+#endif
 
 	LCD_Init();
 
@@ -777,6 +822,8 @@ int main(void) {
 		}
 	}
 
+	bootstage_mark(BOOTSTAGE_STORAGE, card0.hci->name);
+
 	/* Load the DTB, kernel image, and configuration data from the SD card. */
 	if (load_sdcard(&image) != 0) {
 		printk_warning("SMHC: loading failed, try to boot from SDC2\n");
@@ -807,6 +854,8 @@ int main(void) {
 		goto _fail;
 	}
 
+	bootstage_mark(BOOTSTAGE_FDT, NULL);
+
 	printk_info("EXTLINUX: load extlinux done, now booting...\n");
 
 	atf_head_t *atf_head = (atf_head_t *) image.bl31_dest;
@@ -825,6 +874,10 @@ int main(void) {
 	LCD_ShowString(0, 12, "Kernel Addr: 0x40800000", SPI_LCD_COLOR_GREEN, SPI_LCD_COLOR_BLACK, 12);
 	LCD_ShowString(0, 24, "DTB Addr: 0x40400000", SPI_LCD_COLOR_GREEN, SPI_LCD_COLOR_BLACK, 12);
 
+	/* Last mark, the kernel finds the timeline in /proc/device-tree/bootstage */
+	bootstage_mark(BOOTSTAGE_HANDOFF, "bl31");
+	bootstage_fdt_fixup(image.of_dest);
+
 	clean_syterkit_data();
 
 	gicr_set_waker();
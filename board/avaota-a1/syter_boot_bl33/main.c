@@ -30,6 +30,7 @@
 
 #include <pmu/axp.h>
 
+#include <bootpack.h>
 #include <fdt_wrapper.h>
 #include <ff.h>
 #include <sys-sdhci.h>
@@ -47,6 +48,10 @@
 #define CONFIG_BL33_FILENAME "syter_bl33.bin"
 #define CONFIG_BL33_LOAD_ADDR (0x4a000000)
 
+/* Boot container holding all of the above, see scripts/genimage/genimage_bootpack.cfg */
+#define CONFIG_BOOTPACK_FILENAME "boot.pack"
+#define CONFIG_BOOTPACK_RAW_SECTOR (2048)
+
 #define CONFIG_SDMMC_SPEED_TEST_SIZE 1024// (unit: 512B sectors)
 
 #define CONFIG_DEFAULT_BOOTDELAY 0
@@ -99,6 +104,8 @@ typedef struct {
 
 image_info_t image;
 
+static bootpack_t bootpack;
+
 #define CHUNK_SIZE 0x20000
 
 static int fatfs_loadimage(char *filename, BYTE *dest) {
@@ -144,6 +151,82 @@ open_fail:
 	return ret;
 }
 
+/* Point the image at the payloads of the loaded boot container */
+static int bootpack_apply(image_info_t *image) {
+	const struct {
+		const char *name;
+		uint8_t **dest;
+	} map[] = {
+			{"bl31", &image->bl31_dest},
+			{"dtb", &image->of_dest},
+			{"kernel", &image->kernel_dest},
+			{"bl33", &image->bl33_dest},
+	};
+	const bootpack_entry_t *entry;
+
+	for (int i = 0; i < sizeof(map) / sizeof(map[0]); i++) {
+		entry = bootpack_find(&bootpack, map[i].name);
+		if (entry == NULL) {
+			printk_error("BOOTPACK: missing payload %s\n", map[i].name);
+			return -1;
+		}
+		*map[i].dest = (uint8_t *) entry->load_addr;
+	}
+
+	return 0;
+}
+
+static int sdmmc_bootpack_read(bootpack_reader_t *reader, uint32_t offset, void *buf, uint32_t len) {
+	static uint8_t bounce[512];
+	uint32_t blkno = CONFIG_BOOTPACK_RAW_SECTOR + offset / 512;
+	uint32_t blkcnt = len / 512;
+
+	if (offset % 512) {
+		printk_error("BOOTPACK: unaligned offset 0x%x\n", offset);
+		return -1;
+	}
+
+	/* Whole blocks straight to the destination, the tail through a bounce buffer */
+	if (blkcnt && sdmmc_blk_read(&card0, buf, blkno, blkcnt) != blkcnt)
+		return -1;
+
+	if (len % 512) {
+		if (sdmmc_blk_read(&card0, bounce, blkno + blkcnt, 1) != 1)
+			return -1;
+		memcpy((uint8_t *) buf + blkcnt * 512, bounce, len % 512);
+	}
+
+	return 0;
+}
+
+static int load_bootpack_raw(image_info_t *image) {
+	bootpack_reader_t reader = {
+			.name = "sdmmc",
+			.read = sdmmc_bootpack_read,
+	};
+
+	if (bootpack_load(&reader, &bootpack))
+		return -1;
+
+	return bootpack_apply(image);
+}
+
+static int load_bootpack_fat(image_info_t *image) {
+	bootpack_reader_t reader;
+	FIL file;
+	int ret;
+
+	if (bootpack_fat_open(&reader, &file, CONFIG_BOOTPACK_FILENAME))
+		return -1;
+
+	ret = bootpack_load(&reader, &bootpack);
+	bootpack_fat_close(&reader);
+	if (ret)
+		return ret;
+
+	return bootpack_apply(image);
+}
+
 static int load_sdcard(image_info_t *image) {
 	FATFS fs;
 	FRESULT fret;
@@ -160,12 +243,16 @@ static int load_sdcard(image_info_t *image) {
 
 	fret = f_mount(&fs, "", 1);
 	if (fret != FR_OK) {
-		printk_error("FATFS: mount error: %d\n", fret);
-		return -1;
+		printk_warning("FATFS: mount error: %d, trying raw boot pack\n", fret);
+		return load_bootpack_raw(image);
 	} else {
 		printk_debug("FATFS: mount OK\n");
 	}
 
+	/* One container replaces the separate file loads below */
+	if (load_bootpack_fat(image) == 0)
+		goto umount;
+
 	printk_info("FATFS: read %s addr=%x\n", image->bl31_filename, (uint32_t) image->bl31_dest);
 	ret = fatfs_loadimage(image->bl31_filename, image->bl31_dest);
 	if (ret)
@@ -186,6 +273,7 @@ static int load_sdcard(image_info_t *image) {
 	if (ret)
 		return ret;
 
+umount:
 	/* umount fs */
 	fret = f_mount(0, "", 0);
 	if (fret != FR_OK) {
@@ -253,8 +341,8 @@ msh_define_help(boot, "boot to linux", "Usage: boot\n");
 int cmd_boot(int argc, const char **argv) {
 	atf_head_t *atf_head = (atf_head_t *) image.bl31_dest;
 
-	atf_head->next_boot_base = CONFIG_BL33_LOAD_ADDR;
-	atf_head->dtb_base = CONFIG_DTB_LOAD_ADDR;
+	atf_head->next_boot_base = (uint32_t) image.bl33_dest;
+	atf_head->dtb_base = (uint32_t) image.of_dest;
 
 	atf_head->platform[0] = 0x00;
 	atf_head->platform[1] = 0x52;
@@ -272,7 +360,7 @@ int cmd_boot(int argc, const char **argv) {
 
 	gicr_set_waker();
 
-	jmp_to_arm64(CONFIG_BL31_LOAD_ADDR);
+	jmp_to_arm64((uint32_t) image.bl31_dest);
 
 	printk_info("Back to SyterKit\n");
 
@@ -19,7 +19,11 @@
 #include <sys-spi-nor.h>
 #include <sys-spi.h>
 
+#include <bootpack.h>
 #include <common.h>
+#include <smalloc.h>
+#include <sstdlib.h>
+#include <storage_bench.h>
 
 #include <cli.h>
 #include <cli_shell.h>
@@ -35,6 +39,12 @@ extern sunxi_sdhci_t sdhci0;
 #define CONFIG_SDMMC_SPEED_TEST_SIZE 4 * 1024// (unit: 512B sectors)
 #define CHUNK_SIZE 0x20000
 
+#define CONFIG_HEAP_BASE (0x80800000)
+#define CONFIG_HEAP_SIZE (16 * 1024 * 1024)
+
+#define CONFIG_BENCH_BUF_BASE (0x81800000)
+#define CONFIG_BENCH_BUF_SIZE (16 * 1024 * 1024)
+
 msh_declare_command(read);
 msh_define_help(read, "read SMHC", "Usage: read\n");
 int cmd_read(int argc, const char **argv) {
@@ -86,6 +96,9 @@ int cmd_load(int argc, const char **argv) {
 		printk_warning("SMHC: init failed\n");
 	} else {
 		printk_debug("Card OK!\n");
+#ifdef CONFIG_STORAGE_BENCH
+		storage_bench_add_sdmmc(&card0, 0);
+#endif
 	}
 	return 0;
 }
@@ -106,12 +119,92 @@ int cmd_bt(int argc, const char **argv) {
 	return 0;
 }
 
+msh_declare_command(nor_erase);
+msh_define_help(nor_erase, "erase SPI NOR region", "Usage: nor_erase [flash addr] [length]\n");
+int cmd_nor_erase(int argc, const char **argv) {
+	uint32_t start;
+
+	if (argc != 3) {
+		uart_puts(cmd_nor_erase_usage);
+		return -1;
+	}
+
+	uint32_t addr = simple_strtoul(argv[1], NULL, 16);
+	uint32_t len = simple_strtoul(argv[2], NULL, 16);
+
+	start = time_ms();
+	if (spi_nor_erase(&sunxi_spi0, addr, len) != 0) {
+		printk_error("SPI NOR: erase 0x%08x+0x%x failed\n", addr, len);
+		return -1;
+	}
+	printk_info("SPI NOR: erased %uKB in %ums\n", len / 1024, time_ms() - start);
+	return 0;
+}
+
+msh_declare_command(nor_write);
+msh_define_help(nor_write, "write memory to SPI NOR, skipping unchanged sectors", "Usage: nor_write [flash addr] [memory addr] [length]\n");
+int cmd_nor_write(int argc, const char **argv) {
+	uint32_t start, elapsed, done;
+
+	if (argc != 4) {
+		uart_puts(cmd_nor_write_usage);
+		return -1;
+	}
+
+	uint32_t addr = simple_strtoul(argv[1], NULL, 16);
+	uint32_t mem = simple_strtoul(argv[2], NULL, 16);
+	uint32_t len = simple_strtoul(argv[3], NULL, 16);
+
+	start = time_ms();
+	done = spi_nor_write(&sunxi_spi0, (uint8_t *) mem, addr, len);
+	elapsed = time_ms() - start;
+	if (done != len) {
+		printk_error("SPI NOR: write stopped at 0x%08x\n", addr + done);
+		return -1;
+	}
+	printk_info("SPI NOR: wrote %uKB in %ums at %uKB/S\n", len / 1024, elapsed, elapsed ? (len / 1024) * 1000 / elapsed : 0);
+	return 0;
+}
+
+static int spi_nor_bootpack_read(bootpack_reader_t *reader, uint32_t offset, void *buf, uint32_t len) {
+	uint32_t base = (uint32_t) reader->priv;
+
+	return spi_nor_read(&sunxi_spi0, buf, base + offset, len) == len ? 0 : -1;
+}
+
+msh_declare_command(nor_bootpack);
+msh_define_help(nor_bootpack, "load boot container from SPI NOR", "Usage: nor_bootpack [flash addr]\n");
+int cmd_nor_bootpack(int argc, const char **argv) {
+	static bootpack_t pack;
+	bootpack_reader_t reader = {
+			.name = "spi-nor",
+			.read = spi_nor_bootpack_read,
+	};
+
+	if (argc != 2) {
+		uart_puts(cmd_nor_bootpack_usage);
+		return -1;
+	}
+
+	reader.priv = (void *) simple_strtoul(argv[1], NULL, 16);
+
+	if (bootpack_load(&reader, &pack) != 0)
+		return -1;
+
+	for (uint32_t i = 0; i < pack.head.entry_count; i++)
+		printk_info("BOOTPACK: %-16s 0x%08x %u bytes\n", pack.entry[i].name, pack.entry[i].load_addr, pack.entry[i].raw_size);
+	return 0;
+}
+
 const msh_command_entry commands[] = {
 		msh_define_command(load),
 		msh_define_command(read),
 		msh_define_command(write),
 		msh_define_command(bt),
 		msh_define_command(reset),
+		msh_define_command(nor_erase),
+		msh_define_command(nor_write),
+		msh_define_command(nor_bootpack),
 		msh_command_end,
 };
 
@@ -132,10 +225,17 @@ int main(void) {
 
 	uint32_t dram_size = sunxi_dram_init(&dram_para);
 
+	smalloc_init(CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
+
 	sunxi_spi_init(&sunxi_spi0);
 
 	spi_nor_detect(&sunxi_spi0);
 
+#ifdef CONFIG_STORAGE_BENCH
+	storage_bench_set_buffer((void *) CONFIG_BENCH_BUF_BASE, CONFIG_BENCH_BUF_SIZE);
+	storage_bench_add_spi_nor(&sunxi_spi0, 0);
+#endif
+
 	memset((void *) 0x81000000, 0x0, 0x1000);
 
 	uint32_t time = time_ms();
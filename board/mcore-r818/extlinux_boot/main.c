@@ -9,6 +9,7 @@
 #include <log.h>
 #include <timer.h>
 
+#include <arena.h>
 #include <common.h>
 #include <jmp.h>
 #include <mmu.h>
@@ -49,6 +50,10 @@
 #define CONFIG_HEAP_BASE (0x50800000)
 #define CONFIG_HEAP_SIZE (16 * 1024 * 1024)
 
+/* Boot-phase temporaries, released in one go once the kernel is prepared */
+#define CONFIG_ARENA_BASE (0x51800000)
+#define CONFIG_ARENA_SIZE (1 * 1024 * 1024)
+
 extern sunxi_serial_t uart_dbg;
 
 extern sunxi_i2c_t i2c_pmu;
@@ -116,6 +121,8 @@ typedef struct image_header {
 
 image_info_t image;
 
+static arena_t boot_arena;
+
 #define CHUNK_SIZE 0x20000
 
 static int fatfs_loadimage_size(char *filename, BYTE *dest, uint32_t *file_size) {
@@ -256,7 +263,7 @@ static char *copy_until_newline_or_end(char *source) {
 	} else {
 		len = strlen(source);
 	}
-	char *dest = smalloc(len + 1);
+	char *dest = arena_alloc(&boot_arena, len + 1, 1);
 	if (!dest)
 		return NULL;
 
@@ -346,6 +353,7 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 	FATFS fs;
 	FRESULT fret;
 	ext_linux_data_t data = {0};
+	arena_mark_t mark = arena_mark(&boot_arena);
 	int ret, err = -1;
 	uint32_t start;
 
@@ -429,7 +437,7 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 		goto _error;
 	}
 
-	uint8_t *tmp_buf = (uint8_t *) smalloc(16 * sizeof(uint8_t));
+	uint8_t *tmp_buf = (uint8_t *) arena_alloc(&boot_arena, 16 * sizeof(uint8_t), sizeof(uint64_t));
 
 	/* fix up memory region */
 	int len = fdt_pack_reg(image->of_dest, tmp_buf, SDRAM_BASE, (dram_size * 1024 * 1024));
@@ -438,9 +446,6 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 		printk_error("Can't change memory base node: %s\n", fdt_strerror(ret));
 		goto _error;
 	}
-	/* clean tmp_buf */
-	sfree(tmp_buf);
-	tmp_buf = NULL;
 
 	/* Get the offset of "/chosen" node */
 	int chosen_node = fdt_find_or_add_subnode(image->of_dest, 0, "chosen");
@@ -494,7 +499,7 @@ static int load_extlinux(image_info_t *image, uint32_t dram_size) {
 _set_bootargs:
 	len = 0;
 	/* Get bootargs string */
-	char *bootargs = (char *) smalloc(4096);
+	char *bootargs = (char *) arena_alloc(&boot_arena, 4096, 1);
 	memset(bootargs, 0, 4096);
 	char *bootargs_str = (void *) fdt_getprop(image->of_dest, chosen_node, "bootargs", &len);
 	if (bootargs_str == NULL) {
@@ -531,11 +536,11 @@ _add_dts_size:
 			goto _add_dts_size;
 		} else {
 			printk_error("DTB: Can't increase blob size: %s\n", fdt_strerror(ret));
-			goto _bootargs_error;
+			goto _error;
 		}
 	} else if (ret < 0) {
 		printk_error("Can't change bootargs node: %s\n", fdt_strerror(ret));
-		goto _bootargs_error;
+		goto _error;
 	}
 
 	/* Get the total size of DTB */
@@ -543,20 +548,13 @@ _add_dts_size:
 
 	if (ret < 0) {
 		printk_error("libfdt fdt_setprop() error: %s\n", fdt_strerror(ret));
-		goto _bootargs_error;
+		goto _error;
 	}
 
 	err = 0;
-_bootargs_error:
-	if (bootargs_str != NULL)
-		sfree(bootargs_str);
-
 _error:
-	sfree(data.os);
-	sfree(data.kernel);
-	sfree(data.initrd);
-	sfree(data.fdt);
-	sfree(data.append);
+	/* Everything parsed or built here has been copied into the FDT by now */
+	arena_reset(&boot_arena, mark);
 	return err;
 }
 
@@ -618,6 +616,9 @@ int main(void) {
 	/* Initialize the small memory allocator. */
 	smalloc_init(CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
 
+	/* Initialize the arena for boot-phase temporaries. */
+	arena_init(&boot_arena, (void *) CONFIG_ARENA_BASE, CONFIG_ARENA_SIZE);
+
 	/* Clear the image_info_t struct. */
 	memset(&image, 0, sizeof(image_info_t));
 
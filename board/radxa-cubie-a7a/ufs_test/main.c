@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <timer.h>
+
+#include <common.h>
+#include <smalloc.h>
+#include <sstdlib.h>
+#include <string.h>
+
+#include <reg-ncat.h>
+#include <sys-clk.h>
+
+#include <pmu/axp.h>
+#include <sys-dram.h>
+#include <sys-i2c.h>
+
+#include <ufs/ufs.h>
+
+#include <cli.h>
+#include <cli_shell.h>
+#include <cli_termesc.h>
+
+#define CONFIG_HEAP_BASE (SDRAM_BASE + 0x00800000)
+#define CONFIG_HEAP_SIZE (16 * 1024 * 1024)
+
+/* Reads land here, large enough for the queued throughput test */
+#define UFS_BUF_ADDR (SDRAM_BASE + 0x02000000)
+#define UFS_BENCH_BYTES (16 * 1024 * 1024)
+
+extern sunxi_serial_t uart_dbg;
+
+extern sunxi_i2c_t i2c_pmu;
+
+extern uint32_t dram_para[128];
+
+extern void board_common_init(void);
+
+static blk_desc_t ufs_blk;
+
+static ufs_device_t ufs_dev = {
+		.sc_plat =
+				{
+						.base = SUNXI_UFS_BASE,
+				},
+		.bd = &ufs_blk,
+};
+
+static void ufs_clk_init(void) {
+	uint32_t reg;
+
+	/* AXI from PERI0 300MHz, config clock from the 24MHz oscillator */
+	writel((UFS_AXI_CLK_REG_UFS_AXI_CLK_GATING_CLOCK_IS_ON << UFS_AXI_CLK_REG_UFS_AXI_CLK_GATING_OFFSET) |
+				   (UFS_AXI_CLK_REG_CLK_SRC_SEL_PERI0_300M << UFS_AXI_CLK_REG_CLK_SRC_SEL_OFFSET),
+		   SUNXI_CCU_BASE + UFS_AXI_CLK_REG);
+	writel((UFS_CFG_CLK_REG_UFS_CFG_CLK_GATING_CLOCK_IS_ON << UFS_CFG_CLK_REG_UFS_CFG_CLK_GATING_OFFSET) |
+				   (UFS_CFG_CLK_REG_CLK_SRC_SEL_HOSC << UFS_CFG_CLK_REG_CLK_SRC_SEL_OFFSET),
+		   SUNXI_CCU_BASE + UFS_CFG_CLK_REG);
+
+	/* Hold everything in reset while the gate opens, then release */
+	writel(0, SUNXI_CCU_BASE + UFS_BGR_REG);
+	udelay(10);
+	reg = (UFS_BGR_REG_UFS_GATING_PASS << UFS_BGR_REG_UFS_GATING_OFFSET);
+	writel(reg, SUNXI_CCU_BASE + UFS_BGR_REG);
+	reg |= (UFS_BGR_REG_UFS_RST_DE_ASSERT << UFS_BGR_REG_UFS_RST_OFFSET) | (UFS_BGR_REG_UFS_AXI_RST_DE_ASSERT << UFS_BGR_REG_UFS_AXI_RST_OFFSET) |
+		   (UFS_BGR_REG_UFS_PHY_RST_DE_ASSERT << UFS_BGR_REG_UFS_PHY_RST_OFFSET) | (UFS_BGR_REG_UFS_CORE_RST_DE_ASSERT << UFS_BGR_REG_UFS_CORE_RST_OFFSET);
+	writel(reg, SUNXI_CCU_BASE + UFS_BGR_REG);
+	udelay(10);
+}
+
+msh_declare_command(ufs_read);
+msh_define_help(ufs_read, "read blocks from UFS LUN 0", "Usage: ufs_read <lba> <count>\n");
+int cmd_ufs_read(int argc, const char **argv) {
+	uint64_t lba, count, done;
+
+	if (argc < 3) {
+		uart_puts(cmd_ufs_read_usage);
+		return 0;
+	}
+
+	lba = simple_strtoull(argv[1], NULL, 0);
+	count = simple_strtoull(argv[2], NULL, 0);
+	if (count * ufs_blk.blksz > UFS_BENCH_BYTES) {
+		printk_error("UFS: at most %u bytes\n", UFS_BENCH_BYTES);
+		return -1;
+	}
+
+	done = scsi_read(&ufs_dev, lba, count, (void *) UFS_BUF_ADDR);
+	printk_info("UFS: read %llu of %llu blocks\n", done, count);
+	dump_hex(UFS_BUF_ADDR, done * ufs_blk.blksz > 0x200 ? 0x200 : done * ufs_blk.blksz);
+
+	return 0;
+}
+
+const msh_command_entry commands[] = {
+		msh_define_command(ufs_read),
+		msh_command_end,
+};
+
+int main(void) {
+	uint64_t blocks, done;
+	uint32_t start, ms;
+
+	sunxi_serial_init(&uart_dbg);
+
+	show_banner();
+
+	board_common_init();
+
+	sunxi_i2c_init(&i2c_pmu);
+
+	sunxi_clk_init();
+
+	pmu_axp8191_init(&i2c_pmu);
+
+	sunxi_dram_init(dram_para);
+
+	smalloc_init(CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
+
+	ufs_clk_init();
+
+	if (ufs_init(&ufs_dev) || scsi_scan_dev(&ufs_dev))
+		goto _shell;
+
+	printk_info("UFS: LUN 0, %llu blocks of %llu bytes\n", ufs_blk.lba, ufs_blk.blksz);
+
+	/* Long enough to keep every transfer request slot busy */
+	blocks = UFS_BENCH_BYTES / ufs_blk.blksz;
+	if (blocks > ufs_blk.lba)
+		blocks = ufs_blk.lba;
+	start = time_ms();
+	done = scsi_read(&ufs_dev, 0, blocks, (void *) UFS_BUF_ADDR);
+	ms = time_ms() - start;
+	printk_info("UFS: read %lluKB in %ums, %uKB/s\n", done * ufs_blk.blksz / 1024, ms, ms ? (uint32_t) (done * ufs_blk.blksz / ms * 1000 / 1024) : 0);
+
+_shell:
+	syterkit_shell_attach(commands);
+
+	return 0;
+}
@@ -154,6 +154,7 @@ dram_para_t dram_para = {
 };
 
 void clean_syterkit_data(void) {
+	log_flush();
 	/* Disable MMU, data cache, instruction cache, interrupts */
 	arm32_mmu_disable();
 	printk_info("disable mmu ok...\n");
@@ -163,6 +164,7 @@ void clean_syterkit_data(void) {
 	printk_info("disable icache ok...\n");
 	arm32_interrupt_disable();
 	printk_info("free interrupt ok...\n");
+	log_flush();
 }
 
 void rtc_set_vccio_det_spare(void) {
@@ -0,0 +1,543 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <config.h>
+#include <log.h>
+#include <timer.h>
+
+#include <cache.h>
+#include <common.h>
+#include <cpufeature.h>
+#include <jmp.h>
+#include <mmu.h>
+#include <string.h>
+
+#include "sys-dma.h"
+#include "sys-dram.h"
+
+/*
+ * DRAM bandwidth and latency, for judging dram_para changes on speed as well
+ * as stability. For the board's dram_para and then for every clock in
+ * dram_clk_sweep[], DRAM is initialized again and three tests run:
+ *
+ * - STREAM copy/scale/add/triad, in C and with NEON, reporting the best and
+ *   average rate over STREAM_NTIMES runs and the words that came out wrong;
+ * - a dependent-load pointer chase over a random cycle of cache lines, for
+ *   working sets from 4KB up, giving the load latency of L1, L2 and DRAM;
+ * - a DMA copy alone, then with the CPU copying at the same time, for the
+ *   bandwidth each master gets when both share the DRAM controller.
+ *
+ * Every result is one CSV line starting with the test name and dram_clk, so
+ * runs of different parameters can be diffed. Rates count the bytes read plus
+ * the bytes written, as STREAM does, so a copy moves twice its size:
+ *
+ *   stream,dram_clk,impl,kernel,bytes,best_mb_s,avg_mb_s,errors
+ *   chase,dram_clk,set_bytes,loads,ns_per_load
+ *   dma,dram_clk,mode,dma_bytes,dma_mb_s,cpu_bytes,cpu_mb_s,errors
+ */
+
+extern sunxi_serial_t uart_dbg;
+
+extern sunxi_dma_t sunxi_dma;
+
+extern dram_para_t dram_para;
+
+/* Clocks in MHz to run at after the board's own, lower only so the sweep stays in the rated range */
+static const uint32_t dram_clk_sweep[] = {480, 432, 360};
+
+#define BENCH_BASE (SDRAM_BASE)
+
+/* 32-bit elements, so results check exactly and softfp builds run the same kernels */
+#define STREAM_ELEMS (1024 * 1024)
+#define STREAM_BYTES (STREAM_ELEMS * sizeof(uint32_t))
+#define STREAM_NTIMES 10
+#define STREAM_SCALAR 3
+#define STREAM_A (BENCH_BASE)
+#define STREAM_B (STREAM_A + STREAM_BYTES)
+#define STREAM_C (STREAM_B + STREAM_BYTES)
+
+#define DMA_BYTES (8 * 1024 * 1024)
+#define DMA_SRC (STREAM_C + STREAM_BYTES)
+#define DMA_DST (DMA_SRC + DMA_BYTES)
+/* The CPU copies in chunks of this size while it polls the DMA */
+#define DMA_CPU_CHUNK (64 * 1024)
+
+#define CHASE_MIN_SET (4 * 1024)
+#define CHASE_MAX_SET (32 * 1024 * 1024)
+#define CHASE_STRIDE 64 /* a cache line */
+#define CHASE_LOADS (1024 * 1024)
+#define CHASE_BUF (BENCH_BASE)
+/* Line order of the cycle being built, right after the largest set */
+#define CHASE_ORDER (CHASE_BUF + CHASE_MAX_SET)
+
+#define BENCH_SIZE (CHASE_MAX_SET + CHASE_MAX_SET / CHASE_STRIDE * sizeof(uint32_t))
+
+enum {
+	KERNEL_COPY,
+	KERNEL_SCALE,
+	KERNEL_ADD,
+	KERNEL_TRIAD,
+	KERNEL_COUNT,
+};
+
+static const char *const kernel_name[KERNEL_COUNT] = {"copy", "scale", "add", "triad"};
+
+/* Words read and written per element */
+static const uint32_t kernel_words[KERNEL_COUNT] = {2, 2, 3, 3};
+
+typedef struct {
+	const char *name;
+	void (*copy)(uint32_t *c, const uint32_t *a, uint32_t n);
+	void (*scale)(uint32_t *b, const uint32_t *c, uint32_t q, uint32_t n);
+	void (*add)(uint32_t *c, const uint32_t *a, const uint32_t *b, uint32_t n);
+	void (*triad)(uint32_t *a, const uint32_t *b, const uint32_t *c, uint32_t q, uint32_t n);
+	uint32_t needs; /* CPU_FEATURE_* bits the variant runs on */
+} stream_impl_t;
+
+/* The C kernels stay scalar, the compiler would otherwise vectorize them at -O3 */
+#define SCALAR __attribute__((optimize("no-tree-vectorize")))
+
+static void SCALAR stream_copy_c(uint32_t *c, const uint32_t *a, uint32_t n) {
+	for (uint32_t j = 0; j < n; j++)
+		c[j] = a[j];
+}
+
+static void SCALAR stream_scale_c(uint32_t *b, const uint32_t *c, uint32_t q, uint32_t n) {
+	for (uint32_t j = 0; j < n; j++)
+		b[j] = q * c[j];
+}
+
+static void SCALAR stream_add_c(uint32_t *c, const uint32_t *a, const uint32_t *b, uint32_t n) {
+	for (uint32_t j = 0; j < n; j++)
+		c[j] = a[j] + b[j];
+}
+
+static void SCALAR stream_triad_c(uint32_t *a, const uint32_t *b, const uint32_t *c, uint32_t q, uint32_t n) {
+	for (uint32_t j = 0; j < n; j++)
+		a[j] = b[j] + q * c[j];
+}
+
+#ifdef __ARM_NEON
+/* n is a multiple of 16 elements */
+static void stream_copy_neon(uint32_t *c, const uint32_t *a, uint32_t n) {
+	__asm__ __volatile__("1:\n"
+						 "vld1.32 {d0-d3}, [%1]!\n"
+						 "vld1.32 {d4-d7}, [%1]!\n"
+						 "subs %2, %2, #16\n"
+						 "vst1.32 {d0-d3}, [%0]!\n"
+						 "vst1.32 {d4-d7}, [%0]!\n"
+						 "bgt 1b\n"
+						 : "+r"(c), "+r"(a), "+r"(n)
+						 :
+						 : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc", "memory");
+}
+
+static void stream_scale_neon(uint32_t *b, const uint32_t *c, uint32_t q, uint32_t n) {
+	__asm__ __volatile__("vdup.32 q8, %3\n"
+						 "1:\n"
+						 "vld1.32 {d0-d3}, [%1]!\n"
+						 "vld1.32 {d4-d7}, [%1]!\n"
+						 "vmul.i32 q0, q0, q8\n"
+						 "vmul.i32 q1, q1, q8\n"
+						 "vmul.i32 q2, q2, q8\n"
+						 "vmul.i32 q3, q3, q8\n"
+						 "subs %2, %2, #16\n"
+						 "vst1.32 {d0-d3}, [%0]!\n"
+						 "vst1.32 {d4-d7}, [%0]!\n"
+						 "bgt 1b\n"
+						 : "+r"(b), "+r"(c), "+r"(n)
+						 : "r"(q)
+						 : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d16", "d17", "cc", "memory");
+}
+
+static void stream_add_neon(uint32_t *c, const uint32_t *a, const uint32_t *b, uint32_t n) {
+	__asm__ __volatile__("1:\n"
+						 "vld1.32 {d0-d3}, [%1]!\n"
+						 "vld1.32 {d4-d7}, [%2]!\n"
+						 "vadd.i32 q0, q0, q2\n"
+						 "vadd.i32 q1, q1, q3\n"
+						 "subs %3, %3, #8\n"
+						 "vst1.32 {d0-d3}, [%0]!\n"
+						 "bgt 1b\n"
+						 : "+r"(c), "+r"(a), "+r"(b), "+r"(n)
+						 :
+						 : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc", "memory");
+}
+
+static void stream_triad_neon(uint32_t *a, const uint32_t *b, const uint32_t *c, uint32_t q, uint32_t n) {
+	__asm__ __volatile__("vdup.32 q8, %4\n"
+						 "1:\n"
+						 "vld1.32 {d0-d3}, [%1]!\n"
+						 "vld1.32 {d4-d7}, [%2]!\n"
+						 "vmla.i32 q0, q2, q8\n"
+						 "vmla.i32 q1, q3, q8\n"
+						 "subs %3, %3, #8\n"
+						 "vst1.32 {d0-d3}, [%0]!\n"
+						 "bgt 1b\n"
+						 : "+r"(a), "+r"(b), "+r"(c), "+r"(n)
+						 : "r"(q)
+						 : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d16", "d17", "cc", "memory");
+}
+#endif
+
+static const stream_impl_t impls[] = {
+		{"c", stream_copy_c, stream_scale_c, stream_add_c, stream_triad_c, 0},
+#ifdef __ARM_NEON
+		{"neon", stream_copy_neon, stream_scale_neon, stream_add_neon, stream_triad_neon, CPU_FEATURE_NEON},
+#endif
+};
+
+/* bytes per microsecond is MB/s */
+static uint32_t bench_rate(uint64_t bytes, uint64_t us) {
+	if (us == 0)
+		us = 1;
+	return (uint32_t) (bytes / us);
+}
+
+static uint32_t stream_check(const uint32_t *v, uint32_t expect) {
+	uint32_t errors = 0;
+
+	for (uint32_t j = 0; j < STREAM_ELEMS; j++)
+		if (v[j] != expect)
+			errors++;
+
+	return errors;
+}
+
+static void stream_run(const stream_impl_t *impl, uint32_t clk) {
+	uint32_t *a = (uint32_t *) STREAM_A;
+	uint32_t *b = (uint32_t *) STREAM_B;
+	uint32_t *c = (uint32_t *) STREAM_C;
+	uint64_t times[KERNEL_COUNT][STREAM_NTIMES];
+	uint64_t start, best, sum;
+	uint32_t aj = 1, bj = 2, cj = 0;
+	uint32_t errors;
+
+	for (uint32_t j = 0; j < STREAM_ELEMS; j++) {
+		a[j] = aj;
+		b[j] = bj;
+		c[j] = cj;
+	}
+
+	for (uint32_t k = 0; k < STREAM_NTIMES; k++) {
+		start = time_us();
+		impl->copy(c, a, STREAM_ELEMS);
+		times[KERNEL_COPY][k] = time_us() - start;
+
+		start = time_us();
+		impl->scale(b, c, STREAM_SCALAR, STREAM_ELEMS);
+		times[KERNEL_SCALE][k] = time_us() - start;
+
+		start = time_us();
+		impl->add(c, a, b, STREAM_ELEMS);
+		times[KERNEL_ADD][k] = time_us() - start;
+
+		start = time_us();
+		impl->triad(a, b, c, STREAM_SCALAR, STREAM_ELEMS);
+		times[KERNEL_TRIAD][k] = time_us() - start;
+
+		cj = aj;
+		bj = STREAM_SCALAR * cj;
+		cj = aj + bj;
+		aj = bj + STREAM_SCALAR * cj;
+	}
+
+	errors = stream_check(a, aj) + stream_check(b, bj) + stream_check(c, cj);
+	if (errors)
+		printk_error("DRAM: %s STREAM at %uMHz has %u wrong words\n", impl->name, clk, errors);
+
+	for (uint32_t i = 0; i < KERNEL_COUNT; i++) {
+		uint64_t bytes = (uint64_t) kernel_words[i] * STREAM_BYTES;
+
+		/* The first run warms up, as in STREAM */
+		best = times[i][1];
+		sum = 0;
+		for (uint32_t k = 1; k < STREAM_NTIMES; k++) {
+			if (times[i][k] < best)
+				best = times[i][k];
+			sum += times[i][k];
+		}
+
+		printk(LOG_LEVEL_MUTE, "stream,%u,%s,%s,%u,%u,%u,%u\n", clk, impl->name, kernel_name[i], (uint32_t) bytes, bench_rate(bytes, best),
+			   bench_rate(bytes * (STREAM_NTIMES - 1), sum), errors);
+	}
+}
+
+static uint32_t chase_seed;
+
+/* Where the chase ends up, so the compiler keeps the loads */
+static void *volatile chase_sink;
+
+/* xorshift32, a fixed seed gives every run the same cycles */
+static uint32_t chase_rand(void) {
+	chase_seed ^= chase_seed << 13;
+	chase_seed ^= chase_seed >> 17;
+	chase_seed ^= chase_seed << 5;
+	return chase_seed;
+}
+
+/* Link the lines of the set into one cycle in random order (Sattolo's algorithm) */
+static void **chase_build(uint32_t set) {
+	uint32_t lines = set / CHASE_STRIDE;
+	uint32_t *order = (uint32_t *) CHASE_ORDER;
+	uint8_t *buf = (uint8_t *) CHASE_BUF;
+	uint32_t i, j, tmp;
+
+	for (i = 0; i < lines; i++)
+		order[i] = i;
+
+	for (i = lines - 1; i > 0; i--) {
+		j = chase_rand() % i;
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+
+	for (i = 0; i < lines; i++)
+		*(void **) (buf + order[i] * CHASE_STRIDE) = buf + order[(i + 1) % lines] * CHASE_STRIDE;
+
+	return (void **) (buf + order[0] * CHASE_STRIDE);
+}
+
+/* Every load needs the one before it, so no two can be in flight together */
+static void **chase_loads(void **p, uint32_t loads) {
+	for (uint32_t i = 0; i < loads; i += 8) {
+		p = (void **) *p;
+		p = (void **) *p;
+		p = (void **) *p;
+		p = (void **) *p;
+		p = (void **) *p;
+		p = (void **) *p;
+		p = (void **) *p;
+		p = (void **) *p;
+	}
+
+	return p;
+}
+
+static void chase_run(uint32_t clk) {
+	uint64_t start, us;
+	uint32_t ns10;
+	void **p;
+
+	chase_seed = 0x2545f491;
+
+	for (uint32_t set = CHASE_MIN_SET; set <= CHASE_MAX_SET; set <<= 1) {
+		p = chase_build(set);
+
+		/* One lap to pull the set into the caches it fits in */
+		p = chase_loads(p, set / CHASE_STRIDE);
+
+		start = time_us();
+		p = chase_loads(p, CHASE_LOADS);
+		us = time_us() - start;
+		chase_sink = p;
+
+		ns10 = (uint32_t) (us * 10000 / CHASE_LOADS);
+		printk(LOG_LEVEL_MUTE, "chase,%u,%u,%u,%u.%u\n", clk, set, CHASE_LOADS, ns10 / 10, ns10 % 10);
+	}
+}
+
+static uint32_t dma_check(void) {
+	const uint32_t *src = (const uint32_t *) DMA_SRC;
+	const uint32_t *dst = (const uint32_t *) DMA_DST;
+	uint32_t errors = 0;
+
+	for (uint32_t j = 0; j < DMA_BYTES / sizeof(uint32_t); j++)
+		if (dst[j] != src[j])
+			errors++;
+
+	return errors;
+}
+
+/* Copy STREAM a to c in chunks until the DMA is done, or for cpu_bytes without one */
+static uint64_t dma_cpu_traffic(const stream_impl_t *impl, sunxi_dma_async_t *req, uint64_t cpu_bytes) {
+	uint32_t *a = (uint32_t *) STREAM_A;
+	uint32_t *c = (uint32_t *) STREAM_C;
+	uint32_t off = 0;
+	uint64_t bytes = 0;
+
+	for (;;) {
+		if (req) {
+			sunxi_dma_poll(req->dma_fd);
+			if (req->request.status != SUNXI_DMA_REQ_PENDING)
+				break;
+		} else if (bytes >= cpu_bytes) {
+			break;
+		}
+
+		impl->copy(c + off, a + off, DMA_CPU_CHUNK / sizeof(uint32_t));
+		off = (off + DMA_CPU_CHUNK / sizeof(uint32_t)) % STREAM_ELEMS;
+		bytes += 2 * DMA_CPU_CHUNK;
+	}
+
+	return bytes;
+}
+
+static void dma_run(const stream_impl_t *impl, uint32_t clk) {
+	sunxi_dma_async_t req;
+	uint64_t start, dma_us, cpu_us, cpu_bytes;
+	uint32_t *src = (uint32_t *) DMA_SRC;
+	uint32_t dma_bytes = 2 * DMA_BYTES;
+	uint32_t errors;
+
+	for (uint32_t j = 0; j < DMA_BYTES / sizeof(uint32_t); j++)
+		src[j] = j * 0x9e3779b9;
+
+	/* DMA alone, timed from the submit, the cache maintenance before it is not DRAM traffic */
+	memset((void *) DMA_DST, 0, DMA_BYTES);
+	sunxi_dma_memcpy_async(&req, (void *) DMA_DST, src, DMA_BYTES);
+	if (!req.dma_fd) {
+		printk_warning("DRAM: no DMA channel, skipping the DMA test\n");
+		return;
+	}
+	start = time_us();
+	if (sunxi_dma_async_wait(&req, 1000))
+		return;
+	dma_us = time_us() - start;
+	errors = dma_check();
+
+	/* CPU alone, moving as many bytes as the DMA did */
+	start = time_us();
+	cpu_bytes = dma_cpu_traffic(impl, NULL, dma_bytes);
+	cpu_us = time_us() - start;
+
+	printk(LOG_LEVEL_MUTE, "dma,%u,alone,%u,%u,%u,%u,%u\n", clk, dma_bytes, bench_rate(dma_bytes, dma_us), (uint32_t) cpu_bytes, bench_rate(cpu_bytes, cpu_us),
+		   errors);
+
+	/* Both at once, the CPU stops when it sees the DMA done */
+	memset((void *) DMA_DST, 0, DMA_BYTES);
+	sunxi_dma_memcpy_async(&req, (void *) DMA_DST, src, DMA_BYTES);
+	if (!req.dma_fd)
+		return;
+	start = time_us();
+	cpu_bytes = dma_cpu_traffic(impl, &req, 0);
+	dma_us = time_us() - start;
+	if (sunxi_dma_async_wait(&req, 1000))
+		return;
+	errors = dma_check();
+
+	printk(LOG_LEVEL_MUTE, "dma,%u,shared,%u,%u,%u,%u,%u\n", clk, dma_bytes, bench_rate(dma_bytes, dma_us), (uint32_t) cpu_bytes, bench_rate(cpu_bytes, dma_us),
+		   errors);
+}
+
+static void bench_cache_enable(void) {
+	uint32_t actlr;
+
+	/* The A7 only caches data with ACTLR.SMP set, arm32_mmu_enable() leaves it to CONFIG_CHIP_DCACHE */
+	__asm__ __volatile__("mrc p15, 0, %0, c1, c0, 1" : "=r"(actlr));
+	__asm__ __volatile__("mcr p15, 0, %0, c1, c0, 1" : : "r"(actlr | (1 << 6)));
+	__asm__ __volatile__("isb");
+
+	/* Lines left from before the last DRAM init are stale */
+	invalidate_dcache_range(BENCH_BASE, BENCH_BASE + BENCH_SIZE);
+	arm32_dcache_enable();
+}
+
+static void bench_cache_disable(void) {
+	flush_dcache_range(BENCH_BASE, BENCH_BASE + BENCH_SIZE);
+	arm32_mmu_disable();
+}
+
+static bool dram_up;
+
+/* Stop everything using DRAM before it is initialized again */
+static void bench_dram_down(void) {
+	if (!dram_up)
+		return;
+
+	sunxi_dma_exit(&sunxi_dma);
+	bench_cache_disable();
+	dram_up = false;
+}
+
+/* Initialize DRAM at a clock, 0 for the clock in dram_para, and bring up the caches and DMA */
+static uint32_t bench_dram_init(uint32_t clk) {
+	uint32_t dram_size;
+
+	bench_dram_down();
+
+	if (clk)
+		dram_para.dram_clk = clk;
+
+	dram_size = sunxi_dram_init(&dram_para);
+	if (!dram_size) {
+		printk_error("DRAM: init at %uMHz failed\n", dram_para.dram_clk);
+		return 0;
+	}
+
+	arm32_mmu_enable(SDRAM_BASE, dram_size);
+	bench_cache_enable();
+	sunxi_dma_init(&sunxi_dma);
+	dram_up = true;
+
+	return dram_size;
+}
+
+static void bench_run(uint32_t dram_size) {
+	uint32_t clk = dram_para.dram_clk;
+	const stream_impl_t *cpu_impl = &impls[0];
+
+	printk_info("DRAM: %uMHz type %u %uMB zq 0x%x odt_en 0x%x para1 0x%x para2 0x%x\n", clk, dram_para.dram_type, dram_size, dram_para.dram_zq,
+				dram_para.dram_odt_en, dram_para.dram_para1, dram_para.dram_para2);
+	printk_info("DRAM: tpr10 0x%08x tpr11 0x%08x tpr12 0x%08x tpr13 0x%08x\n", dram_para.dram_tpr10, dram_para.dram_tpr11, dram_para.dram_tpr12,
+				dram_para.dram_tpr13);
+
+	/* The page table sits in the last MB */
+	if ((uint64_t) dram_size * 1024 * 1024 < BENCH_SIZE + 1024 * 1024) {
+		printk_error("DRAM: %uMB is too small for the benchmark\n", dram_size);
+		return;
+	}
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(impls); i++) {
+		if (!cpu_has_feature(impls[i].needs))
+			continue;
+		stream_run(&impls[i], clk);
+		/* The DMA test runs the CPU side with NEON where there is one */
+		cpu_impl = &impls[i];
+	}
+
+	chase_run(clk);
+
+	dma_run(cpu_impl, clk);
+}
+
+int main(void) {
+	uint32_t board_clk, dram_size;
+
+	sunxi_serial_init(&uart_dbg);
+
+	show_banner();
+
+	sunxi_clk_init();
+
+	printk(LOG_LEVEL_MUTE, "stream,dram_clk,impl,kernel,bytes,best_mb_s,avg_mb_s,errors\n");
+	printk(LOG_LEVEL_MUTE, "chase,dram_clk,set_bytes,loads,ns_per_load\n");
+	printk(LOG_LEVEL_MUTE, "dma,dram_clk,mode,dma_bytes,dma_mb_s,cpu_bytes,cpu_mb_s,errors\n");
+
+	board_clk = dram_para.dram_clk;
+
+	dram_size = bench_dram_init(0);
+	if (dram_size)
+		bench_run(dram_size);
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(dram_clk_sweep); i++) {
+		dram_size = bench_dram_init(dram_clk_sweep[i]);
+		if (dram_size)
+			bench_run(dram_size);
+	}
+
+	/* Leave DRAM as the board sets it up for whatever is loaded over FEL next */
+	if (ARRAY_SIZE(dram_clk_sweep))
+		bench_dram_init(board_clk);
+
+	bench_dram_down();
+
+	jmp_to_fel();
+
+	return 0;
+}
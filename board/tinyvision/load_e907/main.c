@@ -12,6 +12,7 @@
 #include <common.h>
 #include <jmp.h>
 
+#include "sys-dma.h"
 #include "sys-dram.h"
 #include "sys-sdcard.h"
 #include "sys-sid.h"
@@ -29,6 +30,8 @@ extern sunxi_serial_t uart_dbg;
 
 extern sdhci_t sdhci0;
 
+extern sunxi_dma_t sunxi_dma;
+
 extern dram_para_t dram_para;
 
 #define FILENAME_MAX_LEN 64
@@ -166,10 +169,15 @@ int main(void) {
 	uint32_t elf_run_addr = elf32_get_entry_addr((phys_addr_t) image.dest);
 	printk_info("RISC-V ELF run addr: 0x%08x\n", elf_run_addr);
 
+	/* Segments are placed by DMA, the channels are handed back before the E907 starts */
+	sunxi_dma_init(&sunxi_dma);
+
 	if (load_elf32_image((phys_addr_t) image.dest)) {
 		printk_error("RISC-V ELF load FAIL\n");
 	}
 
+	sunxi_dma_exit(&sunxi_dma);
+
 	sunxi_e907_clock_init(elf_run_addr);
 
 	dump_e907_clock();
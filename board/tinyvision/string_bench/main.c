@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <config.h>
+#include <log.h>
+#include <timer.h>
+
+#include <common.h>
+#include <cpufeature.h>
+#include <jmp.h>
+#include <mmu.h>
+#include <string.h>
+
+#include "sys-dram.h"
+
+extern sunxi_serial_t uart_dbg;
+
+extern dram_para_t dram_para;
+
+#define BENCH_SRC_ADDR (SDRAM_BASE + 0x01000000)
+#define BENCH_DST_ADDR (SDRAM_BASE + 0x02000000)
+#define BENCH_MAX_SIZE (1024 * 1024)
+#define BENCH_BYTES_PER_CLASS (16 * 1024 * 1024)
+
+typedef struct {
+	const char *name;
+	void *(*copy)(void *dst, const void *src, int cnt);
+	void *(*set)(void *dst, int val, int cnt);
+	int (*cmp)(const void *dst, const void *src, unsigned int cnt);
+	uint32_t needs; /* CPU_FEATURE_* bits the variant runs on */
+} string_impl_t;
+
+#ifdef CONFIG_NEON_STRING
+extern void *memcpy_arm(void *dst, const void *src, int cnt);
+extern void *memset_arm(void *dst, int val, int cnt);
+extern int memcmp_arm(const void *dst, const void *src, unsigned int cnt);
+extern void *memcpy_neon(void *dst, const void *src, int cnt);
+extern void *memset_neon(void *dst, int val, int cnt);
+extern int memcmp_neon(const void *dst, const void *src, unsigned int cnt);
+#endif
+
+static const string_impl_t impls[] = {
+#ifdef CONFIG_NEON_STRING
+		{"arm", memcpy_arm, memset_arm, memcmp_arm, 0},
+		{"neon", memcpy_neon, memset_neon, memcmp_neon, CPU_FEATURE_NEON},
+#else
+		{"arm", memcpy, memset, memcmp, 0},
+#endif
+};
+
+static const uint32_t size_class[] = {16, 64, 256, 1024, 4096, 65536, BENCH_MAX_SIZE};
+
+/* bytes per microsecond is MB/s */
+static uint32_t bench_rate(uint32_t bytes, uint64_t us) {
+	if (us == 0)
+		us = 1;
+	return (uint32_t) (bytes / us);
+}
+
+static void bench_one(const string_impl_t *impl, uint32_t size, uint32_t misalign) {
+	uint8_t *src = (uint8_t *) BENCH_SRC_ADDR + misalign;
+	uint8_t *dst = (uint8_t *) BENCH_DST_ADDR;
+	uint32_t loops = BENCH_BYTES_PER_CLASS / size;
+	uint32_t bytes = loops * size;
+	uint64_t start, t_cpy, t_set, t_cmp;
+	uint32_t i;
+
+	start = time_us();
+	for (i = 0; i < loops; i++)
+		impl->copy(dst, src, size);
+	t_cpy = time_us() - start;
+
+	start = time_us();
+	for (i = 0; i < loops; i++)
+		impl->set(dst + misalign, 0x5a, size);
+	t_set = time_us() - start;
+
+	impl->copy(dst, src, size);
+	start = time_us();
+	for (i = 0; i < loops; i++)
+		impl->cmp(dst, src, size);
+	t_cmp = time_us() - start;
+
+	printk_info("%-5s %8u %s  memcpy %5u MB/s  memset %5u MB/s  memcmp %5u MB/s\n", impl->name, size, misalign ? "unaligned" : "aligned  ",
+				bench_rate(bytes, t_cpy), bench_rate(bytes, t_set), bench_rate(bytes, t_cmp));
+}
+
+/* Every implementation has to agree on the results before its numbers mean anything */
+static int bench_check(const string_impl_t *impl) {
+	uint8_t *src = (uint8_t *) BENCH_SRC_ADDR;
+	uint8_t *dst = (uint8_t *) BENCH_DST_ADDR;
+	uint32_t size, off;
+
+	for (size = 0; size < 300; size += 7) {
+		for (off = 0; off < 4; off++) {
+			impl->set(dst, 0, size + 32);
+			impl->copy(dst + off, src + 3 - off, size);
+			if (impl->cmp(dst + off, src + 3 - off, size) != 0 || dst[off + size] != 0)
+				goto fail;
+			if (size == 0)
+				continue;
+			dst[off + size - 1] ^= 0x80;
+			if (impl->cmp(dst + off, src + 3 - off, size) == 0)
+				goto fail;
+			impl->set(dst + off, 0xa5, size);
+			if (dst[off] != 0xa5 || dst[off + size - 1] != 0xa5 || dst[off + size] != 0)
+				goto fail;
+		}
+	}
+
+	return 0;
+
+fail:
+	printk_error("%s: mismatch at size %u offset %u\n", impl->name, size, off);
+	return -1;
+}
+
+int main(void) {
+	uint32_t i, j;
+
+	sunxi_serial_init(&uart_dbg);
+
+	show_banner();
+
+	sunxi_clk_init();
+
+	uint32_t dram_size = sunxi_dram_init(&dram_para);
+	arm32_mmu_enable(SDRAM_BASE, dram_size);
+
+	printk_info("string bench: %uKB per size class\n", BENCH_BYTES_PER_CLASS / 1024);
+
+	for (i = 0; i < BENCH_MAX_SIZE; i++)
+		((uint8_t *) BENCH_SRC_ADDR)[i] = i * 7 + (i >> 8);
+
+	for (i = 0; i < ARRAY_SIZE(impls); i++) {
+		if (!cpu_has_feature(impls[i].needs))
+			continue;
+		if (bench_check(&impls[i]))
+			goto _fel;
+	}
+
+	for (j = 0; j < ARRAY_SIZE(size_class); j++) {
+		for (i = 0; i < ARRAY_SIZE(impls); i++) {
+			if (!cpu_has_feature(impls[i].needs))
+				continue;
+			bench_one(&impls[i], size_class[j], 0);
+			bench_one(&impls[i], size_class[j], 1);
+		}
+	}
+
+_fel:
+	jmp_to_fel();
+
+	return 0;
+}
@@ -5,8 +5,12 @@
 #include <stdint.h>
 #include <types.h>
 
+#include <bootstage.h>
 #include <config.h>
+#include <ftrace.h>
 #include <log.h>
+#include <log_persist.h>
+#include <profile.h>
 #include <timer.h>
 
 #include <common.h>
@@ -28,6 +32,10 @@
 #include "sys-sid.h"
 #include "sys-spi.h"
 
+#ifdef CONFIG_PROFILE
+#include "sys-gic.h"
+#endif
+
 #include "fdt_wrapper.h"
 #include "ff.h"
 #include "libfdt.h"
@@ -45,8 +53,18 @@
 #define CONFIG_HEAP_BASE (0x40800000)
 #define CONFIG_HEAP_SIZE (16 * 1024 * 1024)
 
+/* Boot log kept across warm resets in the last 64 KiB of the 64 MiB DRAM */
+#define CONFIG_LOG_PERSIST_BASE (0x43ff0000)
+#define CONFIG_LOG_PERSIST_SIZE (64 * 1024)
+
 #define CONFIG_DEFAULT_BOOTDELAY 5
 
+/* Sampling profiler histogram, taken from the heap */
+#define CONFIG_PROFILE_BUF_SIZE (64 * 1024)
+
+/* Function trace ring, 8 bytes per event */
+#define CONFIG_FTRACE_BUF_SIZE (256 * 1024)
+
 #define FILENAME_MAX_LEN 64
 typedef struct {
 	uint8_t *dest;
@@ -121,6 +139,7 @@ static int fatfs_loadimage(char *filename, BYTE *dest) {
 		goto read_fail;
 	}
 	ret = 0;
+	bootstage_mark(BOOTSTAGE_LOAD, filename);
 
 read_fail:
 	fret = f_close(&file);
@@ -270,6 +289,7 @@ static int update_bootargs_from_config(uint32_t dram_size) {
 	int ret = 0;
 	char *bootargs_str_config = NULL;
 	char *mac_addr = NULL;
+	char *log_levels = NULL;
 
 	/* Check if using config file, get bootargs in the config file */
 	if (image.is_config) {
@@ -281,8 +301,13 @@ static int update_bootargs_from_config(uint32_t dram_size) {
 		}
 		bootargs_str_config = find_entry_value(entries, entry_count, "configs", "bootargs");
 		mac_addr = find_entry_value(entries, entry_count, "configs", "mac_addr");
+		log_levels = find_entry_value(entries, entry_count, "configs", "loglevel");
 	}
 
+	/* e.g. loglevel = spi:2,fatfs:2 */
+	if (log_levels != NULL)
+		log_module_set_levels(log_levels);
+
 	/* Force image.dest to be a pointer to fdt_header structure */
 	struct fdt_header *dtb_header = (struct fdt_header *) image.of_dest;
 
@@ -347,6 +372,11 @@ _add_dts_size:
 		return -1;
 	}
 
+#ifdef CONFIG_LOG_PERSIST
+	/* Let Linux show the boot log in /sys/fs/pstore */
+	log_persist_fdt_fixup(image.of_dest);
+#endif
+
 	return 0;
 _err_size:
 	printk_error("DTB: Can't increase blob size: %s\n", fdt_strerror(ret));
@@ -512,6 +542,16 @@ int cmd_boot(int argc, const char **argv) {
 		abort();
 	}
 
+	/* Last mark, the kernel finds the timeline in /proc/device-tree/bootstage */
+	bootstage_mark(BOOTSTAGE_HANDOFF, "kernel");
+	bootstage_fdt_fixup(image.of_dest);
+
+#ifdef CONFIG_PROFILE
+	/* Printed before the jump, the persistent log hands it to Linux as well */
+	profile_stop();
+	profile_dump();
+#endif
+
 	/* Disable MMU, data cache, instruction cache, interrupts */
 	clean_syterkit_data();
 
@@ -530,6 +570,12 @@ int cmd_boot(int argc, const char **argv) {
 	return 0;
 }
 
+#ifdef CONFIG_PROFILE
+void arm32_do_irq(struct arm_regs_t *regs) {
+	do_irq(regs);
+}
+#endif
+
 const msh_command_entry commands[] = {
 		msh_define_command(bootargs),
 		msh_define_command(reload),
@@ -543,6 +589,8 @@ const msh_command_entry commands[] = {
  * an SD card, sets boot arguments, and boots the kernel. If the kernel fails to boot, the function jumps to FEL mode.
  */
 int main(void) {
+	bootstage_mark(BOOTSTAGE_START, NULL);
+
 	/* Initialize the debug serial interface. */
 	sunxi_serial_init(&uart_dbg);
 
@@ -552,6 +600,8 @@ int main(void) {
 	/* Initialize the system clock. */
 	sunxi_clk_init();
 
+	bootstage_mark(BOOTSTAGE_CLOCK, NULL);
+
 	/* Check rtc fel flag. if set flag, goto fel */
 	if (rtc_probe_fel_flag()) {
 		printk_info("RTC: get fel flag, jump to fel mode.\n");
@@ -562,22 +612,46 @@ int main(void) {
 		goto _fel;
 	}
 
+#ifdef CONFIG_PROFILE
+	/* Sample DRAM init too, the histogram moves to DRAM once it is up */
+	arch_interrupt_init();
+	profile_start(0);
+#endif
+
 	/* Initialize the DRAM and enable memory management unit (MMU). */
 	uint32_t dram_size = sunxi_dram_init(&dram_para);
 	arm32_mmu_enable(SDRAM_BASE, dram_size);
 
+	bootstage_mark(BOOTSTAGE_DRAM, NULL);
+
 	/* Debug message to indicate that MMU is enabled. */
 	printk_debug("enable mmu ok\n");
 
 	/* Initialize the small memory allocator. */
 	smalloc_init(CONFIG_HEAP_BASE, CONFIG_HEAP_SIZE);
 
+#ifdef CONFIG_PROFILE
+	profile_set_buffer(smalloc(CONFIG_PROFILE_BUF_SIZE), CONFIG_PROFILE_BUF_SIZE);
+#endif
+
+#ifdef CONFIG_FUNC_TRACE
+	/* Covers SD card init and the file loads, "ftrace dump" in the shell prints it */
+	ftrace_start(smalloc(CONFIG_FTRACE_BUF_SIZE), CONFIG_FTRACE_BUF_SIZE);
+#endif
+
+#ifdef CONFIG_LOG_PERSIST
+	/* Move the log captured so far to DRAM, it survives warm resets from here on */
+	log_persist_init(CONFIG_LOG_PERSIST_BASE, CONFIG_LOG_PERSIST_SIZE);
+#endif
+
 	/* Set up Real-Time Clock (RTC) hardware. */
 	rtc_set_vccio_det_spare();
 
 	/* Check if system voltage is within limits. */
 	sys_ldo_check();
 
+	bootstage_mark(BOOTSTAGE_PMU, "ldo");
+
 	/* Dump information about the system clocks. */
 	sunxi_clk_dump();
 
@@ -609,6 +683,8 @@ int main(void) {
 		goto _shell;
 	}
 
+	bootstage_mark(BOOTSTAGE_STORAGE, sdhci0.name);
+
 	/* Load the DTB, kernel image, and configuration data from the SD card. */
 	if (load_sdcard(&image) != 0) {
 		printk_warning("SMHC: loading failed\n");
@@ -620,6 +696,8 @@ int main(void) {
 		goto _shell;
 	}
 
+	bootstage_mark(BOOTSTAGE_FDT, NULL);
+
 	int bootdelay = CONFIG_DEFAULT_BOOTDELAY;
 
 	if (image.is_config) {
@@ -643,6 +721,13 @@ int main(void) {
 	cmd_boot(0, NULL);
 
 _shell:
+#ifdef CONFIG_FUNC_TRACE
+	ftrace_stop();
+#endif
+#ifdef CONFIG_PROFILE
+	/* Keep the shell idle loop out of the boot profile, "profile dump" shows it */
+	profile_stop();
+#endif
 	syterkit_shell_attach(commands);
 
 _fel:
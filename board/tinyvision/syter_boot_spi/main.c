@@ -11,6 +11,7 @@
 #include <mmu.h>
 #include <common.h>
 #include <jmp.h>
+#include <mempool.h>
 
 #include <image_loader.h>
 
@@ -19,6 +20,7 @@
 #include "sys-sid.h"
 #include "sys-spi.h"
 #include "sys-dma.h"
+#include "sys-gic.h"
 #include "sys-spi-nand.h"
 
 #include "libfdt.h"
@@ -32,6 +34,9 @@
 #define CONFIG_DTB_LOAD_ADDR (0x41008000)
 #define CONFIG_KERNEL_LOAD_ADDR (0x41800000)
 
+// Uncached pool for DMA descriptors, in the MB below the MMU table at the top of DRAM
+#define CONFIG_DMA_POOL_SIZE (1 * 1024 * 1024)
+
 // 128KB erase sectors, so place them starting from 2nd sector
 #define CONFIG_SPINAND_DTB_ADDR (128 * 2048)
 #define CONFIG_SPINAND_KERNEL_ADDR (256 * 2048)
@@ -55,6 +60,8 @@ extern dram_para_t dram_para;
 
 extern sunxi_spi_t sunxi_spi0;
 
+extern sunxi_dma_t sunxi_dma;
+
 extern sdhci_t sdhci0;
 
 image_info_t image;
@@ -196,9 +203,15 @@ int main(void) {
 
 	sunxi_clk_init();
 
-	sunxi_dram_init(&dram_para);
+	/* The MMU is needed to map the DMA pool uncached */
+	uint32_t dram_size = sunxi_dram_init(&dram_para);
+	arm32_mmu_enable(SDRAM_BASE, dram_size);
+
+	if (mem_pool_init(MEM_ATTR_UNCACHED, (void *) (SDRAM_BASE + ((dram_size - 1) << 20) - CONFIG_DMA_POOL_SIZE), CONFIG_DMA_POOL_SIZE) != 0)
+		printk_warning("DMA: descriptors stay cacheable\n");
 
 	uint32_t entry_point = 0;
+	bool dma_irq = false;
 	void (*kernel_entry)(int zero, int arch, unsigned int params);
 
 	sunxi_clk_dump();
@@ -229,16 +242,26 @@ int main(void) {
 
 _spi:
 	printk_debug("SPI: init\n");
+	/* SPI DMA requests complete from the DMA interrupt, the handler goes in before the CPU unmasks it */
+	arch_interrupt_init();
 	if (sunxi_spi_init(&sunxi_spi0) != 0) {
 		printk_error("SPI: init failed\n");
 	}
 
+	dma_irq = sunxi_dma_irq_init() == 0;
+	if (dma_irq)
+		arm32_interrupt_enable();
+
 	if (load_spi_nand(&sunxi_spi0, &image) != 0) {
 		printk_error("SPI-NAND: loading failed\n");
 	}
 
 	sunxi_spi_disable(&sunxi_spi0);
 
+	/* Hand the DMA interrupt line back before the kernel sets up the GIC */
+	if (dma_irq)
+		sunxi_dma_exit(&sunxi_dma);
+
 _boot:
 	if (zImage_loader((unsigned char *) image.dest, &entry_point)) {
 		printk_error("boot setup failed\n");
@@ -79,6 +79,9 @@ int main(void) {
 
 	printk_info("USB init OK.\n");
 
+	/* The USB handlers log a lot, let the UART interrupt send it */
+	log_ring_irq_init();
+
 	sunxi_usb_attach();
 
 	abort();
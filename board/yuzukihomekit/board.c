@@ -156,6 +156,7 @@ dram_para_t dram_para = {
 };
 
 void clean_syterkit_data(void) {
+	log_flush();
 	/* Disable MMU, data cache, instruction cache, interrupts */
 	arm32_mmu_disable();
 	printk_info("disable mmu ok...\n");
@@ -165,6 +166,7 @@ void clean_syterkit_data(void) {
 	printk_info("disable icache ok...\n");
 	arm32_interrupt_disable();
 	printk_info("free interrupt ok...\n");
+	log_flush();
 }
 
 void show_chip() {
@@ -70,6 +70,65 @@ function(add_syterkit_app target_name)
         COMMENT "Padding MTD 8192 Binary"
     )
 
+    # Self-decompressing version of the _bin target
+    if(ENABLE_COMPRESS_BOOT0)
+        # Payload, linked behind the stub region
+        add_executable(${target_name}_lz4 ${APP_COMMON_SOURCE} ${ARGN})
+
+        set_target_properties(${target_name}_lz4 PROPERTIES LINK_DEPENDS "${LINK_SCRIPT_LZ4_PAYLOAD}")
+        target_link_libraries(${target_name}_lz4 ${APP_LIBS} -Wl,--whole-archive ${APP_COMMON_LIBRARY} ${APP_LINK_LIBRARY} -Wl,--no-whole-archive -T"${LINK_SCRIPT_LZ4_PAYLOAD}" -flto -nostdlib -Wl,-gc-sections -Wl,-z,noexecstack,-Map,${target_name}_lz4.map)
+
+        add_custom_command(
+            TARGET ${target_name}_lz4
+            POST_BUILD COMMAND ${CMAKE_OBJCOPY} -v -O binary ${target_name}_lz4 ${target_name}_lz4_payload.bin
+            COMMENT "Copy Payload Binary ${target_name}_lz4 => ${target_name}_lz4_payload.bin"
+        )
+
+        # Stub, only needs the board boot head besides its own sources
+        set(LZ4_STUB_HEAD ${APP_COMMON_SOURCE})
+        list(FILTER LZ4_STUB_HEAD INCLUDE REGEX "head\\.c$")
+
+        add_executable(${target_name}_lz4stub ${LZ4_STUB_START} ${CMAKE_SOURCE_DIR}/src/lz4_stub.c ${CMAKE_SOURCE_DIR}/src/lz4.c ${LZ4_STUB_HEAD})
+        add_dependencies(${target_name}_lz4stub ${target_name}_lz4)
+
+        # The stub is not linked against the library, keep gcc from turning the copy loops into memcpy calls
+        target_compile_definitions(${target_name}_lz4stub PRIVATE CONFIG_COMPRESS_STUB_SIZE=${CONFIG_COMPRESS_STUB_SIZE})
+        target_compile_options(${target_name}_lz4stub PRIVATE -fno-tree-loop-distribute-patterns)
+
+        set_target_properties(${target_name}_lz4stub PROPERTIES LINK_DEPENDS "${LINK_SCRIPT_LZ4_STUB}")
+        target_link_libraries(${target_name}_lz4stub ${APP_LIBS} -T"${LINK_SCRIPT_LZ4_STUB}" -nostdlib -Wl,-gc-sections -Wl,-z,noexecstack,-Map,${target_name}_lz4stub.map)
+
+        add_custom_command(
+            TARGET ${target_name}_lz4stub
+            POST_BUILD COMMAND ${CMAKE_SIZE} -B -x ${target_name}_lz4stub
+            COMMENT "Get Size of ${target_name}_lz4stub"
+        )
+
+        add_custom_command(
+            TARGET ${target_name}_lz4stub
+            POST_BUILD COMMAND ${CMAKE_OBJCOPY} -v -O binary ${target_name}_lz4stub ${target_name}_bin_lz4_card.bin
+            COMMENT "Copy Block Binary ${target_name}_lz4stub => ${target_name}_bin_lz4_card.bin"
+        )
+
+        add_custom_command(
+            TARGET ${target_name}_lz4stub
+            POST_BUILD COMMAND ${CMAKE_OBJCOPY} -v -O binary ${target_name}_lz4stub ${target_name}_bin_lz4_spi.bin
+            COMMENT "Copy MTD Binary ${target_name}_lz4stub => ${target_name}_bin_lz4_spi.bin"
+        )
+
+        add_custom_command(
+            TARGET ${target_name}_lz4stub
+            POST_BUILD COMMAND ${CMAKE_MKSUNXI} -z ${target_name}_bin_lz4_card.bin ${target_name}_lz4_payload.bin 512
+            COMMENT "Pack Compressed Block 512 Binary"
+        )
+
+        add_custom_command(
+            TARGET ${target_name}_lz4stub
+            POST_BUILD COMMAND ${CMAKE_MKSUNXI} -z ${target_name}_bin_lz4_spi.bin ${target_name}_lz4_payload.bin 8192
+            COMMENT "Pack Compressed MTD 8192 Binary"
+        )
+    endif()
+
     if(CMAKE_BUILD_TYPE STREQUAL Trace OR CMAKE_BUILD_TYPE STREQUAL Debug)
         add_custom_command(
             TARGET ${target_name}_bin
@@ -7,6 +7,12 @@ set(CONFIG_BOARD_100ASK_D1_H True)
 
 add_definitions(-DCONFIG_CHIP_SUN20IW1)
 
+# Options
+
+# By setting ENABLE_VECTOR_STRING to ON, the vector memcpy/memset/memcmp/
+# strlen/memchr are linked in and used when the C906 reports a vector unit.
+option(ENABLE_VECTOR_STRING "Use vector memcpy/memset/memcmp/strlen/memchr" OFF)
+
 # Set the cross-compile toolchain
 if(DEFINED ENV{RISCV_ROOT_PATH})
     file(TO_CMAKE_PATH $ENV{RISCV_ROOT_PATH} RISCV_ROOT_PATH)
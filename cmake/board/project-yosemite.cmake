@@ -13,6 +13,10 @@ add_definitions(-DCONFIG_CHIP_SUN8IW21)
 # in scenarios where performance gains from hardware acceleration are desired.
 option(ENABLE_HARDFP "Enable hardware floating-point operations" ON)
 
+# By setting ENABLE_NEON_STRING to ON, the NEON memcpy/memset/memcmp with
+# 64 byte block loops are linked in and used when the CPU reports NEON.
+option(ENABLE_NEON_STRING "Use NEON memcpy/memset/memcmp" OFF)
+
 # Set the cross-compile toolchain
 set(CROSS_COMPILE "arm-none-eabi-")
 set(CROSS_COMPILE ${CROSS_COMPILE} CACHE STRING "CROSS_COMPILE Toolchain")
@@ -8,6 +8,7 @@ set(CONFIG_CHIP_GIC True)
 set(CONFIG_BOARD_YUZUKIHOMEKIT True)
 
 add_definitions(-DCONFIG_CHIP_SUN8IW20 -DCONFIG_FATFS_CACHE_SIZE=0x2000000 -DCONFIG_FATFS_CACHE_ADDR=0x48000000)
+add_definitions(-DCONFIG_CHIP_GIC)
 
 # Options
 
@@ -16,6 +17,10 @@ add_definitions(-DCONFIG_CHIP_SUN8IW20 -DCONFIG_FATFS_CACHE_SIZE=0x2000000 -DCON
 # in scenarios where performance gains from hardware acceleration are desired.
 option(ENABLE_HARDFP "Enable hardware floating-point operations" ON)
 
+# By setting ENABLE_NEON_STRING to ON, the NEON memcpy/memset/memcmp with
+# 64 byte block loops are linked in and used when the CPU reports NEON.
+option(ENABLE_NEON_STRING "Use NEON memcpy/memset/memcmp" OFF)
+
 # Set the cross-compile toolchain
 set(CROSS_COMPILE "arm-none-eabi-")
 set(CROSS_COMPILE ${CROSS_COMPILE} CACHE STRING "CROSS_COMPILE Toolchain")
@@ -13,6 +13,16 @@ add_definitions(-DCONFIG_CHIP_SUN8IW21)
 # in scenarios where performance gains from hardware acceleration are desired.
 option(ENABLE_HARDFP "Enable hardware floating-point operations" ON)
 
+# By setting ENABLE_NEON_STRING to ON, the NEON memcpy/memset/memcmp with
+# 64 byte block loops are linked in and used when the CPU reports NEON.
+option(ENABLE_NEON_STRING "Use NEON memcpy/memset/memcmp" OFF)
+
+# By setting ENABLE_COMPRESS_BOOT0 to ON, every app also gets a _bin_lz4 image:
+# a small stub decompresses the LZ4 packed app from SRAM before running it,
+# trading a few milliseconds of decompression for less data read by the BROM.
+option(ENABLE_COMPRESS_BOOT0 "Build self-decompressing boot0 images" OFF)
+set(CONFIG_COMPRESS_STUB_SIZE "0x1000")
+
 # Set the cross-compile toolchain
 set(CROSS_COMPILE "arm-none-eabi-")
 set(CROSS_COMPILE ${CROSS_COMPILE} CACHE STRING "CROSS_COMPILE Toolchain")
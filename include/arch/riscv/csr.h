@@ -21,11 +21,15 @@ extern "C" {
 #define MSTATUS_MXR (1 << 19)
 #define MSTATUS_TVM (1 << 20)
 #define MSTATUS_TW (1 << 21)
+#define MSTATUS_VS (3 << 23) /**< C906 RVV 0.7.1 vector context status */
 #define MSTATUS32_SD (1 << 31)
 #define MSTATUS_UXL (3ULL << 32)
 #define MSTATUS_SXL (3ULL << 34)
 #define MSTATUS64_SD (1ULL << 63)
 
+/** Machine ISA Register extension bit, e.g. MISA_EXT('V') */
+#define MISA_EXT(x) (1UL << ((x) - 'A'))
+
 /** Machine Extra Status Bit Definitions */
 #define MXSTATUS_MM (1 << 15)
 #define MXSTATUS_THEADISAEE (1 << 22)
@@ -34,4 +34,16 @@ static inline void riscv_interrupt_disable(void) {
 	csr_clear(mstatus, MSTATUS_MIE);
 }
 
+/**
+ * @brief Install a handler for a core interrupt of the C906.
+ *
+ * The C906 trap handler calls it for the software and timer interrupts,
+ * causes 0 to 7 of mcause. The E907 hands those to the CLIC driver instead.
+ *
+ * @param cause The interrupt number in mcause, e.g. 7 for the machine timer.
+ * @param handler The handler, NULL to ignore the interrupt again.
+ * @param data Passed to the handler.
+ */
+void riscv64_install_core_handler(int cause, void (*handler)(void *data), void *data);
+
 #endif /* __INTERRUPT_H__ */
\ No newline at end of file
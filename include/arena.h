@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/**
+ * @brief Bump allocator over a fixed memory region.
+ *
+ * Allocations carry no header and cannot be freed one by one. Boot-phase
+ * temporaries that die together are released at once by resetting the arena
+ * to a mark taken before they were allocated.
+ */
+typedef struct arena {
+	unsigned long base; /**< First byte of the region */
+	unsigned long end;	/**< One past the last byte of the region */
+	unsigned long cur;	/**< Next free byte */
+	unsigned long peak; /**< Highest value cur has reached */
+} arena_t;
+
+/**
+ * @brief Position in an arena, everything allocated after it is released by arena_reset().
+ */
+typedef unsigned long arena_mark_t;
+
+/**
+ * Initialize an arena over the given memory region.
+ *
+ * @param arena The arena to initialize.
+ * @param base The start address of the region.
+ * @param size The size of the region in bytes.
+ * @return Zero if successful, -1 if the region is empty.
+ */
+int arena_init(arena_t *arena, void *base, uint32_t size);
+
+/**
+ * Allocate memory from an arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @param align The alignment in bytes, must be a power of two; 0 means pointer alignment.
+ * @return A pointer to the allocated memory, or NULL if the arena is exhausted.
+ */
+void *arena_alloc(arena_t *arena, uint32_t size, uint32_t align);
+
+/**
+ * Take a mark of the current arena position.
+ *
+ * @param arena The arena to mark.
+ * @return The mark to pass to arena_reset().
+ */
+static inline arena_mark_t arena_mark(arena_t *arena) {
+	return arena->cur;
+}
+
+/**
+ * Release everything allocated since the mark was taken.
+ *
+ * @param arena The arena to reset.
+ * @param mark A mark returned by arena_mark() on the same arena.
+ */
+static inline void arena_reset(arena_t *arena, arena_mark_t mark) {
+	if (mark >= arena->base && mark <= arena->cur)
+		arena->cur = mark;
+}
+
+/**
+ * Get the number of bytes currently allocated from an arena.
+ *
+ * @param arena The arena to query.
+ * @return The number of bytes in use.
+ */
+static inline uint32_t arena_used(const arena_t *arena) {
+	return arena->cur - arena->base;
+}
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __ARENA_H__
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __BOOTSTAGE_H__
+#define __BOOTSTAGE_H__
+
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/* Number of marks kept, later marks are dropped with a warning */
+#define BOOTSTAGE_MAX_RECORDS 32
+
+/* Mark names are copied and truncated to this length, terminator included */
+#define BOOTSTAGE_NAME_LEN 24
+
+/*
+ * Kind of a mark. The id groups marks for tools/bootstage.py, the name tells
+ * marks of the same kind apart, e.g. the file of a BOOTSTAGE_LOAD.
+ */
+enum bootstage_id {
+	BOOTSTAGE_START,   /* main() entered */
+	BOOTSTAGE_CLOCK,   /* PLLs and bus clocks set up */
+	BOOTSTAGE_PMU,	   /* PMU found and rails set */
+	BOOTSTAGE_DRAM,	   /* DRAM trained and usable */
+	BOOTSTAGE_STORAGE, /* boot media probed */
+	BOOTSTAGE_LOAD,	   /* a file or image loaded */
+	BOOTSTAGE_FDT,	   /* device tree fixed up for the kernel */
+	BOOTSTAGE_HANDOFF, /* about to jump to the next image */
+	BOOTSTAGE_USER,	   /* anything else */
+	BOOTSTAGE_COUNT,
+};
+
+/**
+ * Record that a boot stage ended now.
+ *
+ * Times are microseconds of the arch timer, which starts at power on, so
+ * the first mark also shows how long the BROM and earlier stages took.
+ *
+ * @param id The kind of stage, one of enum bootstage_id.
+ * @param name A name for the mark, NULL for the name of the id.
+ * @return The time of the mark in microseconds.
+ */
+uint32_t bootstage_mark(enum bootstage_id id, const char *name);
+
+/**
+ * Print all marks with their absolute time and the time since the previous
+ * mark, in microseconds.
+ */
+void bootstage_report(void);
+
+/**
+ * Add the marks to the FDT handed to the kernel, as /bootstage with one
+ * subnode per mark holding "name", "id" and "mark" (microseconds). This is
+ * the layout U-Boot uses, Linux shows it in /proc/device-tree/bootstage.
+ *
+ * Marks made after this call are not in the tree, so call it last.
+ *
+ * @param fdt The FDT handed to the kernel.
+ * @return 0 on success, -1 on error.
+ */
+int bootstage_fdt_fixup(void *fdt);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __BOOTSTAGE_H__
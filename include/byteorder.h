@@ -38,7 +38,8 @@ static inline u32_t __swahb32(u32_t x) {
 	return (((x & (u32_t) 0x00ff00ffUL) << 8) | ((x & (u32_t) 0xff00ff00UL) >> 8));
 }
 
-#if (BYTE_ORDER == BIG_ENDIAN)
+/* The compiler knows the byte order of the target, no arch header is needed */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
 #define cpu_to_le64(x) (__swab64((u64_t) (x)))
 #define le64_to_cpu(x) (__swab64((u64_t) (x)))
 #define cpu_to_le32(x) (__swab32((u32_t) (x)))
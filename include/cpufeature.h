@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __CPUFEATURE_H__
+#define __CPUFEATURE_H__
+
+/* cpu_dispatch_t slots, in pointer sized units, for the assembly trampolines */
+#define CPU_DISPATCH_MEMCPY 0
+#define CPU_DISPATCH_MEMSET 1
+#define CPU_DISPATCH_MEMCMP 2
+#define CPU_DISPATCH_STRLEN 3
+#define CPU_DISPATCH_MEMCHR 4
+#define CPU_DISPATCH_CRC32 5
+
+#ifndef __ASSEMBLER__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/* Feature bits, filled in by cpu_features_init() */
+#define CPU_FEATURE_FPU (1 << 0)	/**< Single precision floating point, enabled */
+#define CPU_FEATURE_FPU_DP (1 << 1) /**< Double precision floating point */
+#define CPU_FEATURE_NEON (1 << 2)	/**< ARM Advanced SIMD, enabled */
+#define CPU_FEATURE_VECTOR (1 << 3) /**< RISC-V vector unit, enabled */
+#define CPU_FEATURE_IDIV (1 << 4)	/**< Hardware integer divide in the current instruction set */
+#define CPU_FEATURE_CRC32 (1 << 5)	/**< ARMv8 CRC32 instructions */
+#define CPU_FEATURE_DSP (1 << 6)	/**< RISC-V packed SIMD (P extension) */
+#define CPU_FEATURE_COUNT 7
+
+/**
+ * Kernels with more than one implementation.
+ *
+ * Every entry points at the generic version until cpu_features_init() picks
+ * the best one the running core supports. On builds with SIMD string routines
+ * memcpy() and friends are small trampolines that jump through this table, so
+ * callers never need to look at it; other kernels, like crc32(), call through
+ * it themselves. The layout is shared with the assembly trampolines.
+ */
+typedef struct cpu_dispatch {
+	void *(*memcpy)(void *dst, const void *src, int len);
+	void *(*memset)(void *dst, int val, int len);
+	int (*memcmp)(const void *dst, const void *src, unsigned int len);
+	unsigned int (*strlen)(const char *str);
+	void *(*memchr)(void *src, int val, unsigned int len);
+	uint32_t (*crc32)(uint32_t crc, const void *buf, uint32_t len);
+} cpu_dispatch_t;
+
+extern uint32_t cpu_features;
+
+extern cpu_dispatch_t cpu_dispatch;
+
+/**
+ * Probe the CPU, enable the units that were found and resolve cpu_dispatch.
+ *
+ * Called once from show_banner(); later calls do nothing. Code running before
+ * it is correct, it just uses the generic kernels.
+ */
+void cpu_features_init(void);
+
+/**
+ * Check for a feature found by cpu_features_init().
+ *
+ * @param feature One or more CPU_FEATURE_* bits.
+ * @return true if all of them are present.
+ */
+static inline bool cpu_has_feature(uint32_t feature) {
+	return (cpu_features & feature) == feature;
+}
+
+/**
+ * Print the feature bitmap and the kernel variants in use.
+ */
+void cpu_features_dump(void);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __ASSEMBLER__
+
+#endif// __CPUFEATURE_H__
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/**
+ * Update a CRC-32 (IEEE 802.3, the zlib one) with a buffer.
+ *
+ * Uses the CRC32 instructions when cpu_features_init() found them.
+ *
+ * @param crc Result of the previous call, 0 to start.
+ * @param buf Data to add.
+ * @param len Length of the data in bytes.
+ * @return The updated CRC.
+ */
+uint32_t crc32(uint32_t crc, const void *buf, uint32_t len);
+
+/**
+ * Table driven CRC-32, the fallback of crc32().
+ */
+uint32_t crc32_generic(uint32_t crc, const void *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __CRC32_H__
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __DIV64_H__
+#define __DIV64_H__
+
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/**
+ * Divide a 64-bit value by a divisor below 65536.
+ *
+ * 32-bit targets have no 64-bit divide instruction and the compiler calls a
+ * generic library routine, a bit-at-a-time loop of well over a hundred
+ * cycles. With a small divisor the long division can work on 16-bit digits
+ * instead: every partial dividend fits in 32 bits, so four hardware 32-bit
+ * divisions give the exact quotient. Counter to time conversions use this.
+ *
+ * @param x The dividend.
+ * @param d The divisor, 1 to 65535.
+ * @return x / d.
+ */
+static inline uint64_t div_u64_u16(uint64_t x, uint32_t d) {
+#ifdef __LP64__
+	return x / d;
+#else
+	uint32_t hi = (uint32_t) (x >> 32), lo = (uint32_t) x;
+	uint32_t q3, q2, q1, q0, r;
+
+	q3 = (hi >> 16) / d;
+	r = (hi >> 16) - q3 * d;
+	r = (r << 16) | (hi & 0xffff);
+	q2 = r / d;
+	r -= q2 * d;
+	r = (r << 16) | (lo >> 16);
+	q1 = r / d;
+	r -= q1 * d;
+	r = (r << 16) | (lo & 0xffff);
+	q0 = r / d;
+
+	return ((uint64_t) ((q3 << 16) | q2) << 32) | ((q1 << 16) | q0);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __DIV64_H__
@@ -5,6 +5,7 @@
 
 /*CPUX*/
 #define SUNXI_CPUXCFG_BASE (0x08100000)
+#define SUNXI_RISCV_CLINT_BASE (0x14000000)
 
 /*sys ctrl*/
 #define SUNXI_TIMER_BASE (0x02050000)
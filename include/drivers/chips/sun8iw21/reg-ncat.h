@@ -98,6 +98,7 @@
 #define VCCIO_DET_BYPASS_EN (1 << 0)
 
 /* IRQ */
+#define AW_IRQ_UART0 34 /* UART1..5 follow */
 #define AW_IRQ_USB_OTG 61
 #define AW_IRQ_USB_EHCI0 62
 #define AW_IRQ_USB_OHCI0 63
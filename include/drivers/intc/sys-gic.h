@@ -29,6 +29,13 @@ extern "C" {
  */
 void do_irq(struct arm_regs_t *regs);
 
+/**
+ * @brief Gets the registers of the code the current IRQ interrupted
+ * 
+ * @return Pointer to the ARM registers, NULL outside of do_irq()
+ */
+struct arm_regs_t *get_irq_regs(void);
+
 /**
  * @brief Initializes the interrupt mechanism
  * 
@@ -110,6 +110,7 @@ typedef struct sunxi_sdhci {
 	sunxi_sdhci_clk_t sdhci_clk;
 	uint32_t max_clk;
 	uint32_t dma_des_addr;
+	bool pio; /* move all data through the FIFO, for benchmarking */
 	sunxi_sdhci_type_t sdhci_mmc_type;
 
 	/* Pinctrl info */
@@ -52,6 +52,30 @@ typedef struct {
  */
 int spi_nand_detect(sunxi_spi_t *spi);
 
+/**
+ * Get the capacity of the detected SPI NAND flash.
+ *
+ * @return The capacity in bytes, 0 before spi_nand_detect() found a chip.
+ */
+uint32_t spi_nand_get_capacity(void);
+
+/**
+ * Get the I/O mode used for reads.
+ *
+ * @return The I/O mode, the one of the detected chip unless changed.
+ */
+spi_io_mode_t spi_nand_get_io_mode(void);
+
+/**
+ * Set the I/O mode used for reads, e.g. to compare them.
+ *
+ * Modes faster than the one of the detected chip return garbage, the
+ * quad enable bit is only set for chips listed with a quad mode.
+ *
+ * @param mode I/O mode to use.
+ */
+void spi_nand_set_io_mode(spi_io_mode_t mode);
+
 /**
  * Read data from SPI NAND flash.
  *
@@ -102,6 +102,8 @@ typedef struct spi_nor_info {
 	uint8_t opcode_erase_32k;	 /**< Opcode to erase a 32K block of the SPI NOR Flash. */
 	uint8_t opcode_erase_64k;	 /**< Opcode to erase a 64K block of the SPI NOR Flash. */
 	uint8_t opcode_erase_256k;	 /**< Opcode to erase a 256K block of the SPI NOR Flash. */
+	uint8_t opcode_write_quad;	 /**< Opcode for quad input page program, 0 if not supported. */
+	uint8_t quad_enable;		 /**< How the QE bit is set, as the SFDP QER field, used with opcode_write_quad. */
 } spi_nor_info_t;
 
 /**
@@ -118,12 +120,17 @@ enum SPI_NOR_OPS {
 	NOR_OPCODE_RDID = 0x9f,		/**< Read ID Command: Retrieve the identity of the memory device */
 	NOR_OPCODE_WRSR = 0x01,		/**< Write Status Register Command: Write to the status register */
 	NOR_OPCODE_RDSR = 0x05,		/**< Read Status Register Command: Read the current status register */
+	NOR_OPCODE_RDSR2 = 0x35,	/**< Read Status Register 2 Command: Read the second status register */
+	NOR_OPCODE_WRSR2 = 0x31,	/**< Write Status Register 2 Command: Write to the second status register */
 	NOR_OPCODE_WREN = 0x06,		/**< Write Enable Command: Enable write operations on the memory */
 	NOR_OPCODE_READ = 0x03,		/**< Read Data Command: Read data from the memory */
 	NOR_OPCODE_PROG = 0x02,		/**< Page Program Command: Program data into a memory page */
+	NOR_OPCODE_PROG_QUAD = 0x32,	/**< Quad Page Program Command: Program a page with data on four lines */
+	NOR_OPCODE_PROG_QUAD_4B = 0x34, /**< Quad Page Program Command with 4-byte address */
 	NOR_OPCODE_E4K = 0x20,		/**< 4K Block Erase Command: Erase a 4K block of memory */
 	NOR_OPCODE_E32K = 0x52,		/**< 32K Block Erase Command: Erase a 32K block of memory */
 	NOR_OPCODE_E64K = 0xd8,		/**< 64K Block Erase Command: Erase a 64K block of memory */
+	NOR_OPCODE_E256K = 0xdc,	/**< 256K Block Erase Command: Erase a 256K block of memory */
 	NOR_OPCODE_ENTER_4B = 0xb7, /**< Enter 4-Byte Address Mode Command: Switch to 4-byte addressing mode */
 	NOR_OPCODE_EXIT_4B = 0xe9,	/**< Exit 4-Byte Address Mode Command: Return to 3-byte addressing mode */
 };
@@ -174,6 +181,13 @@ enum SPI_CMD_OPS {
  */
 int spi_nor_detect(sunxi_spi_t *spi);
 
+/**
+ * @brief Gets the capacity of the detected SPI NOR flash.
+ *
+ * @return The capacity in bytes, 0 before spi_nor_detect() found a chip.
+ */
+uint32_t spi_nor_get_capacity(void);
+
 /**
  * @brief Reads a block or multiple blocks of data from the SPI NAND flash memory.
  *
@@ -231,6 +245,44 @@ uint32_t spi_nor_read_block(sunxi_spi_t *spi, uint8_t *buf, uint32_t blk_no, uin
  */
 uint32_t spi_nor_read(sunxi_spi_t *spi, uint8_t *buf, uint32_t addr, uint32_t rxlen);
 
+/**
+ * @brief Erases a region of the SPI NOR flash memory.
+ *
+ * The region is split into erase operations of the largest size the flash
+ * supports (256K, 64K, 32K or 4K) that is aligned to the current address and
+ * fits in the remaining length, so large regions need few erase commands.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] addr The start address of the region, aligned to the smallest erase size.
+ * @param[in] len The length of the region, a multiple of the smallest erase size.
+ *
+ * @return 0 on success, -1 on misaligned arguments or erase timeout.
+ */
+int spi_nor_erase(sunxi_spi_t *spi, uint32_t addr, uint32_t len);
+
+/**
+ * @brief Writes data to the SPI NOR flash memory.
+ *
+ * This function updates the flash so that it contains `buf` at `addr`. Every erase
+ * region is read back and compared first: identical regions are skipped, regions
+ * that only need bits cleared are programmed without erasing, and the rest are
+ * erased with the largest fitting erase size and reprogrammed page by page. Pages
+ * are programmed with quad page program when the flash supports it, and the
+ * payload is moved by DMA when the SPI controller has a transmit DMA channel.
+ *
+ * Data outside `[addr, addr + txlen)` sharing an erase sector with the written
+ * range is preserved, so the scratch sector buffer is allocated with `smalloc`
+ * and the heap must be initialized before calling this function.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] buf Pointer to the data to write.
+ * @param[in] addr The start address in the SPI NOR.
+ * @param[in] txlen The number of bytes to write.
+ *
+ * @return The number of bytes written (or found identical), less than `txlen` on error.
+ */
+uint32_t spi_nor_write(sunxi_spi_t *spi, uint8_t *buf, uint32_t addr, uint32_t txlen);
+
 #ifdef __cplusplus
 }
 #endif// __cplusplus
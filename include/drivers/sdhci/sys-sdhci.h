@@ -80,6 +80,7 @@ typedef struct {
 	volatile sdhci_idma_desc_t dma_desc[32];
 	volatile uint32_t sdhci_pll;
 	uint32_t dma_trglvl;
+	bool pio; /* move all data through the FIFO, for benchmarking */
 
 	bool removable;
 	bool isspi;
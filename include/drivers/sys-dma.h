@@ -88,6 +88,51 @@ typedef struct {
 	sunxi_dma_channel_reg_t channel[16]; /* 0x100 dma channel register */
 } sunxi_dma_reg_t;
 
+
+/**
+ * @brief A list of descriptors executed back to back by one channel.
+ *
+ * Every descriptor added gets the channel configuration given to
+ * sunxi_dma_chain_init(). Descriptors come from a fixed pool and must
+ * be returned with sunxi_dma_chain_free() once the transfer is done.
+ */
+typedef struct {
+	sunxi_dma_desc_t *head;
+	sunxi_dma_desc_t *tail;
+	uint32_t count;
+	uint32_t config;
+	uint32_t commit_para;
+	uint32_t src_step; /* 0 when the source address is fixed (IO mode) */
+	uint32_t dst_step; /* 0 when the destination address is fixed (IO mode) */
+} sunxi_dma_chain_t;
+
+#define SUNXI_DMA_REQ_DONE (0)
+#define SUNXI_DMA_REQ_ERROR (-1)
+#define SUNXI_DMA_REQ_PENDING (1)
+
+/**
+ * @brief Completion callback of a queued request.
+ *
+ * Runs from the DMA interrupt handler in interrupt mode, or from
+ * sunxi_dma_poll()/sunxi_dma_wait() otherwise. The request's chain has
+ * already been freed and the next request of the channel started.
+ *
+ * @param arg User pointer given with the request.
+ * @param status SUNXI_DMA_REQ_DONE, or SUNXI_DMA_REQ_ERROR if the request was dropped.
+ */
+typedef void (*sunxi_dma_callback_t)(void *arg, int status);
+
+/**
+ * @brief A descriptor chain queued on a channel with its completion callback.
+ */
+typedef struct sunxi_dma_request {
+	sunxi_dma_chain_t chain;
+	sunxi_dma_callback_t callback; /* optional */
+	void *arg;
+	volatile int status; /* SUNXI_DMA_REQ_* */
+	struct sunxi_dma_request *next;
+} sunxi_dma_request_t;
+
 typedef struct {
 	uint32_t used;
 	uint32_t channel_count;
@@ -95,6 +140,8 @@ typedef struct {
 	uint32_t reserved;
 	sunxi_dma_desc_t *desc;
 	sunxi_dma_irq_handler_t dma_func;
+	sunxi_dma_request_t *queue_head; /* request running on the channel */
+	sunxi_dma_request_t *queue_tail;
 } sunxi_dma_source_t;
 
 typedef struct {
@@ -106,6 +153,35 @@ typedef struct {
 #define DMA_DEFAULT_CLK_RST_OFFSET (16)
 #define DMA_DEFAULT_CLK_GATE_OFFSET (0)
 
+/* Descriptors shared by all chained transfers */
+#ifndef SUNXI_DMA_DESC_POOL_SIZE
+#define SUNXI_DMA_DESC_POOL_SIZE (32)
+#endif
+
+/* Bytes moved by one descriptor, the byte counter is 25 bits wide */
+#define SUNXI_DMA_MAX_SEG_BYTES (0x1000000)
+
+/* Copies below this size are done by the CPU, see sunxi_dma_bench() */
+#ifndef SUNXI_DMA_MEMCPY_THRESHOLD
+#define SUNXI_DMA_MEMCPY_THRESHOLD (64 * 1024)
+#endif
+
+
+/**
+ * @brief State of an asynchronous DRAM to DRAM copy or fill.
+ *
+ * Filled by sunxi_dma_memcpy_async()/sunxi_dma_memset_async() and
+ * finished by sunxi_dma_async_wait(). dma_fd is 0 when the request
+ * was small or misaligned and has already been done by the CPU.
+ */
+typedef struct {
+	uint32_t dma_fd;
+	sunxi_dma_request_t request;
+	uint32_t dst;
+	uint32_t len;
+	uint32_t pattern __attribute__((aligned(32))); /* fill word read in IO mode by memset */
+} sunxi_dma_async_t;
+
 /**
  * Initialize the DMA subsystem.
  */
@@ -229,6 +305,177 @@ int sunxi_dma_disable_int(uint32_t dma_fd);
  */
 int sunxi_dma_free_int(uint32_t dma_fd);
 
+/**
+ * @brief Set up an empty descriptor chain.
+ *
+ * @param chain Chain to initialize.
+ * @param cfg Channel configuration applied to every descriptor of the chain.
+ *
+ * @return 0 on success.
+ */
+int sunxi_dma_chain_init(sunxi_dma_chain_t *chain, sunxi_dma_set_t *cfg);
+
+/**
+ * @brief Append a transfer to a descriptor chain.
+ *
+ * Transfers larger than SUNXI_DMA_MAX_SEG_BYTES are split over several
+ * descriptors.
+ *
+ * @param chain Chain to extend.
+ * @param saddr Source address.
+ * @param daddr Destination address.
+ * @param bytes Number of bytes.
+ *
+ * @return 0 on success, -1 if the descriptor pool is exhausted.
+ */
+int sunxi_dma_chain_add(sunxi_dma_chain_t *chain, uint32_t saddr, uint32_t daddr, uint32_t bytes);
+
+/**
+ * @brief Return the descriptors of a chain to the pool.
+ *
+ * @param chain Chain to release, must not be running.
+ */
+void sunxi_dma_chain_free(sunxi_dma_chain_t *chain);
+
+/**
+ * @brief Start a descriptor chain on a channel.
+ *
+ * @param dma_fd Handle to the DMA channel.
+ * @param chain Chain to run.
+ *
+ * @return 0 on success, -1 if the channel is not in use or the chain is empty.
+ */
+int sunxi_dma_start_chain(uint32_t dma_fd, sunxi_dma_chain_t *chain);
+
+/**
+ * @brief Route DMA completion through the interrupt controller.
+ *
+ * Installs the DMA interrupt handler and enables the DMA interrupt line.
+ * Afterwards finished requests are retired from the interrupt handler and
+ * sunxi_dma_wait() only watches the request status. Call it after
+ * sunxi_dma_init() once the interrupt controller is set up. Without it,
+ * queued requests are retired by polling.
+ *
+ * @return 0 on success, -1 if the chip has no DMA interrupt support.
+ */
+int sunxi_dma_irq_init(void);
+
+/**
+ * @brief Queue a request on a channel.
+ *
+ * The request starts at once if the channel is idle. Otherwise it starts as
+ * soon as the previous request on the channel finishes, with no CPU round
+ * trip through the caller.
+ *
+ * @param dma_fd Handle to the DMA channel.
+ * @param req Request with a built chain, must stay valid until it completes.
+ *
+ * @return 0 on success, -1 if the channel is not in use or the chain is empty.
+ */
+int sunxi_dma_submit(uint32_t dma_fd, sunxi_dma_request_t *req);
+
+/**
+ * @brief Retire finished requests of a channel when running without interrupts.
+ *
+ * @param dma_fd Handle to the DMA channel.
+ */
+void sunxi_dma_poll(uint32_t dma_fd);
+
+/**
+ * @brief Wait for a queued request to complete.
+ *
+ * Without interrupts the channel is polled, in interrupt mode the status
+ * the handler sets is. Either way the timeout is checked on every pass, so
+ * a lost interrupt still ends the wait.
+ *
+ * @param dma_fd Handle to the DMA channel the request was queued on.
+ * @param req Request to wait for.
+ * @param timeout_ms Timeout in milliseconds.
+ *
+ * @return 0 on success, -1 on error or timeout.
+ */
+int sunxi_dma_wait(uint32_t dma_fd, sunxi_dma_request_t *req, uint32_t timeout_ms);
+
+/**
+ * @brief Start a DRAM to DRAM copy in the background.
+ *
+ * Unaligned head and tail bytes are copied by the CPU, the rest by DMA.
+ * Copies below SUNXI_DMA_MEMCPY_THRESHOLD, copies whose source and
+ * destination are not equally aligned, and copies issued before
+ * sunxi_dma_init() are done immediately by the CPU.
+ *
+ * @param req Request state, must stay valid until sunxi_dma_async_wait().
+ * @param dst Destination.
+ * @param src Source.
+ * @param len Number of bytes, the ranges must not overlap.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int sunxi_dma_memcpy_async(sunxi_dma_async_t *req, void *dst, const void *src, uint32_t len);
+
+/**
+ * @brief Start a DRAM fill in the background.
+ *
+ * @param req Request state, must stay valid until sunxi_dma_async_wait().
+ * @param dst Destination.
+ * @param c Fill byte.
+ * @param len Number of bytes.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int sunxi_dma_memset_async(sunxi_dma_async_t *req, void *dst, uint8_t c, uint32_t len);
+
+/**
+ * @brief Wait for an asynchronous copy or fill and release its channel.
+ *
+ * @param req Request started by sunxi_dma_memcpy_async()/sunxi_dma_memset_async().
+ * @param timeout_ms Timeout in milliseconds.
+ *
+ * @return 0 on success, -1 on timeout.
+ */
+int sunxi_dma_async_wait(sunxi_dma_async_t *req, uint32_t timeout_ms);
+
+/**
+ * @brief Copy memory with DMA and wait for completion.
+ *
+ * Drop-in for memcpy on large DRAM buffers such as ELF segments or a relocated initrd.
+ *
+ * @param dst Destination.
+ * @param src Source.
+ * @param len Number of bytes.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int sunxi_dma_memcpy(void *dst, const void *src, uint32_t len);
+
+/**
+ * @brief Fill memory with DMA and wait for completion.
+ *
+ * Drop-in for memset on large DRAM buffers such as BSS.
+ *
+ * @param dst Destination.
+ * @param c Fill byte.
+ * @param len Number of bytes.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int sunxi_dma_memset(void *dst, uint8_t c, uint32_t len);
+
+/**
+ * @brief Compare CPU memcpy with DMA memcpy over doubling sizes.
+ *
+ * Prints the throughput of both for every size from 1KB to max_len and
+ * returns the smallest size from which DMA stays faster, a candidate for
+ * SUNXI_DMA_MEMCPY_THRESHOLD.
+ *
+ * @param src Source buffer of at least max_len bytes.
+ * @param dst Destination buffer of at least max_len bytes.
+ * @param max_len Largest size to measure.
+ *
+ * @return Crossover size in bytes, 0 if DMA was never faster.
+ */
+uint32_t sunxi_dma_bench(void *src, void *dst, uint32_t max_len);
+
 /**
  * Perform a test DMA transfer between the specified source and destination addresses.
  *
@@ -95,6 +95,7 @@ typedef struct {
 	uint32_t clk_rate;			/**< Clock rate for the SPI device */
 	sunxi_spi_gpio_t gpio;		/**< GPIO configuration for the SPI device */
 	sunxi_dma_t *dma_handle;	/**< DMA handle for the SPI device */
+	bool pio;					/**< Use the FIFO even for transfers DMA would take, for benchmarking */
 	sunxi_clk_t parent_clk_reg; /**< Parent clock register configuration */
 	sunxi_spi_clk_t spi_clk;	/**< SPI clock configuration */
 } sunxi_spi_t;
@@ -161,6 +162,25 @@ int sunxi_spi_update_clk(sunxi_spi_t *spi, uint32_t clk);
  */
 int sunxi_spi_transfer(sunxi_spi_t *spi, spi_io_mode_t mode, void *txbuf, uint32_t txlen, void *rxbuf, uint32_t rxlen);
 
+/**
+ * @brief Performs a SPI write transfer with a separate command phase.
+ * 
+ * This function sends a command (opcode, address, dummy bytes) followed by a data payload in one
+ * chip-select cycle. The command phase is always sent on a single data line. In SPI_IO_QUAD_IO mode
+ * the payload is sent on four data lines, otherwise it is sent on a single line. Large payloads are
+ * fed to the controller by DMA when a transmit DMA channel is available.
+ * 
+ * @param spi Pointer to the SPI structure containing configuration and register information.
+ * @param mode The I/O mode of the payload phase (SPI_IO_SINGLE or SPI_IO_QUAD_IO).
+ * @param cmdbuf Pointer to the command buffer.
+ * @param cmdlen Length of the command in bytes.
+ * @param txbuf Pointer to the payload buffer.
+ * @param txlen Length of the payload in bytes.
+ * 
+ * @return The total number of bytes transferred (cmdlen + txlen).
+ */
+int sunxi_spi_transfer_write(sunxi_spi_t *spi, spi_io_mode_t mode, void *cmdbuf, uint32_t cmdlen, void *txbuf, uint32_t txlen);
+
 
 #ifdef __cplusplus
 }
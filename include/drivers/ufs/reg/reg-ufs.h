@@ -54,4 +54,45 @@ enum {
 	MASK_UIC_DME_TEST_MODE_SUPPORT = 0x04000000,
 };
 
+/* Interrupt status and enable bits */
+enum {
+	UTP_TRANSFER_REQ_COMPL = 0x00000001,
+	UIC_DME_END_PT_RESET = 0x00000002,
+	UIC_ERROR = 0x00000004,
+	UIC_TEST_MODE = 0x00000008,
+	UIC_POWER_MODE = 0x00000010,
+	UIC_HIBERNATE_EXIT = 0x00000020,
+	UIC_HIBERNATE_ENTER = 0x00000040,
+	UIC_LINK_LOST = 0x00000080,
+	UIC_LINK_STARTUP = 0x00000100,
+	UTP_TASK_REQ_COMPL = 0x00000200,
+	UIC_COMMAND_COMPL = 0x00000400,
+	DEVICE_FATAL_ERROR = 0x00000800,
+	CONTROLLER_FATAL_ERROR = 0x00010000,
+	SYSTEM_BUS_FATAL_ERROR = 0x00020000,
+};
+
+/* Host controller status bits */
+enum {
+	DEVICE_PRESENT = 0x00000001,
+	UTP_TRANSFER_REQ_LIST_READY = 0x00000002,
+	UTP_TASK_REQ_LIST_READY = 0x00000004,
+	UIC_COMMAND_READY = 0x00000008,
+	HOST_ERROR_INDICATOR = 0x00000010,
+	DEVICE_ERROR_INDICATOR = 0x00000020,
+	UIC_POWER_MODE_CHANGE_REQ_STATUS_MASK = 0x00000700,
+};
+
+#define UFSHCD_UPMCRS(hcs) (((hcs) >> 8) & 0x7)
+
+/* Host controller enable, UTRL/UTMRL run-stop */
+enum {
+	CONTROLLER_ENABLE = 0x00000001,
+	UTP_TRANSFER_REQ_LIST_RUN_STOP_BIT = 0x00000001,
+	UTP_TASK_REQ_LIST_RUN_STOP_BIT = 0x00000001,
+};
+
+/* UIC command argument 2 result code */
+#define MASK_UIC_COMMAND_ARG2_RESULT 0xFF
+
 #endif// __REG_UFS_H__
\ No newline at end of file
@@ -117,7 +117,7 @@ typedef struct scsi_cmd {
 #define SCSI_MED_REMOVL 0x1E /* Prevent/Allow medium Removal (O) */
 #define SCSI_READ6 0x08		 /* Read 6-byte (MANDATORY) */
 #define SCSI_READ10 0x28	 /* Read 10-byte (MANDATORY) */
-#define SCSI_READ16 0x48
+#define SCSI_READ16 0x88	 /* Read 16-byte (O) */
 #define SCSI_RD_CAPAC 0x25			  /* Read Capacity (MANDATORY) */
 #define SCSI_RD_CAPAC10 SCSI_RD_CAPAC /* Read Capacity (10) */
 #define SCSI_RD_CAPAC16 0x9e		  /* Read Capacity (16) */
@@ -139,6 +139,7 @@ typedef struct scsi_cmd {
 #define SCSI_VERIFY 0x2F			  /* Verify (O) */
 #define SCSI_WRITE6 0x0A			  /* Write 6-Byte (MANDATORY) */
 #define SCSI_WRITE10 0x2A			  /* Write 10-Byte (MANDATORY) */
+#define SCSI_WRITE16 0x8A			  /* Write 16-Byte (O) */
 #define SCSI_WRT_VERIFY 0x2E		  /* Write and Verify (O) */
 #define SCSI_WRITE_LONG 0x3F		  /* Write Long (O) */
 #define SCSI_WRITE_SAME 0x41		  /* Write Same (O) */
@@ -382,6 +382,56 @@ enum {
 
 #define MASK_UIC_COMMAND_RESULT 0xFF
 
+/* PHY adapter layer attributes used during bring-up */
+enum {
+	PA_ACTIVETXDATALANES = 0x1560,
+	PA_CONNECTEDTXDATALANES = 0x1561,
+	PA_TXGEAR = 0x1568,
+	PA_TXTERMINATION = 0x1569,
+	PA_HSSERIES = 0x156A,
+	PA_PWRMODE = 0x1571,
+	PA_LOCAL_TX_LCC_ENABLE = 0x155E,
+	PA_ACTIVERXDATALANES = 0x1580,
+	PA_CONNECTEDRXDATALANES = 0x1581,
+	PA_RXGEAR = 0x1583,
+	PA_RXTERMINATION = 0x1584,
+	PA_MAXRXPWMGEAR = 0x1586,
+	PA_MAXRXHSGEAR = 0x1587,
+	PA_PWRMODEUSERDATA0 = 0x15B0,
+	PA_PWRMODEUSERDATA1 = 0x15B1,
+	PA_PWRMODEUSERDATA2 = 0x15B2,
+};
+
+/* PA power modes */
+enum {
+	FAST_MODE = 1,
+	SLOW_MODE = 2,
+	FASTAUTO_MODE = 4,
+	SLOWAUTO_MODE = 5,
+	UNCHANGED = 7,
+};
+
+/* PA HS rate series */
+enum {
+	PA_HS_MODE_A = 1,
+	PA_HS_MODE_B = 2,
+};
+
+#define UFS_PWM_G1 1
+#define UFS_HS_G1 1
+
+/* Transfer request slots kept in flight by the driver */
+#define UFS_QUEUE_DEPTH 4
+
+/* Bytes covered by one PRDT entry, the data byte count field is 18 bits */
+#define UFS_PRDT_MAX_BYTES (256 * 1024)
+
+/* Timeouts in ms */
+#define UFS_UIC_CMD_TIMEOUT 500
+#define UFS_NOP_OUT_TIMEOUT 50
+#define UFS_QUERY_TIMEOUT 1500
+#define UFS_SCSI_TIMEOUT 3000
+
 typedef struct ufs_pa_layer_attr {
 	uint32_t gear_rx;
 	uint32_t gear_tx;
@@ -706,6 +756,18 @@ typedef struct ufs_hba {
 
 	ufs_dev_cmd_t dev_cmd;
 	uint32_t dev_ref_clk_freq;
+
+	/* Controller register base */
+	virtual_addr_t ioaddr;
+
+	/* Number of transfer request slots in use, at most UFS_QUEUE_DEPTH */
+	uint32_t nutrs;
+
+	/* Bitmap of slots rung in the doorbell and not completed yet */
+	uint32_t outstanding_reqs;
+
+	/* Data buffer of each in-flight slot, invalidated on completion for reads */
+	scsi_cmd_t *slot_cmd[UFS_QUEUE_DEPTH];
 } ufs_hba_t;
 
 typedef struct ufs_device {
@@ -714,4 +776,97 @@ typedef struct ufs_device {
 	void *bd;
 } ufs_device_t;
 
+/**
+ * @brief Bring up the UFS host controller and the attached device.
+ *
+ * Enables the host controller, starts the UniPro link through DME_LINKSTARTUP,
+ * sets up the transfer request lists, checks the device with NOP OUT, waits
+ * for fDeviceInit to clear, then switches the link to the fastest HS gear both
+ * sides support. Descriptor memory comes from smalloc, so the heap must be
+ * initialized first.
+ *
+ * @param dev UFS device, sc_plat.base holds the controller base address.
+ * @return 0 on success, -1 on failure.
+ */
+int ufs_init(ufs_device_t *dev);
+
+/**
+ * @brief Queue a SCSI command on a transfer request slot and ring the doorbell.
+ *
+ * @param hba UFS host controller.
+ * @param pccb SCSI command, must stay valid until completion.
+ * @param tag Slot to use, below hba->nutrs and not outstanding.
+ * @return 0 on success, -1 on failure.
+ */
+int ufshcd_queue_scsi(ufs_hba_t *hba, scsi_cmd_t *pccb, int tag);
+
+/**
+ * @brief Wait for a queued SCSI command and check its status.
+ *
+ * @param hba UFS host controller.
+ * @param tag Slot the command was queued on.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return 0 on success, -1 on failure.
+ */
+int ufshcd_complete_scsi(ufs_hba_t *hba, int tag, uint32_t timeout_ms);
+
+/**
+ * @brief Execute a SCSI command synchronously.
+ *
+ * @param hba UFS host controller.
+ * @param pccb SCSI command.
+ * @return 0 on success, -1 on failure.
+ */
+int ufshcd_exec_scsi(ufs_hba_t *hba, scsi_cmd_t *pccb);
+
+/**
+ * @brief Send a DME get or set UIC command.
+ *
+ * @param hba UFS host controller.
+ * @param attr_sel Attribute selector, see UIC_ARG_MIB.
+ * @param peer DME_LOCAL or DME_PEER.
+ * @param value Value to set, or where to store the value read.
+ * @param set true for DME_SET, false for DME_GET.
+ * @return 0 on success, -1 on failure.
+ */
+int ufshcd_dme_access(ufs_hba_t *hba, uint32_t attr_sel, int peer, uint32_t *value, bool set);
+
+/**
+ * @brief Platform PHY setup, called with the host enabled before link startup.
+ *
+ * @param hba UFS host controller.
+ * @return 0 on success, -1 on failure.
+ */
+int ufs_phy_init(ufs_hba_t *hba);
+
+/**
+ * @brief Detect the logical unit behind the controller and fill dev->bd.
+ *
+ * @param dev UFS device.
+ * @return 0 on success, -1 on failure.
+ */
+int scsi_scan_dev(ufs_device_t *dev);
+
+/**
+ * @brief Read blocks from the logical unit, keeping several requests in flight.
+ *
+ * @param dev UFS device.
+ * @param blknr First block.
+ * @param blkcnt Number of blocks.
+ * @param buffer Destination, must be 4-byte aligned.
+ * @return Number of blocks read.
+ */
+uint64_t scsi_read(ufs_device_t *dev, uint64_t blknr, uint64_t blkcnt, const void *buffer);
+
+/**
+ * @brief Write blocks to the logical unit, keeping several requests in flight.
+ *
+ * @param dev UFS device.
+ * @param blknr First block.
+ * @param blkcnt Number of blocks.
+ * @param buffer Source, must be 4-byte aligned.
+ * @return Number of blocks written.
+ */
+uint64_t scsi_write(ufs_device_t *dev, uint64_t blknr, uint64_t blkcnt, const void *buffer);
+
 #endif// __UFS_H__
\ No newline at end of file
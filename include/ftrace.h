@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __FTRACE_H__
+#define __FTRACE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/*
+ * Function entry/exit tracing.
+ *
+ * With ENABLE_FUNC_TRACE the storage drivers and FatFs are built with
+ * -finstrument-functions, every function there calls the hooks in
+ * src/ftrace.c on entry and exit. Each call stores one event, the cycle
+ * counter and the function address, into a ring in a buffer given to
+ * ftrace_start(). The oldest events are overwritten once it is full.
+ *
+ * The buffer keeps its header, so a raw copy read back with xfel works as
+ * well as the text of ftrace_dump(). tools/ftrace.py turns either into a
+ * Chrome trace / Perfetto JSON file, or a per function summary.
+ *
+ * The cycle counter is 32 bits wide and wraps every few seconds, events
+ * further apart than that come out too close in the trace.
+ */
+
+#define FTRACE_MAGIC 0x43525446 /* "FTRC" */
+
+/* Set in ftrace_event_t.fn for an exit, function addresses are even */
+#define FTRACE_EXIT 1
+
+typedef struct ftrace_event {
+	uint32_t cycles;
+	uint32_t fn;
+} ftrace_event_t;
+
+typedef struct ftrace_header {
+	uint32_t magic;
+	uint32_t entries; /* power of two */
+	uint32_t head;	  /* events written so far, free running */
+	uint32_t mhz;	  /* cycle counter rate, filled in by ftrace_dump() */
+	ftrace_event_t event[];
+} ftrace_header_t;
+
+/**
+ * Start recording into a buffer, events already in it are dropped.
+ *
+ * @param buf The buffer, usually in DRAM, NULL to reuse the previous one.
+ * @param size Size of the buffer in bytes.
+ * @return 0 on success, -1 without a usable buffer.
+ */
+int ftrace_start(void *buf, uint32_t size);
+
+/**
+ * Stop recording, the events are kept for ftrace_dump().
+ */
+void ftrace_stop(void);
+
+/**
+ * Print the recorded events for tools/ftrace.py, oldest first.
+ */
+void ftrace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __FTRACE_H__
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __BOOTPACK_H__
+#define __BOOTPACK_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <ff.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/*
+ * Boot container layout, all fields little endian:
+ *
+ *   +-------------------+ 0
+ *   | bootpack_head_t   |
+ *   | bootpack_entry_t  | x entry_count
+ *   +-------------------+ head_size, aligned to align
+ *   | payload 0         |
+ *   +-------------------+ aligned to align
+ *   | payload 1         |
+ *   | ...               |
+ *   +-------------------+ total_size
+ *
+ * Built by tools/mkbootpack, keep both sides in sync.
+ */
+#define BOOTPACK_MAGIC "SKBPACK"
+#define BOOTPACK_VERSION 1
+#define BOOTPACK_NAME_LEN 16
+#define BOOTPACK_MAX_ENTRIES 20
+
+#define BOOTPACK_FLAG_LZ4 (1 << 0)	 /* payload is an LZ4 block */
+#define BOOTPACK_FLAG_CRC32 (1 << 1) /* crc32 of the loaded data is valid */
+
+typedef struct bootpack_entry {
+	char name[BOOTPACK_NAME_LEN]; /* NUL terminated payload name */
+	uint32_t offset;			  /* offset of the payload from the container start */
+	uint32_t size;				  /* size stored in the container */
+	uint32_t raw_size;			  /* size once loaded, differs from size when compressed */
+	uint32_t load_addr;			  /* where the payload is loaded */
+	uint32_t flags;				  /* BOOTPACK_FLAG_* */
+	uint32_t crc32;				  /* crc32 of the loaded payload */
+	uint32_t reserved[2];
+} bootpack_entry_t;
+
+typedef struct bootpack_head {
+	uint8_t magic[8];	  /* ="SKBPACK" */
+	uint32_t version;	  /* BOOTPACK_VERSION */
+	uint32_t head_size;	  /* size of head and TOC */
+	uint32_t total_size;  /* size of the whole container */
+	uint32_t align;		  /* payload alignment */
+	uint32_t entry_count; /* number of TOC entries */
+	uint32_t head_crc32;  /* crc32 of head and TOC, computed with this field zero */
+} bootpack_head_t;
+
+typedef struct bootpack {
+	bootpack_head_t head;
+	bootpack_entry_t entry[BOOTPACK_MAX_ENTRIES];
+} bootpack_t;
+
+/**
+ * @brief Backend the container is read from.
+ *
+ * read() copies len bytes at byte offset from the container start into buf
+ * and returns 0 on success. It is called with large lengths, backends should
+ * stream them instead of splitting into small transfers.
+ */
+typedef struct bootpack_reader {
+	const char *name;
+	void *priv;
+	int (*read)(struct bootpack_reader *reader, uint32_t offset, void *buf, uint32_t len);
+} bootpack_reader_t;
+
+/**
+ * @brief Compute the CRC32 (IEEE 802.3) of a buffer.
+ *
+ * @param crc Initial value, 0 for a new computation.
+ * @param buf Pointer to the data.
+ * @param len Length of the data in bytes.
+ * @return The updated CRC32.
+ */
+uint32_t bootpack_crc32(uint32_t crc, const void *buf, uint32_t len);
+
+/**
+ * @brief Read the TOC of a container and load every payload to its load address.
+ *
+ * Uncompressed payloads whose layout in the container matches their layout in
+ * memory are merged into a single read. Compressed payloads are read behind
+ * their load address and decompressed in place.
+ *
+ * @param reader Backend to read the container from.
+ * @param pack Filled with the container head and TOC.
+ * @return 0 on success, -1 on failure.
+ */
+int bootpack_load(bootpack_reader_t *reader, bootpack_t *pack);
+
+/**
+ * @brief Look up a payload in a loaded container by name.
+ *
+ * @param pack Container filled by bootpack_load.
+ * @param name Payload name.
+ * @return Pointer to the TOC entry, or NULL if not found.
+ */
+const bootpack_entry_t *bootpack_find(const bootpack_t *pack, const char *name);
+
+/**
+ * @brief Set up a reader over a file on a mounted FAT filesystem.
+ *
+ * @param reader Reader to initialize.
+ * @param file File object, must stay valid while the reader is used.
+ * @param filename Path of the container file, kept to open it again for reads going backwards.
+ * @return 0 on success, -1 if the file can not be opened.
+ */
+int bootpack_fat_open(bootpack_reader_t *reader, FIL *file, const char *filename);
+
+/**
+ * @brief Close a reader set up by bootpack_fat_open.
+ *
+ * @param reader Reader to close.
+ */
+void bootpack_fat_close(bootpack_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __BOOTPACK_H__
@@ -24,6 +24,18 @@ typedef struct vaddr_map {
 	uint32_t range_size;
 } vaddr_map_t;
 
+/**
+ * Copies a program segment to its load address and clears its tail.
+ *
+ * Large segments are copied by DMA once sunxi_dma_init() has run, by the CPU otherwise.
+ *
+ * @param dst The load address of the segment.
+ * @param src The segment data in the image.
+ * @param filesz The size of the segment in the image.
+ * @param memsz The size of the segment in memory, the bytes past filesz are cleared.
+ */
+void elf_load_segment(void *dst, const void *src, uint32_t filesz, uint32_t memsz);
+
 /**
  * Extracts the entry address from an ELF32 image loaded at 'base'.
  *
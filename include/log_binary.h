@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __LOG_BINARY_H__
+#define __LOG_BINARY_H__
+
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/*
+ * Binary log records, enabled with ENABLE_BINARY_LOG.
+ *
+ * printk_*() stop formatting on the target. Each call site keeps its format
+ * string in the .logfmt section, which the link scripts leave out of the
+ * image, and sends a record instead of text:
+ *
+ *   u8  LOG_BINARY_SYNC
+ *   u8  payload length in bytes
+ *   u32 format string id, its address in .logfmt
+ *   u32 microseconds since boot, as printk() prints them
+ *   u32 argument types, LOG_ARG_BITS per argument from bit 0, level in bits 28-31
+ *   payload, per argument: W32 4 bytes, W64 and DOUBLE 8 bytes,
+ *           STR a length byte and the characters
+ *
+ * All words are little endian. tools/logdecode.py reads the format strings
+ * back from the ELF and prints the same lines printk() would have.
+ */
+
+#define LOG_BINARY_SYNC 0xa5
+#define LOG_BINARY_HEAD_SIZE 14
+#define LOG_BINARY_PAYLOAD_MAX 255
+
+#define LOG_ARG_NONE 0	 /* argument type printk_*() can not defer */
+#define LOG_ARG_W32 1	 /* integer or pointer up to 32 bits */
+#define LOG_ARG_W64 2	 /* 64-bit integer or pointer */
+#define LOG_ARG_STR 3	 /* string, copied into the record */
+#define LOG_ARG_DOUBLE 4 /* float or double, passed as double */
+#define LOG_ARG_BITS 3
+#define LOG_ARG_MAX 8
+#define LOG_ARG_LEVEL_SHIFT 28
+
+/*
+ * Type of one argument. Strings are copied at the call, so stack buffers are
+ * fine; anything that is not a scalar, e.g. a struct or a long double, maps to
+ * LOG_ARG_NONE and fails the build. The + 0 sizes the value as it is passed,
+ * after integer promotion and array decay.
+ */
+#define LOG_ARG_TYPE(x)                                                                    \
+	_Generic((x),                                                                          \
+			char *: LOG_ARG_STR,                                                           \
+			const char *: LOG_ARG_STR,                                                     \
+			float: LOG_ARG_DOUBLE,                                                         \
+			double: LOG_ARG_DOUBLE,                                                        \
+			default: (__builtin_classify_type(x) <= 5 /* integer, enum, bool or pointer */ \
+							 ? (sizeof((x) + 0) > 4 ? LOG_ARG_W64 : LOG_ARG_W32)           \
+							 : LOG_ARG_NONE))
+
+#define LOG_ARG_AT(i, x) | (LOG_ARG_TYPE(x) << (LOG_ARG_BITS * (i)))
+#define LOG_ARG_OK(i, x) +!!LOG_ARG_TYPE(x)
+
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+
+/* Apply m(index, arg) to every argument, each argument is expanded once */
+#define LOG_MAP_0(m)
+#define LOG_MAP_1(m, a) m(0, a)
+#define LOG_MAP_2(m, a, b) LOG_MAP_1(m, a) m(1, b)
+#define LOG_MAP_3(m, a, b, c) LOG_MAP_2(m, a, b) m(2, c)
+#define LOG_MAP_4(m, a, b, c, d) LOG_MAP_3(m, a, b, c) m(3, d)
+#define LOG_MAP_5(m, a, b, c, d, e) LOG_MAP_4(m, a, b, c, d) m(4, e)
+#define LOG_MAP_6(m, a, b, c, d, e, f) LOG_MAP_5(m, a, b, c, d, e) m(5, f)
+#define LOG_MAP_7(m, a, b, c, d, e, f, g) LOG_MAP_6(m, a, b, c, d, e, f) m(6, g)
+#define LOG_MAP_8(m, a, b, c, d, e, f, g, h) LOG_MAP_7(m, a, b, c, d, e, f, g) m(7, h)
+#define LOG_MAP(m, ...) LOG_CAT(LOG_MAP_, LOG_NARGS(__VA_ARGS__))(m, ##__VA_ARGS__)
+
+/** Argument type word of a call, a compile time constant */
+#define LOG_TYPES(...) (0 LOG_MAP(LOG_ARG_AT, ##__VA_ARGS__))
+
+/** Number of arguments with a usable type */
+#define LOG_TYPES_COUNT(...) (0 LOG_MAP(LOG_ARG_OK, ##__VA_ARGS__))
+
+/**
+ * Emit a binary record for a printk_*() call.
+ *
+ * fmt has to be a string literal, it only exists in the ELF.
+ */
+#define printk_binary(level, fmt, ...)                                                                              \
+	({                                                                                                              \
+		static const char __log_fmt[] __attribute__((section(".logfmt"), used)) = fmt;                              \
+		_Static_assert(LOG_TYPES_COUNT(__VA_ARGS__) == LOG_NARGS(__VA_ARGS__),                                      \
+					   "printk_*() argument can not be deferred to the binary log (at most 8 scalars or strings)"); \
+		log_binary_write((level), __log_fmt, LOG_TYPES(__VA_ARGS__), ##__VA_ARGS__);                                \
+	})
+
+/**
+ * Encode one record and queue it like console output.
+ *
+ * @param level LOG_LEVEL_* of the call.
+ * @param fmt Format string id, never dereferenced.
+ * @param types Argument types from LOG_TYPES().
+ * @param ... The printk arguments.
+ */
+void log_binary_write(int level, const char *fmt, uint32_t types, ...);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __LOG_BINARY_H__
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __LOG_PERSIST_H__
+#define __LOG_PERSIST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/*
+ * Persistent boot log.
+ *
+ * printk() output up to log_capture_level is also kept in a DRAM region that
+ * is not cleared on warm reset. The region uses the ramoops console zone
+ * layout, so after log_persist_fdt_fixup() Linux finds the SyterKit log in
+ * /sys/fs/pstore/console-ramoops-0, and the next SyterKit boot appends to
+ * whatever the previous boot, or Linux, left in it:
+ *
+ *   u32 sig    LOG_PERSIST_SIG
+ *   u32 start  offset in data where the next byte goes
+ *   u32 size   bytes of data in use, the oldest byte is at start once full
+ *   u8  data[] region size - 12 bytes, used as a ring
+ *
+ * Output before log_persist_init() is kept in a small early buffer and moved
+ * over by it. Binary log builds keep nothing, their records are not text.
+ *
+ * Capture is opt-in: printk() only feeds the log when the build defines
+ * CONFIG_LOG_PERSIST (cmake -DENABLE_LOG_PERSIST=ON), and the apps only set
+ * up the region and the ramoops node then.
+ */
+
+#define LOG_PERSIST_SIG 0x43474244 /* "DBGC", PERSISTENT_RAM_SIG of Linux */
+
+/* Bytes kept from before log_persist_init(), the rest is dropped */
+#ifndef CONFIG_LOG_PERSIST_EARLY_SIZE
+#define CONFIG_LOG_PERSIST_EARLY_SIZE 1024
+#endif
+
+typedef struct log_persist_header {
+	uint32_t sig;
+	uint32_t start;
+	uint32_t size;
+	uint8_t data[];
+} log_persist_header_t;
+
+/**
+ * Start capturing into a DRAM region.
+ *
+ * An intact log from an earlier boot is kept and appended to, anything else
+ * is cleared. Call once DRAM and the MMU are up.
+ *
+ * @param base Start of the region, also the address given to Linux.
+ * @param size Size of the region, a power of two as ramoops requires.
+ * @return 0 on success, -1 if the region can not be used.
+ */
+int log_persist_init(unsigned long base, uint32_t size);
+
+/**
+ * Store one byte of printk() output.
+ *
+ * @param c The byte, a newline also writes the captured line back to DRAM.
+ */
+void log_persist_putc(char c);
+
+/**
+ * Check whether printk() output is still captured.
+ *
+ * @return true with a region set up, or while the early buffer has room.
+ */
+bool log_persist_active(void);
+
+/**
+ * Print the captured log, oldest first, straight to the UART.
+ */
+void log_persist_dump(void);
+
+/**
+ * Drop the captured log.
+ */
+void log_persist_clear(void);
+
+/**
+ * Describe the region to Linux as a ramoops node under /reserved-memory.
+ *
+ * Grows the FDT as needed and creates /reserved-memory with the cells of the
+ * root node if the tree has none. Does nothing without log_persist_init().
+ *
+ * @param fdt The FDT handed to the kernel.
+ * @return 0 on success or if there is nothing to add, -1 on error.
+ */
+int log_persist_fdt_fixup(void *fdt);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __LOG_PERSIST_H__
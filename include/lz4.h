@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __LZ4_H__
+#define __LZ4_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/**
+ * @brief Extra room needed after the decompressed data for in-place decompression.
+ *
+ * When the compressed stream is placed at the very end of a buffer of
+ * raw_size + LZ4_DECOMPRESS_INPLACE_MARGIN(comp_size) bytes, decompressing it
+ * to the start of the same buffer never overwrites unread input.
+ */
+#define LZ4_DECOMPRESS_INPLACE_MARGIN(comp_size) (((comp_size) >> 8) + 32)
+
+#define LZ4_STUB_MAGIC "SKLZ4INF"
+
+/**
+ * @brief Information block of the self-decompressing boot0 stub.
+ *
+ * The block lives inside the stub image. stub_size is fixed when the stub is
+ * linked, comp_size and raw_size are filled in by mksunxi when the compressed
+ * payload is appended behind the stub.
+ */
+typedef struct lz4_stub_info {
+	uint8_t magic[8];	/* ="SKLZ4INF" */
+	uint32_t stub_size; /* size reserved for the stub, payload starts here */
+	uint32_t comp_size; /* size of the LZ4 block, generated by mksunxi */
+	uint32_t raw_size;	/* size of the payload once decompressed, generated by mksunxi */
+	uint32_t reserved;
+} lz4_stub_info_t;
+
+/**
+ * @brief Decompress a raw LZ4 block.
+ *
+ * The output may overlap the input as long as the input sits at the end of
+ * the output buffer with LZ4_DECOMPRESS_INPLACE_MARGIN bytes of slack.
+ *
+ * @param src Pointer to the compressed block.
+ * @param src_len Length of the compressed block in bytes.
+ * @param dst Pointer to the output buffer.
+ * @param dst_cap Capacity of the output buffer in bytes.
+ * @return Number of bytes written to dst, or -1 if the block is malformed.
+ */
+int lz4_decompress(const uint8_t *src, uint32_t src_len, uint8_t *dst, uint32_t dst_cap);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __LZ4_H__
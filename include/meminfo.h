@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __MEMINFO_H__
+#define __MEMINFO_H__
+
+#include <stdint.h>
+#include <types.h>
+
+#include "smalloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/* Number of DRAM regions that can be recorded by meminfo_claim() */
+#define MEMINFO_MAX_REGIONS 16
+
+/* Region names are copied and truncated to this length, terminator included */
+#define MEMINFO_NAME_LEN 24
+
+/**
+ * Record a memory region taken by a loader, so that meminfo_dump() can list it.
+ *
+ * Claims that overlap an earlier one are reported with a warning, which makes
+ * a kernel loaded on top of its device tree or initrd visible right away.
+ * Recording is only done when CONFIG_HEAP_STATS is enabled, in release builds
+ * this is an empty inline function.
+ *
+ * @param name A name for the region, e.g. the file that was loaded into it.
+ * @param base The start address of the region.
+ * @param size The size of the region in bytes.
+ */
+#ifdef CONFIG_HEAP_STATS
+void meminfo_claim(const char *name, unsigned long base, unsigned long size);
+#else
+static inline void meminfo_claim(const char *name, unsigned long base, unsigned long size) {
+}
+#endif// CONFIG_HEAP_STATS
+
+/**
+ * Print the static image layout from the linker symbols, the heap usage and
+ * the regions recorded with meminfo_claim(). Like meminfo_claim(), it is an
+ * empty inline function without CONFIG_HEAP_STATS.
+ */
+#ifdef CONFIG_HEAP_STATS
+void meminfo_dump(void);
+#else
+static inline void meminfo_dump(void) {
+}
+#endif// CONFIG_HEAP_STATS
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __MEMINFO_H__
@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __MEMPOOL_H__
+#define __MEMPOOL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/**
+ * @brief Cache attribute of a DRAM region.
+ */
+typedef enum mem_attr {
+	MEM_ATTR_CACHED = 0,   /**< Normal write-back memory, the default for all of DRAM */
+	MEM_ATTR_WRITECOMBINE, /**< Uncached but bufferable, writes may be merged; for framebuffers */
+	MEM_ATTR_UNCACHED,	   /**< Uncached and unbuffered; for DMA descriptors and coherent buffers */
+	MEM_ATTR_COUNT,
+} mem_attr_t;
+
+/**
+ * Change the cache attribute of a memory region.
+ *
+ * Implemented per architecture:
+ * - arm32 rewrites the 1MB section descriptors set up by arm32_mmu_enable(),
+ *   so base and size must be 1MB aligned and the MMU must be enabled.
+ * - riscv32 E907 splits the sysmap regions, base and size must be 4KB aligned.
+ * - riscv64 C906 runs in machine mode where the memory attributes are fixed,
+ *   the default implementation returns -1 for anything but MEM_ATTR_CACHED.
+ *
+ * The data cache is cleaned and invalidated for the region, so no dirty line
+ * is written back over it later.
+ *
+ * @param base The start address of the region.
+ * @param size The size of the region in bytes.
+ * @param attr The new attribute.
+ * @return Zero if successful, -1 if the attribute cannot be applied.
+ */
+int arch_mem_set_attr(unsigned long base, unsigned long size, mem_attr_t attr);
+
+/**
+ * Carve a DRAM region into the allocation pool of the given attribute.
+ *
+ * The attribute is applied to the region first. When the architecture cannot
+ * do that, for example on C906 or with the MMU off, no pool is created and an
+ * error is printed; memory is never handed out with the wrong attribute.
+ * Each attribute has one pool; initializing it again replaces the old one.
+ *
+ * @param attr The attribute of the pool.
+ * @param base The start address of the region, see arch_mem_set_attr() for the alignment.
+ * @param size The size of the region in bytes.
+ * @return Zero if successful, -1 if the attribute cannot be applied or the pool could not be created.
+ */
+int mem_pool_init(mem_attr_t attr, void *base, uint32_t size);
+
+/**
+ * Check whether the pool of the given attribute has been created.
+ *
+ * @param attr The attribute of the pool.
+ * @return True if mem_pool_init() succeeded for that attribute.
+ */
+bool mem_pool_is_ready(mem_attr_t attr);
+
+/**
+ * Allocate memory from the pool of the given attribute.
+ *
+ * @param attr The attribute of the pool.
+ * @param size The number of bytes to allocate.
+ * @param align The alignment in bytes, must be a power of two; 0 means the default 16 byte alignment.
+ * @return A pointer to the allocated memory, or NULL if the pool does not exist or is exhausted.
+ */
+void *mem_pool_alloc(mem_attr_t attr, uint32_t size, uint32_t align);
+
+/**
+ * Free memory obtained from mem_pool_alloc(), the pool is found from the address.
+ *
+ * @param p The pointer to the memory to free.
+ */
+void mem_pool_free(void *p);
+
+/**
+ * Allocate a zeroed buffer that the CPU and DMA masters see the same way
+ * without cache maintenance.
+ *
+ * The buffer comes from the MEM_ATTR_UNCACHED pool and is aligned to a cache
+ * line.
+ *
+ * @param size The number of bytes to allocate.
+ * @param dma_handle Receives the bus address of the buffer, may be NULL.
+ * @return A pointer to the buffer, or NULL if the pool does not exist or is exhausted.
+ */
+void *dma_alloc_coherent(uint32_t size, uint32_t *dma_handle);
+
+/**
+ * Free a buffer obtained from dma_alloc_coherent().
+ *
+ * @param p The pointer to the buffer.
+ */
+void dma_free_coherent(void *p);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __MEMPOOL_H__
@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/*
+ * Sampling profiler.
+ *
+ * A periodic timer interrupt records the interrupted PC together with the
+ * return address register into a histogram of (pc, ra) pairs, so a slow boot
+ * can be looked at without adding printk() everywhere. The timer is the
+ * secure physical arch timer on arm32 chips with a GIC, and the CLINT
+ * mtimecmp on the C906.
+ *
+ * Sampling can start before DRAM is up, it then fills a small table in the
+ * image until profile_set_buffer() moves it to DRAM. profile_dump() prints
+ * the histogram, tools/profile.py resolves it against the app ELF:
+ *
+ *   profile: 2048 samples at 1000 Hz, 311 entries, 0 dropped
+ *   0x40005e64 0x40005f10 412
+ *
+ * The ra column is the link register at the time of the sample. In a leaf
+ * function it is the caller, anywhere else it may be stale.
+ */
+
+#define PROFILE_MAGIC 0x464f5250 /* "PROF" */
+
+#ifndef CONFIG_PROFILE_HZ
+#define CONFIG_PROFILE_HZ 1000
+#endif
+
+/* Slots of the table used before profile_set_buffer(), a power of two */
+#ifndef CONFIG_PROFILE_EARLY_ENTRIES
+#define CONFIG_PROFILE_EARLY_ENTRIES 128
+#endif
+
+typedef struct profile_entry {
+	uint32_t pc;
+	uint32_t ra;
+	uint32_t count; /* 0 for a free slot */
+} profile_entry_t;
+
+/**
+ * Start sampling.
+ *
+ * The histogram is cleared first. Needs the interrupt controller set up by
+ * arch_interrupt_init() on arm32, unmasks the CPU interrupt.
+ *
+ * @param hz Samples per second, 0 for CONFIG_PROFILE_HZ.
+ * @return 0 on success, -1 if this chip has no profiler timer.
+ */
+int profile_start(uint32_t hz);
+
+/**
+ * Stop sampling, the histogram is kept for profile_dump().
+ */
+void profile_stop(void);
+
+/**
+ * Move the histogram to a larger buffer, usually in DRAM.
+ *
+ * Samples taken so far are carried over, so sampling can run across DRAM
+ * init. The buffer is used until the next call.
+ *
+ * @param buf The buffer.
+ * @param size Size of the buffer in bytes, at least a few KiB.
+ * @return 0 on success, -1 if the buffer is too small.
+ */
+int profile_set_buffer(void *buf, uint32_t size);
+
+/**
+ * Check whether the timer is sampling.
+ *
+ * @return true between profile_start() and profile_stop().
+ */
+bool profile_running(void);
+
+/**
+ * Print the histogram for tools/profile.py, one "pc ra count" line per slot.
+ */
+void profile_dump(void);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __PROFILE_H__
@@ -10,18 +10,42 @@
 extern "C" {
 #endif// __cplusplus
 
-struct alloc_struct_t {
-	phys_addr_t address;
-	uint32_t size;
-	uint32_t o_size;
-	struct alloc_struct_t *next;
-};
-
 #define BYTE_ALIGN(x) (((x + 15) / 16) * 16)
 
+/*
+ * Debug and trace builds keep allocation counters and tag every block with
+ * the function that allocated it. Release builds leave the allocator fast
+ * path untouched and smalloc_dump() and meminfo_dump() are empty inlines;
+ * only smalloc_get_stats() still returns the heap-walk figures there.
+ */
+#if defined(DEBUG_MODE) || defined(TRACE_MODE)
+#define CONFIG_HEAP_STATS
+#endif
+
+/**
+ * @brief Heap usage snapshot returned by smalloc_get_stats().
+ */
+typedef struct smalloc_stats {
+	unsigned long heap_start;	/**< First byte managed by the allocator */
+	unsigned long heap_size;	/**< Bytes managed by the allocator, headers included */
+	unsigned long used;			/**< Payload bytes in allocated blocks */
+	unsigned long free;			/**< Payload bytes in free blocks */
+	unsigned long largest_free; /**< Largest single allocation that can still succeed */
+	uint32_t used_blocks;		/**< Number of allocated blocks */
+	uint32_t free_blocks;		/**< Number of free blocks, a measure of fragmentation */
+	unsigned long peak;			/**< Highest value used has reached (CONFIG_HEAP_STATS only) */
+	uint32_t allocs;			/**< Successful allocations since init (CONFIG_HEAP_STATS only) */
+	uint32_t failures;			/**< Failed allocations since init (CONFIG_HEAP_STATS only) */
+} smalloc_stats_t;
+
 /**
  * Initialize the simple malloc library with the specified heap parameters.
  *
+ * The heap is managed as a two-level segregated fit allocator: smalloc and
+ * sfree run in bounded time regardless of the number of live blocks, freed
+ * blocks are merged with their free neighbours immediately, and every block
+ * carries a 16 byte header. Returned pointers are 16 byte aligned.
+ *
  * @param p_heap_head The starting address of the heap.
  * @param n_heap_size The size of the heap in bytes.
  * @return Zero if successful, non-zero otherwise.
@@ -36,12 +60,25 @@ int32_t smalloc_init(uint32_t p_heap_head, uint32_t n_heap_size);
  */
 void *smalloc(uint32_t num_bytes);
 
+/**
+ * Allocate a block of memory from the heap whose address is a multiple of the given alignment.
+ *
+ * @param align The alignment in bytes, must be a power of two (e.g. a cache line for DMA buffers).
+ * @param num_bytes The number of bytes to allocate.
+ * @return A pointer to the allocated memory block, or NULL if allocation fails.
+ */
+void *smemalign(uint32_t align, uint32_t num_bytes);
+
 /**
  * Reallocate a block of memory with the specified new size.
  *
+ * The block is resized in place when possible, otherwise the contents are
+ * copied to a new block and the old one is freed. A size of zero frees the
+ * block.
+ *
  * @param p The pointer to the memory block to reallocate.
- * @param num_bytes The new size in bytes.
- * @return A pointer to the reallocated memory block, or NULL if reallocation fails.
+ * @param num_bytes The new total size in bytes.
+ * @return A pointer to the reallocated memory block, or NULL if reallocation fails or num_bytes is zero.
  */
 void *srealloc(void *p, uint32_t num_bytes);
 
@@ -52,6 +89,74 @@ void *srealloc(void *p, uint32_t num_bytes);
  */
 void sfree(void *p);
 
+/**
+ * @brief A separate heap with its own free lists, see smalloc_pool_create().
+ */
+typedef struct tlsf_control_t smalloc_pool_t;
+
+/**
+ * Create an independent heap over the given memory region.
+ *
+ * The bookkeeping of the pool is stored at the start of the region, so no
+ * static memory is used per pool. Pools serve memory that needs to stay
+ * apart from the main heap, such as regions with special cache attributes.
+ *
+ * @param mem The start address of the region.
+ * @param size The size of the region in bytes.
+ * @return The pool, or NULL if the region is too small.
+ */
+smalloc_pool_t *smalloc_pool_create(void *mem, uint32_t size);
+
+/**
+ * Allocate a block of memory from a pool.
+ *
+ * @param pool The pool to allocate from.
+ * @param num_bytes The number of bytes to allocate.
+ * @param align The alignment in bytes, must be a power of two; 0 means the default 16 byte alignment.
+ * @return A pointer to the allocated memory block, or NULL if allocation fails.
+ */
+void *smalloc_pool_alloc(smalloc_pool_t *pool, uint32_t num_bytes, uint32_t align);
+
+/**
+ * Return a block of memory to the pool it was allocated from.
+ *
+ * @param pool The pool the block belongs to.
+ * @param p The pointer to the memory block to free.
+ */
+void smalloc_pool_free(smalloc_pool_t *pool, void *p);
+
+/**
+ * Collect heap usage figures.
+ *
+ * Walks every block of the heap, so the cost is proportional to the number
+ * of blocks. Intended for diagnostics, not for the allocation path.
+ *
+ * @param stats Filled with the current figures.
+ */
+void smalloc_get_stats(smalloc_stats_t *stats);
+
+/**
+ * Print a summary of the heap followed by every block with the function
+ * that allocated it. An empty inline function without CONFIG_HEAP_STATS.
+ */
+#ifdef CONFIG_HEAP_STATS
+void smalloc_dump(void);
+#else
+static inline void smalloc_dump(void) {
+}
+#endif// CONFIG_HEAP_STATS
+
+#ifdef CONFIG_HEAP_STATS
+void *smalloc_tagged(uint32_t num_bytes, const char *tag);
+void *smemalign_tagged(uint32_t align, uint32_t num_bytes, const char *tag);
+void *srealloc_tagged(void *p, uint32_t num_bytes, const char *tag);
+
+/* Record the calling function as the owner of each block */
+#define smalloc(n) smalloc_tagged((n), __func__)
+#define smemalign(a, n) smemalign_tagged((a), (n), __func__)
+#define srealloc(p, n) srealloc_tagged((p), (n), __func__)
+#endif// CONFIG_HEAP_STATS
+
 #ifdef __cplusplus
 }
 #endif// __cplusplus
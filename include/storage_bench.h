@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __STORAGE_BENCH_H__
+#define __STORAGE_BENCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+
+#include <sys-sdcard.h>
+#include <sys-spi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif// __cplusplus
+
+/*
+ * Read throughput and latency of the boot media.
+ *
+ * An app registers the media it has as targets, the "bench" shell command
+ * (ENABLE_STORAGE_BENCH) then sweeps the block size from min to max, doubling
+ * it, over sequential and random offsets, every mode of the target (SMHC
+ * clock, SPI clock and I/O mode) and DMA vs FIFO transfers. Every point
+ * reads about STORAGE_BENCH_BYTES and prints one CSV line:
+ *
+ *   bench,target,mode,xfer,pattern,block,ops,bytes,us,kib_s,min_us,p50_us,p90_us,p99_us,max_us
+ *
+ * "bench dma" instead times DRAM to DRAM copies by the CPU and by the DMA
+ * controller, to pick SUNXI_DMA_MEMCPY_THRESHOLD.
+ *
+ * The random offsets come from a fixed seed, so runs on different boards or
+ * firmware read the same blocks and their output can be diffed.
+ */
+
+#define STORAGE_BENCH_MAX_TARGETS 4
+
+/* Reads timed per point, for the percentiles */
+#define STORAGE_BENCH_MAX_OPS 1024
+
+/* Bytes read per point, at least one block */
+#define STORAGE_BENCH_BYTES (4 * 1024 * 1024)
+
+#define STORAGE_BENCH_MIN_BLOCK 512
+#define STORAGE_BENCH_MAX_BLOCK (16 * 1024 * 1024)
+
+enum {
+	STORAGE_BENCH_SEQ = 1 << 0,
+	STORAGE_BENCH_RAND = 1 << 1,
+	STORAGE_BENCH_DMA = 1 << 2,
+	STORAGE_BENCH_PIO = 1 << 3,
+};
+
+typedef struct storage_bench_target storage_bench_target_t;
+
+struct storage_bench_target {
+	const char *name;
+	void *priv;
+	uint64_t size; /* bytes from offset 0 the benchmark may read */
+	uint32_t align; /* offsets are multiples of this */
+	uint32_t flags; /* patterns and transfers the target supports */
+
+	/**
+	 * Read len bytes at offset.
+	 *
+	 * @return 0 on success, -1 on failure.
+	 */
+	int (*read)(storage_bench_target_t *target, uint64_t offset, void *buf, uint32_t len);
+
+	/**
+	 * Name mode n, NULL for a target with a single mode.
+	 *
+	 * @return 0 on success, -1 past the last mode.
+	 */
+	int (*mode_name)(storage_bench_target_t *target, uint32_t n, char *name, uint32_t len);
+
+	/**
+	 * Switch to mode n.
+	 *
+	 * @return 0 on success, -1 if the mode does not work here.
+	 */
+	int (*set_mode)(storage_bench_target_t *target, uint32_t n);
+
+	/* Called untimed before sequential reads start over at offset 0, optional */
+	void (*rewind)(storage_bench_target_t *target);
+
+	/* Go back to the mode the target was registered in, optional */
+	void (*restore)(storage_bench_target_t *target);
+
+	/* Use the FIFO instead of DMA, optional */
+	void (*set_pio)(storage_bench_target_t *target, bool pio);
+};
+
+typedef struct storage_bench_params {
+	const char *mode;	/* only the mode of this name, NULL for all */
+	uint32_t flags;		/* STORAGE_BENCH_SEQ | ..., 0 for all */
+	uint32_t min_block; /* 0 for STORAGE_BENCH_MIN_BLOCK */
+	uint32_t max_block; /* 0 for STORAGE_BENCH_MAX_BLOCK */
+} storage_bench_params_t;
+
+/**
+ * Set the buffer the benchmark reads into.
+ *
+ * @param buf The buffer, in DRAM, blocks larger than it are skipped.
+ * @param size Size of the buffer in bytes.
+ */
+void storage_bench_set_buffer(void *buf, uint32_t size);
+
+/**
+ * Register a target for the bench command.
+ *
+ * @param target The target, kept by reference, registering it again does nothing.
+ * @return 0 on success, -1 if the table is full.
+ */
+int storage_bench_register(storage_bench_target_t *target);
+
+/**
+ * Find a registered target.
+ *
+ * @param name Name of the target.
+ * @return The target, or NULL if there is none of that name.
+ */
+storage_bench_target_t *storage_bench_find(const char *name);
+
+/**
+ * Print the registered targets and their modes.
+ */
+void storage_bench_list(void);
+
+/**
+ * Run the sweep on a target and print a CSV line per point.
+ *
+ * @param target The target, NULL for every registered one.
+ * @param params What to sweep, NULL for everything.
+ * @return 0 on success, -1 if a read failed or nothing was run.
+ */
+int storage_bench_run(storage_bench_target_t *target, const storage_bench_params_t *params);
+
+/**
+ * Compare CPU memcpy with DMA memcpy, see sunxi_dma_bench().
+ *
+ * The buffer is split in a source and a destination half, so sizes go up
+ * to half of it. The DMA must have been initialized by the app.
+ *
+ * @param max_len Largest size to measure, 0 for half the buffer.
+ * @return 0 on success, -1 if there is no buffer.
+ */
+int storage_bench_dma(uint32_t max_len);
+
+/**
+ * Register an initialized SD/MMC card, named "sdmmc".
+ *
+ * Its modes are the SMHC clocks, the card is initialized again for each.
+ *
+ * @param card The card, after sdmmc_init().
+ * @param size Bytes from the start of the card to read, 0 for all of it.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_bench_add_sdmmc(sdmmc_pdata_t *card, uint64_t size);
+
+/**
+ * Register a detected SPI NAND, named "spi-nand".
+ *
+ * Its modes are the SPI clocks in each I/O mode up to the one of the chip.
+ *
+ * @param spi The SPI controller, after spi_nand_detect().
+ * @param size Bytes from the start of the flash to read, 0 for all of it.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_bench_add_spi_nand(sunxi_spi_t *spi, uint32_t size);
+
+/**
+ * Register a detected SPI NOR, named "spi-nor".
+ *
+ * Its modes are the SPI clocks, the driver reads in single I/O mode.
+ *
+ * @param spi The SPI controller, after spi_nor_detect().
+ * @param size Bytes from the start of the flash to read, 0 for all of it.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_bench_add_spi_nor(sunxi_spi_t *spi, uint32_t size);
+
+/**
+ * Register a file on the FAT file system of the SD card, named "fatfs".
+ *
+ * Read with f_read() through the whole FatFs stack. f_lseek() is not built,
+ * so only sequential reads are run, from the start of the file. Adding
+ * another file replaces the previous one.
+ *
+ * @param path Path of the file, the volume is mounted with a work area of its own.
+ * @return 0 on success, -1 if the file cannot be opened.
+ */
+int storage_bench_add_fatfs(const char *path);
+
+#ifdef __cplusplus
+}
+#endif// __cplusplus
+
+#endif// __STORAGE_BENCH_H__
@@ -46,7 +46,12 @@ int memcmp(const void *dst, const void *src, unsigned int cnt) __attribute__((op
  * @param str The input string.
  * @return The length of the input string.
  */
-unsigned int strlen(const char *str) __attribute__((optimize("O0")));
+unsigned int strlen(const char *str) __attribute__((optimize("no-tree-loop-distribute-patterns")));
+
+/**
+ * Portable strlen(), reachable even when architecture code overrides strlen().
+ */
+unsigned int strlen_generic(const char *str) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Calculates the length of the string 's', but not more than 'n' characters.
@@ -55,7 +60,7 @@ unsigned int strlen(const char *str) __attribute__((optimize("O0")));
  * @param n The maximum number of characters to examine.
  * @return The length of the input string, but not more than 'n'.
  */
-unsigned int strnlen(const char *s, unsigned int n) __attribute__((optimize("O0")));
+unsigned int strnlen(const char *s, unsigned int n) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Copies the string pointed to by 'src', including the terminating null byte, to the buffer pointed to by 'dst'.
@@ -92,7 +97,7 @@ char *strcat(char *dst, const char *src) __attribute__((optimize("O0")));
  * @param p2 The second string to compare.
  * @return An integer less than, equal to, or greater than zero if 'p1' is found, respectively, to be less than, to match, or be greater than 'p2'.
  */
-int strcmp(const char *p1, const char *p2) __attribute__((optimize("O0")));
+int strcmp(const char *p1, const char *p2) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Compares at most the first 'cnt' characters of the string pointed to by 'p1' to the string pointed to by 'p2'.
@@ -102,7 +107,7 @@ int strcmp(const char *p1, const char *p2) __attribute__((optimize("O0")));
  * @param cnt The maximum number of characters to compare.
  * @return An integer less than, equal to, or greater than zero if 'p1' is found, respectively, to be less than, to match, or be greater than 'p2'.
  */
-int strncmp(const char *p1, const char *p2, unsigned int cnt) __attribute__((optimize("O0")));
+int strncmp(const char *p1, const char *p2, unsigned int cnt) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Finds the first occurrence of the character 'c' (converted to a char) in the string pointed to by 's', including the terminating null byte.
@@ -111,7 +116,7 @@ int strncmp(const char *p1, const char *p2, unsigned int cnt) __attribute__((opt
  * @param c The character to search for.
  * @return A pointer to the located character, or NULL if the character does not occur in the string.
  */
-char *strchr(const char *s, int c) __attribute__((optimize("O0")));
+char *strchr(const char *s, int c) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Finds the last occurrence of the character 'c' (converted to a char) in the string pointed to by 's', including the terminating null byte.
@@ -120,7 +125,7 @@ char *strchr(const char *s, int c) __attribute__((optimize("O0")));
  * @param c The character to search for.
  * @return A pointer to the located character, or NULL if the character does not occur in the string.
  */
-char *strrchr(const char *s, int c) __attribute__((optimize("O0")));
+char *strrchr(const char *s, int c) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Finds the first occurrence of the substring 'what' in the string 's'.
@@ -129,7 +134,7 @@ char *strrchr(const char *s, int c) __attribute__((optimize("O0")));
  * @param what The substring to search for.
  * @return A pointer to the beginning of the located substring, or NULL if the substring does not occur in the string.
  */
-char *strstr(const char *s, const char *what) __attribute__((optimize("O0")));
+char *strstr(const char *s, const char *what) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Locates the first occurrence of the character 'value' (converted to an unsigned char) in the first 'num' bytes of the memory area pointed to by 'ptr'.
@@ -139,7 +144,12 @@ char *strstr(const char *s, const char *what) __attribute__((optimize("O0")));
  * @param num The number of bytes to examine.
  * @return A pointer to the located character, or NULL if the character does not occur in the memory area.
  */
-void *memchr(void *ptr, int value, unsigned int num) __attribute__((optimize("O0")));
+void *memchr(void *ptr, int value, unsigned int num) __attribute__((optimize("no-tree-loop-distribute-patterns")));
+
+/**
+ * Portable memchr(), reachable even when architecture code overrides memchr().
+ */
+void *memchr_generic(void *ptr, int value, unsigned int num) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 /**
  * Copies 'count' bytes from the memory area 'src' to the memory area 'dest'. The memory areas may overlap.
@@ -149,7 +159,7 @@ void *memchr(void *ptr, int value, unsigned int num) __attribute__((optimize("O0
  * @param count The number of bytes to copy.
  * @return A pointer to the destination memory area.
  */
-void *memmove(void *dest, const void *src, unsigned int count) __attribute__((optimize("O0")));
+void *memmove(void *dest, const void *src, unsigned int count) __attribute__((optimize("no-tree-loop-distribute-patterns")));
 
 #ifdef CONFIG_SPRINTF
 /**
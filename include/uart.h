@@ -45,6 +45,15 @@ char get_uart_input(void);
  */
 void uart_log_putchar(void *arg, char c);
 
+/**
+ * Writes 'len' characters from 's' to the log output, as one span.
+ *
+ * @param arg A pointer to optional arguments.
+ * @param s The characters to be written.
+ * @param len The number of characters.
+ */
+void uart_log_write(void *arg, const char *s, unsigned len);
+
 /**
  * Tests whether a character is waiting in the UART input buffer.
  *
@@ -42,6 +42,21 @@ extern "C" {
  */
 #define XCFG_FORMAT_LONGLONG 1
 
+/**
+ * Define XCFG_FORMAT_FAST_DECIMAL=0 to convert decimal numbers one digit per
+ * division instead of two, saves a 200 byte table.
+ */
+#ifndef XCFG_FORMAT_FAST_DECIMAL
+#define XCFG_FORMAT_FAST_DECIMAL 1
+#endif
+
+/**
+ * Size of the stack buffer xvformat_span() collects output in.
+ */
+#ifndef XCFG_FORMAT_SPAN
+#define XCFG_FORMAT_SPAN 64
+#endif
+
 /**
  * Formats and outputs a string according to a format string 'fmt' and a variable argument list 'args'.
  * The output is written character by character using a user-defined output function 'outchar'.
@@ -54,6 +69,19 @@ extern "C" {
  */
 unsigned xvformat(void (*outchar)(void *arg, char), void *arg, const char *fmt, va_list args);
 
+/**
+ * Same as xvformat(), but the output is handed over in spans of up to
+ * XCFG_FORMAT_SPAN characters, for outputs with a cost per call such as a
+ * locked ring buffer.
+ *
+ * @param outspan The output function that writes 'len' characters from 's'.
+ * @param arg A pointer to optional arguments for the output function.
+ * @param fmt The format string specifying the output format.
+ * @param args The variable argument list containing the values to be formatted and output.
+ * @return The number of characters written.
+ */
+unsigned xvformat_span(void (*outspan)(void *arg, const char *s, unsigned len), void *arg, const char *fmt, va_list args);
+
 /**
  * Formats and outputs a string according to a format string 'fmt' and an arbitrary number of variable arguments.
  * The output is written character by character using a user-defined output function 'outchar'.
@@ -64,11 +64,7 @@ int load_elf64_image(phys_addr_t img_addr) {
 		if ((phdr->p_memsz == 0) || (phdr->p_filesz == 0))
 			continue;
 
-		if (phdr->p_filesz)
-			memcpy(dst, src, phdr->p_filesz);
-
-		if (phdr->p_filesz != phdr->p_memsz)
-			memset((u8 *) dst + phdr->p_filesz, 0x00, phdr->p_memsz - phdr->p_filesz);
+		elf_load_segment(dst, src, phdr->p_filesz, phdr->p_memsz);
 	}
 
 	return 0;
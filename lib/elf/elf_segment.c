@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <types.h>
+
+#include <elf_loader.h>
+
+#include <log.h>
+
+#include <sys-dma.h>
+
+/**
+ * @brief Place one program segment
+ * @details The file part is moved by sunxi_dma_memcpy_async(), which does it on
+ *          the CPU when the DMA is not initialized or the segment is small. The
+ *          CPU copies the file part again if the DMA fails, and clears the rest
+ *          of the segment only once the DMA is done: the first BSS bytes can
+ *          share a cache line with the end of the file part, which the wait
+ *          invalidates, and the CPU must not dirty lines the DMA is writing.
+ * @param dst Load address of the segment
+ * @param src Segment data in the image
+ * @param filesz Bytes of the segment in the image
+ * @param memsz Bytes of the segment in memory
+ */
+void elf_load_segment(void *dst, const void *src, uint32_t filesz, uint32_t memsz) {
+	sunxi_dma_async_t req;
+
+	sunxi_dma_memcpy_async(&req, dst, src, filesz);
+
+	if (sunxi_dma_async_wait(&req, 100 + filesz / (64 * 1024))) {
+		printk_warning("ELF: DMA copy to 0x%08x failed, copying by CPU\n", (uint32_t) dst);
+		memcpy(dst, src, filesz);
+	}
+
+	if (filesz != memsz)
+		memset((u8 *) dst + filesz, 0x00, memsz - filesz);
+}
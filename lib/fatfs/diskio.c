@@ -6,6 +6,8 @@
 /* This is an example of glue functions to attach various exsisting      */
 /* storage control modules to the FatFs module with a defined API.       */
 /*-----------------------------------------------------------------------*/
+#define LOG_MODULE LOG_MODULE_FATFS
+
 #include "ff.h" /* Obtains integer types */
 
 #include "diskio.h"
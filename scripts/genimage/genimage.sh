@@ -4,13 +4,13 @@ die() {
   cat <<EOF >&2
 Error: $@
 
-Usage: ${0} -c GENIMAGE_CONFIG_FILE
+Usage: ${0} -c GENIMAGE_CONFIG_FILE [-p BOOTPACK_LIST]
 EOF
   exit 1
 }
 
 # Parse arguments and put into argument list of the script
-opts="$(getopt -n "${0##*/}" -o c: -- "$@")" || exit $?
+opts="$(getopt -n "${0##*/}" -o c:p: -- "$@")" || exit $?
 eval set -- "$opts"
 
 GENIMAGE_TMP="${BUILD_DIR}/genimage.tmp"
@@ -20,6 +20,9 @@ while true ; do
 	-c)
 	  GENIMAGE_CFG="${2}";
 	  shift 2 ;;
+	-p)
+	  BOOTPACK_LIST="${2}";
+	  shift 2 ;;
 	--) # Discard all non-option parameters
 	  shift 1;
 	  break ;;
@@ -30,6 +33,14 @@ done
 
 [ -n "${GENIMAGE_CFG}" ] || die "Missing argument"
 
+# Pack the payloads listed in BOOTPACK_LIST into ${BINARIES_DIR}/boot.pack,
+# file paths in the list are relative to BINARIES_DIR
+if [ -n "${BOOTPACK_LIST}" ]; then
+	MKBOOTPACK="$(dirname "$(readlink -f "${0}")")/../../tools/mkbootpack"
+	BOOTPACK_LIST="$(readlink -f "${BOOTPACK_LIST}")"
+	(cd "${BINARIES_DIR}" && "${MKBOOTPACK}" -f "${BOOTPACK_LIST}" -o boot.pack) || die "mkbootpack failed"
+fi
+
 # Pass an empty rootpath. genimage makes a full copy of the given rootpath to
 # ${GENIMAGE_TMP}/root so passing TARGET_DIR would be a waste of time and disk
 # space. We don't rely on genimage to build the rootfs image, just to insert a
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <barrier.h>
+#include <string.h>
+
+#include <cpufeature.h>
+#include <crc32.h>
+
+#define CPACR_CP10_CP11 (0xf << 20) /* full access to the VFP/NEON coprocessors */
+#define FPEXC_EN (1 << 30)
+
+#define ID_FIELD(reg, shift) (((reg) >> (shift)) & 0xf)
+
+#ifdef CONFIG_NEON_STRING
+/* string_dispatch.S owns the public names, these are the two variants */
+extern void *memcpy_arm(void *dst, const void *src, int len);
+extern void *memset_arm(void *dst, int val, int len);
+extern int memcmp_arm(const void *dst, const void *src, unsigned int len);
+extern void *memcpy_neon(void *dst, const void *src, int len);
+extern void *memset_neon(void *dst, int val, int len);
+extern int memcmp_neon(const void *dst, const void *src, unsigned int len);
+#else
+#define memcpy_arm memcpy
+#define memset_arm memset
+#define memcmp_arm memcmp
+#endif
+
+extern uint32_t crc32_armv8(uint32_t crc, const void *buf, uint32_t len);
+
+cpu_dispatch_t cpu_dispatch = {
+		.memcpy = memcpy_arm,
+		.memset = memset_arm,
+		.memcmp = memcmp_arm,
+		.strlen = strlen,
+		.memchr = memchr,
+		.crc32 = crc32_generic,
+};
+
+/*
+ * The FPU is probed by asking for coprocessor access: CPACR bits of absent
+ * coprocessors read back as zero. Only then is it safe to touch FPEXC and the
+ * media feature registers.
+ */
+static uint32_t arm32_probe_fpu(void) {
+	uint32_t cpacr, mvfr0, mvfr1, features = 0;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 2"
+				 : "=r"(cpacr));
+	asm volatile("mcr p15, 0, %0, c1, c0, 2"
+				 :
+				 : "r"(cpacr | CPACR_CP10_CP11));
+	isb();
+	asm volatile("mrc p15, 0, %0, c1, c0, 2"
+				 : "=r"(cpacr));
+	if ((cpacr & CPACR_CP10_CP11) != CPACR_CP10_CP11)
+		return 0;
+
+	asm volatile("vmsr fpexc, %0"
+				 :
+				 : "r"(FPEXC_EN));
+	asm volatile("vmrs %0, mvfr0"
+				 : "=r"(mvfr0));
+	asm volatile("vmrs %0, mvfr1"
+				 : "=r"(mvfr1));
+
+	if (ID_FIELD(mvfr0, 4))
+		features |= CPU_FEATURE_FPU;
+	if (ID_FIELD(mvfr0, 8))
+		features |= CPU_FEATURE_FPU_DP;
+	/* SIMD load/store and integer, all the string routines need */
+	if (ID_FIELD(mvfr1, 8) && ID_FIELD(mvfr1, 12))
+		features |= CPU_FEATURE_NEON;
+
+	return features;
+}
+
+void cpu_features_init(void) {
+	static bool probed;
+	uint32_t isar0, isar5;
+
+	if (probed)
+		return;
+	probed = true;
+
+	cpu_features = arm32_probe_fpu();
+
+	asm volatile("mrc p15, 0, %0, c0, c2, 0"
+				 : "=r"(isar0));
+	asm volatile("mrc p15, 0, %0, c0, c2, 5"
+				 : "=r"(isar5));
+
+	/* Divide_instrs counts Thumb first, which the C code is built for */
+	if (ID_FIELD(isar0, 24))
+		cpu_features |= CPU_FEATURE_IDIV;
+	/* ID_ISAR5 is RES0 before ARMv8 */
+	if (ID_FIELD(isar5, 16))
+		cpu_features |= CPU_FEATURE_CRC32;
+
+#ifdef CONFIG_NEON_STRING
+	if (cpu_has_feature(CPU_FEATURE_NEON)) {
+		cpu_dispatch.memcpy = memcpy_neon;
+		cpu_dispatch.memset = memset_neon;
+		cpu_dispatch.memcmp = memcmp_neon;
+	}
+#endif
+
+	if (cpu_has_feature(CPU_FEATURE_CRC32))
+		cpu_dispatch.crc32 = crc32_armv8;
+}
@@ -48,6 +48,7 @@ void __attribute__((weak)) arm32_do_undefined_instruction(struct arm_regs_t *reg
 	printk_error("undefined_instruction\n");
 	show_regs(regs);
 	regs->pc += 4;
+	log_flush();
 	abort();
 }
 
@@ -55,6 +56,7 @@ void __attribute__((weak)) arm32_do_software_interrupt(struct arm_regs_t *regs)
 	printk_error("software_interrupt\n");
 	show_regs(regs);
 	regs->pc += 4;
+	log_flush();
 	abort();
 }
 
@@ -62,6 +64,7 @@ void __attribute__((weak)) arm32_do_prefetch_abort(struct arm_regs_t *regs) {
 	printk_error("prefetch_abort\n");
 	show_regs(regs);
 	regs->pc += 4;
+	log_flush();
 	abort();
 }
 
@@ -69,17 +72,20 @@ void __attribute__((weak)) arm32_do_data_abort(struct arm_regs_t *regs) {
 	printk_error("data_abort\n");
 	show_regs(regs);
 	regs->pc += 4;
+	log_flush();
 	abort();
 }
 
 void __attribute__((weak)) arm32_do_irq(struct arm_regs_t *regs) {
 	printk_error("undefined IRQ\n");
 	show_regs(regs);
+	log_flush();
 	abort();
 }
 
 void __attribute__((weak)) arm32_do_fiq(struct arm_regs_t *regs) {
 	printk_error("undefined FIQ\n");
 	show_regs(regs);
+	log_flush();
 	abort();
 }
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+
+#include <cache.h>
+#include <mmu.h>
+
+#include <mempool.h>
+
+/* Short-descriptor section entry, the layout arm32_mmu_enable() uses */
+#define SECTION_SHIFT 20
+#define SECTION_SIZE (1UL << SECTION_SHIFT)
+#define SECTION_TYPE 0x2
+#define SECTION_B (1 << 2)
+#define SECTION_C (1 << 3)
+#define SECTION_DOMAIN (15 << 5)
+#define SECTION_AP_RW (3 << 10)
+#define SECTION_TEX(x) ((x) << 12)
+
+/* TEX remap is off, so TEX[2:0], C and B encode the memory type directly */
+#ifdef CONFIG_CHIP_DCACHE
+#define SECTION_ATTR_CACHED (SECTION_C | SECTION_B)
+#else
+#define SECTION_ATTR_CACHED (SECTION_C)
+#endif
+/* Normal memory, outer and inner non-cacheable; the write buffer may merge stores */
+#define SECTION_ATTR_NORMAL_NC (SECTION_TEX(1))
+
+int arch_mem_set_attr(unsigned long base, unsigned long size, mem_attr_t attr) {
+	uint32_t *page_table, ttbr, desc_attr;
+	unsigned long i;
+
+	if ((base | size) & (SECTION_SIZE - 1) || !size)
+		return -1;
+
+	/* Without the MMU there are no descriptors to change */
+	if (!(arm32_read_p15_c1() & 1))
+		return -1;
+
+	switch (attr) {
+		case MEM_ATTR_CACHED:
+			desc_attr = SECTION_ATTR_CACHED;
+			break;
+		/*
+		 * Device and strongly-ordered memory fault on unaligned accesses,
+		 * which memcpy and memset into buffers rely on, so uncached
+		 * buffers use normal non-cacheable memory as Linux does.
+		 */
+		case MEM_ATTR_WRITECOMBINE:
+		case MEM_ATTR_UNCACHED:
+			desc_attr = SECTION_ATTR_NORMAL_NC;
+			break;
+		default:
+			return -1;
+	}
+
+	asm volatile("mrc p15, 0, %0, c2, c0, 0"
+				 : "=r"(ttbr));
+	page_table = (uint32_t *) (ttbr & ~0x3fffUL);
+
+	/* Write dirty lines back while they are still reachable as cacheable */
+	flush_dcache_range(base, base + size);
+
+	for (i = base >> SECTION_SHIFT; i < (base + size) >> SECTION_SHIFT; i++)
+		page_table[i] = (i << SECTION_SHIFT) | SECTION_AP_RW | SECTION_DOMAIN | desc_attr | SECTION_TYPE;
+
+	flush_dcache_range((unsigned long) &page_table[base >> SECTION_SHIFT], (unsigned long) &page_table[(base + size) >> SECTION_SHIFT]);
+
+	/* Invalidate the TLB and the branch predictor */
+	asm volatile("mcr p15, 0, %0, c8, c7, 0"
+				 :
+				 : "r"(0));
+	asm volatile("mcr p15, 0, %0, c7, c5, 6"
+				 :
+				 : "r"(0));
+	asm volatile("dsb");
+	asm volatile("isb");
+
+	/* Drop lines speculatively filled before the new attribute took effect */
+	flush_dcache_range(base, base + size);
+
+	printk_trace("MMU: 0x%08lx-0x%08lx attr %d\n", base, base + size, attr);
+
+	return 0;
+}
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <types.h>
 
+#include <div64.h>
 #include <log.h>
 
 #include <timer.h>
@@ -34,14 +35,14 @@ uint64_t get_arch_counter(void) {
  * get current time.(millisecond)
  */
 uint32_t time_ms(void) {
-	return get_arch_counter() / 24000;
+	return (uint32_t) div_u64_u16(get_arch_counter(), 24000);
 }
 
 /*
  * get current time.(microsecond)
  */
 uint64_t time_us(void) {
-	return get_arch_counter() / (uint64_t) 24;
+	return div_u64_u16(get_arch_counter(), 24);
 }
 
 void udelay(uint32_t us) {
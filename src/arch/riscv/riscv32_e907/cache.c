@@ -15,6 +15,8 @@
 #include <common.h>
 #include <log.h>
 
+#include <mempool.h>
+
 #include <e907/sysmap.h>
 
 /* #define DEBUG_SYSMAP */
@@ -133,6 +135,113 @@ int sysmap_add_mem_region(uint32_t start_addr, uint32_t len, uint32_t mem_attr)
 	return SYSMAP_RET_OK;
 }
 
+/*
+ * Give [start_addr, start_addr + len) its own attribute by rebuilding the
+ * region table: the regions it overlaps are cut around it and neighbours
+ * that end up with the same attribute are merged again.
+ */
+static int sysmap_set_mem_region_attr(uint32_t start_addr, uint32_t len, uint32_t mem_attr) {
+	uint32_t limit[SYSMAP_REGION_NUM + 2], attr[SYSMAP_REGION_NUM + 2];
+	uint32_t end_addr = start_addr + len;
+	uint32_t base = 0, top, cur_attr, n = 0, i, w;
+	bool placed = false;
+
+	if (!IS_MEM_ADDR_ALIGNED(start_addr) || !IS_MEM_ADDR_ALIGNED(len))
+		return SYSMAP_RET_INVALID_MEM_ADDR;
+
+	if (!len || end_addr < start_addr)
+		return SYSMAP_RET_INVALID_MEM_LEN;
+
+	if ((mem_attr & SYSMAP_MEM_ATTR_MASK) != mem_attr)
+		return SYSMAP_RET_INVALID_MEM_ATTR;
+
+	if (!region_index || start_addr >= get_mem_region_upper_limit(region_index - 1))
+		return sysmap_add_mem_region(start_addr, len, mem_attr);
+
+	for (i = 0; i < region_index; i++, base = top) {
+		top = get_mem_region_upper_limit(i);
+		cur_attr = get_mem_region_attr(i);
+
+		if (top <= start_addr || base >= end_addr) {
+			limit[n] = top;
+			attr[n++] = cur_attr;
+			continue;
+		}
+
+		if (base < start_addr) {
+			limit[n] = start_addr;
+			attr[n++] = cur_attr;
+		}
+
+		if (top >= end_addr) {
+			limit[n] = end_addr;
+			attr[n++] = mem_attr;
+			placed = true;
+		}
+
+		if (top > end_addr) {
+			limit[n] = top;
+			attr[n++] = cur_attr;
+		}
+	}
+
+	if (!placed) {
+		limit[n] = end_addr;
+		attr[n++] = mem_attr;
+	}
+
+	/* Merge neighbours with the same attribute and drop empty regions */
+	for (i = 1, w = 1; i < n; i++) {
+		if (attr[i] == attr[w - 1] || limit[i] == limit[w - 1]) {
+			limit[w - 1] = limit[i];
+		} else {
+			limit[w] = limit[i];
+			attr[w++] = attr[i];
+		}
+	}
+	n = w;
+
+	if (n > SYSMAP_REGION_NUM)
+		return SYSMAP_RET_REGION_NOT_ENOUGH;
+
+	for (i = 0; i < n; i++)
+		sysmap_setup_mem_region(i, limit[i], attr[i]);
+
+	/* Regions no longer needed collapse to zero length above the last one */
+	for (; i < region_index; i++)
+		sysmap_setup_mem_region(i, limit[n - 1], attr[n - 1]);
+
+	region_index = n;
+	return SYSMAP_RET_OK;
+}
+
+int arch_mem_set_attr(unsigned long base, unsigned long size, mem_attr_t attr) {
+	static const uint32_t sysmap_attr[MEM_ATTR_COUNT] = {
+			[MEM_ATTR_CACHED] = SYSMAP_MEM_ATTR_RAM,
+			[MEM_ATTR_WRITECOMBINE] = SYSMAP_MEM_ATTR_WO_NC_B,
+			[MEM_ATTR_UNCACHED] = SYSMAP_MEM_ATTR_WO_NC_NB,
+	};
+	int ret;
+
+	if (attr >= MEM_ATTR_COUNT)
+		return -1;
+
+	/* Write dirty lines back before the region may become uncached */
+	flush_dcache_range(base, base + size);
+
+	ret = sysmap_set_mem_region_attr(base, size, sysmap_attr[attr]);
+	if (ret) {
+		printk_warning("SYSMAP: 0x%08lx-0x%08lx attr 0x%x failed: %d\n", base, base + size, sysmap_attr[attr], ret);
+		return -1;
+	}
+
+	/* Drop lines filled before the new attribute took effect */
+	flush_dcache_range(base, base + size);
+	sysmap_dump_region_info();
+
+	return 0;
+}
+
 void sysmap_dump_region_info(void) {
 #ifdef DEBUG_SYSMAP
 	uint32_t i, mem_attr;
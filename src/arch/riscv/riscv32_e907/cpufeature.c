@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <string.h>
+
+#include <csr.h>
+
+#include <cpufeature.h>
+#include <crc32.h>
+
+/* E907 has no kernel variants yet, the table only keeps crc32() and friends working */
+cpu_dispatch_t cpu_dispatch = {
+		.memcpy = memcpy,
+		.memset = memset,
+		.memcmp = memcmp,
+		.strlen = strlen,
+		.memchr = memchr,
+		.crc32 = crc32_generic,
+};
+
+void cpu_features_init(void) {
+	static bool probed;
+	unsigned long misa;
+
+	if (probed)
+		return;
+	probed = true;
+
+	misa = csr_read(misa);
+
+	if (misa & MISA_EXT('F'))
+		cpu_features |= CPU_FEATURE_FPU;
+	if (misa & MISA_EXT('D'))
+		cpu_features |= CPU_FEATURE_FPU_DP;
+	if (misa & MISA_EXT('M'))
+		cpu_features |= CPU_FEATURE_IDIV;
+	if (misa & MISA_EXT('P'))
+		cpu_features |= CPU_FEATURE_DSP;
+}
@@ -8,11 +8,23 @@
 #include <types.h>
 
 int memcmp(const void *s1, const void *s2, unsigned int n) {
-	const unsigned char *su1, *su2;
+	const unsigned char *su1 = s1, *su2 = s2;
 	int res = 0;
 
-	for (su1 = s1, su2 = s2; 0 < n; ++su1, ++su2, n--)
+	/* Skip equal words while both sides share the same alignment */
+	if ((((unsigned long) su1 ^ (unsigned long) su2) & (sizeof(unsigned long) - 1)) == 0) {
+		for (; n > 0 && ((unsigned long) su1 & (sizeof(unsigned long) - 1)); ++su1, ++su2, n--)
+			if ((res = *su1 - *su2) != 0)
+				return res;
+
+		for (; n >= sizeof(unsigned long); su1 += sizeof(unsigned long), su2 += sizeof(unsigned long), n -= sizeof(unsigned long))
+			if (*(const unsigned long *) su1 != *(const unsigned long *) su2)
+				break;
+	}
+
+	/* The first differing byte is within the next word */
+	for (; 0 < n; ++su1, ++su2, n--)
 		if ((res = *su1 - *su2) != 0)
 			break;
 	return res;
-}
\ No newline at end of file
+}
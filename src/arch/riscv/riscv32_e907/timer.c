@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 
+#include <div64.h>
 #include <io.h>
 #include <log.h>
 #include <stdarg.h>
@@ -73,7 +74,7 @@ uint64_t get_arch_counter(void) {
  * @return Current time in milliseconds.
  */
 uint32_t time_ms(void) {
-	return (uint32_t) (get_arch_counter() / (uint64_t) (current_hosc_freq * 1000));
+	return (uint32_t) div_u64_u16(get_arch_counter(), current_hosc_freq * 1000);
 }
 
 /**
@@ -85,7 +86,7 @@ uint32_t time_ms(void) {
  * @return Current time in microseconds.
  */
 uint64_t time_us(void) {
-	return get_arch_counter() / (uint64_t) current_hosc_freq;
+	return div_u64_u16(get_arch_counter(), current_hosc_freq);
 }
 
 /**
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <string.h>
+
+#include <csr.h>
+
+#include <cpufeature.h>
+#include <crc32.h>
+
+#ifdef CONFIG_VECTOR_STRING
+/* string_dispatch.S owns the public names, these are the two variants */
+extern void *memcpy_scalar(void *dst, const void *src, int len);
+extern void *memset_scalar(void *dst, int val, int len);
+extern int memcmp_scalar(const void *dst, const void *src, unsigned int len);
+extern void *memcpy_vector(void *dst, const void *src, int len);
+extern void *memset_vector(void *dst, int val, int len);
+extern int memcmp_vector(const void *dst, const void *src, unsigned int len);
+extern unsigned int strlen_vector(const char *str);
+extern void *memchr_vector(void *src, int val, unsigned int len);
+#else
+#define memcpy_scalar memcpy
+#define memset_scalar memset
+#define memcmp_scalar memcmp
+#define strlen_generic strlen
+#define memchr_generic memchr
+#endif
+
+cpu_dispatch_t cpu_dispatch = {
+		.memcpy = memcpy_scalar,
+		.memset = memset_scalar,
+		.memcmp = memcmp_scalar,
+		.strlen = strlen_generic,
+		.memchr = memchr_generic,
+		.crc32 = crc32_generic,
+};
+
+void cpu_features_init(void) {
+	static bool probed;
+	unsigned long misa;
+
+	if (probed)
+		return;
+	probed = true;
+
+	/* misa is the bare metal equivalent of probing instructions for SIGILL */
+	misa = csr_read(misa);
+
+	if (misa & MISA_EXT('F'))
+		cpu_features |= CPU_FEATURE_FPU;
+	if (misa & MISA_EXT('D'))
+		cpu_features |= CPU_FEATURE_FPU_DP;
+	if (misa & MISA_EXT('M'))
+		cpu_features |= CPU_FEATURE_IDIV;
+
+	/* C906 cores without the vector unit (D1s/F133) clear misa.V and keep mstatus.VS at zero */
+	if (misa & MISA_EXT('V')) {
+		csr_set(mstatus, MSTATUS_VS);
+		if ((csr_read(mstatus) & MSTATUS_VS) == MSTATUS_VS)
+			cpu_features |= CPU_FEATURE_VECTOR;
+	}
+
+#ifdef CONFIG_VECTOR_STRING
+	if (cpu_has_feature(CPU_FEATURE_VECTOR)) {
+		cpu_dispatch.memcpy = memcpy_vector;
+		cpu_dispatch.memset = memset_vector;
+		cpu_dispatch.memcmp = memcmp_vector;
+		cpu_dispatch.strlen = strlen_vector;
+		cpu_dispatch.memchr = memchr_vector;
+	}
+#endif
+}
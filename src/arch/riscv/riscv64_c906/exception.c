@@ -425,7 +425,8 @@ void riscv64_handle_exception(struct pt_regs_t *regs) {
 			case 6: /* Hypervisor timer interrupt */
 			case 7: /* Machine timer interrupt */
 				csr_clear(mip, pending);
-				(core_interrupt_handler[cause].func)(core_interrupt_handler[cause].data);
+				if (core_interrupt_handler[cause].func)
+					(core_interrupt_handler[cause].func)(core_interrupt_handler[cause].data);
 				break;
 			case 8:	 /* User external interrupt */
 			case 9:	 /* Supervisor external interrupt */
@@ -469,4 +470,11 @@ void riscv64_handle_exception(struct pt_regs_t *regs) {
 }
 
 static void dummy_interrupt_function(void *data) {
-}
\ No newline at end of file
+}
+
+void riscv64_install_core_handler(int cause, void (*handler)(void *data), void *data) {
+	if (cause < 0 || cause >= ARRAY_SIZE(core_interrupt_handler))
+		return;
+	core_interrupt_handler[cause].data = data;
+	core_interrupt_handler[cause].func = handler ? handler : dummy_interrupt_function;
+}
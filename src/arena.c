@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include "arena.h"
+
+int arena_init(arena_t *arena, void *base, uint32_t size) {
+	arena->base = arena->cur = arena->peak = (unsigned long) base;
+	arena->end = arena->base + size;
+
+	return size ? 0 : -1;
+}
+
+void *arena_alloc(arena_t *arena, uint32_t size, uint32_t align) {
+	unsigned long p;
+
+	if (!align)
+		align = sizeof(void *);
+
+	if (align & (align - 1))
+		return NULL;
+
+	p = (arena->cur + align - 1) & ~(unsigned long) (align - 1);
+	if (p < arena->cur || p > arena->end || size > arena->end - p)
+		return NULL;
+
+	arena->cur = p + size;
+	if (arena->cur > arena->peak)
+		arena->peak = arena->cur;
+
+	return (void *) p;
+}
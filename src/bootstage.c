@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <sstdlib.h>
+#include <string.h>
+#include <timer.h>
+
+#include "bootstage.h"
+#include "fdt_wrapper.h"
+#include "libfdt.h"
+
+typedef struct bootstage_record {
+	uint32_t time_us;
+	uint32_t id;
+	char name[BOOTSTAGE_NAME_LEN];
+} bootstage_record_t;
+
+static bootstage_record_t records[BOOTSTAGE_MAX_RECORDS];
+static uint32_t record_count;
+static uint32_t records_dropped;
+
+static const char *const bootstage_id_name[BOOTSTAGE_COUNT] = {
+		[BOOTSTAGE_START] = "start",
+		[BOOTSTAGE_CLOCK] = "clock",
+		[BOOTSTAGE_PMU] = "pmu",
+		[BOOTSTAGE_DRAM] = "dram",
+		[BOOTSTAGE_STORAGE] = "storage",
+		[BOOTSTAGE_LOAD] = "load",
+		[BOOTSTAGE_FDT] = "fdt",
+		[BOOTSTAGE_HANDOFF] = "handoff",
+		[BOOTSTAGE_USER] = "user",
+};
+
+uint32_t bootstage_mark(enum bootstage_id id, const char *name) {
+	uint32_t now = (uint32_t) time_us();
+	bootstage_record_t *r;
+
+	if (record_count == BOOTSTAGE_MAX_RECORDS) {
+		if (!records_dropped++)
+			printk_warning("BOOTSTAGE: no record left for %s, dropping later marks\n", name ? name : bootstage_id_name[BOOTSTAGE_USER]);
+		return now;
+	}
+
+	if (id >= BOOTSTAGE_COUNT)
+		id = BOOTSTAGE_USER;
+
+	r = &records[record_count++];
+	r->time_us = now;
+	r->id = id;
+	strncpy(r->name, name ? name : bootstage_id_name[id], BOOTSTAGE_NAME_LEN - 1);
+
+	return now;
+}
+
+void bootstage_report(void) {
+	uint32_t prev = 0;
+
+	printk(LOG_LEVEL_MUTE, "Timer summary in microseconds (%u records, %u dropped):\n", record_count, records_dropped);
+	printk(LOG_LEVEL_MUTE, "%11s %11s  %-8s %s\n", "Mark", "Elapsed", "Stage", "Name");
+	for (uint32_t i = 0; i < record_count; i++) {
+		printk(LOG_LEVEL_MUTE, "%11u %11u  %-8s %s\n", records[i].time_us, records[i].time_us - prev, bootstage_id_name[records[i].id], records[i].name);
+		prev = records[i].time_us;
+	}
+}
+
+int bootstage_fdt_fixup(void *fdt) {
+	char index[12];
+	int parent, node, ret;
+
+	/* A tree used before may still carry the marks of an earlier boot */
+	parent = fdt_path_offset(fdt, "/bootstage");
+	if (parent >= 0)
+		fdt_del_node(fdt, parent);
+
+	/* Node header, three properties and their names for each record */
+	if ((ret = fdt_increase_size(fdt, 64 + record_count * (BOOTSTAGE_NAME_LEN + 64))) != 0)
+		goto _err;
+
+	if ((ret = parent = fdt_add_subnode(fdt, 0, "bootstage")) < 0)
+		goto _err;
+
+	/* New subnodes go first, add them backwards to get them in order */
+	for (uint32_t i = record_count; i-- > 0;) {
+		ltoa(i, index, 10);
+		if ((ret = node = fdt_add_subnode(fdt, parent, index)) < 0)
+			goto _err;
+		if ((ret = fdt_setprop_string(fdt, node, "name", records[i].name)) != 0 ||
+			(ret = fdt_setprop_u32(fdt, node, "id", records[i].id)) != 0 ||
+			(ret = fdt_setprop_u32(fdt, node, "mark", records[i].time_us)) != 0)
+			goto _err;
+	}
+
+	printk_debug("FDT: /bootstage with %u records\n", record_count);
+
+	return 0;
+_err:
+	printk_error("FDT: Can't add /bootstage: %s\n", fdt_strerror(ret));
+	return -1;
+}
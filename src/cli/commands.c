@@ -3,6 +3,12 @@
 #include <sstdlib.h>
 
 #include <log.h>
+#include <bootstage.h>
+#include <ftrace.h>
+#include <log_persist.h>
+#include <meminfo.h>
+#include <profile.h>
+#include <storage_bench.h>
 
 #include "cli.h"
 #include "cli_config.h"
@@ -67,6 +73,157 @@ static int cmd_write32(int argc, const char **argv) {
 	return 0;
 }
 
+#ifdef CONFIG_HEAP_STATS
+static int cmd_meminfo(int argc, const char **argv) {
+	meminfo_dump();
+	return 0;
+}
+#endif
+
+static int cmd_bootstage(int argc, const char **argv) {
+	bootstage_report();
+	return 0;
+}
+
+#ifdef CONFIG_PROFILE
+static int cmd_profile(int argc, const char **argv) {
+	if (argc >= 2 && !strcmp(argv[1], "start")) {
+		if (profile_start(argc == 3 ? simple_strtoul(argv[2], NULL, 10) : 0))
+			return 1;
+		return 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "stop")) {
+		profile_stop();
+		return 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "dump")) {
+		profile_dump();
+		return 0;
+	}
+
+	printk(LOG_LEVEL_MUTE, "Usage: profile start [hz] | stop | dump\n");
+	return 1;
+}
+#endif
+
+#ifdef CONFIG_FUNC_TRACE
+static int cmd_ftrace(int argc, const char **argv) {
+	if (argc == 2 && !strcmp(argv[1], "start"))
+		return ftrace_start(NULL, 0) ? 1 : 0;
+
+	if (argc == 2 && !strcmp(argv[1], "stop")) {
+		ftrace_stop();
+		return 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "dump")) {
+		ftrace_dump();
+		return 0;
+	}
+
+	printk(LOG_LEVEL_MUTE, "Usage: ftrace start | stop | dump\n");
+	return 1;
+}
+#endif
+
+#ifdef CONFIG_STORAGE_BENCH
+/* Bytes with an optional k or m suffix */
+static uint32_t parse_size(const char *arg) {
+	char *end;
+	uint32_t size = simple_strtoul(arg, &end, 0);
+
+	if (*end == 'k' || *end == 'K')
+		size *= 1024;
+	else if (*end == 'm' || *end == 'M')
+		size *= 1024 * 1024;
+	return size;
+}
+
+static int cmd_bench(int argc, const char **argv) {
+	storage_bench_params_t params = {0};
+	storage_bench_target_t *target = NULL;
+
+	if (argc == 2 && !strcmp(argv[1], "list")) {
+		storage_bench_list();
+		return 0;
+	}
+
+	if (argc == 3 && !strcmp(argv[1], "file"))
+		return storage_bench_add_fatfs(argv[2]) ? 1 : 0;
+
+	if (argc >= 2 && !strcmp(argv[1], "dma"))
+		return storage_bench_dma(argc == 3 ? parse_size(argv[2]) : 0) ? 1 : 0;
+
+	if (argc < 2) {
+		printk(LOG_LEVEL_MUTE, "Usage: bench list | file <path> | dma [max] | <target|all> [mode] [seq|rand] [dma|pio] [min [max]]\n");
+		return 1;
+	}
+
+	if (strcmp(argv[1], "all")) {
+		target = storage_bench_find(argv[1]);
+		if (!target) {
+			printk(LOG_LEVEL_MUTE, "bench: no target %s, see bench list\n", argv[1]);
+			return 1;
+		}
+	}
+
+	for (int i = 2; i < argc; i++) {
+		if (!strcmp(argv[i], "seq"))
+			params.flags |= STORAGE_BENCH_SEQ;
+		else if (!strcmp(argv[i], "rand"))
+			params.flags |= STORAGE_BENCH_RAND;
+		else if (!strcmp(argv[i], "dma"))
+			params.flags |= STORAGE_BENCH_DMA;
+		else if (!strcmp(argv[i], "pio"))
+			params.flags |= STORAGE_BENCH_PIO;
+		else if (argv[i][0] >= '0' && argv[i][0] <= '9' && !params.min_block)
+			params.min_block = parse_size(argv[i]);
+		else if (argv[i][0] >= '0' && argv[i][0] <= '9')
+			params.max_block = parse_size(argv[i]);
+		else
+			params.mode = argv[i];
+	}
+
+	return storage_bench_run(target, &params) ? 1 : 0;
+}
+#endif
+
+static int cmd_dmesg(int argc, const char **argv) {
+	if (argc == 1) {
+		log_persist_dump();
+		return 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "-c")) {
+		log_persist_clear();
+		return 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "-s")) {
+		printk(LOG_LEVEL_MUTE, "console level %d, capture level %d, compiled in %d\n", log_console_level, log_capture_level, LOG_LEVEL_DEFAULT);
+		log_module_show();
+		return 0;
+	}
+
+	if (argc == 3 && !strcmp(argv[1], "-m"))
+		return log_module_set_levels(argv[2]) ? 1 : 0;
+
+	if (argc == 3 && !strcmp(argv[1], "-n")) {
+		log_console_level = simple_strtoul(argv[2], NULL, 10);
+		return 0;
+	}
+
+	if (argc == 3 && !strcmp(argv[1], "-l")) {
+		log_capture_level = simple_strtoul(argv[2], NULL, 10);
+		return 0;
+	}
+
+	printk(LOG_LEVEL_MUTE, "Usage: dmesg [-c | -s | -n level | -l level | -m module:level,...]\n");
+	return 1;
+}
+
 static int cmd_history(int argc, const char **argv) {
 	for (int i = get_history_count(); i >= 0; i--) {
 		uart_puts(history_get(i));
@@ -112,6 +269,37 @@ const msh_command_entry msh_builtin_commands[] = {
 		{"hexdump", cmd_hexdump, "dumps memory region in hex", "Usage: hexdump [address] [length]\n"},
 		{"read32", cmd_read32, "read 32-bits value from device reg", "Usage: read32 [address]\n"},
 		{"write32", cmd_write32, "write 32-bits value to device reg", "Usage: write32 [address] [data]\n"},
+#ifdef CONFIG_HEAP_STATS
+		{"meminfo", cmd_meminfo, "show image layout, heap usage and loaded regions", "Usage: meminfo\n"},
+#endif
+		{"bootstage", cmd_bootstage, "show the boot timeline", "Usage: bootstage\n"},
+#ifdef CONFIG_PROFILE
+		{"profile", cmd_profile, "sample the PC from a timer interrupt",
+		 "Usage: profile start [hz] | stop | dump\n"
+		 "    start clears the histogram and samples at hz (default 1000),\n"
+		 "    dump prints it for tools/profile.py.\n"},
+#endif
+#ifdef CONFIG_FUNC_TRACE
+		{"ftrace", cmd_ftrace, "trace function entry and exit of the storage drivers",
+		 "Usage: ftrace start | stop | dump\n"
+		 "    start drops the recorded events and records again,\n"
+		 "    dump prints them for tools/ftrace.py.\n"},
+#endif
+#ifdef CONFIG_STORAGE_BENCH
+		{"bench", cmd_bench, "measure read throughput and latency of the boot media",
+		 "Usage: bench list | file <path> | dma [max] | <target|all> [mode] [seq|rand] [dma|pio] [min [max]]\n"
+		 "    Sweeps the block size from min to max (default 512 to 16m),\n"
+		 "    every mode, pattern and transfer unless one is given, and\n"
+		 "    prints a CSV line per point. list shows targets and modes,\n"
+		 "    file adds a file on the SD card as the fatfs target, dma\n"
+		 "    compares CPU and DMA memcpy up to max for the threshold.\n"},
+#endif
+		{"dmesg", cmd_dmesg, "show or clear the persistent log, set log levels",
+		 "Usage: dmesg [-c | -s | -n level | -l level | -m module:level,...]\n"
+		 "    Prints the persistent log, oldest first.\n"
+		 "    -c clears it, -s shows the levels, -n sets the console level\n"
+		 "    and -l the level captured in the persistent log (0-5).\n"
+		 "    -m sets the level of log modules, e.g. spi:2,fatfs:2 or all:5.\n"},
 		{"ls", cmd_ls, "linux nerd compatible", "Usage: ls\n"},
 		msh_command_end,
 };
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 #include <config.h>
+#include <cpufeature.h>
 #include <io.h>
 #include <log.h>
 #include <timer.h>
@@ -22,4 +23,7 @@ void show_banner(void) {
 	printk_info("\n");
 
 	show_chip();
+
+	cpu_features_init();
+	cpu_features_dump();
 }
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <string.h>
+
+#include "cpufeature.h"
+
+/* The assembly trampolines index the table with these */
+_Static_assert(offsetof(cpu_dispatch_t, memcpy) == CPU_DISPATCH_MEMCPY * sizeof(void *), "cpu_dispatch_t layout");
+_Static_assert(offsetof(cpu_dispatch_t, memset) == CPU_DISPATCH_MEMSET * sizeof(void *), "cpu_dispatch_t layout");
+_Static_assert(offsetof(cpu_dispatch_t, memcmp) == CPU_DISPATCH_MEMCMP * sizeof(void *), "cpu_dispatch_t layout");
+_Static_assert(offsetof(cpu_dispatch_t, strlen) == CPU_DISPATCH_STRLEN * sizeof(void *), "cpu_dispatch_t layout");
+_Static_assert(offsetof(cpu_dispatch_t, memchr) == CPU_DISPATCH_MEMCHR * sizeof(void *), "cpu_dispatch_t layout");
+_Static_assert(offsetof(cpu_dispatch_t, crc32) == CPU_DISPATCH_CRC32 * sizeof(void *), "cpu_dispatch_t layout");
+
+uint32_t cpu_features;
+
+static const char *const cpu_feature_name[CPU_FEATURE_COUNT] = {
+		"fpu", "fpu-dp", "neon", "vector", "idiv", "crc32", "dsp",
+};
+
+void cpu_features_dump(void) {
+	char buf[64];
+	int len = 0;
+
+	buf[0] = '\0';
+	for (int i = 0; i < CPU_FEATURE_COUNT; i++) {
+		if (!(cpu_features & (1 << i)))
+			continue;
+		buf[len++] = ' ';
+		strcpy(&buf[len], cpu_feature_name[i]);
+		len += strlen(cpu_feature_name[i]);
+	}
+	printk_info("CPU features:%s\n", len ? buf : " none");
+
+	printk_debug("CPU dispatch: memcpy %p memset %p memcmp %p strlen %p memchr %p crc32 %p\n", cpu_dispatch.memcpy, cpu_dispatch.memset,
+				 cpu_dispatch.memcmp, cpu_dispatch.strlen, cpu_dispatch.memchr, cpu_dispatch.crc32);
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include "cpufeature.h"
+#include "crc32.h"
+
+static uint32_t crc32_table[256];
+
+static void crc32_table_init(void) {
+	uint32_t c;
+	int i, k;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (k = 0; k < 8; k++)
+			c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+		crc32_table[i] = c;
+	}
+}
+
+uint32_t crc32_generic(uint32_t crc, const void *buf, uint32_t len) {
+	const uint8_t *p = buf;
+
+	/* Entry 1 is never zero once the table is built */
+	if (crc32_table[1] == 0)
+		crc32_table_init();
+
+	crc = ~crc;
+	while (len--)
+		crc = crc32_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+uint32_t crc32(uint32_t crc, const void *buf, uint32_t len) {
+	return cpu_dispatch.crc32(crc, buf, len);
+}
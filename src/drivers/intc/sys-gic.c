@@ -15,6 +15,7 @@
 #include <sys-gic.h>
 
 static irq_handler_t sunxi_int_handlers[GIC_IRQ_NUM];
+static struct arm_regs_t *sunxi_irq_regs;
 
 /**
  * @brief Get interrupts state.
@@ -125,6 +126,11 @@ static void gic_sgi_handler(uint32_t irq_no) {
 }
 
 static void gic_ppi_handler(uint32_t irq_no) {
+	/* The arch timers are PPIs */
+	if (sunxi_int_handlers[irq_no].func && sunxi_int_handlers[irq_no].func != default_isr) {
+		sunxi_int_handlers[irq_no].func(sunxi_int_handlers[irq_no].data);
+		return;
+	}
 	printk_debug("GIC: PPI irq %d coming... \n", irq_no);
 }
 
@@ -180,6 +186,7 @@ void do_irq(struct arm_regs_t *regs) {
 		printk_debug("GIC: irq NO.(%d) > GIC_IRQ_NUM(%d) !!\n", idnum, GIC_IRQ_NUM - 32);
 		return;
 	}
+	sunxi_irq_regs = regs;
 	if (idnum < 16)
 		gic_sgi_handler(idnum);
 	else if (idnum < 32)
@@ -189,9 +196,14 @@ void do_irq(struct arm_regs_t *regs) {
 	writel(idnum, GIC_END_INT_REG);
 	writel(idnum, GIC_DEACT_INT_REG);
 	gic_clear_pending(idnum);
+	sunxi_irq_regs = NULL;
 	return;
 }
 
+struct arm_regs_t *get_irq_regs(void) {
+	return sunxi_irq_regs;
+}
+
 void irq_free_handler(int irq) {
 	arm32_interrupt_disable();
 	if (irq >= GIC_IRQ_NUM) {
@@ -228,7 +240,8 @@ int irq_disable(int irq_no) {
 		return -1;
 	}
 
-	gic_spi_set_target(irq_no, 0);
+	if (irq_no >= 32)
+		gic_spi_set_target(irq_no, 0);
 	offset = irq_no >> 5;
 	reg_val = (1 << (irq_no & 0x1f));
 	writel(reg_val, GIC_CLR_EN(offset));
@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier:	GPL-2.0+ */
 
+#define LOG_MODULE LOG_MODULE_SMHC
+
 #include <barrier.h>
 #include <io.h>
 #include <stdarg.h>
@@ -977,8 +979,8 @@ int sunxi_sdhci_xfer(sunxi_sdhci_t *sdhci, mmc_cmd_t *cmd, mmc_data_t *data) {
 	data_sync_barrier();
 
 	if (data) {
-		printk_trace("SMHC: transfer data %lu bytes by %s\n", data->blocksize * data->blocks, (((data->blocksize * data->blocks > 512) && (mmc_host->sdhci_desc)) ? "DMA" : "CPU"));
-		if ((data->blocksize * data->blocks > 512) && (mmc_host->sdhci_desc)) {
+		printk_trace("SMHC: transfer data %lu bytes by %s\n", data->blocksize * data->blocks, (((data->blocksize * data->blocks > 512) && (mmc_host->sdhci_desc) && !sdhci->pio) ? "DMA" : "CPU"));
+		if ((data->blocksize * data->blocks > 512) && (mmc_host->sdhci_desc) && !sdhci->pio) {
 			use_dma_status = true;
 			mmc_host->reg->gctrl &= ~SMHC_GCTRL_ACCESS_BY_AHB;
 			ret = sunxi_sunxi_sdhci_trans_data_dma(sdhci, data);
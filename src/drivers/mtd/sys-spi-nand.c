@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 
+#define LOG_MODULE LOG_MODULE_SPI
+
 #include <io.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -379,6 +381,33 @@ int spi_nand_detect(sunxi_spi_t *spi) {
 	return -1; /* Return failure */
 }
 
+/**
+ * Get the capacity of the detected SPI NAND flash.
+ *
+ * @return The capacity in bytes, 0 before spi_nand_detect() found a chip.
+ */
+uint32_t spi_nand_get_capacity(void) {
+	return info.page_size * info.pages_per_block * info.blocks_per_die * info.ndies;
+}
+
+/**
+ * Get the I/O mode used for reads.
+ *
+ * @return The I/O mode, the one of the detected chip unless changed.
+ */
+spi_io_mode_t spi_nand_get_io_mode(void) {
+	return info.mode;
+}
+
+/**
+ * Set the I/O mode used for reads.
+ *
+ * @param mode I/O mode, no faster than the one of the detected chip.
+ */
+void spi_nand_set_io_mode(spi_io_mode_t mode) {
+	info.mode = mode;
+}
+
 /**
  * Load a page from SPI NAND flash at the specified offset.
  *
@@ -483,6 +512,7 @@ uint32_t spi_nand_read(sunxi_spi_t *spi, uint8_t *buf, uint32_t addr, uint32_t r
 		tx[4] = 0x0;
 
 		sunxi_spi_transfer(spi, info.mode, tx, txlen, buf, rxlen);
+		len = rxlen;
 	}
 
 	return len; /* Return total number of bytes read */
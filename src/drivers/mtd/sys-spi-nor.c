@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 
+#define LOG_MODULE LOG_MODULE_SPI
+
 #include <io.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -10,6 +12,8 @@
 #include <timer.h>
 
 #include <log.h>
+#include <smalloc.h>
+#include <string.h>
 
 #include <sys-clk.h>
 #include <sys-dma.h>
@@ -21,9 +25,9 @@
 static spi_nor_info_t info;
 
 static const spi_nor_info_t spi_nor_info_table[] = {
-		{"W25X40", 0xef3013, 512 * 1024, 4096, 1, 256, 3, NOR_OPCODE_READ, NOR_OPCODE_PROG, NOR_OPCODE_WREN, NOR_OPCODE_E4K, 0, NOR_OPCODE_E64K, 0},
-		{"W25Q128JVEIQ", 0xefc018, 16 * 1024 * 1024, 4096, 1, 256, 3, NOR_OPCODE_READ, NOR_OPCODE_PROG, NOR_OPCODE_WREN, NOR_OPCODE_E4K, NOR_OPCODE_E32K, NOR_OPCODE_E64K, 0},
-		{"GD25D10B", 0xc84011, 128 * 1024, 4096, 1, 256, 3, NOR_OPCODE_READ, NOR_OPCODE_PROG, NOR_OPCODE_WREN, NOR_OPCODE_E4K, NOR_OPCODE_E32K, NOR_OPCODE_E64K, 0},
+		{"W25X40", 0xef3013, 512 * 1024, 4096, 1, 256, 3, NOR_OPCODE_READ, NOR_OPCODE_PROG, NOR_OPCODE_WREN, NOR_OPCODE_E4K, 0, NOR_OPCODE_E64K, 0, 0, 0},
+		{"W25Q128JVEIQ", 0xefc018, 16 * 1024 * 1024, 4096, 1, 256, 3, NOR_OPCODE_READ, NOR_OPCODE_PROG, NOR_OPCODE_WREN, NOR_OPCODE_E4K, NOR_OPCODE_E32K, NOR_OPCODE_E64K, 0, NOR_OPCODE_PROG_QUAD, 4},
+		{"GD25D10B", 0xc84011, 128 * 1024, 4096, 1, 256, 3, NOR_OPCODE_READ, NOR_OPCODE_PROG, NOR_OPCODE_WREN, NOR_OPCODE_E4K, NOR_OPCODE_E32K, NOR_OPCODE_E64K, 0, 0, 0},
 };
 
 /**
@@ -236,9 +240,133 @@ static inline void spi_nor_chip_reset(sunxi_spi_t *spi) {
  * @param spi Pointer to a `sunxi_spi_t` structure representing the SPI device.
  */
 static inline void spi_nor_set_write_enable(sunxi_spi_t *spi) {
-	sunxi_spi_transfer(spi, SPI_IO_SINGLE, (void *) info.opcode_write_enable, 1, NULL, 0);
+	uint8_t tx = info.opcode_write_enable;
+
+	sunxi_spi_transfer(spi, SPI_IO_SINGLE, &tx, 1, NULL, 0);
+}
+
+/**
+ * @brief Wait for SPI NOR Flash to finish a program or erase operation.
+ * 
+ * Program and erase operations take far longer than reads (a 64K erase may take
+ * seconds), so unlike `spi_nor_wait_for_busy` this function bounds the wait by time
+ * instead of by a number of status polls.
+ * 
+ * @param spi Pointer to a `sunxi_spi_t` structure representing the SPI device.
+ * @param timeout_ms Maximum time to wait in milliseconds.
+ * 
+ * @return 0 when the flash is ready, -1 on timeout.
+ */
+static int spi_nor_wait_for_ready(sunxi_spi_t *spi, uint32_t timeout_ms) {
+	uint32_t start = time_ms();
+
+	while ((spi_nor_read_status_register(spi) & 0x1) == 0x1) {
+		if (time_ms() - start > timeout_ms) {
+			printk_warning("SPI NOR: wait ready timeout\n");
+			return -1;
+		}
+	}
+	return 0;
 }
 
+/**
+ * @brief Build a command header made of an opcode and an address.
+ * 
+ * @param tx Buffer receiving the command, at least 5 bytes long.
+ * @param opcode The command opcode.
+ * @param addr The flash address, sent with 3 or 4 bytes depending on `info.address_length`.
+ * 
+ * @return The length of the command header in bytes.
+ */
+static inline uint32_t spi_nor_build_cmd(uint8_t *tx, uint8_t opcode, uint32_t addr) {
+	tx[0] = opcode;
+	if (info.address_length == 4) {
+		tx[1] = (uint8_t) (addr >> 24);
+		tx[2] = (uint8_t) (addr >> 16);
+		tx[3] = (uint8_t) (addr >> 8);
+		tx[4] = (uint8_t) (addr >> 0);
+		return 5;
+	}
+	tx[1] = (uint8_t) (addr >> 16);
+	tx[2] = (uint8_t) (addr >> 8);
+	tx[3] = (uint8_t) (addr >> 0);
+	return 4;
+}
+
+/**
+ * @brief Set the Quad Enable bit of the SPI NOR Flash.
+ * 
+ * The location of the QE bit is described by the Quad Enable Requirements (QER) field
+ * of the 15th dword of the SFDP basic table.
+ * 
+ * @param spi Pointer to a `sunxi_spi_t` structure representing the SPI device.
+ * @param qer The QER field value.
+ * 
+ * @return 1 if quad data lines can be used, 0 otherwise.
+ */
+static int spi_nor_quad_enable(sunxi_spi_t *spi, uint32_t qer) {
+	uint8_t tx[3];
+	uint8_t sr1, sr2 = 0;
+
+	switch (qer) {
+		case 0:
+			/* No QE bit, IO2/IO3 are always data lines */
+			return 1;
+		case 1:
+		case 4:
+		case 5:
+			/* QE is bit 1 of SR2, written along with SR1 */
+			sr1 = spi_nor_read_status_register(spi);
+			tx[0] = NOR_OPCODE_RDSR2;
+			sunxi_spi_transfer(spi, SPI_IO_SINGLE, tx, 1, &sr2, 1);
+			if (sr2 & 0x2)
+				return 1;
+			tx[0] = NOR_OPCODE_WRSR;
+			tx[1] = sr1;
+			tx[2] = sr2 | 0x2;
+			spi_nor_set_write_enable(spi);
+			sunxi_spi_transfer(spi, SPI_IO_SINGLE, tx, 3, NULL, 0);
+			break;
+		case 2:
+			/* QE is bit 6 of SR1 */
+			sr1 = spi_nor_read_status_register(spi);
+			if (sr1 & 0x40)
+				return 1;
+			spi_nor_set_write_enable(spi);
+			spi_nor_write_status_register(spi, sr1 | 0x40);
+			break;
+		case 6:
+			/* QE is bit 1 of SR2, written with its own command */
+			tx[0] = NOR_OPCODE_RDSR2;
+			sunxi_spi_transfer(spi, SPI_IO_SINGLE, tx, 1, &sr2, 1);
+			if (sr2 & 0x2)
+				return 1;
+			tx[0] = NOR_OPCODE_WRSR2;
+			tx[1] = sr2 | 0x2;
+			spi_nor_set_write_enable(spi);
+			sunxi_spi_transfer(spi, SPI_IO_SINGLE, tx, 2, NULL, 0);
+			break;
+		default:
+			return 0;
+	}
+
+	return spi_nor_wait_for_ready(spi, 100) == 0;
+}
+
+/**
+ * @brief Look up a chip in the ID table.
+ *
+ * @param id The 24-bit JEDEC ID.
+ *
+ * @return The table entry, or NULL if the chip is not in the table.
+ */
+static const spi_nor_info_t *spi_nor_find_id(uint32_t id) {
+	for (uint32_t i = 0; i < ARRAY_SIZE(spi_nor_info_table); i++) {
+		if (spi_nor_info_table[i].id == id)
+			return &spi_nor_info_table[i];
+	}
+	return NULL;
+}
 
 /**
  * @brief Retrieves the information of the SPI NOR flash.
@@ -267,8 +395,8 @@ static inline void spi_nor_set_write_enable(sunxi_spi_t *spi) {
  */
 static inline int spi_nor_get_info(sunxi_spi_t *spi) {
 	sfdp_t sfdp;
-	spi_nor_info_t *tmp_info;
-	uint32_t v, i, id = 0x0;
+	const spi_nor_info_t *tmp_info;
+	uint32_t v, id = 0x0;
 
 	spinor_read_id(spi, &id);
 	info.id = id;
@@ -397,14 +525,32 @@ static inline int spi_nor_get_info(sunxi_spi_t *spi) {
 			info.write_granularity = 1 << ((v >> 4) & 0xf);
 		}
 		info.opcode_write = NOR_OPCODE_PROG;
+
+		/*
+		 * SFDP only describes fast reads, whether quad page program exists
+		 * comes from the ID table. The QE bit is set as the 15th dword says
+		 * where there is one, otherwise as the table says.
+		 */
+		info.opcode_write_quad = 0x00;
+		info.quad_enable = 0;
+		tmp_info = spi_nor_find_id(id);
+		if (tmp_info && tmp_info->opcode_write_quad) {
+			v = tmp_info->quad_enable;
+			if ((sfdp.basic_table.major == 1) && (sfdp.basic_table.minor >= 6))
+				v = ((sfdp.basic_table.table[59] << 24) | (sfdp.basic_table.table[58] << 16) | (sfdp.basic_table.table[57] << 8) | (sfdp.basic_table.table[56] << 0)) >> 20 & 0x7;
+			if (spi_nor_quad_enable(spi, v)) {
+				info.opcode_write_quad = (info.address_length == 4) ? NOR_OPCODE_PROG_QUAD_4B : NOR_OPCODE_PROG_QUAD;
+				info.quad_enable = v;
+			}
+		}
 		return 1;
 	} else if ((id != 0xffffff) && (id != 0)) {
-		for (i = 0; i < ARRAY_SIZE(spi_nor_info_table); i++) {
-			tmp_info = &spi_nor_info_table[i];
-			if (id == tmp_info->id) {
-				memcpy(&info, tmp_info, sizeof(spi_nor_info_t));
-				return 1;
-			}
+		tmp_info = spi_nor_find_id(id);
+		if (tmp_info) {
+			memcpy(&info, tmp_info, sizeof(spi_nor_info_t));
+			if (info.opcode_write_quad && !spi_nor_quad_enable(spi, info.quad_enable))
+				info.opcode_write_quad = 0x00;
+			return 1;
 		}
 		printk_error("The spi nor flash '0x%x' is not yet supported\r\n", id);
 	}
@@ -497,6 +643,15 @@ int spi_nor_detect(sunxi_spi_t *spi) {
 	return 0;
 }
 
+/**
+ * @brief Gets the capacity of the detected SPI NOR flash.
+ *
+ * @return The capacity in bytes, 0 before spi_nor_detect() found a chip.
+ */
+uint32_t spi_nor_get_capacity(void) {
+	return info.capacity;
+}
+
 /**
  * @brief Reads a block or multiple blocks of data from the SPI NAND flash memory.
  *
@@ -613,3 +768,310 @@ uint32_t spi_nor_read(sunxi_spi_t *spi, uint8_t *buf, uint32_t addr, uint32_t rx
 	}
 	return ret;
 }
+
+/**
+ * @brief Pick the erase operation for the start of a region.
+ *
+ * Returns the largest erase size supported by the flash that is aligned to `addr`
+ * and not larger than `len`.
+ *
+ * @param[in] addr The current address in the region.
+ * @param[in] len The remaining length of the region.
+ * @param[out] opcode The erase opcode matching the returned size.
+ *
+ * @return The erase size in bytes, or 0 if no erase size fits.
+ */
+static uint32_t spi_nor_erase_unit(uint32_t addr, uint32_t len, uint8_t *opcode) {
+	const struct {
+		uint32_t size;
+		uint8_t opcode;
+	} units[] = {
+			{262144, info.opcode_erase_256k},
+			{65536, info.opcode_erase_64k},
+			{32768, info.opcode_erase_32k},
+			{4096, info.opcode_erase_4k},
+	};
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(units); i++) {
+		if (units[i].opcode == 0x00 || units[i].size > len || (addr & (units[i].size - 1)))
+			continue;
+		*opcode = units[i].opcode;
+		return units[i].size;
+	}
+	return 0;
+}
+
+/**
+ * @brief Issue one erase command and wait for it to finish.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] opcode The erase opcode.
+ * @param[in] addr The address of the erase unit.
+ * @param[in] size The size of the erase unit, used to scale the timeout.
+ *
+ * @return 0 on success, -1 on timeout.
+ */
+static int spi_nor_erase_one(sunxi_spi_t *spi, uint8_t opcode, uint32_t addr, uint32_t size) {
+	uint8_t tx[5];
+	uint32_t cmdlen = spi_nor_build_cmd(tx, opcode, addr);
+
+	printk_trace("SPI NOR: erase 0x%08x size %uKB\n", addr, size / 1024);
+
+	spi_nor_set_write_enable(spi);
+	sunxi_spi_transfer(spi, SPI_IO_SINGLE, tx, cmdlen, NULL, 0);
+
+	/* 4K erases finish within 400ms, 256K erases within a few seconds */
+	return spi_nor_wait_for_ready(spi, 500 + size / 64);
+}
+
+/**
+ * @brief Get the page program size of the flash.
+ *
+ * @return The page size in bytes.
+ */
+static inline uint32_t spi_nor_page_size(void) {
+	/* a granularity below 64 bytes only means single bytes are programmable */
+	return (info.write_granularity >= 64) ? info.write_granularity : 256;
+}
+
+/**
+ * @brief Program data into already erased (or bit-compatible) flash.
+ *
+ * The data is split at page boundaries, and each page is sent with quad page
+ * program when supported.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] buf Pointer to the data to program.
+ * @param[in] addr The start address in the SPI NOR.
+ * @param[in] len The number of bytes to program.
+ *
+ * @return 0 on success, -1 on timeout.
+ */
+static int spi_nor_program(sunxi_spi_t *spi, uint8_t *buf, uint32_t addr, uint32_t len) {
+	uint32_t page = spi_nor_page_size();
+	uint32_t cmdlen, chunk;
+	uint8_t tx[5];
+
+	while (len > 0) {
+		chunk = page - (addr & (page - 1));
+		if (chunk > len)
+			chunk = len;
+
+		spi_nor_set_write_enable(spi);
+		if (info.opcode_write_quad) {
+			cmdlen = spi_nor_build_cmd(tx, info.opcode_write_quad, addr);
+			sunxi_spi_transfer_write(spi, SPI_IO_QUAD_IO, tx, cmdlen, buf, chunk);
+		} else {
+			cmdlen = spi_nor_build_cmd(tx, info.opcode_write, addr);
+			sunxi_spi_transfer_write(spi, SPI_IO_SINGLE, tx, cmdlen, buf, chunk);
+		}
+
+		if (spi_nor_wait_for_ready(spi, 50))
+			return -1;
+
+		addr += chunk;
+		buf += chunk;
+		len -= chunk;
+	}
+	return 0;
+}
+
+/**
+ * @brief Program the pages of a region that are not already in the wanted state.
+ *
+ * Pages that hold only 0xFF in `data` are skipped after an erase, and pages equal to
+ * the current flash content `old` are skipped when no erase took place.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] data The wanted content of the region.
+ * @param[in] old The current content of the region, or NULL if it was just erased.
+ * @param[in] addr The start address of the region.
+ * @param[in] len The length of the region.
+ *
+ * @return 0 on success, -1 on timeout.
+ */
+static int spi_nor_program_changed(sunxi_spi_t *spi, uint8_t *data, uint8_t *old, uint32_t addr, uint32_t len) {
+	uint32_t page = spi_nor_page_size();
+	uint32_t chunk, i;
+	bool skip;
+
+	while (len > 0) {
+		chunk = page - (addr & (page - 1));
+		if (chunk > len)
+			chunk = len;
+
+		if (old != NULL) {
+			skip = (memcmp(data, old, chunk) == 0);
+			old += chunk;
+		} else {
+			skip = true;
+			for (i = 0; i < chunk; i++) {
+				if (data[i] != 0xff) {
+					skip = false;
+					break;
+				}
+			}
+		}
+
+		if (!skip && spi_nor_program(spi, data, addr, chunk))
+			return -1;
+
+		addr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	return 0;
+}
+
+/**
+ * @brief Erases a region of the SPI NOR flash memory.
+ *
+ * The region is split into erase operations of the largest size the flash
+ * supports (256K, 64K, 32K or 4K) that is aligned to the current address and
+ * fits in the remaining length, so large regions need few erase commands.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] addr The start address of the region, aligned to the smallest erase size.
+ * @param[in] len The length of the region, a multiple of the smallest erase size.
+ *
+ * @return 0 on success, -1 on misaligned arguments or erase timeout.
+ */
+int spi_nor_erase(sunxi_spi_t *spi, uint32_t addr, uint32_t len) {
+	uint32_t size;
+	uint8_t opcode;
+
+	if (info.blksz == 0 || (addr % info.blksz) || (len % info.blksz) || (addr + len > info.capacity)) {
+		printk_warning("SPI NOR: erase 0x%08x+0x%x not aligned to 0x%x or out of range\n", addr, len, info.blksz);
+		return -1;
+	}
+
+	while (len > 0) {
+		size = spi_nor_erase_unit(addr, len, &opcode);
+		if (size == 0) {
+			printk_warning("SPI NOR: no erase opcode for 0x%08x\n", addr);
+			return -1;
+		}
+		if (spi_nor_erase_one(spi, opcode, addr, size))
+			return -1;
+		addr += size;
+		len -= size;
+	}
+	return 0;
+}
+
+/**
+ * @brief Writes data to the SPI NOR flash memory.
+ *
+ * This function updates the flash so that it contains `buf` at `addr`. Every erase
+ * region is read back and compared first: identical regions are skipped, regions
+ * that only need bits cleared are programmed without erasing, and the rest are
+ * erased with the largest fitting erase size and reprogrammed page by page.
+ *
+ * @param[in] spi Pointer to the SPI interface structure.
+ * @param[in] buf Pointer to the data to write.
+ * @param[in] addr The start address in the SPI NOR.
+ * @param[in] txlen The number of bytes to write.
+ *
+ * @return The number of bytes written (or found identical), less than `txlen` on error.
+ * 
+ * @details Regions fully covered by the write may use erase sizes up to 256K. Partial
+ *          sectors at the head and tail are read into a scratch buffer and merged with
+ *          the new data, so bytes outside the written range are preserved.
+ */
+uint32_t spi_nor_write(sunxi_spi_t *spi, uint8_t *buf, uint32_t addr, uint32_t txlen) {
+	uint32_t blksz = info.blksz;
+	uint32_t ret = 0, skipped = 0;
+	uint32_t sect, off, len, unit, i;
+	bool need_erase, differs;
+	uint8_t opcode;
+	uint8_t *sbuf;
+
+	if (blksz == 0 || addr + txlen > info.capacity) {
+		printk_warning("SPI NOR: write 0x%08x+0x%x out of range\n", addr, txlen);
+		return 0;
+	}
+
+	sbuf = smalloc(blksz);
+	if (sbuf == NULL) {
+		printk_error("SPI NOR: can not allocate %u bytes sector buffer\n", blksz);
+		return 0;
+	}
+
+	while (txlen > 0) {
+		sect = addr & ~(blksz - 1);
+		off = addr - sect;
+
+		if (off == 0 && txlen >= blksz) {
+			/* Fully covered region, use the largest erase unit that fits */
+			unit = spi_nor_erase_unit(addr, txlen & ~(blksz - 1), &opcode);
+			if (unit == 0)
+				break;
+			len = unit;
+		} else {
+			/* Partial sector, merge the new data into the current content */
+			unit = blksz;
+			spi_nor_erase_unit(sect, blksz, &opcode);
+			len = blksz - off;
+			if (len > txlen)
+				len = txlen;
+		}
+
+		/* Compare the whole unit sector by sector before touching the flash */
+		need_erase = false;
+		differs = false;
+		for (i = 0; i < unit; i += blksz) {
+			uint32_t cmp_off = (unit == blksz) ? off : 0;
+			uint32_t cmp_len = (unit == blksz) ? len : blksz;
+			uint8_t *data = buf + i;
+
+			spi_nor_read_block(spi, sbuf, (sect + i) / blksz, 1);
+			if (memcmp(sbuf + cmp_off, data, cmp_len) == 0)
+				continue;
+			differs = true;
+			for (uint32_t j = 0; j < cmp_len; j++) {
+				if ((sbuf[cmp_off + j] & data[j]) != data[j]) {
+					need_erase = true;
+					break;
+				}
+			}
+			if (need_erase)
+				break;
+		}
+
+		if (!differs) {
+			skipped += len;
+		} else if (!need_erase) {
+			/* Only 1 -> 0 transitions, program the changed pages in place */
+			for (i = 0; i < unit; i += blksz) {
+				uint32_t cmp_off = (unit == blksz) ? off : 0;
+				uint32_t cmp_len = (unit == blksz) ? len : blksz;
+
+				spi_nor_read_block(spi, sbuf, (sect + i) / blksz, 1);
+				if (spi_nor_program_changed(spi, buf + i, sbuf + cmp_off, sect + i + cmp_off, cmp_len))
+					goto out;
+			}
+		} else if (unit == blksz) {
+			/* Read-modify-write of a single sector, sbuf still holds its content */
+			memcpy(sbuf + off, buf, len);
+			if (spi_nor_erase_one(spi, opcode, sect, blksz))
+				goto out;
+			if (spi_nor_program_changed(spi, sbuf, NULL, sect, blksz))
+				goto out;
+		} else {
+			if (spi_nor_erase_one(spi, opcode, sect, unit))
+				goto out;
+			if (spi_nor_program_changed(spi, buf, NULL, sect, unit))
+				goto out;
+		}
+
+		addr += len;
+		buf += len;
+		txlen -= len;
+		ret += len;
+	}
+
+out:
+	printk_debug("SPI NOR: wrote %u bytes, %u bytes already up to date\n", ret, skipped);
+	sfree(sbuf);
+	return ret;
+}
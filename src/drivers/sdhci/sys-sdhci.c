@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 
+#define LOG_MODULE LOG_MODULE_SMHC
+
 #include <barrier.h>
 #include <io.h>
 #include <stdarg.h>
@@ -305,7 +307,7 @@ bool sdhci_transfer(sdhci_t *sdhci, sdhci_cmd_t *cmd, sdhci_data_t *dat) {
 	sdhci->reg->rint = 0xffffffff;// Clear status
 	sdhci->reg->arg = cmd->arg;
 
-	if (dat && (dat->blkcnt * dat->blksz) > 64) {
+	if (dat && !sdhci->pio && (dat->blkcnt * dat->blksz) > 64) {
 		dma = true;
 		sdhci->reg->gctrl &= ~SMHC_GCTRL_ACCESS_BY_AHB;
 		prepare_dma(sdhci, dat);
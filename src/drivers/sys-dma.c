@@ -15,10 +15,20 @@
 #include <stdint.h>
 #include <types.h>
 
+#include <cache.h>
 #include <log.h>
+#include <mempool.h>
+#include <string.h>
+#include <timer.h>
 
 #include <sys-dma.h>
 
+#if defined(CONFIG_CHIP_GIC) && defined(AW_IRQ_DMA)
+#include <interrupt.h>
+#include <sys-intc.h>
+#define SUNXI_DMA_HAS_IRQ
+#endif
+
 /**
  * @def SUNXI_DMA_MAX
  * @brief Maximum number of DMA channels supported
@@ -48,10 +58,31 @@ static int dma_init_ok = -1;
 static sunxi_dma_source_t dma_channel_source[SUNXI_DMA_MAX];
 
 /**
- * @brief Array of DMA descriptor structures
- * @details Stores DMA transfer descriptors for each channel, aligned to 64 bytes
+ * @brief Cacheable descriptor storage, used while no uncached pool exists
+ * @details The first SUNXI_DMA_MAX entries belong to the channels, the rest form the chain pool
+ */
+static sunxi_dma_desc_t dma_desc_static[SUNXI_DMA_MAX + SUNXI_DMA_DESC_POOL_SIZE] __attribute__((aligned(64)));
+
+/**
+ * @brief Array of DMA descriptor structures, one per channel
+ */
+static sunxi_dma_desc_t *dma_channel_desc = dma_desc_static;
+
+/**
+ * @brief Pool of descriptors for chained transfers
+ * @details Handed out one at a time by dma_desc_alloc(), tracked in dma_desc_used
  */
-static sunxi_dma_desc_t dma_channel_desc[SUNXI_DMA_MAX] __attribute__((aligned(64)));
+static sunxi_dma_desc_t *dma_desc_pool = dma_desc_static + SUNXI_DMA_MAX;
+
+/**
+ * @brief Set once the descriptors live in dma_alloc_coherent() memory and need no cache maintenance
+ */
+static bool dma_desc_coherent = false;
+
+/**
+ * @brief Allocation bitmap of the descriptor pool, one bit per descriptor
+ */
+static uint32_t dma_desc_used[(SUNXI_DMA_DESC_POOL_SIZE + 31) / 32];
 
 /**
  * @brief Base address of DMA registers
@@ -59,6 +90,62 @@ static sunxi_dma_desc_t dma_channel_desc[SUNXI_DMA_MAX] __attribute__((aligned(6
  */
 static uint32_t DMA_REG_BASE = 0x0;
 
+/**
+ * @brief Completion mode
+ * @details Set by sunxi_dma_irq_init() once requests are retired from the interrupt handler
+ */
+static int dma_irq_mode = 0;
+
+/**
+ * @brief Mask the CPU interrupt and return the previous mask state
+ * @details Guards the request queues and the descriptor pool against the DMA interrupt handler.
+ * @return Non-zero if the interrupt was already masked
+ */
+static inline uint32_t dma_irq_save(void) {
+#ifdef SUNXI_DMA_HAS_IRQ
+	uint32_t cpsr;
+
+	__asm__ __volatile__("mrs %0, cpsr" : "=r"(cpsr) : : "memory");
+	arm32_interrupt_disable();
+	return cpsr & (1 << 7);
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Restore the CPU interrupt mask saved by dma_irq_save()
+ * @param flags Value returned by dma_irq_save()
+ */
+static inline void dma_irq_restore(uint32_t flags) {
+#ifdef SUNXI_DMA_HAS_IRQ
+	if (!flags)
+		arm32_interrupt_enable();
+#endif
+}
+
+/**
+ * @brief Enable or disable the queue end interrupt of a channel
+ * @details Queue end fires when the controller reaches a descriptor linked to
+ *          SUNXI_DMA_LINK_NULL, i.e. once per request.
+ * @param dma_source Channel to configure
+ * @param enable true to enable, false to disable
+ */
+static void dma_queue_int_enable(sunxi_dma_source_t *dma_source, bool enable) {
+	sunxi_dma_reg_t *dma_reg = (sunxi_dma_reg_t *) DMA_REG_BASE;
+	uint32_t channel_count = dma_source->channel_count;
+	volatile uint32_t *irq_en = (channel_count < 8) ? &dma_reg->irq_en0 : &dma_reg->irq_en1;
+	uint32_t bit = DMA_QUEUE_END_INT << ((channel_count % 8) * 4);
+
+	if (!DMA_REG_BASE)
+		return;
+
+	if (enable)
+		*irq_en |= bit;
+	else
+		*irq_en &= ~bit;
+}
+
 /**
  * @brief Initialize DMA clock
  * @details Configures the clock settings for the DMA controller, including bus clock gating,
@@ -91,6 +178,17 @@ void sunxi_dma_init(sunxi_dma_t *dma) {
 
 	sunxi_dma_clk_init(dma);
 
+	/* Move the descriptors to uncached memory once the board has created the pool */
+	if (!dma_desc_coherent && mem_pool_is_ready(MEM_ATTR_UNCACHED)) {
+		sunxi_dma_desc_t *desc = dma_alloc_coherent(sizeof(dma_desc_static), NULL);
+
+		if (desc) {
+			dma_channel_desc = desc;
+			dma_desc_pool = desc + SUNXI_DMA_MAX;
+			dma_desc_coherent = true;
+		}
+	}
+
 	// Disable all interrupts
 	dma_reg->irq_en0 = 0;
 	dma_reg->irq_en1 = 0;
@@ -126,6 +224,15 @@ void sunxi_dma_exit(sunxi_dma_t *dma) {
 	uint32_t dma_fd;
 	sunxi_dma_reg_t *dma_reg = (sunxi_dma_reg_t *) dma->dma_reg_base;
 
+#ifdef SUNXI_DMA_HAS_IRQ
+	/* Hand the interrupt line back before the next stage takes over */
+	if (dma_irq_mode) {
+		irq_disable(AW_IRQ_DMA);
+		irq_free_handler(AW_IRQ_DMA);
+		dma_irq_mode = 0;
+	}
+#endif
+
 	/* Free any DMA channels that haven't been released */
 	for (int i = 0; i < SUNXI_DMA_MAX; i++) {
 		if (dma_channel_source[i].used == 1) {
@@ -198,10 +305,26 @@ uint32_t sunxi_dma_request(uint32_t dmatype) {
 int sunxi_dma_release(uint32_t dma_fd) {
 	sunxi_dma_source_t *dma_source = (sunxi_dma_source_t *) dma_fd;
 
+	sunxi_dma_request_t *req;
+	uint32_t flags;
+
 	if (!dma_source->used) {
 		return -1;
 	}
 
+	// Drop requests still queued, the caller has stopped the channel
+	flags = dma_irq_save();
+	dma_queue_int_enable(dma_source, false);
+	while ((req = dma_source->queue_head) != NULL) {
+		dma_source->queue_head = req->next;
+		sunxi_dma_chain_free(&req->chain);
+		req->status = SUNXI_DMA_REQ_ERROR;
+		if (req->callback)
+			req->callback(req->arg, SUNXI_DMA_REQ_ERROR);
+	}
+	dma_source->queue_tail = NULL;
+	dma_irq_restore(flags);
+
 	// Disable and free interrupts
 	sunxi_dma_disable_int(dma_fd);
 	sunxi_dma_free_int(dma_fd);
@@ -232,7 +355,7 @@ int sunxi_dma_setting(uint32_t dma_fd, sunxi_dma_set_t *cfg) {
 
 	// Configure descriptor link for loop mode
 	if (dma_set->loop_mode)
-		desc->link = (uint32_t) (&dma_source->desc);
+		desc->link = (uint32_t) dma_source->desc;
 	else
 		desc->link = SUNXI_DMA_LINK_NULL;
 
@@ -460,6 +583,519 @@ int sunxi_dma_free_int(uint32_t dma_fd) {
 	return 0;
 }
 
+/**
+ * @brief Take a descriptor from the pool
+ * @return Pointer to a free descriptor, or NULL if the pool is exhausted
+ */
+static sunxi_dma_desc_t *dma_desc_alloc(void) {
+	uint32_t flags = dma_irq_save();
+
+	for (int i = 0; i < SUNXI_DMA_DESC_POOL_SIZE; i++) {
+		if (!(dma_desc_used[i / 32] & (1U << (i % 32)))) {
+			dma_desc_used[i / 32] |= 1U << (i % 32);
+			dma_irq_restore(flags);
+			return &dma_desc_pool[i];
+		}
+	}
+
+	dma_irq_restore(flags);
+	return NULL;
+}
+
+/**
+ * @brief Return a descriptor to the pool
+ * @param desc Descriptor obtained from dma_desc_alloc()
+ */
+static void dma_desc_free(sunxi_dma_desc_t *desc) {
+	int i = desc - dma_desc_pool;
+	uint32_t flags;
+
+	if (i >= 0 && i < SUNXI_DMA_DESC_POOL_SIZE) {
+		flags = dma_irq_save();
+		dma_desc_used[i / 32] &= ~(1U << (i % 32));
+		dma_irq_restore(flags);
+	}
+}
+
+/**
+ * @brief Initialize an empty descriptor chain
+ * @details Captures the channel configuration and commit parameters once, every
+ *          descriptor appended later uses them.
+ * @param chain Chain to initialize
+ * @param cfg Channel configuration for the descriptors of the chain
+ * @return 0 on success
+ */
+int sunxi_dma_chain_init(sunxi_dma_chain_t *chain, sunxi_dma_set_t *cfg) {
+	chain->head = NULL;
+	chain->tail = NULL;
+	chain->count = 0;
+	chain->config = *(volatile uint32_t *) &cfg->channel_cfg;
+	chain->commit_para = (cfg->wait_cyc & 0xff) | ((cfg->data_block_size & 0xff) << 8);
+	chain->src_step = cfg->channel_cfg.src_addr_mode == DMAC_CFG_SRC_ADDR_TYPE_LINEAR_MODE;
+	chain->dst_step = cfg->channel_cfg.dst_addr_mode == DMAC_CFG_DEST_ADDR_TYPE_LINEAR_MODE;
+
+	return 0;
+}
+
+/**
+ * @brief Append a transfer to a descriptor chain
+ * @details Splits the transfer into descriptors of at most SUNXI_DMA_MAX_SEG_BYTES
+ *          and links them behind the current tail.
+ * @param chain Chain to extend
+ * @param saddr Source address
+ * @param daddr Destination address
+ * @param bytes Number of bytes to transfer
+ * @return 0 on success, -1 if the descriptor pool is exhausted
+ */
+int sunxi_dma_chain_add(sunxi_dma_chain_t *chain, uint32_t saddr, uint32_t daddr, uint32_t bytes) {
+	sunxi_dma_desc_t *desc;
+	uint32_t seg;
+
+	while (bytes) {
+		desc = dma_desc_alloc();
+		if (desc == NULL) {
+			printk_error("DMA: descriptor pool exhausted\n");
+			return -1;
+		}
+
+		seg = bytes > SUNXI_DMA_MAX_SEG_BYTES ? SUNXI_DMA_MAX_SEG_BYTES : bytes;
+
+		desc->config = chain->config;
+		desc->source_addr = saddr;
+		desc->dest_addr = daddr;
+		desc->byte_count = seg;
+		desc->commit_para = chain->commit_para;
+		desc->link = SUNXI_DMA_LINK_NULL;
+
+		if (chain->tail)
+			chain->tail->link = (uint32_t) desc;
+		else
+			chain->head = desc;
+		chain->tail = desc;
+		chain->count++;
+
+		if (chain->src_step)
+			saddr += seg;
+		if (chain->dst_step)
+			daddr += seg;
+		bytes -= seg;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Release all descriptors of a chain
+ * @param chain Chain to release, the channel running it must be stopped or finished
+ */
+void sunxi_dma_chain_free(sunxi_dma_chain_t *chain) {
+	sunxi_dma_desc_t *desc = chain->head;
+	sunxi_dma_desc_t *next;
+
+	while (desc) {
+		next = (desc->link == SUNXI_DMA_LINK_NULL) ? NULL : (sunxi_dma_desc_t *) desc->link;
+		dma_desc_free(desc);
+		desc = next;
+	}
+
+	chain->head = NULL;
+	chain->tail = NULL;
+	chain->count = 0;
+}
+
+/**
+ * @brief Start a descriptor chain
+ * @details Writes the descriptors back to memory and hands the head to the channel,
+ *          the controller follows the links until it reaches SUNXI_DMA_LINK_NULL.
+ * @param dma_fd Handle to the DMA channel to use
+ * @param chain Chain to run
+ * @return 0 on success, -1 if the channel is not in use or the chain is empty
+ */
+int sunxi_dma_start_chain(uint32_t dma_fd, sunxi_dma_chain_t *chain) {
+	sunxi_dma_source_t *dma_source = (sunxi_dma_source_t *) dma_fd;
+	sunxi_dma_channel_reg_t *channel = dma_source->channel;
+	sunxi_dma_desc_t *desc;
+
+	if (!dma_source->used || chain->head == NULL)
+		return -1;
+
+	if (!dma_desc_coherent) {
+		for (desc = chain->head; desc; desc = (desc->link == SUNXI_DMA_LINK_NULL) ? NULL : (sunxi_dma_desc_t *) desc->link)
+			flush_dcache_range((uint32_t) desc, (uint32_t) desc + sizeof(sunxi_dma_desc_t));
+	}
+
+	channel->desc_addr = (uint32_t) chain->head;
+	channel->enable = 1;
+
+	return 0;
+}
+
+/**
+ * @brief Retire the request at the head of a channel queue
+ * @details Starts the next queued request first so the channel idles only for the
+ *          time it takes to get here, then frees the finished chain and runs the
+ *          callback. Called with the CPU interrupt masked or from the handler.
+ * @param dma_source Channel whose head request has finished
+ */
+static void dma_queue_retire(sunxi_dma_source_t *dma_source) {
+	sunxi_dma_request_t *req = dma_source->queue_head;
+
+	if (req == NULL)
+		return;
+
+	dma_source->queue_head = req->next;
+	if (dma_source->queue_head)
+		sunxi_dma_start_chain((uint32_t) dma_source, &dma_source->queue_head->chain);
+	else
+		dma_source->queue_tail = NULL;
+
+	sunxi_dma_chain_free(&req->chain);
+	req->status = SUNXI_DMA_REQ_DONE;
+	if (req->callback)
+		req->callback(req->arg, SUNXI_DMA_REQ_DONE);
+}
+
+#ifdef SUNXI_DMA_HAS_IRQ
+/**
+ * @brief DMA interrupt handler
+ * @details Acknowledges every pending channel interrupt and retires the head request
+ *          of each channel that reached the end of its descriptor chain.
+ * @param data DMA register base
+ */
+static void sunxi_dma_irq_handler(void *data) {
+	sunxi_dma_reg_t *dma_reg = (sunxi_dma_reg_t *) data;
+	uint32_t pending0 = dma_reg->irq_pending0;
+	uint32_t pending1 = dma_reg->irq_pending1;
+	uint32_t pending;
+
+	dma_reg->irq_pending0 = pending0;
+	dma_reg->irq_pending1 = pending1;
+
+	for (int i = 0; i < SUNXI_DMA_MAX; i++) {
+		pending = (i < 8) ? (pending0 >> (i * 4)) : (pending1 >> ((i - 8) * 4));
+		if ((pending & DMA_QUEUE_END_INT) && dma_channel_source[i].used)
+			dma_queue_retire(&dma_channel_source[i]);
+	}
+}
+#endif
+
+/**
+ * @brief Switch request completion to the DMA interrupt
+ * @details Installs the handler on the interrupt controller, after that finished
+ *          requests are retired without the waiter polling the channel.
+ * @return 0 on success, -1 if the chip has no DMA interrupt or DMA is not initialized
+ */
+int sunxi_dma_irq_init(void) {
+#ifdef SUNXI_DMA_HAS_IRQ
+	if (dma_init_ok <= 0)
+		return -1;
+
+	irq_install_handler(AW_IRQ_DMA, sunxi_dma_irq_handler, (void *) DMA_REG_BASE);
+	irq_enable(AW_IRQ_DMA);
+	dma_irq_mode = 1;
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief Queue a request on a channel
+ * @details Starts the request immediately when the channel queue is empty, otherwise
+ *          appends it; it is started when the request ahead of it is retired.
+ * @param dma_fd Handle to the DMA channel
+ * @param req Request with a built descriptor chain
+ * @return 0 on success, -1 if the channel is not in use or the chain is empty
+ */
+int sunxi_dma_submit(uint32_t dma_fd, sunxi_dma_request_t *req) {
+	sunxi_dma_source_t *dma_source = (sunxi_dma_source_t *) dma_fd;
+	uint32_t flags;
+	int ret = 0;
+
+	if (!dma_source->used || req->chain.head == NULL)
+		return -1;
+
+	req->status = SUNXI_DMA_REQ_PENDING;
+	req->next = NULL;
+
+	flags = dma_irq_save();
+	if (dma_irq_mode)
+		dma_queue_int_enable(dma_source, true);
+
+	if (dma_source->queue_tail) {
+		dma_source->queue_tail->next = req;
+		dma_source->queue_tail = req;
+	} else {
+		dma_source->queue_head = req;
+		dma_source->queue_tail = req;
+		ret = sunxi_dma_start_chain(dma_fd, &req->chain);
+	}
+	dma_irq_restore(flags);
+
+	return ret;
+}
+
+/**
+ * @brief Check whether the request at the head of a channel queue has finished
+ * @details The busy bit only rises once the controller has fetched the first
+ *          descriptor, so an idle channel right after sunxi_dma_start_chain() may
+ *          not have started yet. The descriptor address register follows the
+ *          links and reads SUNXI_DMA_LINK_NULL once the last descriptor is loaded.
+ * @param dma_source Channel with a non-empty queue
+ * @return true if the channel is idle after loading the last descriptor
+ */
+static bool dma_queue_head_done(sunxi_dma_source_t *dma_source) {
+	if (sunxi_dma_querystatus((uint32_t) dma_source) != 0)
+		return false;
+
+	return dma_source->channel->desc_addr == SUNXI_DMA_LINK_NULL;
+}
+
+/**
+ * @brief Retire finished requests of a channel by polling its status
+ * @details Only needed without sunxi_dma_irq_init(), the interrupt handler does the
+ *          same work otherwise.
+ * @param dma_fd Handle to the DMA channel
+ */
+void sunxi_dma_poll(uint32_t dma_fd) {
+	sunxi_dma_source_t *dma_source = (sunxi_dma_source_t *) dma_fd;
+
+	if (dma_irq_mode)
+		return;
+
+	while (dma_source->queue_head && dma_queue_head_done(dma_source))
+		dma_queue_retire(dma_source);
+}
+
+/**
+ * @brief Wait for a queued request to complete
+ * @details In interrupt mode the handler retires the request and only its status is
+ *          watched. No timer interrupt is armed, so sleeping in wfi would never see
+ *          the timeout if the DMA interrupt were lost.
+ * @param dma_fd Handle to the DMA channel the request was queued on
+ * @param req Request to wait for
+ * @param timeout_ms Timeout in milliseconds
+ * @return 0 on success, -1 on error or timeout
+ */
+int sunxi_dma_wait(uint32_t dma_fd, sunxi_dma_request_t *req, uint32_t timeout_ms) {
+	uint32_t start = time_ms();
+
+	while (req->status == SUNXI_DMA_REQ_PENDING) {
+		sunxi_dma_poll(dma_fd);
+
+		if (req->status == SUNXI_DMA_REQ_PENDING && time_ms() - start > timeout_ms) {
+			printk_error("DMA: request timeout\n");
+			return -1;
+		}
+	}
+
+	return req->status == SUNXI_DMA_REQ_DONE ? 0 : -1;
+}
+
+/**
+ * @brief Fill a DRAM to DRAM channel configuration moving 32-bit words
+ * @param dma_set Configuration to fill
+ * @param src_io Keep the source address fixed, used to repeat a fill pattern
+ */
+static void dma_mem_setting(sunxi_dma_set_t *dma_set, bool src_io) {
+	memset(dma_set, 0, sizeof(sunxi_dma_set_t));
+
+	dma_set->loop_mode = 0;
+	dma_set->wait_cyc = 8;
+	dma_set->data_block_size = 32 / 8;
+
+	dma_set->channel_cfg.src_drq_type = DMAC_CFG_TYPE_DRAM;
+	dma_set->channel_cfg.src_addr_mode = src_io ? DMAC_CFG_SRC_ADDR_TYPE_IO_MODE : DMAC_CFG_SRC_ADDR_TYPE_LINEAR_MODE;
+	dma_set->channel_cfg.src_burst_length = src_io ? DMAC_CFG_SRC_1_BURST : DMAC_CFG_SRC_8_BURST;
+	dma_set->channel_cfg.src_data_width = DMAC_CFG_SRC_DATA_WIDTH_32BIT;
+
+	dma_set->channel_cfg.dst_drq_type = DMAC_CFG_TYPE_DRAM;
+	dma_set->channel_cfg.dst_addr_mode = DMAC_CFG_DEST_ADDR_TYPE_LINEAR_MODE;
+	dma_set->channel_cfg.dst_burst_length = DMAC_CFG_DEST_8_BURST;
+	dma_set->channel_cfg.dst_data_width = DMAC_CFG_DEST_DATA_WIDTH_32BIT;
+}
+
+/**
+ * @brief Build and start a word transfer for an asynchronous request
+ * @details The destination is cleaned and invalidated first so no dirty line is
+ *          written back on top of the DMA data, the source is cleaned so the
+ *          controller sees what the CPU wrote.
+ * @param req Request to start, req->dst and req->len describe the DMA part
+ * @param saddr Source address, ignored as a range when src_io is set
+ * @param src_io Source is a single fill word
+ * @return 0 on success, -1 on failure
+ */
+static int dma_async_start(sunxi_dma_async_t *req, uint32_t saddr, bool src_io) {
+	sunxi_dma_set_t dma_set;
+
+	req->dma_fd = sunxi_dma_request_from_last(DMAC_DMATYPE_NORMAL);
+	if (!req->dma_fd) {
+		printk_debug("DMA: no free channel, falling back to CPU\n");
+		return -1;
+	}
+
+	dma_mem_setting(&dma_set, src_io);
+	sunxi_dma_chain_init(&req->request.chain, &dma_set);
+	if (sunxi_dma_chain_add(&req->request.chain, saddr, req->dst, req->len)) {
+		sunxi_dma_chain_free(&req->request.chain);
+		sunxi_dma_release(req->dma_fd);
+		req->dma_fd = 0;
+		return -1;
+	}
+
+	if (src_io)
+		flush_dcache_range(saddr, saddr + sizeof(uint32_t));
+	else
+		flush_dcache_range(saddr, saddr + req->len);
+	flush_dcache_range(req->dst, req->dst + req->len);
+
+	req->request.callback = NULL;
+	req->request.arg = NULL;
+
+	return sunxi_dma_submit(req->dma_fd, &req->request);
+}
+
+/**
+ * @brief Start an asynchronous DRAM to DRAM copy
+ * @details Bytes before the first word aligned destination address and after the
+ *          last whole word are copied by the CPU before the DMA starts. Small or
+ *          differently aligned copies are done entirely by the CPU.
+ * @param req Request state, completed by sunxi_dma_async_wait()
+ * @param dst Destination address
+ * @param src Source address
+ * @param len Number of bytes to copy
+ * @return 0 on success, -1 on failure
+ */
+int sunxi_dma_memcpy_async(sunxi_dma_async_t *req, void *dst, const void *src, uint32_t len) {
+	uint32_t d = (uint32_t) dst, s = (uint32_t) src;
+	uint32_t head, tail;
+
+	req->dma_fd = 0;
+	req->len = 0;
+
+	if (dma_init_ok <= 0 || len < SUNXI_DMA_MEMCPY_THRESHOLD || ((d ^ s) & 3)) {
+		memcpy(dst, src, len);
+		return 0;
+	}
+
+	head = (4 - (d & 3)) & 3;
+	tail = (len - head) & 3;
+	memcpy(dst, src, head);
+	memcpy((uint8_t *) dst + len - tail, (const uint8_t *) src + len - tail, tail);
+
+	req->dst = d + head;
+	req->len = len - head - tail;
+
+	if (dma_async_start(req, s + head, false)) {
+		memcpy((void *) req->dst, (const void *) (s + head), req->len);
+		req->len = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Start an asynchronous DRAM fill
+ * @details The fill byte is replicated into a word the controller reads in IO mode
+ *          for every destination word. Unaligned edges are filled by the CPU.
+ * @param req Request state, completed by sunxi_dma_async_wait()
+ * @param dst Destination address
+ * @param c Fill byte
+ * @param len Number of bytes to fill
+ * @return 0 on success, -1 on failure
+ */
+int sunxi_dma_memset_async(sunxi_dma_async_t *req, void *dst, uint8_t c, uint32_t len) {
+	uint32_t d = (uint32_t) dst;
+	uint32_t head, tail;
+
+	req->dma_fd = 0;
+	req->len = 0;
+
+	if (dma_init_ok <= 0 || len < SUNXI_DMA_MEMCPY_THRESHOLD) {
+		memset(dst, c, len);
+		return 0;
+	}
+
+	head = (4 - (d & 3)) & 3;
+	tail = (len - head) & 3;
+	memset(dst, c, head);
+	memset((uint8_t *) dst + len - tail, c, tail);
+
+	req->pattern = c * 0x01010101U;
+	req->dst = d + head;
+	req->len = len - head - tail;
+
+	if (dma_async_start(req, (uint32_t) &req->pattern, true)) {
+		memset((void *) req->dst, c, req->len);
+		req->len = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Wait for an asynchronous copy or fill to finish
+ * @details Sleeps or polls in sunxi_dma_wait(), then releases the channel and drops
+ *          any line the CPU may have speculatively fetched from the destination.
+ * @param req Request to wait for
+ * @param timeout_ms Timeout in milliseconds
+ * @return 0 on success, -1 on timeout
+ */
+int sunxi_dma_async_wait(sunxi_dma_async_t *req, uint32_t timeout_ms) {
+	int ret;
+
+	if (!req->dma_fd)
+		return 0;
+
+	ret = sunxi_dma_wait(req->dma_fd, &req->request, timeout_ms);
+	if (ret) {
+		printk_error("DMA: async transfer to 0x%08x failed\n", req->dst);
+		sunxi_dma_stop(req->dma_fd);
+	}
+
+	invalidate_dcache_range(req->dst, req->dst + req->len);
+
+	/* Release also drops the request if it is still queued after a timeout */
+	sunxi_dma_release(req->dma_fd);
+	req->dma_fd = 0;
+
+	return ret;
+}
+
+/**
+ * @brief Copy memory with DMA and wait for completion
+ * @param dst Destination address
+ * @param src Source address
+ * @param len Number of bytes to copy
+ * @return 0 on success, -1 on failure
+ */
+int sunxi_dma_memcpy(void *dst, const void *src, uint32_t len) {
+	sunxi_dma_async_t req;
+
+	if (sunxi_dma_memcpy_async(&req, dst, src, len))
+		return -1;
+
+	/* Allow 1ms per 64KB on top of a fixed margin, DRAM copies run far faster */
+	return sunxi_dma_async_wait(&req, 100 + len / (64 * 1024));
+}
+
+/**
+ * @brief Fill memory with DMA and wait for completion
+ * @param dst Destination address
+ * @param c Fill byte
+ * @param len Number of bytes to fill
+ * @return 0 on success, -1 on failure
+ */
+int sunxi_dma_memset(void *dst, uint8_t c, uint32_t len) {
+	sunxi_dma_async_t req;
+
+	if (sunxi_dma_memset_async(&req, dst, c, len))
+		return -1;
+
+	return sunxi_dma_async_wait(&req, 100 + len / (64 * 1024));
+}
+
 /**
  * @brief Test DMA functionality
  * @details Performs a DMA transfer test between two memory regions, verifies data integrity,
@@ -558,4 +1194,78 @@ int sunxi_dma_test(uint32_t *src_addr, uint32_t *dst_addr, uint32_t len) {
 	sunxi_dma_release(dma_fd);
 
 	return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Benchmark CPU memcpy against DMA memcpy
+ * @details Runs both on the same buffers for sizes doubling from 1KB up to max_len,
+ *          prints the throughput of each and reports the smallest size from which
+ *          DMA stays ahead. The DMA time includes channel setup, cache maintenance
+ *          and completion polling, which is what a caller of sunxi_dma_memcpy() pays.
+ * @param src Source buffer, at least max_len bytes, word aligned
+ * @param dst Destination buffer, at least max_len bytes, word aligned
+ * @param max_len Largest size to measure
+ * @return Crossover size in bytes, 0 if DMA was never faster
+ */
+uint32_t sunxi_dma_bench(void *src, void *dst, uint32_t max_len) {
+	sunxi_dma_async_t req;
+	sunxi_dma_set_t dma_set;
+	uint64_t start, cpu_us, dma_us;
+	uint32_t len, crossover = 0;
+
+	if (dma_init_ok <= 0) {
+		printk_error("DMA: bench needs sunxi_dma_init() first\n");
+		return 0;
+	}
+
+	memset(src, 0x5a, max_len);
+	dma_mem_setting(&dma_set, false);
+
+	printk_info("DMA: bench %-10s %-12s %-12s\n", "size", "cpu KB/s", "dma KB/s");
+
+	for (len = 1024; len <= max_len; len <<= 1) {
+		start = time_us();
+		memcpy(dst, src, len);
+		cpu_us = time_us() - start;
+
+		/* Bypass the threshold so small sizes are measured on the DMA path too */
+		start = time_us();
+		req.dma_fd = sunxi_dma_request_from_last(DMAC_DMATYPE_NORMAL);
+		if (!req.dma_fd) {
+			printk_error("DMA: bench can't request dma\n");
+			return 0;
+		}
+		req.dst = (uint32_t) dst;
+		req.len = len;
+		req.request.callback = NULL;
+		sunxi_dma_chain_init(&req.request.chain, &dma_set);
+		sunxi_dma_chain_add(&req.request.chain, (uint32_t) src, req.dst, len);
+		flush_dcache_range((uint32_t) src, (uint32_t) src + len);
+		flush_dcache_range(req.dst, req.dst + len);
+		sunxi_dma_submit(req.dma_fd, &req.request);
+		sunxi_dma_async_wait(&req, 1000);
+		dma_us = time_us() - start;
+
+		if (cpu_us == 0)
+			cpu_us = 1;
+		if (dma_us == 0)
+			dma_us = 1;
+
+		printk_info("DMA: bench %-10u %-12u %-12u\n", len, (uint32_t) ((uint64_t) len * 1000000 / 1024 / cpu_us),
+					(uint32_t) ((uint64_t) len * 1000000 / 1024 / dma_us));
+
+		if (dma_us < cpu_us) {
+			if (!crossover)
+				crossover = len;
+		} else {
+			crossover = 0;
+		}
+	}
+
+	if (crossover)
+		printk_info("DMA: bench crossover at %uKB, set SUNXI_DMA_MEMCPY_THRESHOLD accordingly\n", crossover / 1024);
+	else
+		printk_info("DMA: bench CPU memcpy was faster at every size\n");
+
+	return crossover;
+}
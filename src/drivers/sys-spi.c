@@ -21,6 +21,8 @@
 /* #define LOG_LEVEL_DEFAULT LOG_LEVEL_DEBUG */
 #endif
 
+#define LOG_MODULE LOG_MODULE_SPI
+
 #include <io.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -28,12 +30,16 @@
 #include <stdint.h>
 #include <types.h>
 
+#include <cache.h>
 #include <timer.h>
 
 #include <log.h>
 
 #include <sys-spi.h>
 
+/* SPI DMA transfers are paced by the bus clock, wait for them without a deadline */
+#define SPI_DMA_WAIT_FOREVER (0xffffffff)
+
 /* DMA Handler */
 /**
  * @brief DMA configuration structure for SPI RX (Receive)
@@ -53,6 +59,38 @@ static __attribute__((section(".data"))) sunxi_dma_set_t spi_rx_dma;
  */
 static uint32_t spi_dma_handler = 0;
 
+/**
+ * @brief DMA configuration structure for SPI TX (Transmit)
+ * 
+ * This structure is used for configuring the DMA controller for SPI data
+ * transmission, feeding the SPI transmit FIFO from DRAM.
+ */
+static __attribute__((section(".data"))) sunxi_dma_set_t spi_tx_dma;
+
+/**
+ * @brief DMA handler for SPI transmit
+ * 
+ * This variable holds the DMA channel used to feed the SPI transmit FIFO.
+ * It stays 0 when no spare DMA channel is available, in which case
+ * transmission falls back to FIFO polling.
+ */
+static uint32_t spi_tx_dma_handler = 0;
+
+/**
+ * @brief SPI receive DMA request in flight
+ * 
+ * Started by sunxi_spi_read_by_dma() and completed by its callback, which
+ * runs from the DMA interrupt when sunxi_dma_irq_init() was called. The
+ * range is kept for the cache invalidation in the callback.
+ */
+typedef struct {
+	sunxi_dma_request_t req;
+	uint32_t buf;
+	uint32_t len;
+} spi_rx_xfer_t;
+
+static __attribute__((section(".data"))) spi_rx_xfer_t spi_rx_xfer;
+
 
 /**
  * @brief Perform a software reset on the SPI controller
@@ -432,43 +470,126 @@ static void sunxi_spi_write_tx_fifo(sunxi_spi_t *spi, uint8_t *buf, uint32_t len
 }
 
 /**
- * @brief Perform SPI data reception using DMA
+ * @brief Completion callback of the SPI receive DMA
+ * 
+ * Drops the lines the CPU may have fetched from the buffer while the DMA
+ * was storing to it, so the data is visible as soon as the request is done.
  * 
- * This function initiates a DMA transfer to read data from the SPI receive FIFO into
- * a provided buffer. It enables the DMA receive request and starts the DMA transfer. 
- * The function waits until the DMA transfer is complete before returning.
+ * @param[in] arg The receive transfer, spi_rx_xfer.
+ * @param[in] status SUNXI_DMA_REQ_DONE, or SUNXI_DMA_REQ_ERROR if the request was dropped.
+ */
+static void sunxi_spi_rx_dma_done(void *arg, int status) {
+	spi_rx_xfer_t *xfer = arg;
+
+	if (status == SUNXI_DMA_REQ_DONE)
+		invalidate_dcache_range(xfer->buf, xfer->buf + xfer->len);
+}
+
+/**
+ * @brief Start SPI data reception using DMA
+ * 
+ * This function queues a DMA transfer that drains the SPI receive FIFO into
+ * a provided buffer and returns without waiting for it. The transfer is
+ * completed by sunxi_spi_rx_dma_done(), the caller collects it with
+ * sunxi_spi_read_dma_finish() once the SPI transfer is over.
  * 
  * @param[in] spi A pointer to the SPI structure, which contains the base address
  *                of the SPI controller's registers.
  * @param[out] buf A pointer to the buffer where received data will be stored.
  * @param[in] len The number of bytes to read from the SPI receive FIFO.
  * 
- * @note This function uses DMA for data transfer, so it requires the DMA controller
- *       to be set up and ready to handle the transfer. The DMA handler `spi_dma_handler`
- *       must be initialized properly before calling this function.
- * 
- * @warning If the DMA transfer fails, a warning message will be printed using
- *          `printk_warning`.
+ * @return 0 if the transfer was queued, -1 if the caller has to read the FIFO.
  */
-static void sunxi_spi_read_by_dma(sunxi_spi_t *spi, uint8_t *buf, uint32_t len) {
+static int sunxi_spi_read_by_dma(sunxi_spi_t *spi, uint8_t *buf, uint32_t len) {
 	sunxi_spi_reg_t *spi_reg = (sunxi_spi_reg_t *) spi->base;
-	uint8_t ret = 0x0;
+	int ret;
 
 	// Initialize the buffer to zero
 	memset(buf, 0x0, len);
 
+	// Write the zeroed lines back now, so an eviction cannot overwrite what the DMA stores
+	flush_dcache_range((uint32_t) buf, (uint32_t) buf + len);
+
 	// Enable the RX DMA request in the FIFO control register
 	spi_reg->fifo_ctl |= SPI_FIFO_CTL_RX_DRQEN;
 
-	// Start the DMA transfer
-	ret = sunxi_dma_start(spi_dma_handler, (uint32_t) &spi_reg->rxdata, (uint32_t) buf, len);
-	if (ret) {
-		printk_warning("SPI: DMA transfer failed\n");
+	// Queue the DMA transfer, it completes in the callback
+	spi_rx_xfer.buf = (uint32_t) buf;
+	spi_rx_xfer.len = len;
+	spi_rx_xfer.req.callback = sunxi_spi_rx_dma_done;
+	spi_rx_xfer.req.arg = &spi_rx_xfer;
+	sunxi_dma_chain_init(&spi_rx_xfer.req.chain, &spi_rx_dma);
+	ret = sunxi_dma_chain_add(&spi_rx_xfer.req.chain, (uint32_t) &spi_reg->rxdata, (uint32_t) buf, len);
+	if (ret || sunxi_dma_submit(spi_dma_handler, &spi_rx_xfer.req)) {
+		printk_warning("SPI: DMA transfer failed, reading the FIFO\n");
+		sunxi_dma_chain_free(&spi_rx_xfer.req.chain);
+		spi_reg->fifo_ctl &= ~SPI_FIFO_CTL_RX_DRQEN;
+		return -1;
 	}
 
-	// Wait for the DMA transfer to complete
-	while (sunxi_dma_querystatus(spi_dma_handler))
-		;
+	return 0;
+}
+
+/**
+ * @brief Wait for the SPI receive DMA started by sunxi_spi_read_by_dma()
+ * 
+ * In interrupt mode the callback has usually run by the time the SPI
+ * transfer completes and this returns at once, otherwise it retires the
+ * request by polling the channel.
+ */
+static void sunxi_spi_read_dma_finish(void) {
+	sunxi_dma_wait(spi_dma_handler, &spi_rx_xfer.req, SPI_DMA_WAIT_FOREVER);
+}
+
+/**
+ * @brief Perform SPI data transmission using DMA
+ * 
+ * This function feeds the SPI transmit FIFO from a buffer using the TX DMA channel.
+ * Only the word-aligned part of the buffer is moved by DMA, the remaining tail bytes
+ * are pushed through the FIFO by the CPU after the DMA transfer has completed.
+ * 
+ * @param[in] spi A pointer to the SPI structure, which contains the base address
+ *                of the SPI controller's registers.
+ * @param[in] buf A pointer to the buffer containing the data to be transmitted.
+ * @param[in] len The number of bytes to transmit.
+ * 
+ * @note The buffer must be 4-byte aligned, unaligned buffers are sent by FIFO polling.
+ */
+static void sunxi_spi_write_by_dma(sunxi_spi_t *spi, uint8_t *buf, uint32_t len) {
+	sunxi_spi_reg_t *spi_reg = (sunxi_spi_reg_t *) spi->base;
+	uint32_t dma_len = len & ~0x3;
+	sunxi_dma_request_t req;
+
+	if (((uint32_t) buf & 0x3) || dma_len == 0) {
+		sunxi_spi_write_tx_fifo(spi, buf, len);
+		return;
+	}
+
+	// The DMA reads DRAM, write back what the CPU filled the buffer with
+	flush_dcache_range((uint32_t) buf, (uint32_t) buf + dma_len);
+
+	// Enable the TX DMA request in the FIFO control register
+	spi_reg->fifo_ctl |= SPI_FIFO_CTL_TX_DRQEN;
+
+	// Queue the DMA transfer
+	req.callback = NULL;
+	sunxi_dma_chain_init(&req.chain, &spi_tx_dma);
+	if (sunxi_dma_chain_add(&req.chain, (uint32_t) buf, (uint32_t) &spi_reg->txdata, dma_len) || sunxi_dma_submit(spi_tx_dma_handler, &req)) {
+		printk_warning("SPI: TX DMA transfer failed\n");
+		sunxi_dma_chain_free(&req.chain);
+		spi_reg->fifo_ctl &= ~SPI_FIFO_CTL_TX_DRQEN;
+		sunxi_spi_write_tx_fifo(spi, buf, len);
+		return;
+	}
+
+	// Wait for the DMA transfer to complete, sleeping when DMA interrupts are enabled
+	sunxi_dma_wait(spi_tx_dma_handler, &req, SPI_DMA_WAIT_FOREVER);
+
+	spi_reg->fifo_ctl &= ~SPI_FIFO_CTL_TX_DRQEN;
+
+	if (len > dma_len) {
+		sunxi_spi_write_tx_fifo(spi, buf + dma_len, len - dma_len);
+	}
 }
 
 /**
@@ -587,6 +708,36 @@ static int sunxi_spi_dma_init(sunxi_spi_t *spi) {
 	// Set DMA transfer settings.
 	sunxi_dma_setting(spi_dma_handler, &spi_rx_dma);
 
+	// Request a second DMA channel for the transmit path, fall back to FIFO polling if none is left.
+	spi_tx_dma_handler = sunxi_dma_request(DMAC_DMATYPE_NORMAL);
+
+	if (spi_tx_dma_handler == 0) {
+		printk_debug("SPI: no DMA channel left for TX, using FIFO\n");
+		return 0;
+	}
+
+	/* Configure SPI TX DMA transfer settings */
+	spi_tx_dma.loop_mode = 0;
+	spi_tx_dma.wait_cyc = 0x8;
+	spi_tx_dma.data_block_size = 1 * 32 / 8;
+
+	// Configure source (DRAM) settings for DMA.
+	spi_tx_dma.channel_cfg.src_drq_type = DMAC_CFG_TYPE_DRAM;
+	spi_tx_dma.channel_cfg.src_addr_mode = DMAC_CFG_SRC_ADDR_TYPE_LINEAR_MODE;
+	spi_tx_dma.channel_cfg.src_burst_length = DMAC_CFG_SRC_8_BURST;
+	spi_tx_dma.channel_cfg.src_data_width = DMAC_CFG_SRC_DATA_WIDTH_32BIT;
+
+	// Configure destination (SPI0) settings for DMA.
+	spi_tx_dma.channel_cfg.dst_drq_type = DMAC_CFG_TYPE_SPI0;
+	spi_tx_dma.channel_cfg.dst_addr_mode = DMAC_CFG_DEST_ADDR_TYPE_IO_MODE;
+	spi_tx_dma.channel_cfg.dst_burst_length = DMAC_CFG_DEST_8_BURST;
+	spi_tx_dma.channel_cfg.dst_data_width = DMAC_CFG_DEST_DATA_WIDTH_32BIT;
+
+	sunxi_dma_install_int(spi_tx_dma_handler, NULL);
+	sunxi_dma_enable_int(spi_tx_dma_handler);
+
+	sunxi_dma_setting(spi_tx_dma_handler, &spi_tx_dma);
+
 	return 0;// Success
 }
 
@@ -606,6 +757,9 @@ static int sunxi_spi_dma_deinit(sunxi_spi_t *spi) {
 	// Disable DMA interrupts for the current SPI DMA channel.
 	sunxi_dma_disable_int(spi_dma_handler);
 
+	if (spi_tx_dma_handler)
+		sunxi_dma_disable_int(spi_tx_dma_handler);
+
 	return 0;// Success
 }
 
@@ -958,6 +1112,7 @@ int sunxi_spi_update_clk(sunxi_spi_t *spi, uint32_t clk) {
 int sunxi_spi_transfer(sunxi_spi_t *spi, spi_io_mode_t mode, void *txbuf, uint32_t txlen, void *rxbuf, uint32_t rxlen) {
 	sunxi_spi_reg_t *spi_reg = (sunxi_spi_reg_t *) spi->base;
 	uint32_t stxlen;
+	bool rx_dma = false;
 
 	printk_trace("SPI: tsfr mode=%u tx=%u rx=%u\n", mode, txlen, rxlen);
 
@@ -985,15 +1140,18 @@ int sunxi_spi_transfer(sunxi_spi_t *spi, spi_io_mode_t mode, void *txbuf, uint32
 	sunxi_spi_start_xfer(spi);							  /**< Start the SPI transfer */
 
 	if (txbuf && txlen) {
-		sunxi_spi_write_tx_fifo(spi, txbuf, txlen); /**< Write data to TX FIFO if there's data to transmit */
+		if (txlen > 64 && spi_tx_dma_handler && !spi->pio) {
+			sunxi_spi_write_by_dma(spi, txbuf, txlen); /**< Use DMA for large transmit buffers */
+		} else {
+			sunxi_spi_write_tx_fifo(spi, txbuf, txlen); /**< Write data to TX FIFO if there's data to transmit */
+		}
 	}
 
 	if (rxbuf && rxlen) {
-		if (rxlen > 64) {
-			sunxi_spi_read_by_dma(spi, rxbuf, rxlen); /**< Use DMA for large receive buffers */
-		} else {
+		if (rxlen > 64 && !spi->pio)
+			rx_dma = sunxi_spi_read_by_dma(spi, rxbuf, rxlen) == 0; /**< Use DMA for large receive buffers */
+		if (!rx_dma)
 			sunxi_spi_read_rx_fifo(spi, rxbuf, rxlen); /**< Use FIFO for smaller receive buffers */
-		}
 	}
 
 	if (sunxi_spi_query_irq_pending(spi) & SPI_INT_STA_ERR) {
@@ -1003,6 +1161,9 @@ int sunxi_spi_transfer(sunxi_spi_t *spi, spi_io_mode_t mode, void *txbuf, uint32
 	while (!(sunxi_spi_query_irq_pending(spi) & SPI_INT_STA_TC))
 		; /**< Wait for transfer completion interrupt (TC) */
 
+	if (rx_dma)
+		sunxi_spi_read_dma_finish(); /**< The DMA may still be draining the last FIFO words */
+
 	sunxi_spi_dma_disable(spi); /**< Disable DMA if used */
 
 	if (spi_reg->burst_cnt == 0) {
@@ -1019,3 +1180,76 @@ int sunxi_spi_transfer(sunxi_spi_t *spi, spi_io_mode_t mode, void *txbuf, uint32
 
 	return rxlen + txlen; /**< Return the total number of transferred bytes (TX + RX) */
 }
+
+/**
+ * @brief Performs a SPI write transfer with a separate command phase.
+ * 
+ * This function sends a command (opcode, address, dummy bytes) followed by a data payload in one
+ * chip-select cycle, without requiring the caller to merge both into a single buffer. The command
+ * phase is always sent on a single data line. In SPI_IO_QUAD_IO mode the payload is sent on four
+ * data lines, as used by quad page program commands, otherwise it is sent on a single line.
+ * Large payloads are fed to the controller by DMA when a transmit DMA channel is available.
+ * 
+ * @param spi Pointer to the SPI structure containing configuration and register information.
+ * @param mode The I/O mode of the payload phase (SPI_IO_SINGLE or SPI_IO_QUAD_IO).
+ * @param cmdbuf Pointer to the command buffer.
+ * @param cmdlen Length of the command in bytes.
+ * @param txbuf Pointer to the payload buffer.
+ * @param txlen Length of the payload in bytes.
+ * 
+ * @return The total number of bytes transferred (cmdlen + txlen).
+ */
+int sunxi_spi_transfer_write(sunxi_spi_t *spi, spi_io_mode_t mode, void *cmdbuf, uint32_t cmdlen, void *txbuf, uint32_t txlen) {
+	sunxi_spi_reg_t *spi_reg = (sunxi_spi_reg_t *) spi->base;
+	uint32_t stxlen;
+
+	printk_trace("SPI: write mode=%u cmd=%u tx=%u\n", mode, cmdlen, txlen);
+
+	sunxi_spi_disable_irq(spi, SPI_INT_STA_PENDING_BIT);
+	sunxi_spi_clr_irq_pending(spi, SPI_INT_STA_PENDING_BIT);
+
+	if (mode == SPI_IO_QUAD_IO) {
+		sunxi_spi_set_io_mode(spi, SPI_IO_QUAD_IO);
+		stxlen = cmdlen; /**< Only the command phase goes out on a single line */
+	} else {
+		sunxi_spi_set_io_mode(spi, SPI_IO_SINGLE);
+		stxlen = cmdlen + txlen;
+	}
+
+	sunxi_spi_set_counters(spi, cmdlen + txlen, 0, stxlen, 0);
+	sunxi_spi_reset_fifo(spi);
+	sunxi_spi_start_xfer(spi);
+
+	if (cmdbuf && cmdlen) {
+		sunxi_spi_write_tx_fifo(spi, cmdbuf, cmdlen);
+	}
+
+	if (txbuf && txlen) {
+		if (txlen > 64 && spi_tx_dma_handler) {
+			sunxi_spi_write_by_dma(spi, txbuf, txlen);
+		} else {
+			sunxi_spi_write_tx_fifo(spi, txbuf, txlen);
+		}
+	}
+
+	if (sunxi_spi_query_irq_pending(spi) & SPI_INT_STA_ERR) {
+		printk_warning("SPI: int sta err\n");
+	}
+
+	while (!(sunxi_spi_query_irq_pending(spi) & SPI_INT_STA_TC))
+		;
+
+	sunxi_spi_dma_disable(spi);
+
+	if (spi_reg->burst_cnt == 0) {
+		if (spi_reg->tc & SPI_TC_XCH) {
+			printk_warning("SPI: XCH Control failed\n");
+		}
+	} else {
+		printk_warning("SPI: MBC error\n");
+	}
+
+	sunxi_spi_clr_irq_pending(spi, SPI_INT_STA_PENDING_BIT);
+
+	return cmdlen + txlen;
+}
@@ -8,9 +8,14 @@
 #include <types.h>
 
 #include <log.h>
+#include <string.h>
+#include <timer.h>
 
 #include <ufs/ufs.h>
 
+/* Blocks moved by one request, several of these are kept in flight */
+#define SCSI_RW_CHUNK_BYTES (512 * 1024)
+
 static scsi_cmd_t scsi_cmd_buffer;
 static uint8_t scsi_buffer[512];
 
@@ -69,7 +74,7 @@ static void scsi_setup_start(scsi_cmd_t *pccb) {
 }
 
 static int scsi_exec(ufs_device_t *dev, scsi_cmd_t *pccb) {
-	return 0;
+	return ufshcd_exec_scsi(&dev->ufs_hba, pccb);
 }
 
 static int scsi_bus_reset(ufs_device_t *dev) {
@@ -142,7 +147,7 @@ static int scsi_detect_dev(ufs_device_t *dev, int target, int lun, blk_desc_t *d
 			printk_warning("UFS: device not found\n");
 			return -1;
 		} else {
-			printk_infoinfo("UFS: Found UFS device ID %d\n", pccb->target);
+			printk_info("UFS: Found UFS device ID %d\n", pccb->target);
 			break;
 		}
 	}
@@ -195,10 +200,110 @@ static int scsi_detect_dev(ufs_device_t *dev, int target, int lun, blk_desc_t *d
 	return 0;
 }
 
+static void scsi_setup_rw(scsi_cmd_t *pccb, bool write, uint64_t start, uint32_t blocks) {
+	memset(pccb->cmd, '\0', sizeof(pccb->cmd));
+
+	/* READ/WRITE (10) cover 32-bit LBAs and 16-bit counts, fall back to (16) beyond */
+	if (start <= 0xffffffff && blocks <= 0xffff) {
+		pccb->cmd[0] = write ? SCSI_WRITE10 : SCSI_READ10;
+		pccb->cmd[2] = (uint8_t) (start >> 24);
+		pccb->cmd[3] = (uint8_t) (start >> 16);
+		pccb->cmd[4] = (uint8_t) (start >> 8);
+		pccb->cmd[5] = (uint8_t) start;
+		pccb->cmd[7] = (uint8_t) (blocks >> 8);
+		pccb->cmd[8] = (uint8_t) blocks;
+		pccb->cmdlen = 10;
+	} else {
+		pccb->cmd[0] = write ? SCSI_WRITE16 : SCSI_READ16;
+		pccb->cmd[2] = (uint8_t) (start >> 56);
+		pccb->cmd[3] = (uint8_t) (start >> 48);
+		pccb->cmd[4] = (uint8_t) (start >> 40);
+		pccb->cmd[5] = (uint8_t) (start >> 32);
+		pccb->cmd[6] = (uint8_t) (start >> 24);
+		pccb->cmd[7] = (uint8_t) (start >> 16);
+		pccb->cmd[8] = (uint8_t) (start >> 8);
+		pccb->cmd[9] = (uint8_t) start;
+		pccb->cmd[10] = (uint8_t) (blocks >> 24);
+		pccb->cmd[11] = (uint8_t) (blocks >> 16);
+		pccb->cmd[12] = (uint8_t) (blocks >> 8);
+		pccb->cmd[13] = (uint8_t) blocks;
+		pccb->cmdlen = 16;
+	}
+
+	pccb->msgout[0] = SCSI_IDENTIFY; /* NOT USED */
+}
+
+/**
+ * @brief Split a transfer into chunks and keep one in flight per transfer request slot.
+ *
+ * Slots are used round-robin, the oldest one is completed before it is reused,
+ * so the device always has the next chunk queued while the current one moves.
+ */
+static uint64_t scsi_rw(ufs_device_t *dev, uint64_t blknr, uint64_t blkcnt, uint8_t *buf, bool write) {
+	static scsi_cmd_t rw_cmd[UFS_QUEUE_DEPTH];
+	ufs_hba_t *hba = &dev->ufs_hba;
+	blk_desc_t *bdesc = dev->bd;
+	uint32_t slot_blocks[UFS_QUEUE_DEPTH] = {0};
+	uint32_t chunk_blocks, blocks;
+	uint64_t left = blkcnt, done = 0;
+	bool failed = false;
+	int tag = 0;
+
+	if (bdesc == NULL || bdesc->blksz == 0 || blkcnt == 0)
+		return 0;
+
+	chunk_blocks = SCSI_RW_CHUNK_BYTES / bdesc->blksz;
+	if (chunk_blocks == 0)
+		chunk_blocks = 1;
+
+	while ((left && !failed) || hba->outstanding_reqs) {
+		/* Retire the previous user of this slot first */
+		if (hba->outstanding_reqs & (1 << tag)) {
+			if (ufshcd_complete_scsi(hba, tag, UFS_SCSI_TIMEOUT)) {
+				scsi_print_error(&rw_cmd[tag]);
+				failed = true;
+			} else if (!failed) {
+				done += slot_blocks[tag];
+			}
+		}
+
+		if (left && !failed) {
+			scsi_cmd_t *pccb = &rw_cmd[tag];
+
+			blocks = left > chunk_blocks ? chunk_blocks : (uint32_t) left;
+			memset(pccb, 0, sizeof(scsi_cmd_t));
+			pccb->target = bdesc->target;
+			pccb->lun = bdesc->lun;
+			pccb->pdata = buf;
+			pccb->datalen = (uint64_t) blocks * bdesc->blksz;
+			pccb->dma_dir = write ? DMA_TO_DEVICE : DMA_FROM_DEVICE;
+			scsi_setup_rw(pccb, write, blknr, blocks);
+
+			if (ufshcd_queue_scsi(hba, pccb, tag)) {
+				failed = true;
+			} else {
+				slot_blocks[tag] = blocks;
+				blknr += blocks;
+				left -= blocks;
+				buf += pccb->datalen;
+			}
+		}
+
+		tag = (tag + 1) % hba->nutrs;
+	}
+
+	if (failed)
+		printk_warning("UFS: %s stopped after %llu of %llu blocks\n", write ? "write" : "read", done, blkcnt);
+
+	return done;
+}
+
 uint64_t scsi_read(ufs_device_t *dev, uint64_t blknr, uint64_t blkcnt, const void *buffer) {
+	return scsi_rw(dev, blknr, blkcnt, (uint8_t *) buffer, false);
 }
 
 uint64_t scsi_write(ufs_device_t *dev, uint64_t blknr, uint64_t blkcnt, const void *buffer) {
+	return scsi_rw(dev, blknr, blkcnt, (uint8_t *) buffer, true);
 }
 
 int scsi_scan_dev(ufs_device_t *dev) {
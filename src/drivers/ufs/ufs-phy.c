@@ -10,3 +10,12 @@
 #include <log.h>
 
 #include <ufs/ufs.h>
+
+/*
+ * The generic bring-up needs no PHY programming beyond what the boot ROM
+ * leaves behind. SoCs that need M-PHY calibration before link startup
+ * override this with their own sequence.
+ */
+int __attribute__((weak)) ufs_phy_init(ufs_hba_t *hba) {
+	return 0;
+}
@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 
+#include <barrier.h>
 #include <io.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -8,5 +9,679 @@
 #include <types.h>
 
 #include <log.h>
+#include <timer.h>
+
+#include <byteorder.h>
+#include <cache.h>
+
+#include <smalloc.h>
+#include <string.h>
 
 #include <ufs/ufs.h>
+
+#define UFS_LINK_STARTUP_RETRIES 3
+#define UFS_NOP_OUT_RETRIES 10
+#define UFS_QUERY_RETRIES 3
+#define UFS_DME_PEER_RETRIES 3
+
+/* Maximum task management slots defined by UFSHCI */
+#define UFS_MAX_TM_SLOTS 8
+
+/* Fatal conditions that end any wait on the controller */
+#define UFS_FATAL_ERRORS (DEVICE_FATAL_ERROR | CONTROLLER_FATAL_ERROR | SYSTEM_BUS_FATAL_ERROR)
+
+/* Every register access goes through these two helpers */
+static inline uint32_t ufshcd_readl(ufs_hba_t *hba, uint32_t reg) {
+	return read32(hba->ioaddr + reg);
+}
+
+static inline void ufshcd_writel(ufs_hba_t *hba, uint32_t val, uint32_t reg) {
+	write32(hba->ioaddr + reg, val);
+}
+
+static int ufshcd_wait_for_register(ufs_hba_t *hba, uint32_t reg, uint32_t mask, uint32_t val, uint32_t timeout_ms) {
+	uint32_t start = time_ms();
+
+	while ((ufshcd_readl(hba, reg) & mask) != val) {
+		if (time_ms() - start > timeout_ms)
+			return -1;
+	}
+
+	return 0;
+}
+
+static inline void ufshcd_cache_flush(void *addr, uint32_t len) {
+	flush_dcache_range((uint32_t) addr, (uint32_t) addr + len);
+}
+
+static inline void ufshcd_cache_invalidate(void *addr, uint32_t len) {
+	invalidate_dcache_range((uint32_t) addr, (uint32_t) addr + len);
+}
+
+/**
+ * @brief Allocate zeroed memory from the heap with the alignment UFSHCI requires.
+ */
+static void *ufshcd_alloc_aligned(uint32_t size, uint32_t align) {
+	uint8_t *p = smalloc(size + align);
+
+	if (p == NULL)
+		return NULL;
+
+	p = (uint8_t *) (((uint32_t) p + align - 1) & ~(align - 1));
+	memset(p, 0, size);
+	ufshcd_cache_flush(p, size);
+
+	return p;
+}
+
+static int ufshcd_memory_alloc(ufs_hba_t *hba) {
+	/* UCD must be 128 byte aligned, UTRL and UTMRL 1KB aligned */
+	hba->ucdl = ufshcd_alloc_aligned(sizeof(utp_transfer_cmd_desc_t) * hba->nutrs, 128);
+	hba->utrdl = ufshcd_alloc_aligned(sizeof(utp_transfer_req_desc_t) * hba->nutrs, 1024);
+	hba->utmrdl = ufshcd_alloc_aligned(sizeof(utp_task_req_desc_t) * UFS_MAX_TM_SLOTS, 1024);
+
+	if (hba->ucdl == NULL || hba->utrdl == NULL || hba->utmrdl == NULL) {
+		printk_error("UFS: descriptor allocation failed, is the heap initialized?\n");
+		return -1;
+	}
+
+	/* Device management commands always use slot 0 */
+	hba->ucd_req_ptr = (utp_upiu_req_t *) hba->ucdl[0].command_upiu;
+	hba->ucd_rsp_ptr = (utp_upiu_rsp_t *) hba->ucdl[0].response_upiu;
+	hba->ucd_prdt_ptr = hba->ucdl[0].prd_table;
+
+	return 0;
+}
+
+static int ufshcd_hba_enable(ufs_hba_t *hba) {
+	int retries = 10;
+
+	if (ufshcd_readl(hba, REG_CONTROLLER_ENABLE) & CONTROLLER_ENABLE) {
+		ufshcd_writel(hba, 0, REG_CONTROLLER_ENABLE);
+		if (ufshcd_wait_for_register(hba, REG_CONTROLLER_ENABLE, CONTROLLER_ENABLE, 0, 10)) {
+			printk_error("UFS: controller disable timeout\n");
+			return -1;
+		}
+	}
+
+	ufshcd_writel(hba, CONTROLLER_ENABLE, REG_CONTROLLER_ENABLE);
+
+	/* The controller needs some time to initialize after HCE is set */
+	while (!(ufshcd_readl(hba, REG_CONTROLLER_ENABLE) & CONTROLLER_ENABLE)) {
+		if (--retries == 0) {
+			printk_error("UFS: controller enable timeout\n");
+			return -1;
+		}
+		mdelay(1);
+	}
+
+	return 0;
+}
+
+static int ufshcd_send_uic_cmd(ufs_hba_t *hba, uic_command_t *uic_cmd) {
+	if (ufshcd_wait_for_register(hba, REG_CONTROLLER_STATUS, UIC_COMMAND_READY, UIC_COMMAND_READY, UFS_UIC_CMD_TIMEOUT)) {
+		printk_error("UFS: controller not ready for UIC command 0x%x\n", uic_cmd->command);
+		return -1;
+	}
+
+	ufshcd_writel(hba, UIC_COMMAND_COMPL, REG_INTERRUPT_STATUS);
+
+	ufshcd_writel(hba, uic_cmd->argument1, REG_UIC_COMMAND_ARG_1);
+	ufshcd_writel(hba, uic_cmd->argument2, REG_UIC_COMMAND_ARG_2);
+	ufshcd_writel(hba, uic_cmd->argument3, REG_UIC_COMMAND_ARG_3);
+	ufshcd_writel(hba, uic_cmd->command & 0xff, REG_UIC_COMMAND);
+
+	if (ufshcd_wait_for_register(hba, REG_INTERRUPT_STATUS, UIC_COMMAND_COMPL, UIC_COMMAND_COMPL, UFS_UIC_CMD_TIMEOUT)) {
+		printk_error("UFS: UIC command 0x%x timeout\n", uic_cmd->command);
+		return -1;
+	}
+	ufshcd_writel(hba, UIC_COMMAND_COMPL, REG_INTERRUPT_STATUS);
+
+	uic_cmd->result = ufshcd_readl(hba, REG_UIC_COMMAND_ARG_2) & MASK_UIC_COMMAND_ARG2_RESULT;
+	uic_cmd->argument3 = ufshcd_readl(hba, REG_UIC_COMMAND_ARG_3);
+
+	return uic_cmd->result == UIC_CMD_RESULT_SUCCESS ? 0 : -1;
+}
+
+int ufshcd_dme_access(ufs_hba_t *hba, uint32_t attr_sel, int peer, uint32_t *value, bool set) {
+	uic_command_t uic_cmd = {0};
+	int retries = (peer == DME_PEER) ? UFS_DME_PEER_RETRIES : 1;
+	int ret;
+
+	if (set)
+		uic_cmd.command = (peer == DME_PEER) ? UIC_CMD_DME_PEER_SET : UIC_CMD_DME_SET;
+	else
+		uic_cmd.command = (peer == DME_PEER) ? UIC_CMD_DME_PEER_GET : UIC_CMD_DME_GET;
+
+	do {
+		uic_cmd.argument1 = attr_sel;
+		uic_cmd.argument2 = UIC_ARG_ATTR_TYPE(ATTR_SET_NOR);
+		uic_cmd.argument3 = set ? *value : 0;
+		ret = ufshcd_send_uic_cmd(hba, &uic_cmd);
+	} while (ret && --retries);
+
+	if (ret) {
+		printk_error("UFS: dme-%s%s attr 0x%x failed, result %d\n", peer == DME_PEER ? "peer-" : "", set ? "set" : "get", UIC_GET_ATTR_ID(attr_sel), uic_cmd.result);
+		return -1;
+	}
+
+	if (!set)
+		*value = uic_cmd.argument3;
+
+	return 0;
+}
+
+static inline int ufshcd_dme_set(ufs_hba_t *hba, uint32_t attr_sel, uint32_t value) {
+	return ufshcd_dme_access(hba, attr_sel, DME_LOCAL, &value, true);
+}
+
+static inline int ufshcd_dme_get(ufs_hba_t *hba, uint32_t attr_sel, uint32_t *value) {
+	return ufshcd_dme_access(hba, attr_sel, DME_LOCAL, value, false);
+}
+
+static inline int ufshcd_dme_peer_get(ufs_hba_t *hba, uint32_t attr_sel, uint32_t *value) {
+	return ufshcd_dme_access(hba, attr_sel, DME_PEER, value, false);
+}
+
+static int ufshcd_make_hba_operational(ufs_hba_t *hba) {
+	uint32_t ready = UTP_TRANSFER_REQ_LIST_READY | UTP_TASK_REQ_LIST_READY | UIC_COMMAND_READY;
+
+	ufshcd_writel(hba, (uint32_t) hba->utrdl, REG_UTP_TRANSFER_REQ_LIST_BASE_L);
+	ufshcd_writel(hba, 0, REG_UTP_TRANSFER_REQ_LIST_BASE_H);
+	ufshcd_writel(hba, (uint32_t) hba->utmrdl, REG_UTP_TASK_REQ_LIST_BASE_L);
+	ufshcd_writel(hba, 0, REG_UTP_TASK_REQ_LIST_BASE_H);
+
+	if ((ufshcd_readl(hba, REG_CONTROLLER_STATUS) & ready) != ready) {
+		printk_error("UFS: host controller not ready, status 0x%08x\n", ufshcd_readl(hba, REG_CONTROLLER_STATUS));
+		return -1;
+	}
+
+	ufshcd_writel(hba, UTP_TASK_REQ_LIST_RUN_STOP_BIT, REG_UTP_TASK_REQ_LIST_RUN_STOP);
+	ufshcd_writel(hba, UTP_TRANSFER_REQ_LIST_RUN_STOP_BIT, REG_UTP_TRANSFER_REQ_LIST_RUN_STOP);
+
+	return 0;
+}
+
+static int ufshcd_link_startup(ufs_hba_t *hba) {
+	uic_command_t uic_cmd = {0};
+	int retries = UFS_LINK_STARTUP_RETRIES;
+	int ret;
+
+	do {
+		memset(&uic_cmd, 0, sizeof(uic_cmd));
+		uic_cmd.command = UIC_CMD_DME_LINK_STARTUP;
+
+		ret = ufshcd_send_uic_cmd(hba, &uic_cmd);
+		if (ret == 0 && !(ufshcd_readl(hba, REG_CONTROLLER_STATUS) & DEVICE_PRESENT)) {
+			printk_debug("UFS: link startup done but no device present\n");
+			ret = -1;
+		}
+	} while (ret && --retries);
+
+	if (ret) {
+		printk_error("UFS: link startup failed\n");
+		return -1;
+	}
+
+	if (hba->basic_info.quirks & UFSHCD_QUIRK_BROKEN_LCC) {
+		if (ufshcd_dme_set(hba, UIC_ARG_MIB(PA_LOCAL_TX_LCC_ENABLE), 0))
+			return -1;
+	}
+
+	/* Drop the status bits raised during link startup */
+	ufshcd_writel(hba, ufshcd_readl(hba, REG_INTERRUPT_STATUS), REG_INTERRUPT_STATUS);
+
+	return ufshcd_make_hba_operational(hba);
+}
+
+/* UFSHCI 2.0 and later use the UFS storage command type for every request */
+static inline uint32_t ufshcd_cmd_type(ufs_hba_t *hba, uint32_t legacy_type) {
+	if (hba->basic_info.version == UFSHCI_VERSION_10 || hba->basic_info.version == UFSHCI_VERSION_11)
+		return legacy_type;
+	return UTP_CMD_TYPE_UFS_STORAGE;
+}
+
+static void ufshcd_prepare_req_desc(ufs_hba_t *hba, int tag, uint32_t cmd_type, uint32_t data_direction, uint16_t prdt_len) {
+	utp_transfer_req_desc_t *utrd = &hba->utrdl[tag];
+	utp_transfer_cmd_desc_t *ucd = &hba->ucdl[tag];
+
+	utrd->header.dword_0 = cpu_to_le32(data_direction | (cmd_type << UPIU_COMMAND_TYPE_OFFSET));
+	utrd->header.dword_1 = 0;
+	utrd->header.dword_2 = cpu_to_le32(OCS_INVALID_COMMAND_STATUS);
+	utrd->header.dword_3 = 0;
+
+	utrd->command_desc_base_addr_lo = cpu_to_le32((uint32_t) ucd);
+	utrd->command_desc_base_addr_hi = 0;
+
+	/* Offsets and lengths in dwords, PRDT length in entries */
+	utrd->response_upiu_offset = cpu_to_le16(offsetof(utp_transfer_cmd_desc_t, response_upiu) >> 2);
+	utrd->response_upiu_length = cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+	utrd->prd_table_offset = cpu_to_le16(offsetof(utp_transfer_cmd_desc_t, prd_table) >> 2);
+	utrd->prd_table_length = cpu_to_le16(prdt_len);
+
+	memset(ucd->command_upiu, 0, sizeof(utp_upiu_req_t));
+	memset(ucd->response_upiu, 0, sizeof(utp_upiu_rsp_t));
+}
+
+/**
+ * @brief Describe a data buffer with the PRDT of a slot.
+ *
+ * @return Number of PRDT entries used, or -1 if the buffer does not fit.
+ */
+static int ufshcd_prepare_prdt(ufs_hba_t *hba, int tag, uint8_t *buf, uint32_t len) {
+	ufshcd_sg_entry_t *prd = hba->ucdl[tag].prd_table;
+	uint32_t chunk;
+	int n = 0;
+
+	while (len > 0) {
+		if (n == MAX_BUFF)
+			return -1;
+
+		chunk = len > UFS_PRDT_MAX_BYTES ? UFS_PRDT_MAX_BYTES : len;
+		prd[n].base_addr = cpu_to_le32((uint32_t) buf);
+		prd[n].upper_addr = 0;
+		prd[n].reserved = 0;
+		prd[n].size = cpu_to_le32(chunk - 1);
+
+		buf += chunk;
+		len -= chunk;
+		n++;
+	}
+
+	return n;
+}
+
+static void ufshcd_send_command(ufs_hba_t *hba, int tag) {
+	ufshcd_cache_flush(&hba->ucdl[tag], sizeof(utp_transfer_cmd_desc_t));
+	ufshcd_cache_flush(&hba->utrdl[tag], sizeof(utp_transfer_req_desc_t));
+
+	hba->outstanding_reqs |= (1 << tag);
+	wmb();
+	ufshcd_writel(hba, 1 << tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+}
+
+/**
+ * @brief Wait until the controller clears the doorbell bit of a slot and check OCS.
+ */
+static int ufshcd_wait_slot(ufs_hba_t *hba, int tag, uint32_t timeout_ms) {
+	utp_transfer_req_desc_t *utrd = &hba->utrdl[tag];
+	uint32_t start = time_ms();
+	uint32_t status, ocs;
+
+	while (ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL) & (1 << tag)) {
+		status = ufshcd_readl(hba, REG_INTERRUPT_STATUS);
+		if (status & UFS_FATAL_ERRORS) {
+			printk_error("UFS: fatal error, interrupt status 0x%08x\n", status);
+			goto fail;
+		}
+
+		if (time_ms() - start > timeout_ms) {
+			printk_error("UFS: slot %d timeout\n", tag);
+			goto fail;
+		}
+	}
+
+	/* Completions of other slots may share this bit, they are tracked by the doorbell */
+	ufshcd_writel(hba, UTP_TRANSFER_REQ_COMPL, REG_INTERRUPT_STATUS);
+	hba->outstanding_reqs &= ~(1 << tag);
+
+	ufshcd_cache_invalidate(utrd, sizeof(utp_transfer_req_desc_t));
+	ufshcd_cache_invalidate(hba->ucdl[tag].response_upiu, ALIGNED_UPIU_SIZE);
+
+	ocs = le32_to_cpu(utrd->header.dword_2) & MASK_OCS;
+	if (ocs != OCS_SUCCESS) {
+		printk_error("UFS: slot %d failed, OCS 0x%x\n", tag, ocs);
+		return -1;
+	}
+
+	return 0;
+
+fail:
+	/* Writing 0 to a slot bit of UTRLCLR discards the request */
+	ufshcd_writel(hba, ~(1 << tag), REG_UTP_TRANSFER_REQ_LIST_CLEAR);
+	hba->outstanding_reqs &= ~(1 << tag);
+	return -1;
+}
+
+int ufshcd_queue_scsi(ufs_hba_t *hba, scsi_cmd_t *pccb, int tag) {
+	utp_upiu_req_t *req = (utp_upiu_req_t *) hba->ucdl[tag].command_upiu;
+	uint32_t data_direction, upiu_flags;
+	int prdt_len = 0;
+
+	if (tag >= hba->nutrs || (hba->outstanding_reqs & (1 << tag))) {
+		printk_error("UFS: slot %d busy\n", tag);
+		return -1;
+	}
+
+	if (pccb->datalen == 0 || pccb->dma_dir == DMA_NONE) {
+		data_direction = UTP_NO_DATA_TRANSFER;
+		upiu_flags = UPIU_CMD_FLAGS_NONE;
+	} else if (pccb->dma_dir == DMA_TO_DEVICE) {
+		data_direction = UTP_HOST_TO_DEVICE;
+		upiu_flags = UPIU_CMD_FLAGS_WRITE;
+	} else {
+		data_direction = UTP_DEVICE_TO_HOST;
+		upiu_flags = UPIU_CMD_FLAGS_READ;
+	}
+
+	if (data_direction != UTP_NO_DATA_TRANSFER) {
+		prdt_len = ufshcd_prepare_prdt(hba, tag, pccb->pdata, pccb->datalen);
+		if (prdt_len < 0) {
+			printk_error("UFS: transfer of %u bytes too large\n", (uint32_t) pccb->datalen);
+			return -1;
+		}
+	}
+
+	ufshcd_prepare_req_desc(hba, tag, ufshcd_cmd_type(hba, UTP_CMD_TYPE_SCSI), data_direction, prdt_len);
+
+	req->header.dword_0 = UPIU_HEADER_DWORD(UPIU_TRANSACTION_COMMAND, upiu_flags, pccb->lun, tag);
+	req->header.dword_1 = UPIU_HEADER_DWORD(UPIU_COMMAND_SET_TYPE_SCSI, 0, 0, 0);
+	req->header.dword_2 = 0;
+	req->sc.exp_data_transfer_len = cpu_to_be32((uint32_t) pccb->datalen);
+	memcpy(req->sc.cdb, pccb->cmd, pccb->cmdlen > UFS_CDB_SIZE ? UFS_CDB_SIZE : pccb->cmdlen);
+
+	/* Write back dirty lines for both directions, an eviction must not land on top of DMA data */
+	if (data_direction != UTP_NO_DATA_TRANSFER)
+		ufshcd_cache_flush(pccb->pdata, pccb->datalen);
+
+	hba->slot_cmd[tag] = pccb;
+	ufshcd_send_command(hba, tag);
+
+	return 0;
+}
+
+int ufshcd_complete_scsi(ufs_hba_t *hba, int tag, uint32_t timeout_ms) {
+	scsi_cmd_t *pccb = hba->slot_cmd[tag];
+	utp_upiu_rsp_t *rsp = (utp_upiu_rsp_t *) hba->ucdl[tag].response_upiu;
+	uint32_t dword_1, sense_len;
+
+	if (pccb == NULL)
+		return -1;
+	hba->slot_cmd[tag] = NULL;
+
+	if (ufshcd_wait_slot(hba, tag, timeout_ms)) {
+		pccb->contr_stat = SCSI_SEL_TIME_OUT;
+		return -1;
+	}
+
+	if (pccb->datalen && pccb->dma_dir == DMA_FROM_DEVICE)
+		ufshcd_cache_invalidate(pccb->pdata, pccb->datalen);
+
+	if ((be32_to_cpu(rsp->header.dword_0) >> 24) != UPIU_TRANSACTION_RESPONSE) {
+		printk_error("UFS: unexpected response UPIU 0x%x\n", be32_to_cpu(rsp->header.dword_0) >> 24);
+		return -1;
+	}
+
+	dword_1 = be32_to_cpu(rsp->header.dword_1);
+	pccb->status = dword_1 & MASK_SCSI_STATUS;
+	pccb->contr_stat = 0;
+
+	if (((dword_1 >> 8) & 0xff) != 0 || pccb->status != S_GOOD) {
+		if (pccb->status == S_CHECK_COND) {
+			sense_len = be16_to_cpu(rsp->sr.sense_data_len);
+			if (sense_len > RESPONSE_UPIU_SENSE_DATA_LENGTH)
+				sense_len = RESPONSE_UPIU_SENSE_DATA_LENGTH;
+			memcpy(pccb->sense_buf, rsp->sr.sense_data, sense_len);
+			pccb->sensedatalen = sense_len;
+		}
+		printk_debug("UFS: scsi cmd 0x%02x status 0x%x response 0x%x\n", pccb->cmd[0], pccb->status, (dword_1 >> 8) & 0xff);
+		return -1;
+	}
+
+	pccb->trans_bytes = pccb->datalen - be32_to_cpu(rsp->sr.residual_transfer_count);
+
+	return 0;
+}
+
+int ufshcd_exec_scsi(ufs_hba_t *hba, scsi_cmd_t *pccb) {
+	if (ufshcd_queue_scsi(hba, pccb, 0))
+		return -1;
+
+	return ufshcd_complete_scsi(hba, 0, UFS_SCSI_TIMEOUT);
+}
+
+/**
+ * @brief Issue a NOP OUT or query request on slot 0 and check the response.
+ */
+static int ufshcd_exec_dev_cmd(ufs_hba_t *hba, enum dev_cmd_type type, uint32_t timeout_ms) {
+	const int tag = 0;
+	utp_upiu_req_t *req = hba->ucd_req_ptr;
+	utp_upiu_rsp_t *rsp = hba->ucd_rsp_ptr;
+	ufs_query_t *query = &hba->dev_cmd.query;
+	uint32_t trans;
+
+	if (hba->outstanding_reqs & (1 << tag))
+		return -1;
+
+	ufshcd_prepare_req_desc(hba, tag, ufshcd_cmd_type(hba, UTP_CMD_TYPE_DEV_MANAGE), UTP_NO_DATA_TRANSFER, 0);
+
+	if (type == DEV_CMD_TYPE_NOP) {
+		req->header.dword_0 = UPIU_HEADER_DWORD(UPIU_TRANSACTION_NOP_OUT, 0, 0, tag);
+	} else {
+		req->header.dword_0 = UPIU_HEADER_DWORD(UPIU_TRANSACTION_QUERY_REQ, 0, 0, tag);
+		req->header.dword_1 = UPIU_HEADER_DWORD(0, query->request.query_func, 0, 0);
+		req->qr.opcode = query->request.upiu_req.opcode;
+		req->qr.idn = query->request.upiu_req.idn;
+		req->qr.index = query->request.upiu_req.index;
+		req->qr.selector = query->request.upiu_req.selector;
+		req->qr.value = cpu_to_be32(query->request.upiu_req.value);
+	}
+
+	hba->dev_cmd.type = type;
+	ufshcd_send_command(hba, tag);
+
+	if (ufshcd_wait_slot(hba, tag, timeout_ms))
+		return -1;
+
+	trans = be32_to_cpu(rsp->header.dword_0) >> 24;
+
+	if (type == DEV_CMD_TYPE_NOP)
+		return trans == UPIU_TRANSACTION_NOP_IN ? 0 : -1;
+
+	if (trans != UPIU_TRANSACTION_QUERY_RSP)
+		return -1;
+
+	query->response.response = (be32_to_cpu(rsp->header.dword_1) >> 8) & 0xff;
+	query->response.upiu_res = rsp->qr;
+	query->response.upiu_res.value = be32_to_cpu(rsp->qr.value);
+
+	return query->response.response == QUERY_RESULT_SUCCESS ? 0 : -1;
+}
+
+static int ufshcd_query_flag(ufs_hba_t *hba, enum query_opcode opcode, enum flag_idn idn, bool *flag_res) {
+	ufs_query_t *query = &hba->dev_cmd.query;
+	int retries = UFS_QUERY_RETRIES;
+	int ret;
+
+	do {
+		memset(query, 0, sizeof(ufs_query_t));
+		query->request.upiu_req.opcode = opcode;
+		query->request.upiu_req.idn = idn;
+		query->request.query_func = (opcode == UPIU_QUERY_OPCODE_READ_FLAG) ? UPIU_QUERY_FUNC_STANDARD_READ_REQUEST : UPIU_QUERY_FUNC_STANDARD_WRITE_REQUEST;
+
+		ret = ufshcd_exec_dev_cmd(hba, DEV_CMD_TYPE_QUERY, UFS_QUERY_TIMEOUT);
+	} while (ret && --retries);
+
+	if (ret) {
+		printk_error("UFS: query flag opcode 0x%x idn 0x%x failed, response 0x%x\n", opcode, idn, query->response.response);
+		return -1;
+	}
+
+	if (flag_res)
+		*flag_res = query->response.upiu_res.value & 0x1;
+
+	return 0;
+}
+
+static int ufshcd_verify_dev_init(ufs_hba_t *hba) {
+	int retries;
+
+	for (retries = UFS_NOP_OUT_RETRIES; retries > 0; retries--) {
+		if (ufshcd_exec_dev_cmd(hba, DEV_CMD_TYPE_NOP, UFS_NOP_OUT_TIMEOUT) == 0)
+			return 0;
+	}
+
+	printk_error("UFS: NOP OUT failed\n");
+	return -1;
+}
+
+static int ufshcd_complete_dev_init(ufs_hba_t *hba) {
+	bool flag_res = true;
+	uint32_t start;
+
+	if (ufshcd_query_flag(hba, UPIU_QUERY_OPCODE_SET_FLAG, QUERY_FLAG_IDN_FDEVICEINIT, NULL))
+		return -1;
+
+	/* The device clears fDeviceInit once its initialization is done */
+	start = time_ms();
+	do {
+		if (ufshcd_query_flag(hba, UPIU_QUERY_OPCODE_READ_FLAG, QUERY_FLAG_IDN_FDEVICEINIT, &flag_res))
+			return -1;
+	} while (flag_res && time_ms() - start < UFS_QUERY_TIMEOUT);
+
+	if (flag_res) {
+		printk_error("UFS: fDeviceInit was not cleared by the device\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int ufshcd_get_max_pwr_mode(ufs_hba_t *hba) {
+	ufs_pa_layer_attr_t *pwr = &hba->max_pwr_info.info;
+
+	if (ufshcd_dme_get(hba, UIC_ARG_MIB(PA_CONNECTEDRXDATALANES), &pwr->lane_rx) ||
+		ufshcd_dme_get(hba, UIC_ARG_MIB(PA_CONNECTEDTXDATALANES), &pwr->lane_tx))
+		return -1;
+
+	if (pwr->lane_rx == 0 || pwr->lane_tx == 0) {
+		printk_error("UFS: invalid connected lanes rx %u tx %u\n", pwr->lane_rx, pwr->lane_tx);
+		return -1;
+	}
+
+	/* Fall back to the fastest PWM gear when HS is not supported */
+	if (ufshcd_dme_get(hba, UIC_ARG_MIB(PA_MAXRXHSGEAR), &pwr->gear_rx))
+		return -1;
+	pwr->pwr_rx = FAST_MODE;
+	if (pwr->gear_rx == 0) {
+		if (ufshcd_dme_get(hba, UIC_ARG_MIB(PA_MAXRXPWMGEAR), &pwr->gear_rx))
+			return -1;
+		pwr->pwr_rx = SLOW_MODE;
+	}
+
+	if (ufshcd_dme_peer_get(hba, UIC_ARG_MIB(PA_MAXRXHSGEAR), &pwr->gear_tx))
+		return -1;
+	pwr->pwr_tx = FAST_MODE;
+	if (pwr->gear_tx == 0) {
+		if (ufshcd_dme_peer_get(hba, UIC_ARG_MIB(PA_MAXRXPWMGEAR), &pwr->gear_tx))
+			return -1;
+		pwr->pwr_tx = SLOW_MODE;
+	}
+
+	pwr->hs_rate = PA_HS_MODE_B;
+	hba->max_pwr_info.is_valid = true;
+
+	return 0;
+}
+
+static int ufshcd_uic_change_pwr_mode(ufs_hba_t *hba, uint8_t mode) {
+	uic_command_t uic_cmd = {0};
+	uint32_t upmcrs;
+
+	uic_cmd.command = UIC_CMD_DME_SET;
+	uic_cmd.argument1 = UIC_ARG_MIB(PA_PWRMODE);
+	uic_cmd.argument2 = UIC_ARG_ATTR_TYPE(ATTR_SET_NOR);
+	uic_cmd.argument3 = mode;
+
+	ufshcd_writel(hba, UIC_POWER_MODE, REG_INTERRUPT_STATUS);
+
+	if (ufshcd_send_uic_cmd(hba, &uic_cmd))
+		return -1;
+
+	if (ufshcd_wait_for_register(hba, REG_INTERRUPT_STATUS, UIC_POWER_MODE, UIC_POWER_MODE, UFS_UIC_CMD_TIMEOUT)) {
+		printk_error("UFS: power mode change timeout\n");
+		return -1;
+	}
+	ufshcd_writel(hba, UIC_POWER_MODE, REG_INTERRUPT_STATUS);
+
+	upmcrs = UFSHCD_UPMCRS(ufshcd_readl(hba, REG_CONTROLLER_STATUS));
+	if (upmcrs != PWR_LOCAL) {
+		printk_error("UFS: power mode change failed, UPMCRS %u\n", upmcrs);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int ufshcd_change_power_mode(ufs_hba_t *hba, ufs_pa_layer_attr_t *pwr) {
+	bool rx_fast = (pwr->pwr_rx == FAST_MODE || pwr->pwr_rx == FASTAUTO_MODE);
+	bool tx_fast = (pwr->pwr_tx == FAST_MODE || pwr->pwr_tx == FASTAUTO_MODE);
+
+	if (ufshcd_dme_set(hba, UIC_ARG_MIB(PA_RXGEAR), pwr->gear_rx) ||
+		ufshcd_dme_set(hba, UIC_ARG_MIB(PA_ACTIVERXDATALANES), pwr->lane_rx) ||
+		ufshcd_dme_set(hba, UIC_ARG_MIB(PA_RXTERMINATION), rx_fast) ||
+		ufshcd_dme_set(hba, UIC_ARG_MIB(PA_TXGEAR), pwr->gear_tx) ||
+		ufshcd_dme_set(hba, UIC_ARG_MIB(PA_ACTIVETXDATALANES), pwr->lane_tx) ||
+		ufshcd_dme_set(hba, UIC_ARG_MIB(PA_TXTERMINATION), tx_fast))
+		return -1;
+
+	if ((rx_fast || tx_fast) && ufshcd_dme_set(hba, UIC_ARG_MIB(PA_HSSERIES), pwr->hs_rate))
+		return -1;
+
+	if (ufshcd_uic_change_pwr_mode(hba, pwr->pwr_rx << 4 | pwr->pwr_tx))
+		return -1;
+
+	memcpy(&hba->pwr_info, pwr, sizeof(ufs_pa_layer_attr_t));
+
+	return 0;
+}
+
+int ufs_init(ufs_device_t *dev) {
+	ufs_hba_t *hba = &dev->ufs_hba;
+	uint32_t slots;
+
+	hba->ioaddr = (virtual_addr_t) dev->sc_plat.base;
+	hba->basic_info.capabilities = ufshcd_readl(hba, REG_CONTROLLER_CAPABILITIES);
+	hba->basic_info.version = ufshcd_readl(hba, REG_UFS_VERSION);
+	hba->outstanding_reqs = 0;
+	memset(hba->slot_cmd, 0, sizeof(hba->slot_cmd));
+
+	slots = (hba->basic_info.capabilities & MASK_TRANSFER_REQUESTS_SLOTS) + 1;
+	hba->nutrs = slots > UFS_QUEUE_DEPTH ? UFS_QUEUE_DEPTH : slots;
+
+	printk_debug("UFS: UFSHCI version 0x%08x, %u slots, using %u\n", hba->basic_info.version, slots, hba->nutrs);
+
+	if (ufshcd_memory_alloc(hba))
+		return -1;
+
+	/* Completion is polled, keep the interrupt line quiet */
+	ufshcd_writel(hba, 0, REG_INTERRUPT_ENABLE);
+
+	if (ufshcd_hba_enable(hba))
+		return -1;
+
+	if (ufs_phy_init(hba))
+		return -1;
+
+	if (ufshcd_link_startup(hba))
+		return -1;
+
+	if (ufshcd_verify_dev_init(hba))
+		return -1;
+
+	if (ufshcd_complete_dev_init(hba))
+		return -1;
+
+	/* The link comes up in PWM-G1, stay there if the faster mode can not be reached */
+	if (ufshcd_get_max_pwr_mode(hba) || ufshcd_change_power_mode(hba, &hba->max_pwr_info.info))
+		printk_warning("UFS: power mode change failed, staying in PWM-G1\n");
+
+	dev->sc_plat.max_id = UFSHCD_MAX_ID;
+	dev->sc_plat.max_lun = UFS_MAX_LUNS;
+	dev->sc_plat.max_bytes_per_req = MAX_BUFF * UFS_PRDT_MAX_BYTES;
+
+	printk_info("UFS: link up, %s gear rx %u tx %u, lanes rx %u tx %u\n", hba->pwr_info.pwr_rx == FAST_MODE ? "HS" : "PWM", hba->pwr_info.gear_rx, hba->pwr_info.gear_tx,
+				hba->pwr_info.lane_rx, hba->pwr_info.lane_tx);
+
+	return 0;
+}
@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier:	GPL-2.0+ */
 
+#define LOG_MODULE LOG_MODULE_USB
+
 #include <io.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -1,6 +1,8 @@
 /* SPDX-License-Identifier:	GPL-2.0+ */
 /* Based on https://github.com/allwinner-zh/bootloader */
 
+#define LOG_MODULE LOG_MODULE_USB
+
 #include <io.h>
 #include <stdarg.h>
 #include <stdbool.h>
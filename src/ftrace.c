@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <string.h>
+#include <timer.h>
+
+#include "ftrace.h"
+
+/* The hooks must not call themselves, should this file ever be instrumented */
+#define NO_TRACE __attribute__((no_instrument_function))
+
+/* Ring being recorded into, NULL while stopped */
+static ftrace_header_t *ftrace_ring;
+static ftrace_header_t *ftrace_buf;
+
+static inline __attribute__((always_inline)) uint32_t ftrace_cycles(void) {
+#if defined(__arm__)
+	uint32_t val;
+
+	/* PMCCNTR */
+	__asm__ __volatile__("mrc p15, 0, %0, c9, c13, 0" : "=r"(val));
+	return val;
+#elif defined(__riscv)
+	unsigned long val;
+
+	__asm__ __volatile__("csrr %0, mcycle" : "=r"(val));
+	return (uint32_t) val;
+#else
+	return (uint32_t) get_arch_counter();
+#endif
+}
+
+static void ftrace_cycles_init(void) {
+#if defined(__arm__)
+	uint32_t pmcr;
+
+	/* Enable the PMU and its cycle counter, left running from then on */
+	__asm__ __volatile__("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+	__asm__ __volatile__("mcr p15, 0, %0, c9, c12, 0" : : "r"(pmcr | (1 << 0)));
+	__asm__ __volatile__("mcr p15, 0, %0, c9, c12, 1" : : "r"(1U << 31));
+#endif
+}
+
+/*
+ * The whole cost of an event: a few loads, the counter read and two stores.
+ * There is no lock, the instrumented code does not run in interrupt handlers;
+ * if it ever did, an event landing between reading and writing head would
+ * share a slot with the one it interrupted.
+ */
+static inline __attribute__((always_inline)) void ftrace_record(void *fn, uint32_t exit) {
+	ftrace_header_t *ring = ftrace_ring;
+	ftrace_event_t *e;
+	uint32_t head;
+
+	if (!ring)
+		return;
+
+	head = ring->head;
+	ring->head = head + 1;
+	e = &ring->event[head & (ring->entries - 1)];
+	e->cycles = ftrace_cycles();
+	e->fn = ((uint32_t) (unsigned long) fn & ~FTRACE_EXIT) | exit;
+}
+
+void NO_TRACE __cyg_profile_func_enter(void *this_fn, void *call_site) {
+	ftrace_record(this_fn, 0);
+}
+
+void NO_TRACE __cyg_profile_func_exit(void *this_fn, void *call_site) {
+	ftrace_record(this_fn, FTRACE_EXIT);
+}
+
+int ftrace_start(void *buf, uint32_t size) {
+	ftrace_header_t *ring = buf ? buf : ftrace_buf;
+	uint32_t entries = 1;
+
+	ftrace_ring = NULL;
+
+	if (!ring) {
+		printk_warning("FTRACE: no buffer\n");
+		return -1;
+	}
+
+	if (buf) {
+		while (sizeof(ftrace_header_t) + entries * 2 * sizeof(ftrace_event_t) <= size)
+			entries *= 2;
+		if (entries < 16) {
+			printk_warning("FTRACE: buffer of %u bytes is too small\n", size);
+			return -1;
+		}
+		ring->entries = entries;
+		ftrace_buf = ring;
+	}
+
+	ring->magic = FTRACE_MAGIC;
+	ring->head = 0;
+	ring->mhz = 0;
+
+	ftrace_cycles_init();
+	ftrace_ring = ring;
+
+	printk_debug("FTRACE: %u events at 0x%08lx\n", ring->entries, (unsigned long) ring);
+
+	return 0;
+}
+
+void ftrace_stop(void) {
+	ftrace_ring = NULL;
+}
+
+void ftrace_dump(void) {
+	ftrace_header_t *ring = ftrace_buf;
+	ftrace_header_t *running = ftrace_ring;
+	uint32_t first, cycles;
+	uint64_t us;
+
+	if (!ring) {
+		printk(LOG_LEVEL_MUTE, "ftrace: nothing recorded\n");
+		return;
+	}
+
+	/* Nothing the dump itself calls should end up in the ring */
+	ftrace_ring = NULL;
+
+	/* Cycles per microsecond, for the converter */
+	cycles = ftrace_cycles();
+	us = time_us();
+	udelay(1000);
+	ring->mhz = (ftrace_cycles() - cycles) / (uint32_t) (time_us() - us);
+
+	first = ring->head > ring->entries ? ring->head - ring->entries : 0;
+	printk(LOG_LEVEL_MUTE, "ftrace: %u events, %u lost, %u MHz, ring at 0x%08lx\n", ring->head - first, first, ring->mhz, (unsigned long) ring);
+	for (uint32_t i = first; i != ring->head; i++) {
+		ftrace_event_t *e = &ring->event[i & (ring->entries - 1)];
+		printk(LOG_LEVEL_MUTE, "%08x %08x\n", e->cycles, e->fn);
+	}
+
+	ftrace_ring = running;
+}
@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <crc32.h>
+#include <log.h>
+#include <lz4.h>
+#include <meminfo.h>
+#include <string.h>
+#include <timer.h>
+
+#include <ff.h>
+
+#include "bootpack.h"
+
+uint32_t bootpack_crc32(uint32_t crc, const void *buf, uint32_t len) {
+	return crc32(crc, buf, len);
+}
+
+static int bootpack_check_head(bootpack_t *pack) {
+	bootpack_head_t *head = &pack->head;
+	uint32_t crc;
+
+	if (memcmp(head->magic, BOOTPACK_MAGIC, sizeof(BOOTPACK_MAGIC)) != 0) {
+		printk_error("BOOTPACK: bad magic\n");
+		return -1;
+	}
+
+	if (head->version != BOOTPACK_VERSION) {
+		printk_error("BOOTPACK: unsupported version %u\n", head->version);
+		return -1;
+	}
+
+	if (head->entry_count > BOOTPACK_MAX_ENTRIES || head->head_size < sizeof(bootpack_head_t) + head->entry_count * sizeof(bootpack_entry_t)) {
+		printk_error("BOOTPACK: bad TOC, %u entries\n", head->entry_count);
+		return -1;
+	}
+
+	crc = head->head_crc32;
+	head->head_crc32 = 0;
+	head->head_crc32 = bootpack_crc32(0, pack, sizeof(bootpack_head_t) + head->entry_count * sizeof(bootpack_entry_t));
+	if (head->head_crc32 != crc) {
+		printk_error("BOOTPACK: TOC crc32 mismatch 0x%08x != 0x%08x\n", head->head_crc32, crc);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Uncompressed entry b can share one read with a when the gap is the same in the container and in memory */
+static bool bootpack_can_merge(const bootpack_entry_t *a, const bootpack_entry_t *b) {
+	if ((a->flags | b->flags) & BOOTPACK_FLAG_LZ4)
+		return false;
+	if (b->offset < a->offset || b->load_addr < a->load_addr)
+		return false;
+	return b->offset - a->offset == b->load_addr - a->load_addr;
+}
+
+static int bootpack_load_lz4(bootpack_reader_t *reader, const bootpack_entry_t *entry) {
+	uint8_t *dst = (uint8_t *) entry->load_addr;
+	uint8_t *in = dst + entry->raw_size + LZ4_DECOMPRESS_INPLACE_MARGIN(entry->size) - entry->size;
+
+	/* Stream the block to the end of the output window, then decompress over it */
+	if (reader->read(reader, entry->offset, in, entry->size))
+		return -1;
+
+	if (lz4_decompress(in, entry->size, dst, entry->raw_size) != (int) entry->raw_size) {
+		printk_error("BOOTPACK: %s: decompress failed\n", entry->name);
+		return -1;
+	}
+
+	return 0;
+}
+
+int bootpack_load(bootpack_reader_t *reader, bootpack_t *pack) {
+	bootpack_entry_t *first, *last;
+	uint32_t start, reads = 0, bytes = 0;
+	uint32_t i, j;
+
+	start = time_ms();
+
+	/* One read covers the head and the whole TOC */
+	if (reader->read(reader, 0, pack, sizeof(bootpack_t))) {
+		printk_error("BOOTPACK: %s: read TOC failed\n", reader->name);
+		return -1;
+	}
+
+	if (bootpack_check_head(pack))
+		return -1;
+
+	for (i = 0; i < pack->head.entry_count; i = j) {
+		first = &pack->entry[i];
+		first->name[BOOTPACK_NAME_LEN - 1] = '\0';
+
+		if (first->flags & BOOTPACK_FLAG_LZ4) {
+			printk_debug("BOOTPACK: %s: %u -> %u bytes at 0x%08x\n", first->name, first->size, first->raw_size, first->load_addr);
+			if (bootpack_load_lz4(reader, first))
+				return -1;
+			reads++;
+			bytes += first->size;
+			j = i + 1;
+			continue;
+		}
+
+		/* Extend the read over the following payloads laid out the same way in memory */
+		for (j = i + 1, last = first; j < pack->head.entry_count && bootpack_can_merge(first, &pack->entry[j]); j++)
+			last = &pack->entry[j];
+
+		printk_debug("BOOTPACK: %s..%s: %u bytes at 0x%08x\n", first->name, last->name, last->offset + last->size - first->offset, first->load_addr);
+		if (reader->read(reader, first->offset, (void *) first->load_addr, last->offset + last->size - first->offset)) {
+			printk_error("BOOTPACK: %s: read failed\n", first->name);
+			return -1;
+		}
+		reads++;
+		bytes += last->offset + last->size - first->offset;
+	}
+
+	for (i = 0; i < pack->head.entry_count; i++) {
+		const bootpack_entry_t *entry = &pack->entry[i];
+
+		meminfo_claim(entry->name, entry->load_addr, entry->raw_size);
+
+		if (!(entry->flags & BOOTPACK_FLAG_CRC32))
+			continue;
+
+		if (bootpack_crc32(0, (void *) entry->load_addr, entry->raw_size) != entry->crc32) {
+			printk_error("BOOTPACK: %s: crc32 mismatch\n", entry->name);
+			return -1;
+		}
+	}
+
+	printk_info("BOOTPACK: %s: %u payloads, %uKB in %u reads, %ums\n", reader->name, pack->head.entry_count, bytes / 1024, reads + 1, time_ms() - start);
+
+	return 0;
+}
+
+const bootpack_entry_t *bootpack_find(const bootpack_t *pack, const char *name) {
+	uint32_t i;
+
+	for (i = 0; i < pack->head.entry_count; i++) {
+		if (strncmp(pack->entry[i].name, name, BOOTPACK_NAME_LEN) == 0)
+			return &pack->entry[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * f_lseek() is not built (FF_FS_MINIMIZE 3), so the file is only read forward:
+ * a gap before offset is read into buf, which the data overwrites right after,
+ * and going back means opening the file again.
+ */
+static int bootpack_fat_read(bootpack_reader_t *reader, uint32_t offset, void *buf, uint32_t len) {
+	FIL *file = reader->priv;
+	UINT byte_read = 0;
+	uint32_t skip;
+	FRESULT fret;
+
+	if (len == 0)
+		return 0;
+
+	if (offset < file->fptr) {
+		f_close(file);
+		fret = f_open(file, reader->name, FA_OPEN_EXISTING | FA_READ);
+		if (fret != FR_OK) {
+			printk_error("BOOTPACK: FATFS: reopen error %d\n", fret);
+			return -1;
+		}
+	}
+
+	while (file->fptr < offset) {
+		skip = offset - (uint32_t) file->fptr;
+		if (skip > len)
+			skip = len;
+		fret = f_read(file, buf, skip, &byte_read);
+		if (fret != FR_OK || byte_read != skip) {
+			printk_error("BOOTPACK: FATFS: skip to %u failed %d\n", offset, fret);
+			return -1;
+		}
+	}
+
+	fret = f_read(file, buf, len, &byte_read);
+	if (fret != FR_OK) {
+		printk_error("BOOTPACK: FATFS: read error %d\n", fret);
+		return -1;
+	}
+
+	/* The TOC read may run past the end of a small container */
+	if (byte_read != len && offset != 0) {
+		printk_error("BOOTPACK: FATFS: short read %u of %u\n", byte_read, len);
+		return -1;
+	}
+
+	return 0;
+}
+
+int bootpack_fat_open(bootpack_reader_t *reader, FIL *file, const char *filename) {
+	FRESULT fret;
+
+	fret = f_open(file, filename, FA_OPEN_EXISTING | FA_READ);
+	if (fret != FR_OK) {
+		printk_debug("BOOTPACK: FATFS: open %s error %d\n", filename, fret);
+		return -1;
+	}
+
+	reader->name = filename;
+	reader->priv = file;
+	reader->read = bootpack_fat_read;
+
+	return 0;
+}
+
+void bootpack_fat_close(bootpack_reader_t *reader) {
+	f_close((FIL *) reader->priv);
+}
@@ -6,67 +6,150 @@
 #include <timer.h>
 #include <types.h>
 
+#include <sstdlib.h>
+#include <string.h>
+
 #include "log.h"
+#include "log_persist.h"
 #include "uart.h"
 #include "xformat.h"
 
+#define LOG_SINK_CONSOLE (1 << 0)
+#define LOG_SINK_CAPTURE (1 << 1)
+
+int log_console_level = CONFIG_LOG_CONSOLE_LEVEL;
+int log_capture_level = LOG_LEVEL_DEFAULT;
+
+/* Everything compiled in is printed until log_module_set_levels() says otherwise */
+uint8_t log_module_level[LOG_MODULE_COUNT] = {[0 ... LOG_MODULE_COUNT - 1] = LOG_LEVEL_TRACE};
+
+const char *const log_module_name[LOG_MODULE_COUNT] = {
+		[LOG_MODULE_CORE] = "core",
+		[LOG_MODULE_DRAM] = "dram",
+		[LOG_MODULE_SMHC] = "smhc",
+		[LOG_MODULE_SPI] = "spi",
+		[LOG_MODULE_FATFS] = "fatfs",
+		[LOG_MODULE_USB] = "usb",
+		[LOG_MODULE_PMU] = "pmu",
+};
+
+/* Level letters of the plain prefix kept in the persistent log */
+static const char log_level_tag[] = {
+		[LOG_LEVEL_ERROR] = 'E',
+		[LOG_LEVEL_WARNING] = 'W',
+		[LOG_LEVEL_INFO] = 'I',
+		[LOG_LEVEL_DEBUG] = 'D',
+		[LOG_LEVEL_TRACE] = 'T',
+		[LOG_LEVEL_BACKTRACE] = 'B',
+};
+
+/* Untagged output and backtraces always go out */
+static inline bool log_level_enabled(int level, int limit) {
+	return level == LOG_LEVEL_MUTE || level == LOG_LEVEL_BACKTRACE || level <= limit;
+}
+
+/*
+ * Split a timestamp into seconds and microseconds. 1125899907 / 2^50 is
+ * 1 / 1000000 rounded up and exact for every 32-bit value, so one widening
+ * multiply replaces a division and a modulo.
+ */
+static inline uint32_t log_timestamp_split(uint32_t us, uint32_t *frac) {
+	uint32_t seconds = (uint32_t) (((uint64_t) us * 1125899907U) >> 50);
+
+	*frac = us - seconds * (1000 * 1000);
+	return seconds;
+}
+
+static void log_sink_write(void *arg, const char *s, unsigned len) {
+	uint32_t sinks = *(uint32_t *) arg;
+
+	if (sinks & LOG_SINK_CONSOLE)
+		uart_log_write(NULL, s, len);
+	if (sinks & LOG_SINK_CAPTURE)
+		while (len--)
+			log_persist_putc(*s++);
+}
+
+static void log_persist_putchar(void *arg, char c) {
+	log_persist_putc(c);
+}
+
 void printk(int level, const char *fmt, ...) {
+	uint32_t sinks = 0;
+
+	if (log_level_enabled(level, log_console_level))
+		sinks |= LOG_SINK_CONSOLE;
+#ifdef CONFIG_LOG_PERSIST
+	if (log_level_enabled(level, log_capture_level) && log_persist_active())
+		sinks |= LOG_SINK_CAPTURE;
+#endif
+
+	/* Nothing to do, skip the formatting as well */
+	if (!sinks)
+		return;
+
 	uint32_t now_timestamp = time_us() - get_init_timestamp();
-	uint32_t seconds = now_timestamp / (1000 * 1000);
-	uint32_t milliseconds = now_timestamp % (1000 * 1000);
+	uint32_t milliseconds;
+	uint32_t seconds = log_timestamp_split(now_timestamp, &milliseconds);
+
+	if ((sinks & LOG_SINK_CAPTURE) && level > LOG_LEVEL_MUTE && level <= LOG_LEVEL_BACKTRACE)
+		xformat(log_persist_putchar, NULL, "[%5lu.%06lu][%c] ", seconds, milliseconds, log_level_tag[level]);
 
+	if (sinks & LOG_SINK_CONSOLE) {
 #ifdef DISBALE_COLOR_PRINTK
-	switch (level) {
-		case LOG_LEVEL_TRACE:
-			uart_printf("[%5lu.%06lu][T] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_DEBUG:
-			uart_printf("[%5lu.%06lu][D] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_INFO:
-			uart_printf("[%5lu.%06lu][I] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_WARNING:
-			uart_printf("[%5lu.%06lu][W] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_ERROR:
-			uart_printf("[%5lu.%06lu][E] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_BACKTRACE:
-			uart_printf("[%5lu.%06lu][B] ", seconds, milliseconds);
-		case LOG_LEVEL_MUTE:
-		default:
-			break;
-	}
+		switch (level) {
+			case LOG_LEVEL_TRACE:
+				uart_printf("[%5lu.%06lu][T] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_DEBUG:
+				uart_printf("[%5lu.%06lu][D] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_INFO:
+				uart_printf("[%5lu.%06lu][I] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_WARNING:
+				uart_printf("[%5lu.%06lu][W] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_ERROR:
+				uart_printf("[%5lu.%06lu][E] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_BACKTRACE:
+				uart_printf("[%5lu.%06lu][B] ", seconds, milliseconds);
+			case LOG_LEVEL_MUTE:
+			default:
+				break;
+		}
 #else
-	switch (level) {
-		case LOG_LEVEL_TRACE:
-			uart_printf("[%5lu.%06lu][\033[30mT\033[37m] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_DEBUG:
-			uart_printf("[%5lu.%06lu][\033[32mD\033[37m] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_INFO:
-			uart_printf("[%5lu.%06lu][\033[36mI\033[37m] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_WARNING:
-			uart_printf("[%5lu.%06lu][\033[33mW\033[37m] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_ERROR:
-			uart_printf("[%5lu.%06lu][\033[31mE\033[37m] ", seconds, milliseconds);
-			break;
-		case LOG_LEVEL_BACKTRACE:
-			uart_printf("[%5lu.%06lu][\033[38;5;214mB\033[37m] ", seconds, milliseconds);
-		case LOG_LEVEL_MUTE:
-		default:
-			break;
-	}
+		switch (level) {
+			case LOG_LEVEL_TRACE:
+				uart_printf("[%5lu.%06lu][\033[30mT\033[37m] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_DEBUG:
+				uart_printf("[%5lu.%06lu][\033[32mD\033[37m] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_INFO:
+				uart_printf("[%5lu.%06lu][\033[36mI\033[37m] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_WARNING:
+				uart_printf("[%5lu.%06lu][\033[33mW\033[37m] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_ERROR:
+				uart_printf("[%5lu.%06lu][\033[31mE\033[37m] ", seconds, milliseconds);
+				break;
+			case LOG_LEVEL_BACKTRACE:
+				uart_printf("[%5lu.%06lu][\033[38;5;214mB\033[37m] ", seconds, milliseconds);
+			case LOG_LEVEL_MUTE:
+			default:
+				break;
+		}
 #endif
+	}
+
 	va_list args;
 	va_start(args, fmt);
 	va_list args_copy;
 	va_copy(args_copy, args);
-	xvformat(uart_log_putchar, NULL, fmt, args_copy);
+	xvformat_span(log_sink_write, &sinks, fmt, args_copy);
 	va_end(args);
 	va_end(args_copy);
 }
@@ -76,7 +159,7 @@ void uart_printf(const char *fmt, ...) {
 	va_start(args, fmt);
 	va_list args_copy;
 	va_copy(args_copy, args);
-	xvformat(uart_log_putchar, NULL, fmt, args_copy);
+	xvformat_span(uart_log_write, NULL, fmt, args_copy);
 	va_end(args);
 	va_end(args_copy);
 }
@@ -86,7 +169,7 @@ int printf(const char *fmt, ...) {
 	va_start(args, fmt);
 	va_list args_copy;
 	va_copy(args_copy, args);
-	xvformat(uart_log_putchar, NULL, fmt, args_copy);
+	xvformat_span(uart_log_write, NULL, fmt, args_copy);
 	va_end(args);
 	va_end(args_copy);
 
@@ -95,8 +178,8 @@ int printf(const char *fmt, ...) {
 
 int printf_dram(const char *fmt, ...) {
 	uint32_t now_timestamp = time_us() - get_init_timestamp();
-	uint32_t seconds = now_timestamp / (1000 * 1000);
-	uint32_t milliseconds = now_timestamp % (1000 * 1000);
+	uint32_t milliseconds;
+	uint32_t seconds = log_timestamp_split(now_timestamp, &milliseconds);
 
 	uart_printf("[%5lu.%06lu][\033[36mI\033[37m] ", seconds, milliseconds);
 
@@ -104,13 +187,65 @@ int printf_dram(const char *fmt, ...) {
 	va_start(args, fmt);
 	va_list args_copy;
 	va_copy(args_copy, args);
-	xvformat(uart_log_putchar, NULL, fmt, args_copy);
+	xvformat_span(uart_log_write, NULL, fmt, args_copy);
 	va_end(args);
 	va_end(args_copy);
 
 	return 0;
 }
 
+static int log_module_find(const char *name, unsigned len) {
+	for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+		if (strlen(log_module_name[i]) == len && !strncmp(log_module_name[i], name, len))
+			return i;
+	}
+
+	return -1;
+}
+
+int log_module_set_levels(const char *spec) {
+	const char *sep;
+	char *end;
+	unsigned long level;
+	int module;
+
+	for (;;) {
+		while (*spec == ' ')
+			spec++;
+		if (!*spec)
+			break;
+
+		for (sep = spec; *sep && *sep != ':' && *sep != '='; sep++)
+			;
+		if (!*sep)
+			goto _err;
+
+		level = simple_strtoul(sep + 1, &end, 10);
+		if (end == sep + 1 || level > LOG_LEVEL_TRACE || (*end && *end != ','))
+			goto _err;
+
+		if (sep - spec == 3 && !strncmp(spec, "all", 3)) {
+			memset(log_module_level, level, sizeof(log_module_level));
+		} else {
+			if ((module = log_module_find(spec, sep - spec)) < 0)
+				goto _err;
+			log_module_level[module] = level;
+		}
+
+		spec = *end ? end + 1 : end;
+	}
+
+	return 0;
+_err:
+	printk_warning("LOG: bad module level '%s', use module:level with 0-%d\n", spec, LOG_LEVEL_TRACE);
+	return -1;
+}
+
+void log_module_show(void) {
+	for (int i = 0; i < LOG_MODULE_COUNT; i++)
+		printk(LOG_LEVEL_MUTE, "%-6s %d, compiled in %d\n", log_module_name[i], log_module_level[i], LOG_MODULE_LEVEL_MAX(i));
+}
+
 void dump_hex(uint32_t start_addr, uint32_t count) {
 	uint8_t *ptr = (uint8_t *) start_addr;
 	uint32_t end_addr = start_addr + count;
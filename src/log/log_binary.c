@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <timer.h>
+#include <types.h>
+
+#include "log.h"
+#include "log_binary.h"
+
+static uint8_t *log_put32(uint8_t *p, uint32_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+	return p + 4;
+}
+
+static uint8_t *log_put64(uint8_t *p, uint64_t v) {
+	p = log_put32(p, (uint32_t) v);
+	return log_put32(p, (uint32_t) (v >> 32));
+}
+
+void log_binary_write(int level, const char *fmt, uint32_t types, ...) {
+	uint8_t rec[LOG_BINARY_HEAD_SIZE + LOG_BINARY_PAYLOAD_MAX];
+	uint8_t *p = rec + LOG_BINARY_HEAD_SIZE;
+	uint8_t *end = rec + sizeof(rec);
+	uint32_t now = time_us() - get_init_timestamp();
+	union {
+		double d;
+		uint64_t u;
+	} dbl;
+	const char *s;
+	uint32_t t, n;
+	va_list args;
+
+	/* Records are not text, so they only ever go to the console */
+	if (level > log_console_level)
+		return;
+
+	va_start(args, types);
+	for (t = types; t; t >>= LOG_ARG_BITS) {
+		/* Too much for one record, the decoder shows the missing arguments */
+		if (end - p < 9)
+			break;
+
+		switch (t & ((1 << LOG_ARG_BITS) - 1)) {
+			case LOG_ARG_W32:
+				p = log_put32(p, va_arg(args, uint32_t));
+				break;
+			case LOG_ARG_W64:
+				p = log_put64(p, va_arg(args, uint64_t));
+				break;
+			case LOG_ARG_DOUBLE:
+				dbl.d = va_arg(args, double);
+				p = log_put64(p, dbl.u);
+				break;
+			case LOG_ARG_STR:
+				s = va_arg(args, const char *);
+				if (!s)
+					s = "(null)";
+				/* Strings are copied now, the buffer may be gone when the record is decoded */
+				for (n = 0; s[n] && n < 255 && p + 1 + n < end; n++)
+					p[1 + n] = s[n];
+				p[0] = n;
+				p += 1 + n;
+				break;
+		}
+	}
+	va_end(args);
+
+	rec[0] = LOG_BINARY_SYNC;
+	rec[1] = p - rec - LOG_BINARY_HEAD_SIZE;
+	log_put32(&rec[2], (uint32_t) (unsigned long) fmt);
+	log_put32(&rec[6], now);
+	log_put32(&rec[10], (types & ((1 << LOG_ARG_LEVEL_SHIFT) - 1)) | ((uint32_t) level << LOG_ARG_LEVEL_SHIFT));
+
+	for (uint8_t *q = rec; q < p; q++)
+		log_putc(*q);
+}
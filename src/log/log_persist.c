@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <cache.h>
+#include <string.h>
+#include <uart.h>
+
+#include "fdt_wrapper.h"
+#include "libfdt.h"
+#include "log.h"
+#include "log_persist.h"
+
+static struct {
+	log_persist_header_t *hdr;
+	uint32_t capacity; /* bytes of hdr->data */
+	uint32_t dirty;	   /* offset in data of the first byte not written back yet */
+	uint32_t early_len;
+	char early[CONFIG_LOG_PERSIST_EARLY_SIZE];
+} log_persist;
+
+/**
+ * @brief Write the header and the bytes since the last newline back to DRAM
+ * @details The region is cached; without this a warm reset loses whatever is
+ *          still in the data cache.
+ */
+static void log_persist_writeback(void) {
+	log_persist_header_t *hdr = log_persist.hdr;
+	unsigned long data = (unsigned long) hdr->data;
+
+	if (hdr->start < log_persist.dirty) {
+		flush_dcache_range(data + log_persist.dirty, data + log_persist.capacity);
+		log_persist.dirty = 0;
+	}
+	flush_dcache_range((unsigned long) hdr, data);
+	flush_dcache_range(data + log_persist.dirty, data + hdr->start);
+	log_persist.dirty = hdr->start;
+}
+
+static void log_persist_store(char c) {
+	log_persist_header_t *hdr = log_persist.hdr;
+
+	hdr->data[hdr->start] = c;
+	if (++hdr->start == log_persist.capacity)
+		hdr->start = 0;
+	if (hdr->size < log_persist.capacity)
+		hdr->size++;
+
+	if (c == '\n')
+		log_persist_writeback();
+}
+
+void log_persist_putc(char c) {
+	if (log_persist.hdr)
+		log_persist_store(c);
+	else if (log_persist.early_len < CONFIG_LOG_PERSIST_EARLY_SIZE)
+		log_persist.early[log_persist.early_len++] = c;
+}
+
+bool log_persist_active(void) {
+	return log_persist.hdr || log_persist.early_len < CONFIG_LOG_PERSIST_EARLY_SIZE;
+}
+
+int log_persist_init(unsigned long base, uint32_t size) {
+	log_persist_header_t *hdr = (log_persist_header_t *) base;
+	uint32_t capacity = size - sizeof(*hdr);
+
+	if (size <= sizeof(*hdr) || (size & (size - 1))) {
+		printk_warning("LOG: persistent log size 0x%x is not a power of two\n", size);
+		return -1;
+	}
+
+	/* Keep the log of the previous boot if it still makes sense */
+	if (hdr->sig != LOG_PERSIST_SIG || hdr->start >= capacity || hdr->size > capacity ||
+		(hdr->size < capacity && hdr->start != hdr->size)) {
+		hdr->sig = LOG_PERSIST_SIG;
+		hdr->start = 0;
+		hdr->size = 0;
+	}
+
+	log_persist.capacity = capacity;
+	log_persist.dirty = hdr->start;
+	log_persist.hdr = hdr;
+
+	for (uint32_t i = 0; i < log_persist.early_len; i++)
+		log_persist_store(log_persist.early[i]);
+	log_persist.early_len = 0;
+	log_persist_writeback();
+
+	printk_debug("LOG: persistent log at 0x%08lx, %u of %u bytes in use\n", base, hdr->size, capacity);
+
+	return 0;
+}
+
+void log_persist_dump(void) {
+	log_persist_header_t *hdr = log_persist.hdr;
+	uint32_t i, pos;
+
+	if (!hdr) {
+#ifdef CONFIG_LOG_PERSIST
+		uart_puts("No persistent log, log_persist_init() was not called\n");
+#else
+		uart_puts("No persistent log, built without ENABLE_LOG_PERSIST\n");
+#endif
+		return;
+	}
+
+	/* Full rings start with the oldest byte at start, partial ones at 0 */
+	pos = hdr->size < log_persist.capacity ? 0 : hdr->start;
+	for (i = 0; i < hdr->size; i++) {
+		uart_putchar(hdr->data[pos]);
+		if (++pos == log_persist.capacity)
+			pos = 0;
+	}
+}
+
+void log_persist_clear(void) {
+	log_persist_header_t *hdr = log_persist.hdr;
+
+	if (!hdr)
+		return;
+
+	hdr->start = 0;
+	hdr->size = 0;
+	log_persist.dirty = 0;
+	log_persist_writeback();
+}
+
+/* "ramoops@<base in hex>", without depending on CONFIG_SPRINTF */
+static void log_persist_node_name(char *name, unsigned long base) {
+	static const char hex[] = "0123456789abcdef";
+	int shift;
+
+	strcpy(name, "ramoops@");
+	name += strlen(name);
+	for (shift = sizeof(base) * 8 - 4; shift > 0 && !(base >> shift); shift -= 4)
+		;
+	for (; shift >= 0; shift -= 4)
+		*name++ = hex[(base >> shift) & 0xf];
+	*name = '\0';
+}
+
+int log_persist_fdt_fixup(void *fdt) {
+	log_persist_header_t *hdr = log_persist.hdr;
+	unsigned long base = (unsigned long) hdr;
+	uint32_t size = log_persist.capacity + sizeof(*hdr);
+	char name[24];
+	int parent, node, ret;
+
+	if (!hdr)
+		return 0;
+
+	/* Enough for /reserved-memory and the node */
+	if ((ret = fdt_increase_size(fdt, 512)) != 0)
+		goto _err;
+
+	parent = fdt_path_offset(fdt, "/reserved-memory");
+	if (parent == -FDT_ERR_NOTFOUND) {
+		parent = fdt_add_subnode(fdt, 0, "reserved-memory");
+		if (parent >= 0) {
+			fdt_setprop_u32(fdt, parent, "#address-cells", fdt_address_cells(fdt, 0));
+			fdt_setprop_u32(fdt, parent, "#size-cells", fdt_size_cells(fdt, 0));
+			fdt_setprop(fdt, parent, "ranges", NULL, 0);
+		}
+	}
+	if ((ret = parent) < 0)
+		goto _err;
+
+	log_persist_node_name(name, base);
+	if ((ret = node = fdt_find_or_add_subnode(fdt, parent, name)) < 0)
+		goto _err;
+
+	/* The whole region is one console zone, no dmesg, ftrace or pmsg records */
+	fdt_delprop(fdt, node, "reg");
+	if ((ret = fdt_setprop_string(fdt, node, "compatible", "ramoops")) != 0 ||
+		(ret = fdt_appendprop_addrrange(fdt, parent, node, "reg", base, size)) != 0 ||
+		(ret = fdt_setprop_u32(fdt, node, "console-size", size)) != 0 ||
+		(ret = fdt_setprop_u32(fdt, node, "record-size", 0)) != 0)
+		goto _err;
+
+	printk_debug("FDT: /reserved-memory/%s for the persistent log\n", name);
+
+	return 0;
+_err:
+	printk_error("FDT: Can't add the persistent log node: %s\n", fdt_strerror(ret));
+	return -1;
+}
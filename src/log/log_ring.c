@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <io.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <reg-ncat.h>
+#include <sys-uart.h>
+
+#include "log.h"
+
+#if defined(CONFIG_CHIP_GIC) && defined(AW_IRQ_UART0)
+#include <interrupt.h>
+#include <sys-intc.h>
+#define LOG_RING_HAS_IRQ
+#endif
+
+/* Power of two, the indexes below run freely and are masked on access */
+#ifndef CONFIG_LOG_RING_SIZE
+#define CONFIG_LOG_RING_SIZE 4096
+#endif
+
+#define LOG_RING_MASK (CONFIG_LOG_RING_SIZE - 1)
+
+/* TX FIFO depth of the debug UART, the THRE interrupt fires once it is empty */
+#define UART_FIFO_SIZE 64
+
+#define UART_IER_ETBEI (1 << 1) /* transmit holding register empty interrupt */
+#define UART_IIR_ID_MASK 0xf
+#define UART_IIR_BUSY 0x7 /* LCR written while busy, cleared by reading USR */
+#define UART_LSR_THRE (1 << 5)
+#define UART_LSR_TEMT (1 << 6)
+#define UART_USR 0x7c
+
+_Static_assert((CONFIG_LOG_RING_SIZE & LOG_RING_MASK) == 0, "CONFIG_LOG_RING_SIZE must be a power of two");
+
+extern sunxi_serial_t uart_dbg;
+
+static struct {
+	char buf[CONFIG_LOG_RING_SIZE];
+	volatile uint32_t head; /* next byte written by log_putc() */
+	volatile uint32_t tail; /* next byte sent to the UART */
+	bool active;
+} log_ring;
+
+/**
+ * @brief Mask the CPU interrupt and return the previous mask state
+ * @details printk() may run in an interrupt handler too, so producers keep
+ *          the UART interrupt out while they touch the ring.
+ * @return Non-zero if the interrupt was already masked
+ */
+static inline uint32_t log_irq_save(void) {
+#ifdef LOG_RING_HAS_IRQ
+	uint32_t cpsr;
+
+	__asm__ __volatile__("mrs %0, cpsr" : "=r"(cpsr) : : "memory");
+	arm32_interrupt_disable();
+	return cpsr & (1 << 7);
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Restore the CPU interrupt mask saved by log_irq_save()
+ * @param flags Value returned by log_irq_save()
+ */
+static inline void log_irq_restore(uint32_t flags) {
+#ifdef LOG_RING_HAS_IRQ
+	if (!flags)
+		arm32_interrupt_enable();
+#endif
+}
+
+/**
+ * @brief Move up to one FIFO worth of bytes from the ring to the UART
+ * @details Only called once THRE reports an empty FIFO, so the writes never
+ *          have to check for space.
+ */
+static void log_ring_fill(sunxi_serial_reg_t *serial_reg) {
+	uint32_t tail = log_ring.tail;
+	int n;
+
+	for (n = 0; n < UART_FIFO_SIZE && tail != log_ring.head; n++, tail++)
+		serial_reg->thr = log_ring.buf[tail & LOG_RING_MASK];
+
+	log_ring.tail = tail;
+}
+
+/**
+ * @brief Empty the ring by polling, for full rings and masked interrupts
+ */
+static void log_ring_drain(sunxi_serial_reg_t *serial_reg, uint32_t until) {
+	while ((int32_t) (until - log_ring.tail) > 0) {
+		while ((serial_reg->lsr & UART_LSR_THRE) == 0)
+			;
+		log_ring_fill(serial_reg);
+	}
+}
+
+#ifdef LOG_RING_HAS_IRQ
+static void log_ring_irq_handler(void *data) {
+	sunxi_serial_reg_t *serial_reg = (sunxi_serial_reg_t *) data;
+
+	if ((serial_reg->iir & UART_IIR_ID_MASK) == UART_IIR_BUSY)
+		(void) read32(uart_dbg.base + UART_USR);
+
+	if (serial_reg->lsr & UART_LSR_THRE)
+		log_ring_fill(serial_reg);
+
+	/* Nothing left, THRE would keep firing */
+	if (log_ring.tail == log_ring.head)
+		serial_reg->ier &= ~UART_IER_ETBEI;
+}
+#endif
+
+static void log_ring_putc(char c) {
+	sunxi_serial_reg_t *serial_reg = (sunxi_serial_reg_t *) uart_dbg.base;
+	uint32_t flags = log_irq_save();
+
+	/* Full: make room the slow way instead of dropping the message */
+	if (log_ring.head - log_ring.tail >= CONFIG_LOG_RING_SIZE)
+		log_ring_drain(serial_reg, log_ring.head - CONFIG_LOG_RING_SIZE + UART_FIFO_SIZE);
+
+	log_ring.buf[log_ring.head & LOG_RING_MASK] = c;
+	log_ring.head++;
+
+	/* Enabling THRE with an empty FIFO raises the interrupt right away */
+	if (!(serial_reg->ier & UART_IER_ETBEI))
+		serial_reg->ier |= UART_IER_ETBEI;
+
+	log_irq_restore(flags);
+}
+
+void log_write(const char *s, unsigned len) {
+	sunxi_serial_reg_t *serial_reg = (sunxi_serial_reg_t *) uart_dbg.base;
+	uint32_t flags, head;
+
+	if (!len)
+		return;
+
+	if (!log_ring.active) {
+		while (len--)
+			sunxi_serial_putc(&uart_dbg, *s++);
+		return;
+	}
+
+	flags = log_irq_save();
+	head = log_ring.head;
+
+	while (len--) {
+		if (head - log_ring.tail >= CONFIG_LOG_RING_SIZE) {
+			log_ring.head = head;
+			log_ring_drain(serial_reg, head - CONFIG_LOG_RING_SIZE + UART_FIFO_SIZE);
+		}
+		log_ring.buf[head++ & LOG_RING_MASK] = *s++;
+	}
+	log_ring.head = head;
+
+	if (!(serial_reg->ier & UART_IER_ETBEI))
+		serial_reg->ier |= UART_IER_ETBEI;
+
+	log_irq_restore(flags);
+}
+
+void log_putc(char c) {
+	if (log_ring.active)
+		log_ring_putc(c);
+	else
+		sunxi_serial_putc(&uart_dbg, c);
+}
+
+int log_ring_irq_init(void) {
+#ifdef LOG_RING_HAS_IRQ
+	sunxi_serial_reg_t *serial_reg = (sunxi_serial_reg_t *) uart_dbg.base;
+	int irq = AW_IRQ_UART0 + uart_dbg.id;
+
+	if (log_ring.active)
+		return 0;
+
+	/* Only THRE is used, keep the receive interrupts of the shell off */
+	serial_reg->ier = 0;
+	irq_install_handler(irq, log_ring_irq_handler, serial_reg);
+	irq_enable(irq);
+	log_ring.head = log_ring.tail = 0;
+	log_ring.active = true;
+
+	printk_debug("LOG: %u byte ring on IRQ %d\n", CONFIG_LOG_RING_SIZE, irq);
+
+	return 0;
+#else
+	return -1;
+#endif
+}
+
+void log_flush(void) {
+	sunxi_serial_reg_t *serial_reg = (sunxi_serial_reg_t *) uart_dbg.base;
+	uint32_t flags;
+
+	if (!serial_reg)
+		return;
+
+	if (log_ring.active) {
+		flags = log_irq_save();
+		log_ring_drain(serial_reg, log_ring.head);
+		serial_reg->ier &= ~UART_IER_ETBEI;
+		log_irq_restore(flags);
+	}
+
+	/* Wait until the last byte has left the shift register */
+	while ((serial_reg->lsr & UART_LSR_TEMT) == 0)
+		;
+}
@@ -169,6 +169,36 @@ struct param_s {
 	char state;
 };
 
+/**
+ * Output of one xvformat call
+ */
+struct out_s {
+	/**
+	 * Character output, used when outspan is not set
+	 */
+	void (*outchar)(void *arg, char c);
+
+	/**
+	 * Span output, called with up to XCFG_FORMAT_SPAN chars at a time
+	 */
+	void (*outspan)(void *arg, const char *s, unsigned len);
+
+	/**
+	 * Argument for the output function
+	 */
+	void *arg;
+
+	/**
+	 * Number of chars waiting in buffer
+	 */
+	unsigned len;
+
+	/**
+	 * Chars not handed to outspan yet
+	 */
+	char buffer[XCFG_FORMAT_SPAN];
+};
+
 /**
  * Enum for the internal state machine
  */
@@ -241,6 +271,17 @@ static const char ms_false[] = "False";
  */
 static const char ms_digits[] = "0123456789abcdef";
 
+#if XCFG_FORMAT_FAST_DECIMAL
+/*
+ * Two digit values "00" to "99" for the decimal conversion
+ */
+static const char ms_digits2[] = "0001020304050607080910111213141516171819"
+								 "2021222324252627282930313233343536373839"
+								 "4041424344454647484950515253545556575859"
+								 "6061626364656667686970717273747576777879"
+								 "8081828384858687888990919293949596979899";
+#endif
+
 /*
  * This table contains the next state for all char and it will be
  * generate using xformattable.c
@@ -252,6 +293,46 @@ static const unsigned char formatStates[] = {0x06, 0x00, 0x00, 0x06, 0x00, 0x01,
 											 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x00, 0x70, 0x78, 0x78, 0x78, 0x70, 0x78, 0x00, 0x07, 0x08, 0x00, 0x00,
 											 0x07, 0x00, 0x00, 0x08, 0x08, 0x00, 0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x08, 0x00, 0x07};
 
+#if XCFG_FORMAT_FAST_DECIMAL
+/**
+ * Convert an unsigned value in decimal, two digits for each division
+ *
+ * Same contract as ulong2a() with radix 10, in half the steps.
+ */
+static void ulong2dec(struct param_s *param) {
+	unsigned LONG value = param->values.lvalue;
+	unsigned rem;
+
+	while (value >= 100) {
+		rem = (unsigned) (value % 100) * 2;
+		value /= 100;
+		*param->out-- = ms_digits2[rem + 1];
+		*param->out-- = ms_digits2[rem];
+		param->length += 2;
+		param->prec -= 2;
+	}
+
+	if (value >= 10) {
+		rem = (unsigned) value * 2;
+		*param->out-- = ms_digits2[rem + 1];
+		*param->out-- = ms_digits2[rem];
+		param->length += 2;
+		param->prec -= 2;
+	} else if (value) {
+		*param->out-- = ms_digits[value];
+		param->length++;
+		param->prec--;
+	}
+
+	while (param->prec-- > 0) {
+		*param->out-- = '0';
+		param->length++;
+	}
+
+	param->values.lvalue = 0;
+}
+#endif
+
 /**
  * Convert an unsigned value in one string
  *
@@ -266,6 +347,13 @@ static const unsigned char formatStates[] = {0x06, 0x00, 0x00, 0x06, 0x00, 0x01,
 static void ulong2a(struct param_s *param) {
 	unsigned char digit;
 
+#if XCFG_FORMAT_FAST_DECIMAL
+	if (param->radix == 10) {
+		ulong2dec(param);
+		return;
+	}
+#endif
+
 	while (param->prec-- > 0 || param->values.lvalue) {
 		switch (param->radix) {
 			case 2:
@@ -304,6 +392,37 @@ static void ulong2a(struct param_s *param) {
 static void ullong2a(struct param_s *param) {
 	unsigned char digit;
 
+#if XCFG_FORMAT_FAST_DECIMAL
+	/*
+	 * 32-bit targets divide a long long with a library call, so do one
+	 * for every 8 digits instead of one per digit. The remainder and the
+	 * last part fit in a long.
+	 */
+	if (param->radix == 10) {
+		unsigned LONGLONG value = param->values.llvalue;
+		unsigned LONG low;
+		unsigned rem;
+		int i;
+
+		while (value > (unsigned LONG) -1) {
+			low = (unsigned LONG) (value % 100000000);
+			value /= 100000000;
+			for (i = 0; i < 4; i++) {
+				rem = (unsigned) (low % 100) * 2;
+				low /= 100;
+				*param->out-- = ms_digits2[rem + 1];
+				*param->out-- = ms_digits2[rem];
+			}
+			param->length += 8;
+			param->prec -= 8;
+		}
+
+		param->values.lvalue = (unsigned LONG) value;
+		ulong2dec(param);
+		return;
+	}
+#endif
+
 	while (param->prec-- > 0 || param->values.llvalue) {
 		switch (param->radix) {
 			case 2:
@@ -375,11 +494,37 @@ static unsigned xstrlen(const char *s) {
 	return (unsigned) (i - s);
 }
 
-static unsigned outBuffer(void (*myoutchar)(void *arg, char), void *arg, const char *buffer, int len, unsigned toupper) {
+static void outFlush(struct out_s *out) {
+	if (out->len) {
+		(*out->outspan)(out->arg, out->buffer, out->len);
+		out->len = 0;
+	}
+}
+
+static inline void outChar(struct out_s *out, char c) {
+	if (!out->outspan) {
+		(*out->outchar)(out->arg, c);
+		return;
+	}
+
+	if (out->len == sizeof(out->buffer))
+		outFlush(out);
+
+	out->buffer[out->len++] = c;
+}
+
+static unsigned outBuffer(struct out_s *out, const char *buffer, int len, unsigned toupper) {
 	unsigned count = 0;
 	int i;
 	char c;
 
+	/* Long strings go out as they are instead of through the buffer */
+	if (out->outspan && !toupper && len > (int) sizeof(out->buffer)) {
+		outFlush(out);
+		(*out->outspan)(out->arg, buffer, len);
+		return len;
+	}
+
 	for (i = 0; i < len; i++) {
 		c = buffer[i];
 
@@ -387,18 +532,18 @@ static unsigned outBuffer(void (*myoutchar)(void *arg, char), void *arg, const c
 			c -= 'a' - 'A';
 		}
 
-		(*myoutchar)(arg, c);
+		outChar(out, c);
 		count++;
 	}
 
 	return count;
 }
 
-static unsigned outChars(void (*myoutchar)(void *arg, char), void *arg, char ch, int len) {
+static unsigned outChars(struct out_s *out, char ch, int len) {
 	unsigned count = 0;
 
 	while (len-- > 0) {
-		(*myoutchar)(arg, ch);
+		outChar(out, ch);
 		count++;
 	}
 
@@ -449,14 +594,13 @@ static unsigned outChars(void (*myoutchar)(void *arg, char), void *arg, char ch,
  * - f	Floating point number.
  * - B	Boolean value printed as True / False.
  *
- * @param outchar - Pointer to the function to output one char.
- * @param arg	- Argument for the output function.
+ * @param out	- Output function, its argument and the span buffer.
  * @param fmt	- Format options for the list of parameters.
  * @param args	-List parameters.
  *
  * @return The number of char emitted.
  */
-unsigned xvformat(void (*outchar)(void *, char), void *arg, const char *fmt, va_list _args) {
+static unsigned xvformat_out(struct out_s *out, const char *fmt, va_list _args) {
 	XCFG_FORMAT_STATIC struct param_s param;
 	int i;
 	char c;
@@ -485,7 +629,7 @@ unsigned xvformat(void (*outchar)(void *, char), void *arg, const char *fmt, va_
 		switch (param.state) {
 			default:
 			case ST_NORMAL:
-				(*outchar)(arg, c);
+				outChar(out, c);
 				param.count++;
 				break;
 
@@ -862,12 +1006,12 @@ unsigned xvformat(void (*outchar)(void *, char), void *arg, const char *fmt, va_
 				 */
 				param.width -= (param.length + param.prefixlen);
 
-				param.count += outBuffer(outchar, arg, param.prefix, param.prefixlen, param.flags & FLAG_UPPER);
+				param.count += outBuffer(out, param.prefix, param.prefixlen, param.flags & FLAG_UPPER);
 				if (!(param.flags & FLAG_LEFT))
-					param.count += outChars(outchar, arg, param.pad, param.width);
-				param.count += outBuffer(outchar, arg, param.out, param.length, param.flags & FLAG_UPPER);
+					param.count += outChars(out, param.pad, param.width);
+				param.count += outBuffer(out, param.out, param.length, param.flags & FLAG_UPPER);
 				if (param.flags & FLAG_LEFT)
-					param.count += outChars(outchar, arg, param.pad, param.width);
+					param.count += outChars(out, param.pad, param.width);
 		}
 	}
 
@@ -875,7 +1019,59 @@ unsigned xvformat(void (*outchar)(void *, char), void *arg, const char *fmt, va_
 	va_end(args);
 #endif
 
+	if (out->outspan)
+		outFlush(out);
+
 	return param.count;
 }
 
+/**
+ * Printf like format function, one char at a time.
+ *
+ * @param outchar - Pointer to the function to output one char.
+ * @param arg	- Argument for the output function.
+ * @param fmt	- Format options for the list of parameters.
+ * @param args	-List parameters.
+ *
+ * @return The number of char emitted.
+ *
+ * @see xvformat_out
+ */
+unsigned xvformat(void (*outchar)(void *, char), void *arg, const char *fmt, va_list args) {
+	struct out_s out;
+
+	out.outchar = outchar;
+	out.outspan = 0;
+	out.arg = arg;
+
+	return xvformat_out(&out, fmt, args);
+}
+
+/**
+ * Printf like format function, output in spans.
+ *
+ * Literal text and fields are collected in a buffer on the stack and handed
+ * to outspan in pieces of up to XCFG_FORMAT_SPAN chars, so the output side
+ * pays its per call cost once per span instead of once per char.
+ *
+ * @param outspan - Pointer to the function to output a span of chars.
+ * @param arg	- Argument for the output function.
+ * @param fmt	- Format options for the list of parameters.
+ * @param args	-List parameters.
+ *
+ * @return The number of char emitted.
+ *
+ * @see xvformat_out
+ */
+unsigned xvformat_span(void (*outspan)(void *, const char *, unsigned), void *arg, const char *fmt, va_list args) {
+	struct out_s out;
+
+	out.outchar = 0;
+	out.outspan = outspan;
+	out.arg = arg;
+	out.len = 0;
+
+	return xvformat_out(&out, fmt, args);
+}
+
 /*lint -restore */
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <lz4.h>
+
+#define LZ4_MIN_MATCH 4
+
+/**
+ * @brief Read an LZ4 length extension (a run of 255 bytes ended by a smaller byte).
+ *
+ * @param ip Pointer to the input cursor, advanced past the extension.
+ * @param iend End of the input.
+ * @param len Pointer to the length to extend.
+ * @return 0 on success, -1 if the input ends inside the extension.
+ */
+static int lz4_read_length(const uint8_t **ip, const uint8_t *iend, uint32_t *len) {
+	uint8_t b;
+
+	do {
+		if (*ip >= iend)
+			return -1;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+
+	return 0;
+}
+
+int lz4_decompress(const uint8_t *src, uint32_t src_len, uint8_t *dst, uint32_t dst_cap) {
+	const uint8_t *ip = src;
+	const uint8_t *iend = src + src_len;
+	uint8_t *op = dst;
+	uint8_t *oend = dst + dst_cap;
+	const uint8_t *match;
+	uint32_t token, len, offset;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		/* Literals */
+		len = token >> 4;
+		if (len == 15 && lz4_read_length(&ip, iend, &len))
+			return -1;
+		if (len > (uint32_t) (iend - ip) || len > (uint32_t) (oend - op))
+			return -1;
+		while (len--)
+			*op++ = *ip++;
+
+		/* The last sequence carries literals only */
+		if (ip >= iend)
+			break;
+
+		/* Match */
+		if (iend - ip < 2)
+			return -1;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (uint32_t) (op - dst))
+			return -1;
+
+		len = token & 0xf;
+		if (len == 15 && lz4_read_length(&ip, iend, &len))
+			return -1;
+		len += LZ4_MIN_MATCH;
+		if (len > (uint32_t) (oend - op))
+			return -1;
+
+		/* Byte copy, the match may overlap the bytes being produced */
+		match = op - offset;
+		while (len--)
+			*op++ = *match++;
+	}
+
+	return op - dst;
+}
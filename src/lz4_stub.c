@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <lz4.h>
+
+#ifndef CONFIG_COMPRESS_STUB_SIZE
+#define CONFIG_COMPRESS_STUB_SIZE 0x1000
+#endif
+
+extern uint8_t __spl_start[];
+extern uint8_t __lz4_payload_start[];
+extern uint8_t __lz4_payload_end[];
+
+/*
+ * Patched by mksunxi, volatile so the compiler does not fold the
+ * zero link-time values into the code.
+ */
+const volatile __attribute__((section(".lz4_stub_info"), used)) lz4_stub_info_t lz4_stub_info = {
+		.magic = LZ4_STUB_MAGIC,
+		.stub_size = CONFIG_COMPRESS_STUB_SIZE,
+		.comp_size = 0,
+		.raw_size = 0,
+};
+
+/**
+ * @brief Stop here, nothing is initialized yet to report an error.
+ */
+static void __attribute__((noreturn)) lz4_stub_hang(void) {
+	while (1)
+		;
+}
+
+/**
+ * @brief Decompress the payload appended behind the stub in place.
+ *
+ * The BROM loaded the compressed stream right after the stub, which is also
+ * where the payload is linked to run. The stream is first moved to the end of
+ * the output window, then decompressed forward over its own old location.
+ *
+ * @return Entry address of the decompressed payload.
+ */
+void *lz4_stub_main(void) {
+	uint32_t comp_size = lz4_stub_info.comp_size;
+	uint32_t raw_size = lz4_stub_info.raw_size;
+	uint8_t *src = __spl_start + lz4_stub_info.stub_size;
+	uint8_t *dst = __lz4_payload_start;
+	uint8_t *in;
+	uint32_t i;
+
+	/* Image was not packed by mksunxi, or does not fit in SRAM */
+	if (comp_size == 0 || raw_size == 0)
+		lz4_stub_hang();
+	if (raw_size + LZ4_DECOMPRESS_INPLACE_MARGIN(comp_size) > (uint32_t) (__lz4_payload_end - dst))
+		lz4_stub_hang();
+	/* A stream longer than that would have to move down over the running stub, mksunxi rejects it */
+	if (comp_size > raw_size + LZ4_DECOMPRESS_INPLACE_MARGIN(comp_size))
+		lz4_stub_hang();
+
+	/* The stream only moves up from where the BROM put it, copy backwards */
+	in = dst + raw_size + LZ4_DECOMPRESS_INPLACE_MARGIN(comp_size) - comp_size;
+	for (i = comp_size; i > 0; i--)
+		in[i - 1] = src[i - 1];
+
+	if (lz4_decompress(in, comp_size, dst, raw_size) != (int) raw_size)
+		lz4_stub_hang();
+
+	return dst;
+}
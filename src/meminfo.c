@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <string.h>
+
+#include "meminfo.h"
+
+/* Debug and trace builds only, release builds get the empty inlines of meminfo.h */
+#ifdef CONFIG_HEAP_STATS
+
+/*
+ * Weak so that images linked with a board specific script lacking one of
+ * these symbols still build, the missing section is then skipped.
+ */
+extern char __spl_start[] __attribute__((weak));
+extern char __text_end[] __attribute__((weak));
+extern char __spl_end[] __attribute__((weak));
+extern char _sbss[] __attribute__((weak));
+extern char _ebss[] __attribute__((weak));
+extern char _end[] __attribute__((weak));
+
+typedef struct meminfo_region {
+	char name[MEMINFO_NAME_LEN];
+	unsigned long base;
+	unsigned long size;
+} meminfo_region_t;
+
+static meminfo_region_t regions[MEMINFO_MAX_REGIONS];
+static uint32_t region_count;
+
+void meminfo_claim(const char *name, unsigned long base, unsigned long size) {
+	meminfo_region_t *r;
+
+	for (r = regions; r < regions + region_count; r++) {
+		if (r->base == base && r->size == size && !strncmp(r->name, name, MEMINFO_NAME_LEN - 1))
+			return;
+		if (base < r->base + r->size && r->base < base + size)
+			printk_warning("MEMINFO: %s 0x%08lx-0x%08lx overlaps %s 0x%08lx-0x%08lx\n", name, base, base + size, r->name, r->base, r->base + r->size);
+	}
+
+	if (region_count == MEMINFO_MAX_REGIONS) {
+		printk_warning("MEMINFO: no slot left for %s\n", name);
+		return;
+	}
+
+	strncpy(r->name, name, MEMINFO_NAME_LEN - 1);
+	r->base = base;
+	r->size = size;
+	region_count++;
+}
+
+static void meminfo_print_range(const char *name, const char *start, const char *end) {
+	if (!start || !end)
+		return;
+
+	printk(LOG_LEVEL_MUTE, "  %-8s 0x%08lx-0x%08lx %8lu bytes\n", name, (unsigned long) start, (unsigned long) end, (unsigned long) (end - start));
+}
+
+void meminfo_dump(void) {
+	printk(LOG_LEVEL_MUTE, "image:\n");
+	if (__text_end) {
+		meminfo_print_range("text", __spl_start, __text_end);
+		meminfo_print_range("data", __text_end, __spl_end);
+	} else {
+		meminfo_print_range("image", __spl_start, __spl_end);
+	}
+	meminfo_print_range("bss", _sbss, _ebss);
+	meminfo_print_range("stack", _ebss, _end);
+
+	smalloc_dump();
+
+	printk(LOG_LEVEL_MUTE, "regions:\n");
+	for (uint32_t i = 0; i < region_count; i++)
+		printk(LOG_LEVEL_MUTE, "  %-8s 0x%08lx-0x%08lx %8lu bytes\n", regions[i].name, regions[i].base, regions[i].base + regions[i].size, regions[i].size);
+}
+
+#endif// CONFIG_HEAP_STATS
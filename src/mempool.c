@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <string.h>
+
+#include "meminfo.h"
+#include "mempool.h"
+#include "smalloc.h"
+
+/* Largest data cache line of the supported cores, coherent buffers never share one */
+#define DMA_ALIGN 64
+
+typedef struct mem_pool {
+	smalloc_pool_t *heap;
+	unsigned long base;
+	unsigned long end;
+} mem_pool_t;
+
+static mem_pool_t pools[MEM_ATTR_COUNT];
+
+static const char *const mem_attr_name[MEM_ATTR_COUNT] = {
+		[MEM_ATTR_CACHED] = "pool-cached",
+		[MEM_ATTR_WRITECOMBINE] = "pool-wc",
+		[MEM_ATTR_UNCACHED] = "pool-uncached",
+};
+
+int __attribute__((weak)) arch_mem_set_attr(unsigned long base, unsigned long size, mem_attr_t attr) {
+	return attr == MEM_ATTR_CACHED ? 0 : -1;
+}
+
+int mem_pool_init(mem_attr_t attr, void *base, uint32_t size) {
+	mem_pool_t *pool;
+
+	if (attr >= MEM_ATTR_COUNT)
+		return -1;
+
+	pool = &pools[attr];
+	pool->heap = NULL;
+	if (arch_mem_set_attr((unsigned long) base, size, attr) != 0) {
+		printk_error("MEMPOOL: %s 0x%08lx: attribute not supported here\n", mem_attr_name[attr], (unsigned long) base);
+		return -1;
+	}
+
+	pool->heap = smalloc_pool_create(base, size);
+	if (!pool->heap) {
+		printk_error("MEMPOOL: %s 0x%08lx: region too small\n", mem_attr_name[attr], (unsigned long) base);
+		return -1;
+	}
+
+	pool->base = (unsigned long) base;
+	pool->end = pool->base + size;
+	meminfo_claim(mem_attr_name[attr], pool->base, size);
+
+	printk_debug("MEMPOOL: %s 0x%08lx-0x%08lx\n", mem_attr_name[attr], pool->base, pool->end);
+
+	return 0;
+}
+
+bool mem_pool_is_ready(mem_attr_t attr) {
+	return attr < MEM_ATTR_COUNT && pools[attr].heap;
+}
+
+void *mem_pool_alloc(mem_attr_t attr, uint32_t size, uint32_t align) {
+	if (attr >= MEM_ATTR_COUNT || !pools[attr].heap)
+		return NULL;
+
+	return smalloc_pool_alloc(pools[attr].heap, size, align);
+}
+
+void mem_pool_free(void *p) {
+	unsigned long addr = (unsigned long) p;
+
+	for (int i = 0; i < MEM_ATTR_COUNT; i++) {
+		if (pools[i].heap && addr >= pools[i].base && addr < pools[i].end) {
+			smalloc_pool_free(pools[i].heap, p);
+			return;
+		}
+	}
+}
+
+void *dma_alloc_coherent(uint32_t size, uint32_t *dma_handle) {
+	void *p = mem_pool_alloc(MEM_ATTR_UNCACHED, (size + DMA_ALIGN - 1) & ~(DMA_ALIGN - 1), DMA_ALIGN);
+
+	if (!p) {
+		printk_error("MEMPOOL: dma_alloc_coherent %u bytes failed\n", size);
+		return NULL;
+	}
+
+	memset(p, 0, size);
+
+	if (dma_handle)
+		*dma_handle = (uint32_t) (unsigned long) p;
+
+	return p;
+}
+
+void dma_free_coherent(void *p) {
+	mem_pool_free(p);
+}
@@ -0,0 +1,290 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <io.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <log.h>
+#include <string.h>
+#include <timer.h>
+
+#include <reg-ncat.h>
+
+#include "profile.h"
+
+#if defined(__arm__) && defined(CONFIG_CHIP_GIC)
+#include <interrupt.h>
+#include <mmu.h>
+#include <sys-gic.h>
+#define PROFILE_HAS_TIMER
+#elif defined(__riscv) && __riscv_xlen == 64 && defined(SUNXI_RISCV_CLINT_BASE)
+#include <csr.h>
+#include <interrupt.h>
+#define PROFILE_HAS_TIMER
+#endif
+
+/* Arch timer and CLINT both count at 24 MHz */
+#define PROFILE_TIMER_FREQ 24000000
+
+/* Slots tried for a new pair before the sample is counted as dropped */
+#define PROFILE_PROBES 16
+
+_Static_assert((CONFIG_PROFILE_EARLY_ENTRIES & (CONFIG_PROFILE_EARLY_ENTRIES - 1)) == 0,
+			   "CONFIG_PROFILE_EARLY_ENTRIES must be a power of two");
+
+static profile_entry_t profile_early[CONFIG_PROFILE_EARLY_ENTRIES];
+
+static struct {
+	profile_entry_t *entry;
+	uint32_t entries; /* power of two */
+	uint32_t shift;	  /* 32 - log2(entries), for the hash */
+	uint32_t used;
+	uint32_t samples;
+	uint32_t dropped;
+	uint32_t hz;
+	uint32_t period; /* timer ticks between samples */
+	bool running;
+} profile = {
+		.entry = profile_early,
+		.entries = CONFIG_PROFILE_EARLY_ENTRIES,
+		.shift = 32 - __builtin_ctz(CONFIG_PROFILE_EARLY_ENTRIES),
+};
+
+/**
+ * @brief Count a (pc, ra) pair, open addressing with linear probing
+ * @param count Samples to add, more than one when moving a table
+ * @return 0 on success, -1 if no free slot was found close enough
+ */
+static int profile_add(uint32_t pc, uint32_t ra, uint32_t count) {
+	uint32_t mask = profile.entries - 1;
+	uint32_t i = ((pc ^ (ra << 7)) * 0x9e3779b1U) >> profile.shift;
+	profile_entry_t *e;
+
+	for (int n = 0; n < PROFILE_PROBES; n++, i = (i + 1) & mask) {
+		e = &profile.entry[i];
+		if (e->count == 0) {
+			e->pc = pc;
+			e->ra = ra;
+			e->count = count;
+			profile.used++;
+			return 0;
+		}
+		if (e->pc == pc && e->ra == ra) {
+			e->count += count;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+static void profile_sample(uint32_t pc, uint32_t ra) {
+	profile.samples++;
+	if (profile_add(pc, ra, 1))
+		profile.dropped++;
+}
+
+#if defined(PROFILE_HAS_TIMER) && defined(__arm__)
+/* Secure physical timer, SyterKit runs in the secure world */
+#define PROFILE_TIMER_IRQ 29
+
+#define CNTP_CTL_ENABLE (1 << 0)
+
+static inline uint32_t profile_irq_save(void) {
+	uint32_t cpsr;
+
+	__asm__ __volatile__("mrs %0, cpsr" : "=r"(cpsr) : : "memory");
+	arm32_interrupt_disable();
+	return cpsr & (1 << 7);
+}
+
+static inline void profile_irq_restore(uint32_t flags) {
+	if (!flags)
+		arm32_interrupt_enable();
+}
+
+/* CNTP_TVAL counts down from the value written, the interrupt fires at 0 */
+static inline void profile_timer_arm(uint32_t ticks) {
+	__asm__ __volatile__("mcr p15, 0, %0, c14, c2, 0" : : "r"(ticks));
+}
+
+static inline void profile_timer_ctl(uint32_t ctl) {
+	__asm__ __volatile__("mcr p15, 0, %0, c14, c2, 1" : : "r"(ctl));
+	__asm__ __volatile__("isb" : : : "memory");
+}
+
+static void profile_timer_irq(void *data) {
+	struct arm_regs_t *regs = get_irq_regs();
+
+	/* Rearming also drops the level of the PPI */
+	profile_timer_arm(profile.period);
+	if (regs)
+		profile_sample(regs->pc, regs->lr);
+}
+
+static void profile_timer_start(void) {
+	irq_install_handler(PROFILE_TIMER_IRQ, profile_timer_irq, NULL);
+	profile_timer_arm(profile.period);
+	profile_timer_ctl(CNTP_CTL_ENABLE);
+	irq_enable(PROFILE_TIMER_IRQ);
+	arm32_interrupt_enable();
+}
+
+static void profile_timer_stop(void) {
+	profile_timer_ctl(0);
+	irq_disable(PROFILE_TIMER_IRQ);
+	irq_free_handler(PROFILE_TIMER_IRQ);
+}
+#elif defined(PROFILE_HAS_TIMER)
+#define PROFILE_TIMER_CAUSE 7 /* machine timer interrupt */
+
+#define CLINT_MTIMECMPL (SUNXI_RISCV_CLINT_BASE + 0x4000)
+#define CLINT_MTIMECMPH (SUNXI_RISCV_CLINT_BASE + 0x4004)
+
+/* Trap frame of start.S, left in mscratch by the trap handler */
+#define PROFILE_FRAME_RA 1
+#define PROFILE_FRAME_EPC 33
+
+static inline uint32_t profile_irq_save(void) {
+	return csr_read_clear(mstatus, MSTATUS_MIE) & MSTATUS_MIE;
+}
+
+static inline void profile_irq_restore(uint32_t flags) {
+	if (flags)
+		riscv_interrupt_enable();
+}
+
+/* The interrupt is pending while mtime >= mtimecmp, a new compare value clears it */
+static void profile_timer_arm(uint32_t ticks) {
+	uint64_t next = get_arch_counter() + ticks;
+
+	/* No early match while the halves are written one at a time */
+	writel(0xffffffff, CLINT_MTIMECMPH);
+	writel((uint32_t) next, CLINT_MTIMECMPL);
+	writel((uint32_t) (next >> 32), CLINT_MTIMECMPH);
+}
+
+static void profile_timer_irq(void *data) {
+	unsigned long *frame = (unsigned long *) csr_read(mscratch);
+
+	profile_timer_arm(profile.period);
+	profile_sample((uint32_t) frame[PROFILE_FRAME_EPC], (uint32_t) frame[PROFILE_FRAME_RA]);
+}
+
+static void profile_timer_start(void) {
+	riscv64_install_core_handler(PROFILE_TIMER_CAUSE, profile_timer_irq, NULL);
+	profile_timer_arm(profile.period);
+	csr_set(mie, MIE_MTIE);
+	riscv_interrupt_enable();
+}
+
+static void profile_timer_stop(void) {
+	csr_clear(mie, MIE_MTIE);
+	riscv64_install_core_handler(PROFILE_TIMER_CAUSE, NULL, NULL);
+}
+#else
+static inline uint32_t profile_irq_save(void) {
+	return 0;
+}
+
+static inline void profile_irq_restore(uint32_t flags) {
+}
+
+static void profile_timer_start(void) {
+}
+
+static void profile_timer_stop(void) {
+}
+#endif
+
+int profile_start(uint32_t hz) {
+#ifdef PROFILE_HAS_TIMER
+	if (hz == 0)
+		hz = CONFIG_PROFILE_HZ;
+	if (hz > PROFILE_TIMER_FREQ / 1000) {
+		printk_warning("PROFILE: %u Hz is too fast, using %u Hz\n", hz, PROFILE_TIMER_FREQ / 1000);
+		hz = PROFILE_TIMER_FREQ / 1000;
+	}
+
+	if (profile.running)
+		profile_stop();
+
+	memset(profile.entry, 0, profile.entries * sizeof(profile_entry_t));
+	profile.used = profile.samples = profile.dropped = 0;
+	profile.hz = hz;
+	profile.period = PROFILE_TIMER_FREQ / hz;
+	profile.running = true;
+
+	profile_timer_start();
+
+	printk_debug("PROFILE: sampling at %u Hz, %u slots at 0x%08lx\n", hz, profile.entries, (unsigned long) profile.entry);
+
+	return 0;
+#else
+	printk_warning("PROFILE: no profiler timer on this chip\n");
+	return -1;
+#endif
+}
+
+void profile_stop(void) {
+	if (!profile.running)
+		return;
+
+	profile_timer_stop();
+	profile.running = false;
+}
+
+int profile_set_buffer(void *buf, uint32_t size) {
+	profile_entry_t *old = profile.entry;
+	uint32_t old_entries = profile.entries;
+	uint32_t entries = 1, flags, i;
+
+	while (entries * 2 * sizeof(profile_entry_t) <= size)
+		entries *= 2;
+
+	if (!buf || entries < old_entries) {
+		printk_warning("PROFILE: buffer of %u bytes is smaller than the current table\n", size);
+		return -1;
+	}
+
+	memset(buf, 0, entries * sizeof(profile_entry_t));
+
+	flags = profile_irq_save();
+	profile.entry = buf;
+	profile.entries = entries;
+	profile.shift = 32 - __builtin_ctz(entries);
+	profile.used = 0;
+	for (i = 0; i < old_entries; i++) {
+		if (old[i].count && profile_add(old[i].pc, old[i].ra, old[i].count))
+			profile.dropped += old[i].count;
+	}
+	profile_irq_restore(flags);
+
+	printk_debug("PROFILE: %u slots at 0x%08lx\n", entries, (unsigned long) buf);
+
+	return 0;
+}
+
+bool profile_running(void) {
+	return profile.running;
+}
+
+void profile_dump(void) {
+	bool running = profile.running;
+
+	/* A stable table, and no samples of the dump itself */
+	profile_stop();
+
+	printk(LOG_LEVEL_MUTE, "profile: %u samples at %u Hz, %u entries, %u dropped\n", profile.samples, profile.hz, profile.used, profile.dropped);
+	for (uint32_t i = 0; i < profile.entries; i++) {
+		if (profile.entry[i].count)
+			printk(LOG_LEVEL_MUTE, "0x%08x 0x%08x %u\n", profile.entry[i].pc, profile.entry[i].ra, profile.entry[i].count);
+	}
+
+	if (running) {
+		profile.running = true;
+		profile_timer_start();
+	}
+}
@@ -6,122 +6,582 @@
 #include <string.h>
 #include <types.h>
 
+#include <log.h>
+
 #include "smalloc.h"
 
-static struct alloc_struct_t boot_heap_head, boot_heap_tail;
+/*
+ * Two-level segregated fit allocator.
+ *
+ * Free blocks are kept in size class lists indexed by the position of the
+ * highest set bit of the size (first level) and the next SL_INDEX_COUNT_LOG2
+ * bits below it (second level). A bitmap per level tells which lists are
+ * non-empty, so malloc finds a fitting list with two find-first-set
+ * operations and free merges with both physical neighbours right away.
+ */
+#define ALIGN_SIZE_LOG2 4
+#define ALIGN_SIZE (1UL << ALIGN_SIZE_LOG2)
 
-int32_t smalloc_init(uint32_t p_heap_head, uint32_t n_heap_size) {
-	boot_heap_head.size = boot_heap_tail.size = 0;
-	boot_heap_head.address = p_heap_head;
-	boot_heap_tail.address = p_heap_head + n_heap_size;
-	boot_heap_head.next = &boot_heap_tail;
-	boot_heap_tail.next = 0;
-	return 0;
+#define SL_INDEX_COUNT_LOG2 4
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+
+#define FL_INDEX_MAX 30
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+
+#define SMALL_BLOCK_SIZE (1UL << FL_INDEX_SHIFT)
+
+/* Size flags, sizes are multiples of ALIGN_SIZE so the low bits are free */
+#define BLOCK_FREE (1UL << 0)
+#define BLOCK_PREV_FREE (1UL << 1)
+#define BLOCK_FLAGS (BLOCK_FREE | BLOCK_PREV_FREE)
+
+typedef struct tlsf_block_t {
+	struct tlsf_block_t *prev_phys; /* previous block in memory */
+	unsigned long size;				/* payload size and BLOCK_* flags */
+#ifdef CONFIG_HEAP_STATS
+	const char *tag; /* function that allocated the block */
+#endif
+} __attribute__((aligned(ALIGN_SIZE))) tlsf_block_t;
+
+/* Free list links live in the payload of free blocks */
+typedef struct tlsf_free_t {
+	tlsf_block_t *next_free;
+	tlsf_block_t *prev_free;
+} tlsf_free_t;
+
+#define BLOCK_HEADER_SIZE sizeof(tlsf_block_t)
+#define BLOCK_SIZE_MIN ((sizeof(tlsf_free_t) + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1))
+#define BLOCK_SIZE_MAX (1UL << FL_INDEX_MAX)
+
+typedef struct tlsf_control_t {
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[FL_INDEX_COUNT];
+	tlsf_block_t *blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+	tlsf_block_t *first; /* lowest block, the walk for statistics starts here */
+	unsigned long size;	 /* bytes from first up to and including the sentinel */
+#ifdef CONFIG_HEAP_STATS
+	unsigned long used;
+	unsigned long peak;
+	uint32_t allocs;
+	uint32_t failures;
+#endif
+} tlsf_control_t;
+
+static tlsf_control_t default_heap;
+
+static inline int tlsf_ffs(uint32_t word) {
+	return __builtin_ffs(word) - 1;
 }
 
-void *smalloc(uint32_t num_bytes) {
-	struct alloc_struct_t *ptr, *newptr;
-	uint32_t actual_bytes;
+static inline int tlsf_fls(unsigned long size) {
+	return (int) (sizeof(unsigned long) * 8) - 1 - __builtin_clzl(size);
+}
 
-	if (!num_bytes)
-		return 0;
+static inline unsigned long block_size(const tlsf_block_t *block) {
+	return block->size & ~BLOCK_FLAGS;
+}
 
-	actual_bytes = BYTE_ALIGN(num_bytes);
+static inline void block_set_size(tlsf_block_t *block, unsigned long size) {
+	block->size = size | (block->size & BLOCK_FLAGS);
+}
 
-	ptr = &boot_heap_head;
+static inline bool block_is_free(const tlsf_block_t *block) {
+	return block->size & BLOCK_FREE;
+}
 
-	while (ptr && ptr->next) {
-		if (ptr->next->address >= (ptr->address + ptr->size + 2 * sizeof(struct alloc_struct_t) + actual_bytes)) {
-			break;
-		}
-		ptr = ptr->next;
+static inline bool block_is_prev_free(const tlsf_block_t *block) {
+	return block->size & BLOCK_PREV_FREE;
+}
+
+static inline void *block_to_ptr(const tlsf_block_t *block) {
+	return (void *) ((unsigned long) block + BLOCK_HEADER_SIZE);
+}
+
+static inline tlsf_block_t *block_from_ptr(const void *ptr) {
+	return (tlsf_block_t *) ((unsigned long) ptr - BLOCK_HEADER_SIZE);
+}
+
+static inline tlsf_free_t *block_links(tlsf_block_t *block) {
+	return (tlsf_free_t *) block_to_ptr(block);
+}
+
+static inline tlsf_block_t *block_next(const tlsf_block_t *block) {
+	return (tlsf_block_t *) ((unsigned long) block_to_ptr(block) + block_size(block));
+}
+
+/* Keep the neighbour's back link and PREV_FREE flag in sync with the block */
+static inline void block_link_next(tlsf_block_t *block) {
+	tlsf_block_t *next = block_next(block);
+
+	next->prev_phys = block;
+	if (block_is_free(block))
+		next->size |= BLOCK_PREV_FREE;
+	else
+		next->size &= ~BLOCK_PREV_FREE;
+}
+
+static inline void block_mark_free(tlsf_block_t *block) {
+	block->size |= BLOCK_FREE;
+	block_link_next(block);
+}
+
+static inline void block_mark_used(tlsf_block_t *block) {
+	block->size &= ~BLOCK_FREE;
+	block_link_next(block);
+}
+
+static inline unsigned long adjust_request_size(unsigned long size) {
+	size = (size + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
+	return size < BLOCK_SIZE_MIN ? BLOCK_SIZE_MIN : size;
+}
+
+static void mapping_insert(unsigned long size, int *fli, int *sli) {
+	int fl, sl;
+
+	if (size < SMALL_BLOCK_SIZE) {
+		fl = 0;
+		sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	} else {
+		fl = tlsf_fls(size);
+		sl = (size >> (fl - SL_INDEX_COUNT_LOG2)) ^ (1 << SL_INDEX_COUNT_LOG2);
+		fl -= FL_INDEX_SHIFT - 1;
 	}
 
-	if (!ptr->next) {
-		return 0;
+	*fli = fl;
+	*sli = sl;
+}
+
+/* Round up to the next list so any block found there is large enough */
+static void mapping_search(unsigned long size, int *fli, int *sli) {
+	if (size >= SMALL_BLOCK_SIZE)
+		size += (1UL << (tlsf_fls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+	mapping_insert(size, fli, sli);
+}
+
+static tlsf_block_t *search_suitable_block(tlsf_control_t *heap, int *fli, int *sli) {
+	int fl = *fli, sl = *sli;
+	uint32_t sl_map, fl_map;
+
+	if (fl >= FL_INDEX_COUNT)
+		return NULL;
+
+	sl_map = heap->sl_bitmap[fl] & (~0U << sl);
+	if (!sl_map) {
+		fl_map = fl + 1 < 32 ? heap->fl_bitmap & (~0U << (fl + 1)) : 0;
+		if (!fl_map)
+			return NULL;
+
+		fl = tlsf_ffs(fl_map);
+		sl_map = heap->sl_bitmap[fl];
 	}
+	sl = tlsf_ffs(sl_map);
+
+	*fli = fl;
+	*sli = sl;
+	return heap->blocks[fl][sl];
+}
+
+static void remove_free_block(tlsf_control_t *heap, tlsf_block_t *block, int fl, int sl) {
+	tlsf_free_t *links = block_links(block);
+
+	if (links->prev_free)
+		block_links(links->prev_free)->next_free = links->next_free;
+	if (links->next_free)
+		block_links(links->next_free)->prev_free = links->prev_free;
 
-	newptr = (struct alloc_struct_t *) (ptr->address + ptr->size);
-	if (!newptr) {
-		return 0;
+	if (heap->blocks[fl][sl] == block) {
+		heap->blocks[fl][sl] = links->next_free;
+		if (!links->next_free) {
+			heap->sl_bitmap[fl] &= ~(1U << sl);
+			if (!heap->sl_bitmap[fl])
+				heap->fl_bitmap &= ~(1U << fl);
+		}
 	}
+}
+
+static void insert_free_block(tlsf_control_t *heap, tlsf_block_t *block, int fl, int sl) {
+	tlsf_block_t *head = heap->blocks[fl][sl];
+	tlsf_free_t *links = block_links(block);
 
-	newptr->address = ptr->address + ptr->size + sizeof(struct alloc_struct_t);
-	newptr->size = actual_bytes;
-	newptr->o_size = num_bytes;
-	newptr->next = ptr->next;
-	ptr->next = newptr;
+	links->next_free = head;
+	links->prev_free = NULL;
+	if (head)
+		block_links(head)->prev_free = block;
 
-	return (void *) newptr->address;
+	heap->blocks[fl][sl] = block;
+	heap->fl_bitmap |= 1U << fl;
+	heap->sl_bitmap[fl] |= 1U << sl;
 }
 
-void *srealloc(void *p, uint32_t num_bytes) {
-	struct alloc_struct_t *ptr, *prev;
-	void *tmp;
-	uint32_t actual_bytes;
+static void block_remove(tlsf_control_t *heap, tlsf_block_t *block) {
+	int fl, sl;
+
+	mapping_insert(block_size(block), &fl, &sl);
+	remove_free_block(heap, block, fl, sl);
+}
+
+static void block_insert(tlsf_control_t *heap, tlsf_block_t *block) {
+	int fl, sl;
+
+	mapping_insert(block_size(block), &fl, &sl);
+	insert_free_block(heap, block, fl, sl);
+}
+
+static inline bool block_can_split(const tlsf_block_t *block, unsigned long size) {
+	return block_size(block) >= size + BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN;
+}
+
+/* Cut the block down to size and return the free remainder behind it */
+static tlsf_block_t *block_split(tlsf_block_t *block, unsigned long size) {
+	tlsf_block_t *remaining = (tlsf_block_t *) ((unsigned long) block_to_ptr(block) + size);
+	unsigned long remain_size = block_size(block) - size - BLOCK_HEADER_SIZE;
+
+	remaining->size = remain_size;
+	block_set_size(block, size);
+	remaining->prev_phys = block;
+	block_mark_free(remaining);
+
+	return remaining;
+}
+
+/* Absorb the physically next block, which must already be off the free lists */
+static void block_absorb(tlsf_block_t *prev, tlsf_block_t *block) {
+	block_set_size(prev, block_size(prev) + block_size(block) + BLOCK_HEADER_SIZE);
+	block_link_next(prev);
+}
+
+static tlsf_block_t *block_merge_prev(tlsf_control_t *heap, tlsf_block_t *block) {
+	tlsf_block_t *prev;
+
+	if (!block_is_prev_free(block))
+		return block;
+
+	prev = block->prev_phys;
+	block_remove(heap, prev);
+	block_absorb(prev, block);
+	return prev;
+}
+
+static tlsf_block_t *block_merge_next(tlsf_control_t *heap, tlsf_block_t *block) {
+	tlsf_block_t *next = block_next(block);
+
+	if (!block_is_free(next))
+		return block;
+
+	block_remove(heap, next);
+	block_absorb(block, next);
+	return block;
+}
+
+static void block_trim_free(tlsf_control_t *heap, tlsf_block_t *block, unsigned long size) {
+	if (block_can_split(block, size))
+		block_insert(heap, block_split(block, size));
+}
+
+static void block_trim_used(tlsf_control_t *heap, tlsf_block_t *block, unsigned long size) {
+	tlsf_block_t *remaining;
+
+	if (!block_can_split(block, size))
+		return;
+
+	remaining = block_split(block, size);
+	block_mark_used(block);
+	block_insert(heap, block_merge_next(heap, remaining));
+}
+
+/* Split off the space in front of an aligned payload as a free block of its own */
+static tlsf_block_t *block_trim_free_leading(tlsf_control_t *heap, tlsf_block_t *block, unsigned long gap) {
+	tlsf_block_t *remaining;
+
+	if (gap < BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN)
+		return block;
+
+	remaining = block_split(block, gap - BLOCK_HEADER_SIZE);
+	block_mark_free(block);
+	block_insert(heap, block);
+	return remaining;
+}
+
+static tlsf_block_t *block_locate_free(tlsf_control_t *heap, unsigned long size) {
+	tlsf_block_t *block;
+	int fl, sl;
+
+	if (size > BLOCK_SIZE_MAX - ALIGN_SIZE)
+		return NULL;
+
+	mapping_search(size, &fl, &sl);
+	block = search_suitable_block(heap, &fl, &sl);
+	if (block)
+		remove_free_block(heap, block, fl, sl);
+
+	return block;
+}
+
+static void *block_prepare_used(tlsf_control_t *heap, tlsf_block_t *block, unsigned long size) {
+	if (!block)
+		return NULL;
+
+	block_trim_free(heap, block, size);
+	block_mark_used(block);
+	return block_to_ptr(block);
+}
+
+#ifdef CONFIG_HEAP_STATS
+static void *stats_alloc(tlsf_control_t *heap, void *p, const char *tag) {
+	tlsf_block_t *block;
 
 	if (!p) {
-		return smalloc(num_bytes);
-	}
-	if (!num_bytes) {
-		return p;
+		heap->failures++;
+		return NULL;
 	}
 
-	ptr = &boot_heap_head;
-	while (ptr && ptr->next) {
-		if (ptr->next->address == (phys_addr_t) p)
-			break;
-		ptr = ptr->next;
-	}
-	prev = ptr;
-	ptr = ptr->next;
+	block = block_from_ptr(p);
+	block->tag = tag;
+	heap->allocs++;
+	heap->used += block_size(block);
+	if (heap->used > heap->peak)
+		heap->peak = heap->used;
 
-	if (!ptr) {
-		return 0;
-	}
+	return p;
+}
 
-	actual_bytes = BYTE_ALIGN(ptr->o_size + num_bytes);
-	if (actual_bytes == ptr->size) {
-		return p;
-	}
+static inline void stats_free(tlsf_control_t *heap, tlsf_block_t *block) {
+	heap->used -= block_size(block);
+}
+#else
+#define stats_alloc(heap, p, tag) (p)
+#define stats_free(heap, block) ((void) 0)
+#endif// CONFIG_HEAP_STATS
+
+static int heap_init(tlsf_control_t *heap, unsigned long p_heap_head, unsigned long n_heap_size) {
+	unsigned long start = (p_heap_head + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
+	unsigned long size = (n_heap_size - (start - p_heap_head)) & ~(ALIGN_SIZE - 1);
+	tlsf_block_t *block, *sentinel;
+
+	memset(heap, 0, sizeof(*heap));
 
-	if (ptr->next->address >= (ptr->address + actual_bytes + 2 * sizeof(struct alloc_struct_t))) {
-		ptr->size = actual_bytes;
-		ptr->o_size += num_bytes;
+	if (n_heap_size < start - p_heap_head || size < 2 * BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN)
+		return -1;
 
-		return p;
+	/*
+	 * One free block spans the heap, a zero sized used block marks its end.
+	 * BLOCK_SIZE_MAX itself would map to first level FL_INDEX_COUNT, one past
+	 * the lists, so a block stays below it; merges never grow one past this.
+	 */
+	size -= 2 * BLOCK_HEADER_SIZE;
+	if (size > BLOCK_SIZE_MAX - ALIGN_SIZE)
+		size = BLOCK_SIZE_MAX - ALIGN_SIZE;
+
+	block = (tlsf_block_t *) start;
+	block->prev_phys = NULL;
+	block->size = size;
+	heap->first = block;
+	heap->size = size + 2 * BLOCK_HEADER_SIZE;
+
+	sentinel = block_next(block);
+	sentinel->size = 0;
+
+	block_mark_free(block);
+	block_insert(heap, block);
+
+	return 0;
+}
+
+static void *heap_alloc(tlsf_control_t *heap, uint32_t num_bytes, const char *tag) {
+	unsigned long size;
+
+	if (!num_bytes)
+		return NULL;
+
+	size = adjust_request_size(num_bytes);
+	return stats_alloc(heap, block_prepare_used(heap, block_locate_free(heap, size), size), tag);
+}
+
+static void *heap_memalign(tlsf_control_t *heap, uint32_t align, uint32_t num_bytes, const char *tag) {
+	unsigned long size, aligned, gap;
+	tlsf_block_t *block;
+
+	if (!num_bytes || (align & (align - 1)))
+		return NULL;
+
+	if (align <= ALIGN_SIZE)
+		return heap_alloc(heap, num_bytes, tag);
+
+	/* Ask for enough slack that a too small leading gap can be skipped */
+	size = adjust_request_size(num_bytes);
+	block = block_locate_free(heap, size + align + BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN);
+	if (!block)
+		return stats_alloc(heap, NULL, tag);
+
+	aligned = ((unsigned long) block_to_ptr(block) + align - 1) & ~(unsigned long) (align - 1);
+	gap = aligned - (unsigned long) block_to_ptr(block);
+	if (gap && gap < BLOCK_HEADER_SIZE + BLOCK_SIZE_MIN)
+		gap += align;
+
+	block = block_trim_free_leading(heap, block, gap);
+	return stats_alloc(heap, block_prepare_used(heap, block, size), tag);
+}
+
+static void heap_free(tlsf_control_t *heap, void *p) {
+	tlsf_block_t *block;
+
+	if (p == NULL)
+		return;
+
+	block = block_from_ptr(p);
+	if (block_is_free(block))
+		return;
+
+	stats_free(heap, block);
+	block_mark_free(block);
+	block = block_merge_prev(heap, block);
+	block = block_merge_next(heap, block);
+	block_insert(heap, block);
+}
+
+static void *heap_realloc(tlsf_control_t *heap, void *p, uint32_t num_bytes, const char *tag) {
+	tlsf_block_t *block, *next;
+	unsigned long size, cur;
+	void *tmp;
+
+	if (!p)
+		return heap_alloc(heap, num_bytes, tag);
+
+	if (!num_bytes) {
+		heap_free(heap, p);
+		return NULL;
 	}
 
-	tmp = smalloc(actual_bytes);
-	if (!tmp) {
-		return 0;
+	block = block_from_ptr(p);
+	next = block_next(block);
+	cur = block_size(block);
+	size = adjust_request_size(num_bytes);
+
+	/* Shrink in place, or grow into a free neighbour when it is large enough */
+	if (size <= cur || (block_is_free(next) && cur + block_size(next) + BLOCK_HEADER_SIZE >= size)) {
+		stats_free(heap, block);
+		if (size > cur) {
+			block_merge_next(heap, block);
+			block_mark_used(block);
+		}
+		block_trim_used(heap, block, size);
+		return stats_alloc(heap, p, tag);
 	}
-	memcpy(tmp, (void *) ptr->address, ptr->size);
-	prev->next = ptr->next; /* delete the node which need be released from the memory block chain  */
+
+	tmp = heap_alloc(heap, num_bytes, tag);
+	if (!tmp)
+		return NULL;
+
+	memcpy(tmp, p, cur);
+	heap_free(heap, p);
 
 	return tmp;
 }
 
+int32_t smalloc_init(uint32_t p_heap_head, uint32_t n_heap_size) {
+	return heap_init(&default_heap, p_heap_head, n_heap_size);
+}
+
+/* The parentheses keep the tagging macros of smalloc.h from expanding here */
+void *(smalloc)(uint32_t num_bytes) {
+	return heap_alloc(&default_heap, num_bytes, NULL);
+}
+
+void *(smemalign)(uint32_t align, uint32_t num_bytes) {
+	return heap_memalign(&default_heap, align, num_bytes, NULL);
+}
+
+void *(srealloc)(void *p, uint32_t num_bytes) {
+	return heap_realloc(&default_heap, p, num_bytes, NULL);
+}
+
 void sfree(void *p) {
-	struct alloc_struct_t *ptr, *prev;
+	heap_free(&default_heap, p);
+}
 
-	if (p == NULL)
-		return;
+#ifdef CONFIG_HEAP_STATS
+void *smalloc_tagged(uint32_t num_bytes, const char *tag) {
+	return heap_alloc(&default_heap, num_bytes, tag);
+}
+
+void *smemalign_tagged(uint32_t align, uint32_t num_bytes, const char *tag) {
+	return heap_memalign(&default_heap, align, num_bytes, tag);
+}
+
+void *srealloc_tagged(void *p, uint32_t num_bytes, const char *tag) {
+	return heap_realloc(&default_heap, p, num_bytes, tag);
+}
+#endif// CONFIG_HEAP_STATS
+
+smalloc_pool_t *smalloc_pool_create(void *mem, uint32_t size) {
+	unsigned long start = ((unsigned long) mem + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
+	unsigned long ctrl_size = (sizeof(tlsf_control_t) + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
+	tlsf_control_t *heap = (tlsf_control_t *) start;
 
-	ptr = &boot_heap_head;
-	while (ptr && ptr->next) {
-		if (ptr->next->address == (phys_addr_t) p)
-			break;
-		ptr = ptr->next;
+	/* The control structure sits at the head of the pool memory itself */
+	if (size < start - (unsigned long) mem + ctrl_size)
+		return NULL;
+
+	if (heap_init(heap, start + ctrl_size, size - (start - (unsigned long) mem) - ctrl_size))
+		return NULL;
+
+	return heap;
+}
+
+void *smalloc_pool_alloc(smalloc_pool_t *pool, uint32_t num_bytes, uint32_t align) {
+	return heap_memalign(pool, align, num_bytes, NULL);
+}
+
+void smalloc_pool_free(smalloc_pool_t *pool, void *p) {
+	heap_free(pool, p);
+}
+
+void smalloc_get_stats(smalloc_stats_t *stats) {
+	tlsf_control_t *heap = &default_heap;
+	tlsf_block_t *block;
+	unsigned long size;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->heap_start = (unsigned long) heap->first;
+	stats->heap_size = heap->size;
+
+	for (block = heap->first; block && block_size(block); block = block_next(block)) {
+		size = block_size(block);
+		if (block_is_free(block)) {
+			stats->free += size;
+			stats->free_blocks++;
+			if (size > stats->largest_free)
+				stats->largest_free = size;
+		} else {
+			stats->used += size;
+			stats->used_blocks++;
+		}
 	}
 
-	prev = ptr;
-	ptr = ptr->next;
+#ifdef CONFIG_HEAP_STATS
+	stats->peak = heap->peak;
+	stats->allocs = heap->allocs;
+	stats->failures = heap->failures;
+#endif
+}
 
-	if (!ptr)
-		return;
+#ifdef CONFIG_HEAP_STATS
+void smalloc_dump(void) {
+	tlsf_control_t *heap = &default_heap;
+	smalloc_stats_t stats;
+	tlsf_block_t *block;
 
-	prev->next = ptr->next;
+	smalloc_get_stats(&stats);
 
-	return;
+	printk(LOG_LEVEL_MUTE, "heap: 0x%08lx-0x%08lx, %lu bytes\n", stats.heap_start, stats.heap_start + stats.heap_size, stats.heap_size);
+	printk(LOG_LEVEL_MUTE, "  used %lu bytes in %u blocks, free %lu bytes in %u blocks, largest free %lu\n", stats.used, stats.used_blocks, stats.free,
+		   stats.free_blocks, stats.largest_free);
+	printk(LOG_LEVEL_MUTE, "  peak %lu bytes, %u allocations, %u failed\n", stats.peak, stats.allocs, stats.failures);
+
+	for (block = heap->first; block && block_size(block); block = block_next(block)) {
+		printk(LOG_LEVEL_MUTE, "  0x%08lx %8lu %s %s\n", (unsigned long) block_to_ptr(block), block_size(block), block_is_free(block) ? "free" : "used",
+			   !block_is_free(block) && block->tag ? block->tag : "");
+	}
 }
+#endif// CONFIG_HEAP_STATS
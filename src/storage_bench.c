@@ -0,0 +1,589 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <common.h>
+#include <log.h>
+#include <sstdlib.h>
+#include <string.h>
+#include <timer.h>
+
+#include <sys-dma.h>
+#include <sys-sdcard.h>
+#include <sys-sdhci.h>
+#include <sys-spi-nand.h>
+#include <sys-spi-nor.h>
+#include <sys-spi.h>
+
+#include "ff.h"
+
+#include "storage_bench.h"
+
+#define BENCH_MODE_NAME_LEN 16
+
+/* xorshift32 seed, the same for every point */
+#define BENCH_SEED 0x2545f491
+
+static struct {
+	storage_bench_target_t *target[STORAGE_BENCH_MAX_TARGETS];
+	uint32_t targets;
+	uint8_t *buf;
+	uint32_t size;
+} bench;
+
+static uint32_t bench_latency[STORAGE_BENCH_MAX_OPS];
+
+static uint32_t bench_rand(uint32_t *state) {
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static void bench_sort(uint32_t *v, uint32_t n) {
+	for (uint32_t i = 1; i < n; i++) {
+		uint32_t key = v[i];
+		uint32_t j = i;
+
+		while (j > 0 && v[j - 1] > key) {
+			v[j] = v[j - 1];
+			j--;
+		}
+		v[j] = key;
+	}
+}
+
+/* Nearest rank percentile of a sorted array */
+static uint32_t bench_percentile(const uint32_t *v, uint32_t n, uint32_t p) {
+	uint32_t rank = (n * p + 99) / 100;
+
+	return v[rank ? rank - 1 : 0];
+}
+
+/**
+ * @brief Time the reads of one point and print its CSV line
+ * @return 0 on success, -1 if a read failed
+ */
+static int bench_point(storage_bench_target_t *target, const char *mode, bool pio, uint32_t pattern, uint32_t block) {
+	uint32_t stride = (block + target->align - 1) / target->align * target->align;
+	uint64_t slots = (target->size - block) / stride + 1;
+	uint64_t offset = 0, bytes, us = 0, start;
+	uint32_t seed = BENCH_SEED;
+	uint32_t ops = STORAGE_BENCH_BYTES / block;
+
+	if (ops == 0)
+		ops = 1;
+	if (ops > STORAGE_BENCH_MAX_OPS)
+		ops = STORAGE_BENCH_MAX_OPS;
+
+	if (pattern == STORAGE_BENCH_SEQ && target->rewind)
+		target->rewind(target);
+
+	for (uint32_t i = 0; i < ops; i++) {
+		if (pattern == STORAGE_BENCH_RAND) {
+			uint64_t r = (uint64_t) bench_rand(&seed) << 32 | bench_rand(&seed);
+			offset = r % slots * stride;
+		} else if (offset + block > target->size) {
+			offset = 0;
+			if (target->rewind)
+				target->rewind(target);
+		}
+
+		start = time_us();
+		if (target->read(target, offset, bench.buf, block)) {
+			printk_warning("BENCH: %s read of %u bytes at 0x%llx failed\n", target->name, block, offset);
+			return -1;
+		}
+		bench_latency[i] = (uint32_t) (time_us() - start);
+		us += bench_latency[i];
+
+		if (pattern == STORAGE_BENCH_SEQ)
+			offset += stride;
+	}
+
+	bench_sort(bench_latency, ops);
+	bytes = (uint64_t) ops * block;
+
+	printk(LOG_LEVEL_MUTE, "bench,%s,%s,%s,%s,%u,%u,%llu,%llu,%llu,%u,%u,%u,%u,%u\n", target->name, mode, pio ? "pio" : "dma",
+		   pattern == STORAGE_BENCH_RAND ? "rand" : "seq", block, ops, bytes, us, us ? bytes * 1000000 / 1024 / us : 0, bench_latency[0],
+		   bench_percentile(bench_latency, ops, 50), bench_percentile(bench_latency, ops, 90), bench_percentile(bench_latency, ops, 99),
+		   bench_latency[ops - 1]);
+
+	return 0;
+}
+
+/**
+ * @brief Sweep the block sizes of every pattern and transfer in the current mode
+ * @return Number of points run, -1 if a read failed
+ */
+static int bench_mode(storage_bench_target_t *target, const char *mode, uint32_t flags, uint32_t min_block, uint32_t max_block) {
+	static const uint32_t patterns[] = {STORAGE_BENCH_SEQ, STORAGE_BENCH_RAND};
+	int points = 0;
+
+	for (int pio = 0; pio < 2; pio++) {
+		if (!(flags & (pio ? STORAGE_BENCH_PIO : STORAGE_BENCH_DMA)))
+			continue;
+		if (target->set_pio)
+			target->set_pio(target, pio);
+
+		for (int p = 0; p < 2; p++) {
+			if (!(flags & patterns[p]))
+				continue;
+
+			for (uint32_t block = min_block; block && block <= max_block; block *= 2) {
+				if (block > bench.size || block > target->size)
+					break;
+				if (bench_point(target, mode, pio, patterns[p], block)) {
+					points = -1;
+					break;
+				}
+				points++;
+			}
+			if (points < 0)
+				break;
+		}
+		if (points < 0)
+			break;
+	}
+
+	if (target->set_pio)
+		target->set_pio(target, false);
+
+	return points;
+}
+
+static int bench_target(storage_bench_target_t *target, const storage_bench_params_t *params) {
+	char name[BENCH_MODE_NAME_LEN];
+	uint32_t flags = target->flags;
+	uint32_t min_block = STORAGE_BENCH_MIN_BLOCK, max_block = STORAGE_BENCH_MAX_BLOCK;
+	const char *only = NULL;
+	int points = 0, ret;
+
+	/* Without the knob the driver picks, that is listed as dma */
+	if (!target->set_pio)
+		flags = (flags & ~STORAGE_BENCH_PIO) | STORAGE_BENCH_DMA;
+
+	if (params) {
+		if (params->flags & (STORAGE_BENCH_SEQ | STORAGE_BENCH_RAND))
+			flags &= params->flags | ~(STORAGE_BENCH_SEQ | STORAGE_BENCH_RAND);
+		if (params->flags & (STORAGE_BENCH_DMA | STORAGE_BENCH_PIO))
+			flags &= params->flags | ~(STORAGE_BENCH_DMA | STORAGE_BENCH_PIO);
+		if (params->min_block)
+			min_block = params->min_block;
+		if (params->max_block)
+			max_block = params->max_block;
+		only = params->mode;
+	}
+
+	/* Doubling from a power of two keeps blocks whole sectors */
+	for (uint32_t block = STORAGE_BENCH_MIN_BLOCK;; block *= 2) {
+		if (block >= min_block || block >= STORAGE_BENCH_MAX_BLOCK) {
+			min_block = block;
+			break;
+		}
+	}
+
+	if (max_block > bench.size)
+		printk_info("BENCH: blocks over %u bytes skipped, the buffer is no larger\n", bench.size);
+
+	if (!target->mode_name) {
+		if (only && strcmp(only, "default"))
+			return 0;
+		return bench_mode(target, "default", flags, min_block, max_block);
+	}
+
+	for (uint32_t n = 0; !target->mode_name(target, n, name, sizeof(name)); n++) {
+		if (only && strcmp(only, name))
+			continue;
+		if (target->set_mode(target, n)) {
+			printk_info("BENCH: %s mode %s not available, skipped\n", target->name, name);
+			continue;
+		}
+
+		ret = bench_mode(target, name, flags, min_block, max_block);
+		if (ret < 0) {
+			points = -1;
+			break;
+		}
+		points += ret;
+	}
+
+	if (target->restore)
+		target->restore(target);
+
+	return points;
+}
+
+void storage_bench_set_buffer(void *buf, uint32_t size) {
+	bench.buf = buf;
+	bench.size = size;
+}
+
+int storage_bench_register(storage_bench_target_t *target) {
+	for (uint32_t i = 0; i < bench.targets; i++) {
+		if (bench.target[i] == target)
+			return 0;
+	}
+
+	if (bench.targets == STORAGE_BENCH_MAX_TARGETS) {
+		printk_warning("BENCH: no room for target %s\n", target->name);
+		return -1;
+	}
+
+	bench.target[bench.targets++] = target;
+	printk_debug("BENCH: target %s, %llu bytes\n", target->name, target->size);
+
+	return 0;
+}
+
+storage_bench_target_t *storage_bench_find(const char *name) {
+	for (uint32_t i = 0; i < bench.targets; i++) {
+		if (!strcmp(bench.target[i]->name, name))
+			return bench.target[i];
+	}
+
+	return NULL;
+}
+
+void storage_bench_list(void) {
+	char name[BENCH_MODE_NAME_LEN];
+
+	for (uint32_t i = 0; i < bench.targets; i++) {
+		storage_bench_target_t *target = bench.target[i];
+
+		printk(LOG_LEVEL_MUTE, "%-10s %llu bytes, modes:", target->name, target->size);
+		if (!target->mode_name) {
+			printk(LOG_LEVEL_MUTE, " default\n");
+			continue;
+		}
+		for (uint32_t n = 0; !target->mode_name(target, n, name, sizeof(name)); n++)
+			printk(LOG_LEVEL_MUTE, " %s", name);
+		printk(LOG_LEVEL_MUTE, "\n");
+	}
+}
+
+int storage_bench_run(storage_bench_target_t *target, const storage_bench_params_t *params) {
+	int points = 0, ret;
+
+	if (!bench.buf) {
+		printk_warning("BENCH: no buffer\n");
+		return -1;
+	}
+
+	printk(LOG_LEVEL_MUTE, "bench,target,mode,xfer,pattern,block,ops,bytes,us,kib_s,min_us,p50_us,p90_us,p99_us,max_us\n");
+
+	for (uint32_t i = 0; i < bench.targets; i++) {
+		if (target && bench.target[i] != target)
+			continue;
+		ret = bench_target(bench.target[i], params);
+		if (ret < 0)
+			return -1;
+		points += ret;
+	}
+
+	return points ? 0 : -1;
+}
+
+int storage_bench_dma(uint32_t max_len) {
+	uint32_t half = bench.size / 2 & ~3U;
+
+	if (!bench.buf) {
+		printk_warning("BENCH: no buffer\n");
+		return -1;
+	}
+
+	if (!max_len || max_len > half)
+		max_len = half;
+
+	/* Source in the first half of the buffer, destination in the second */
+	sunxi_dma_bench(bench.buf, bench.buf + half, max_len);
+
+	return 0;
+}
+
+/* SD/MMC, read with sdmmc_blk_read() */
+
+#ifdef CONFIG_CHIP_MMC_V2
+/* Clock limits of the host, the driver picks the mode the card allows below it */
+static const struct {
+	const char *name;
+	uint32_t clk;
+} bench_smhc_modes[] = {
+		{"ds", 25000000},
+		{"hs", 50000000},
+};
+#else
+static const struct {
+	const char *name;
+	smhc_clk_t clk;
+} bench_smhc_modes[] = {
+		{"ds", MMC_CLK_25M},
+		{"hs", MMC_CLK_50M},
+		{"ddr50", MMC_CLK_50M_DDR},
+		{"sdr100", MMC_CLK_100M},
+		{"sdr200", MMC_CLK_200M},
+};
+#endif
+
+static struct {
+	storage_bench_target_t target;
+	sdmmc_pdata_t *card;
+	uint32_t clk; /* as registered */
+} bench_sdmmc;
+
+static int bench_sdmmc_read(storage_bench_target_t *target, uint64_t offset, void *buf, uint32_t len) {
+	uint32_t blkcnt = len / 512;
+
+	return sdmmc_blk_read(bench_sdmmc.card, buf, offset / 512, blkcnt) == blkcnt ? 0 : -1;
+}
+
+static int bench_sdmmc_mode_name(storage_bench_target_t *target, uint32_t n, char *name, uint32_t len) {
+	if (n >= ARRAY_SIZE(bench_smhc_modes))
+		return -1;
+
+	strncpy(name, bench_smhc_modes[n].name, len - 1);
+	name[len - 1] = 0;
+	return 0;
+}
+
+static int bench_sdmmc_init(uint32_t clk) {
+	sdmmc_pdata_t *card = bench_sdmmc.card;
+
+#ifdef CONFIG_CHIP_MMC_V2
+	card->hci->max_clk = clk;
+	if (sunxi_sdhci_init(card->hci))
+		return -1;
+#else
+	card->hci->clock = clk;
+#endif
+	return sdmmc_init(card, card->hci);
+}
+
+static int bench_sdmmc_set_mode(storage_bench_target_t *target, uint32_t n) {
+#ifndef CONFIG_CHIP_MMC_V2
+	/* DDR is only set up for eMMC, SD cards would stay in SDR */
+	if (bench_smhc_modes[n].clk == MMC_CLK_50M_DDR && (bench_sdmmc.card->card.version & SD_VERSION_SD))
+		return -1;
+#endif
+	return bench_sdmmc_init(bench_smhc_modes[n].clk);
+}
+
+static void bench_sdmmc_restore(storage_bench_target_t *target) {
+	if (bench_sdmmc_init(bench_sdmmc.clk))
+		printk_warning("BENCH: %s init failed in its own mode\n", target->name);
+}
+
+static void bench_sdmmc_set_pio(storage_bench_target_t *target, bool pio) {
+	bench_sdmmc.card->hci->pio = pio;
+}
+
+int storage_bench_add_sdmmc(sdmmc_pdata_t *card, uint64_t size) {
+	storage_bench_target_t *target = &bench_sdmmc.target;
+
+	if (!card->online) {
+		printk_warning("BENCH: sdmmc card is not initialized\n");
+		return -1;
+	}
+
+	bench_sdmmc.card = card;
+#ifdef CONFIG_CHIP_MMC_V2
+	bench_sdmmc.clk = card->hci->max_clk;
+	if (!size)
+		size = card->hci->mmc->capacity;
+#else
+	bench_sdmmc.clk = card->hci->clock;
+	if (!size)
+		size = card->card.capacity;
+#endif
+
+	target->name = "sdmmc";
+	target->size = size;
+	target->align = 512;
+	target->flags = STORAGE_BENCH_SEQ | STORAGE_BENCH_RAND | STORAGE_BENCH_DMA | STORAGE_BENCH_PIO;
+	target->read = bench_sdmmc_read;
+	target->mode_name = bench_sdmmc_mode_name;
+	target->set_mode = bench_sdmmc_set_mode;
+	target->restore = bench_sdmmc_restore;
+	target->set_pio = bench_sdmmc_set_pio;
+
+	return storage_bench_register(target);
+}
+
+/* SPI NAND and NOR, a mode per SPI clock and I/O mode */
+
+static const uint32_t bench_spi_clks[] = {25000000, 50000000, 75000000, 100000000};
+
+static const char *const bench_spi_io_names[] = {"single", "dual", "quad", "quad-io"};
+
+typedef struct {
+	storage_bench_target_t target;
+	sunxi_spi_t *spi;
+	uint32_t clk;		/* as registered */
+	spi_io_mode_t mode; /* as registered, the fastest the chip does */
+} bench_spi_t;
+
+static bench_spi_t bench_spi_nand, bench_spi_nor;
+
+static int bench_spi_mode_name(storage_bench_target_t *target, uint32_t n, char *name, uint32_t len) {
+	bench_spi_t *bs = target->priv;
+	uint32_t io = n / ARRAY_SIZE(bench_spi_clks);
+	char mode[BENCH_MODE_NAME_LEN], mhz[8];
+
+	if (io > bs->mode)
+		return -1;
+
+	/* "<io>-<clk>M", without depending on CONFIG_SPRINTF */
+	strcpy(mode, bench_spi_io_names[io]);
+	strcat(mode, "-");
+	strcat(mode, ltoa(bench_spi_clks[n % ARRAY_SIZE(bench_spi_clks)] / 1000000, mhz, 10));
+	strcat(mode, "M");
+
+	strncpy(name, mode, len - 1);
+	name[len - 1] = 0;
+	return 0;
+}
+
+/* Clocks above the one of the board are not known to work with its flash, raise that to try them */
+static int bench_spi_set_mode(storage_bench_target_t *target, uint32_t n) {
+	bench_spi_t *bs = target->priv;
+	uint32_t clk = bench_spi_clks[n % ARRAY_SIZE(bench_spi_clks)];
+
+	if (clk > bs->clk)
+		return -1;
+
+	sunxi_spi_update_clk(bs->spi, clk);
+	if (bs == &bench_spi_nand)
+		spi_nand_set_io_mode((spi_io_mode_t) (n / ARRAY_SIZE(bench_spi_clks)));
+	return 0;
+}
+
+static void bench_spi_restore(storage_bench_target_t *target) {
+	bench_spi_t *bs = target->priv;
+
+	sunxi_spi_update_clk(bs->spi, bs->clk);
+	if (bs == &bench_spi_nand)
+		spi_nand_set_io_mode(bs->mode);
+}
+
+static void bench_spi_set_pio(storage_bench_target_t *target, bool pio) {
+	bench_spi_t *bs = target->priv;
+
+	bs->spi->pio = pio;
+}
+
+static int bench_spi_nand_read(storage_bench_target_t *target, uint64_t offset, void *buf, uint32_t len) {
+	return spi_nand_read(bench_spi_nand.spi, buf, (uint32_t) offset, len) == len ? 0 : -1;
+}
+
+static int bench_spi_nor_read(storage_bench_target_t *target, uint64_t offset, void *buf, uint32_t len) {
+	return spi_nor_read(bench_spi_nor.spi, buf, (uint32_t) offset, len) == len ? 0 : -1;
+}
+
+static int bench_spi_add(bench_spi_t *bs, const char *name, sunxi_spi_t *spi, uint32_t size) {
+	storage_bench_target_t *target = &bs->target;
+
+	bs->spi = spi;
+	bs->clk = spi->clk_rate;
+
+	target->name = name;
+	target->priv = bs;
+	target->size = size;
+	target->flags = STORAGE_BENCH_SEQ | STORAGE_BENCH_RAND | STORAGE_BENCH_DMA | STORAGE_BENCH_PIO;
+	target->mode_name = bench_spi_mode_name;
+	target->set_mode = bench_spi_set_mode;
+	target->restore = bench_spi_restore;
+	target->set_pio = bench_spi_set_pio;
+
+	return storage_bench_register(target);
+}
+
+int storage_bench_add_spi_nand(sunxi_spi_t *spi, uint32_t size) {
+	if (!size)
+		size = spi_nand_get_capacity();
+
+	/* Reads start on a page, 4 KiB is a multiple of every page size */
+	bench_spi_nand.target.align = 4096;
+	bench_spi_nand.target.read = bench_spi_nand_read;
+	bench_spi_nand.mode = spi_nand_get_io_mode();
+
+	return bench_spi_add(&bench_spi_nand, "spi-nand", spi, size);
+}
+
+int storage_bench_add_spi_nor(sunxi_spi_t *spi, uint32_t size) {
+	if (!size)
+		size = spi_nor_get_capacity();
+
+	bench_spi_nor.target.align = 1;
+	bench_spi_nor.target.read = bench_spi_nor_read;
+	bench_spi_nor.mode = SPI_IO_SINGLE;
+
+	return bench_spi_add(&bench_spi_nor, "spi-nor", spi, size);
+}
+
+/* A file read with f_read(), sequentially from the start as f_lseek() is not built */
+
+static struct {
+	storage_bench_target_t target;
+	FATFS fs;
+	FIL file;
+	char path[64];
+	uint64_t pos; /* of the file, ~0 when it could not be opened */
+} bench_fatfs;
+
+static void bench_fatfs_rewind(storage_bench_target_t *target) {
+	f_close(&bench_fatfs.file);
+	bench_fatfs.pos = f_open(&bench_fatfs.file, bench_fatfs.path, FA_OPEN_EXISTING | FA_READ) == FR_OK ? 0 : ~0ULL;
+}
+
+static int bench_fatfs_read(storage_bench_target_t *target, uint64_t offset, void *buf, uint32_t len) {
+	UINT done = 0;
+
+	if (offset != bench_fatfs.pos)
+		return -1;
+	if (f_read(&bench_fatfs.file, buf, len, &done) != FR_OK || done != len)
+		return -1;
+
+	bench_fatfs.pos += done;
+	return 0;
+}
+
+/* FatFs reads the card through card0, see lib/fatfs/diskio.c */
+static void bench_fatfs_set_pio(storage_bench_target_t *target, bool pio) {
+	card0.hci->pio = pio;
+}
+
+int storage_bench_add_fatfs(const char *path) {
+	storage_bench_target_t *target = &bench_fatfs.target;
+	FRESULT fret;
+
+	fret = f_mount(&bench_fatfs.fs, "", 1);
+	if (fret != FR_OK) {
+		printk_warning("BENCH: FATFS mount error %d\n", fret);
+		return -1;
+	}
+
+	/* Registering again switches to another file */
+	f_close(&bench_fatfs.file);
+	strncpy(bench_fatfs.path, path, sizeof(bench_fatfs.path) - 1);
+	fret = f_open(&bench_fatfs.file, bench_fatfs.path, FA_OPEN_EXISTING | FA_READ);
+	if (fret != FR_OK) {
+		printk_warning("BENCH: FATFS open %s error %d\n", bench_fatfs.path, fret);
+		return -1;
+	}
+	bench_fatfs.pos = 0;
+
+	target->name = "fatfs";
+	target->size = f_size(&bench_fatfs.file);
+	target->align = 512;
+	target->flags = STORAGE_BENCH_SEQ | STORAGE_BENCH_DMA | STORAGE_BENCH_PIO;
+	target->read = bench_fatfs_read;
+	target->rewind = bench_fatfs_rewind;
+	target->set_pio = bench_fatfs_set_pio;
+
+	return storage_bench_register(target);
+}
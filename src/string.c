@@ -6,20 +6,59 @@
 #include <stdint.h>
 #include <string.h>
 
-unsigned int strlen(const char *str) {
-	int i = 0;
+/*
+ * Word-at-a-time helpers. A word is scanned for a zero byte with the classic
+ * (x - 0x01..01) & ~x & 0x80..80 test, which never misses a zero byte. Words
+ * are only loaded from aligned addresses, so a scan never crosses into the
+ * next page before the byte loop finds the terminator.
+ */
+typedef unsigned long __attribute__((__may_alias__)) word_t;
+
+#define WORD_SIZE sizeof(word_t)
+#define WORD_MASK (WORD_SIZE - 1)
+#define WORD_ONES ((word_t) -1 / 0xff)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+
+#define word_has_zero(x) (((x) - WORD_ONES) & ~(x) & WORD_HIGHS)
+#define word_misaligned(p) ((unsigned long) (p) & WORD_MASK)
 
-	while (str[i++] != '\0')
+/*
+ * The routines below are weak so architecture code can override them. strlen
+ * and memchr keep a *_generic name for the CPU feature dispatch to fall back
+ * to when they are.
+ */
+unsigned int strlen_generic(const char *str) {
+	const char *s = str;
+	const word_t *w;
+
+	for (; word_misaligned(s); s++)
+		if (*s == '\0')
+			return s - str;
+
+	for (w = (const word_t *) s; !word_has_zero(*w); w++)
+		;
+
+	for (s = (const char *) w; *s != '\0'; s++)
 		;
 
-	return i - 1;
+	return s - str;
 }
 
-unsigned int strnlen(const char *s, unsigned int n) {
-	const char *sc;
+__attribute__((weak, alias("strlen_generic"))) unsigned int strlen(const char *str);
+
+__attribute__((weak)) unsigned int strnlen(const char *s, unsigned int n) {
+	const char *sc = s;
+
+	for (; n && word_misaligned(sc); sc++, n--)
+		if (*sc == '\0')
+			return sc - s;
+
+	for (; n >= WORD_SIZE && !word_has_zero(*(const word_t *) sc); sc += WORD_SIZE, n -= WORD_SIZE)
+		;
 
-	for (sc = s; n-- && *sc != '\0'; ++sc)
+	for (; n && *sc != '\0'; sc++, n--)
 		;
+
 	return sc - s;
 }
 
@@ -43,9 +82,24 @@ char *strcat(char *dst, const char *src) {
 	return p;
 }
 
-int strcmp(const char *p1, const char *p2) {
+__attribute__((weak)) int strcmp(const char *p1, const char *p2) {
 	unsigned char c1, c2;
 
+	/* Skip equal words while both strings share the same alignment */
+	if ((((unsigned long) p1 ^ (unsigned long) p2) & WORD_MASK) == 0) {
+		for (; word_misaligned(p1); p1++, p2++) {
+			c1 = *p1;
+			c2 = *p2;
+			if (c1 != c2)
+				return c1 < c2 ? -1 : 1;
+			if (!c1)
+				return 0;
+		}
+
+		for (; *(const word_t *) p1 == *(const word_t *) p2 && !word_has_zero(*(const word_t *) p1); p1 += WORD_SIZE, p2 += WORD_SIZE)
+			;
+	}
+
 	while (1) {
 		c1 = *p1++;
 		c2 = *p2++;
@@ -58,9 +112,25 @@ int strcmp(const char *p1, const char *p2) {
 	return 0;
 }
 
-int strncmp(const char *p1, const char *p2, unsigned int cnt) {
+__attribute__((weak)) int strncmp(const char *p1, const char *p2, unsigned int cnt) {
 	unsigned char c1, c2;
 
+	/* Skip equal words while both strings share the same alignment */
+	if ((((unsigned long) p1 ^ (unsigned long) p2) & WORD_MASK) == 0) {
+		for (; cnt && word_misaligned(p1); p1++, p2++, cnt--) {
+			c1 = *p1;
+			c2 = *p2;
+			if (c1 != c2)
+				return c1 < c2 ? -1 : 1;
+			if (!c1)
+				return 0;
+		}
+
+		for (; cnt >= WORD_SIZE && *(const word_t *) p1 == *(const word_t *) p2 && !word_has_zero(*(const word_t *) p1);
+			 p1 += WORD_SIZE, p2 += WORD_SIZE, cnt -= WORD_SIZE)
+			;
+	}
+
 	while (cnt--) {
 		c1 = *p1++;
 		c2 = *p2++;
@@ -75,63 +145,78 @@ int strncmp(const char *p1, const char *p2, unsigned int cnt) {
 	return 0;
 }
 
-char *strchr(const char *s, int c) {
-	for (; *s != (char) c; ++s)
+__attribute__((weak)) char *strchr(const char *s, int c) {
+	word_t mask = WORD_ONES * (unsigned char) c;
+	const word_t *w;
+
+	for (; word_misaligned(s); ++s) {
+		if (*s == (char) c)
+			return (char *) s;
+		if (*s == '\0')
+			return NULL;
+	}
+
+	/* Stop at the first word holding either the terminator or c */
+	for (w = (const word_t *) s; !word_has_zero(*w) && !word_has_zero(*w ^ mask); w++)
+		;
+
+	for (s = (const char *) w; *s != (char) c; ++s)
 		if (*s == '\0')
 			return NULL;
 
 	return (char *) s;
 }
 
-char *strrchr(const char *s, int c) {
-	const char *p = s + strlen(s);
+__attribute__((weak)) char *strrchr(const char *s, int c) {
+	const char *last = NULL;
 
-	do {
-		if (*p == (char) c)
-			return (char *) p;
-	} while (--p >= s);
+	if ((char) c == '\0')
+		return (char *) s + strlen(s);
 
-	return NULL;
+	/* Walk the hits forward, each hop is a word-at-a-time strchr */
+	while ((s = strchr(s, c)) != NULL)
+		last = s++;
+
+	return (char *) last;
 }
 
-char *strstr(const char *s1, const char *s2) {
-	register const char *s = s1;
-	register const char *p = s2;
+__attribute__((weak)) char *strstr(const char *s1, const char *s2) {
+	unsigned int len = strlen(s2);
+
+	if (len == 0)
+		return (char *) s1;
 
-	do {
-		if (!*p) {
+	/* Only try a full compare where the first character matches */
+	while ((s1 = strchr(s1, *s2)) != NULL) {
+		if (strncmp(s1, s2, len) == 0)
 			return (char *) s1;
-			;
-		}
-		if (*p == *s) {
-			++p;
-			++s;
-		} else {
-			p = s2;
-			if (!*s) {
-				return NULL;
-			}
-			s = ++s1;
-		}
-	} while (1);
+		s1++;
+	}
+
+	return NULL;
 }
 
-void *memchr(void *src, int val, unsigned int cnt) {
-	char *p = NULL;
-	char *s = (char *) src;
+void *memchr_generic(void *src, int val, unsigned int cnt) {
+	const unsigned char *s = src;
+	unsigned char c = val;
+	word_t mask = WORD_ONES * c;
 
-	while (cnt) {
-		if (*s == val) {
-			p = s;
-			break;
-		}
-		s++;
-		cnt--;
-	}
+	for (; cnt && word_misaligned(s); s++, cnt--)
+		if (*s == c)
+			return (void *) s;
 
-	return p;
+	for (; cnt >= WORD_SIZE && !word_has_zero(*(const word_t *) s ^ mask); s += WORD_SIZE, cnt -= WORD_SIZE)
+		;
+
+	for (; cnt; s++, cnt--)
+		if (*s == c)
+			return (void *) s;
+
+	return NULL;
 }
 
+__attribute__((weak, alias("memchr_generic"))) void *memchr(void *src, int val, unsigned int cnt);
+
 char *strncpy(char *dest, const char *src, unsigned int n) {
 	char *tmp = dest;
 
@@ -144,16 +229,32 @@ char *strncpy(char *dest, const char *src, unsigned int n) {
 	return dest;
 }
 
-void *memmove(void *dst, const void *src, unsigned int cnt) {
-	char *p, *s;
-
-	if (dst <= src) {
-		p = (char *) dst;
-		s = (char *) src;
+__attribute__((weak)) void *memmove(void *dst, const void *src, unsigned int cnt) {
+	unsigned char *p = dst;
+	const unsigned char *s = src;
+	bool words = (((unsigned long) p ^ (unsigned long) s) & WORD_MASK) == 0;
+
+	/* Co-aligned buffers never overlap inside a word, so word copies are safe either way */
+	if (p <= s) {
+		if (words) {
+			for (; cnt && word_misaligned(p); cnt--)
+				*p++ = *s++;
+			for (; cnt >= WORD_SIZE; cnt -= WORD_SIZE, p += WORD_SIZE, s += WORD_SIZE)
+				*(word_t *) p = *(const word_t *) s;
+		}
 		while (cnt--) *p++ = *s++;
 	} else {
-		p = (char *) dst + cnt;
-		s = (char *) src + cnt;
+		p += cnt;
+		s += cnt;
+		if (words) {
+			for (; cnt && word_misaligned(p); cnt--)
+				*--p = *--s;
+			for (; cnt >= WORD_SIZE; cnt -= WORD_SIZE) {
+				p -= WORD_SIZE;
+				s -= WORD_SIZE;
+				*(word_t *) p = *(const word_t *) s;
+			}
+		}
 		while (cnt--) *--p = *--s;
 	}
 
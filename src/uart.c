@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <types.h>
 
+#include <log.h>
 #include <timer.h>
 
 #include <sys-uart.h>
@@ -17,20 +18,34 @@ extern sunxi_serial_t uart_dbg;
 void uart_log_putchar(void *arg, char c) {
 	if (c == '\n') {
 		/* If the character is a newline, transmit a carriage return before newline */
-		sunxi_serial_putc(&uart_dbg, '\r');
+		log_putc('\r');
 	}
-	/* Transmit the character */
-	sunxi_serial_putc(&uart_dbg, c);
+	/* Transmit the character, through the log ring once it is running */
+	log_putc(c);
+}
+
+/* Transmit a span of characters over the UART, adding a carriage return before each newline */
+void uart_log_write(void *arg, const char *s, unsigned len) {
+	unsigned start = 0, i;
+
+	for (i = 0; i < len; i++) {
+		if (s[i] == '\n') {
+			log_write(s + start, i - start);
+			log_write("\r", 1);
+			start = i;
+		}
+	}
+	log_write(s + start, len - start);
 }
 
 /* Transmit a character over the UART */
 int uart_putchar(int c) {
 	if (c == '\n') {
 		/* If the character is a newline, transmit a carriage return before newline */
-		sunxi_serial_putc(&uart_dbg, '\r');
+		log_putc('\r');
 	}
-	/* Transmit the character */
-	sunxi_serial_putc(&uart_dbg, c);
+	/* Transmit the character, in order with the buffered log output */
+	log_putc(c);
 	/* Return success */
 	return 0;
 }
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+/*
+ * The linear first-fit allocator smalloc used before TLSF, kept as the
+ * baseline for "smalloc_test bench". Same logic as before, the block
+ * addresses are uintptr_t so it also runs on 64-bit hosts.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BYTE_ALIGN(x) (((x + 15) / 16) * 16)
+
+struct linear_block_t {
+	uintptr_t address;
+	uint32_t size;
+	uint32_t o_size;
+	struct linear_block_t *next;
+};
+
+static struct linear_block_t heap_head, heap_tail;
+
+void linear_init(void *mem, uint32_t size) {
+	heap_head.size = heap_tail.size = 0;
+	heap_head.address = (uintptr_t) mem;
+	heap_tail.address = (uintptr_t) mem + size;
+	heap_head.next = &heap_tail;
+	heap_tail.next = NULL;
+}
+
+void *linear_alloc(uint32_t num_bytes) {
+	struct linear_block_t *ptr, *newptr;
+	uint32_t actual_bytes;
+
+	if (!num_bytes)
+		return NULL;
+
+	actual_bytes = BYTE_ALIGN(num_bytes);
+
+	/* Walk the chain of allocated blocks for the first gap that fits */
+	ptr = &heap_head;
+	while (ptr && ptr->next) {
+		if (ptr->next->address >= (ptr->address + ptr->size + 2 * sizeof(struct linear_block_t) + actual_bytes))
+			break;
+		ptr = ptr->next;
+	}
+
+	if (!ptr->next)
+		return NULL;
+
+	newptr = (struct linear_block_t *) (ptr->address + ptr->size);
+	newptr->address = ptr->address + ptr->size + sizeof(struct linear_block_t);
+	newptr->size = actual_bytes;
+	newptr->o_size = num_bytes;
+	newptr->next = ptr->next;
+	ptr->next = newptr;
+
+	return (void *) newptr->address;
+}
+
+void linear_free(void *p) {
+	struct linear_block_t *ptr, *prev;
+
+	if (p == NULL)
+		return;
+
+	ptr = &heap_head;
+	while (ptr && ptr->next) {
+		if (ptr->next->address == (uintptr_t) p)
+			break;
+		ptr = ptr->next;
+	}
+
+	prev = ptr;
+	ptr = ptr->next;
+
+	if (!ptr)
+		return;
+
+	prev->next = ptr->next;
+}
@@ -0,0 +1,258 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+/*
+ * Host stress test of the TLSF allocator in src/smalloc.c.
+ *
+ * Pools are carved from mmap()ed memory so the test also runs on 64-bit
+ * hosts, whose addresses do not fit the uint32_t smalloc_init() takes.
+ * Built with ASan and UBSan, an out of range free list index aborts.
+ *
+ * Run with "bench" to time allocation patterns against the linear
+ * allocator smalloc used before, see smalloc_linear.c.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "smalloc.h"
+
+#define STRESS_POOL_SIZE (8 * 1024 * 1024)
+#define STRESS_SLOTS 2000
+#define STRESS_ROUNDS 1000000
+
+/* Largest block the first level lists hold, see FL_INDEX_MAX in smalloc.c */
+#define BLOCK_SIZE_MAX (1UL << 30)
+
+#define BENCH_POOL_SIZE (8 * 1024 * 1024)
+#define BENCH_FDT_BLOCKS 2000
+#define BENCH_FDT_ROUNDS 20
+#define BENCH_CHURN_SLOTS 500
+#define BENCH_CHURN_ROUNDS 200000
+
+void linear_init(void *mem, uint32_t size);
+void *linear_alloc(uint32_t num_bytes);
+void linear_free(void *p);
+
+static int failed;
+
+#define CHECK(cond, ...)                               \
+	do {                                               \
+		if (!(cond)) {                                 \
+			printf("FAIL %s:%d: ", __func__, __LINE__); \
+			printf(__VA_ARGS__);                       \
+			printf("\n");                              \
+			failed++;                                  \
+		}                                              \
+	} while (0)
+
+static void *map(size_t size) {
+	void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (mem == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	return mem;
+}
+
+/* Random allocations and frees of mixed sizes and alignments, every byte is checked before it is freed */
+static void test_stress(void) {
+	static void *ptr[STRESS_SLOTS];
+	static uint32_t len[STRESS_SLOTS];
+	static uint8_t fill[STRESS_SLOTS];
+	uint8_t *mem = map(STRESS_POOL_SIZE);
+	smalloc_pool_t *pool;
+	uint32_t fails = 0;
+
+	pool = smalloc_pool_create(mem + 3, STRESS_POOL_SIZE - 3);
+	CHECK(pool, "pool create");
+	if (!pool)
+		return;
+
+	srand(5);
+	for (uint32_t round = 0; round < STRESS_ROUNDS; round++) {
+		uint32_t i = rand() % STRESS_SLOTS;
+
+		if (ptr[i]) {
+			uint8_t *p = ptr[i];
+
+			for (uint32_t k = 0; k < len[i]; k += 61)
+				CHECK(p[k] == fill[i], "slot %u byte %u overwritten", i, k);
+			CHECK(p[len[i] - 1] == fill[i], "slot %u tail overwritten", i);
+			smalloc_pool_free(pool, p);
+			ptr[i] = NULL;
+			continue;
+		}
+
+		len[i] = 1 + rand() % (rand() % 3 ? 128 : 32768);
+		uint32_t align = rand() % 4 ? 0 : 1U << (rand() % 13);
+		uint8_t *p = smalloc_pool_alloc(pool, len[i], align);
+		if (!p) {
+			fails++;
+			continue;
+		}
+
+		CHECK(((uintptr_t) p & ((align > 16 ? align : 16) - 1)) == 0, "%p not aligned to %u", (void *) p, align);
+		CHECK(p >= mem && p + len[i] <= mem + STRESS_POOL_SIZE, "%p outside the pool", (void *) p);
+		fill[i] = rand();
+		memset(p, fill[i], len[i]);
+		ptr[i] = p;
+	}
+
+	for (uint32_t i = 0; i < STRESS_SLOTS; i++)
+		smalloc_pool_free(pool, ptr[i]);
+
+	/* Everything merged back, a block of most of the pool fits again */
+	void *all = smalloc_pool_alloc(pool, STRESS_POOL_SIZE / 4 * 3, 0);
+	CHECK(all, "no full size block after freeing everything");
+	smalloc_pool_free(pool, all);
+
+	printf("stress: %u rounds, %u allocations did not fit\n", STRESS_ROUNDS, fails);
+	munmap(mem, STRESS_POOL_SIZE);
+}
+
+/* Pools around BLOCK_SIZE_MAX, the free block they start with must land on a valid first level list */
+static void test_block_size_max(void) {
+	static const int64_t delta[] = {-4096, -64, -16, 0, 16, 64, 4096, 1024 * 1024};
+	size_t map_size = BLOCK_SIZE_MAX + 2 * 1024 * 1024;
+	uint8_t *mem = map(map_size);
+
+	for (uint32_t i = 0; i < sizeof(delta) / sizeof(delta[0]); i++) {
+		uint32_t size = BLOCK_SIZE_MAX + delta[i];
+		smalloc_pool_t *pool = smalloc_pool_create(mem, size);
+		void *a, *b;
+
+		CHECK(pool, "pool of %u bytes", size);
+		if (!pool)
+			continue;
+
+		a = smalloc_pool_alloc(pool, 256 * 1024 * 1024, 0);
+		b = smalloc_pool_alloc(pool, 256 * 1024 * 1024, 4096);
+		CHECK(a && b, "two 256MB blocks from a %u byte pool", size);
+		smalloc_pool_free(pool, a);
+		smalloc_pool_free(pool, b);
+
+		/* Freed blocks merge back to the single large block, which must map and be found again */
+		a = smalloc_pool_alloc(pool, BLOCK_SIZE_MAX / 2, 0);
+		CHECK(a, "half of BLOCK_SIZE_MAX from a %u byte pool", size);
+		smalloc_pool_free(pool, a);
+
+		CHECK(!smalloc_pool_alloc(pool, BLOCK_SIZE_MAX, 0), "BLOCK_SIZE_MAX must not be handed out");
+	}
+
+	printf("block size max: pools of 1GB %+lld to %+lld bytes\n", (long long) delta[0], (long long) delta[sizeof(delta) / sizeof(delta[0]) - 1]);
+	munmap(mem, map_size);
+}
+
+static smalloc_pool_t *bench_pool;
+
+static void *tlsf_alloc(uint32_t num_bytes) {
+	return smalloc_pool_alloc(bench_pool, num_bytes, 0);
+}
+
+static void tlsf_free(void *p) {
+	smalloc_pool_free(bench_pool, p);
+}
+
+typedef struct {
+	const char *name;
+	void *(*alloc)(uint32_t num_bytes);
+	void (*free)(void *p);
+} bench_heap_t;
+
+static double now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Many small nodes like an FDT unflatten, freed in interleaved order */
+static void bench_fdt(const bench_heap_t *heap) {
+	static void *ptr[BENCH_FDT_BLOCKS];
+	uint32_t fails = 0;
+	double t = now();
+
+	srand(7);
+	for (uint32_t round = 0; round < BENCH_FDT_ROUNDS; round++) {
+		for (uint32_t i = 0; i < BENCH_FDT_BLOCKS; i++) {
+			ptr[i] = heap->alloc(16 + rand() % 240);
+			fails += !ptr[i];
+		}
+		for (uint32_t i = 0; i < BENCH_FDT_BLOCKS; i += 2)
+			heap->free(ptr[i]);
+		for (uint32_t i = 1; i < BENCH_FDT_BLOCKS; i += 2)
+			heap->free(ptr[i]);
+	}
+
+	printf("  %-8s fdt    %u x %u blocks   %8.4f s, %u failed\n", heap->name, BENCH_FDT_ROUNDS, BENCH_FDT_BLOCKS, now() - t, fails);
+}
+
+/* Random allocations and frees around a steady number of live blocks */
+static void bench_churn(const bench_heap_t *heap) {
+	static void *ptr[BENCH_CHURN_SLOTS];
+	uint32_t fails = 0;
+	double t = now();
+
+	srand(11);
+	for (uint32_t round = 0; round < BENCH_CHURN_ROUNDS; round++) {
+		uint32_t i = rand() % BENCH_CHURN_SLOTS;
+
+		if (ptr[i]) {
+			heap->free(ptr[i]);
+			ptr[i] = NULL;
+		} else {
+			ptr[i] = heap->alloc(16 + rand() % 1008);
+			fails += !ptr[i];
+		}
+	}
+	for (uint32_t i = 0; i < BENCH_CHURN_SLOTS; i++) {
+		heap->free(ptr[i]);
+		ptr[i] = NULL;
+	}
+
+	printf("  %-8s churn  %u ops %u slots %8.4f s, %u failed\n", heap->name, BENCH_CHURN_ROUNDS, BENCH_CHURN_SLOTS, now() - t, fails);
+}
+
+/* TLSF against the linear allocator on the same patterns, times depend on the host */
+static void bench(void) {
+	static const bench_heap_t heaps[] = {
+			{"linear", linear_alloc, linear_free},
+			{"tlsf", tlsf_alloc, tlsf_free},
+	};
+	uint8_t *mem = map(BENCH_POOL_SIZE);
+
+	for (uint32_t i = 0; i < sizeof(heaps) / sizeof(heaps[0]); i++) {
+		linear_init(mem, BENCH_POOL_SIZE);
+		bench_pool = smalloc_pool_create(mem, BENCH_POOL_SIZE);
+		bench_fdt(&heaps[i]);
+
+		linear_init(mem, BENCH_POOL_SIZE);
+		bench_pool = smalloc_pool_create(mem, BENCH_POOL_SIZE);
+		bench_churn(&heaps[i]);
+	}
+
+	munmap(mem, BENCH_POOL_SIZE);
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench();
+		return 0;
+	}
+
+	test_stress();
+	test_block_size_max();
+
+	if (failed) {
+		printf("smalloc_test: %d checks failed\n", failed);
+		return 1;
+	}
+
+	printf("smalloc_test: ok\n");
+	return 0;
+}
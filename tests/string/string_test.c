@@ -0,0 +1,389 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+/*
+ * Host test of the C string routines: src/string.c and the scalar memcmp the
+ * riscv64 dispatch falls back to. Both are linked with a sk_ prefix and
+ * checked against glibc.
+ *
+ * Every buffer ends right before a PROT_NONE guard page, so a word load past
+ * the terminator faults instead of reading stale bytes. Offsets run over two
+ * host words, which covers every misalignment of the 4-byte words of the
+ * 32-bit targets as well. Run with "bench" to compare throughput instead.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_LEN 4096
+#define MAX_OFFSET (2 * sizeof(unsigned long))
+#define RANDOM_ROUNDS 20000
+
+unsigned int sk_strlen(const char *str);
+unsigned int strlen_generic(const char *str);
+unsigned int sk_strnlen(const char *s, unsigned int n);
+char *sk_strcpy(char *dst, const char *src);
+char *sk_strncpy(char *dst, const char *src, unsigned int n);
+char *sk_strcat(char *dst, const char *src);
+int sk_strcmp(const char *p1, const char *p2);
+int sk_strncmp(const char *p1, const char *p2, unsigned int cnt);
+char *sk_strchr(const char *s, int c);
+char *sk_strrchr(const char *s, int c);
+char *sk_strstr(const char *s1, const char *s2);
+void *sk_memchr(void *src, int val, unsigned int cnt);
+void *memchr_generic(void *src, int val, unsigned int cnt);
+void *sk_memmove(void *dst, const void *src, unsigned int cnt);
+int sk_memcmp(const void *s1, const void *s2, size_t n);
+
+static int failed;
+
+#define CHECK(cond, ...)                               \
+	do {                                               \
+		if (!(cond)) {                                 \
+			printf("FAIL %s:%d: ", __func__, __LINE__); \
+			printf(__VA_ARGS__);                       \
+			printf("\n");                              \
+			failed++;                                  \
+		}                                              \
+	} while (0)
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t rng(void) {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static int sign(int v) {
+	return (v > 0) - (v < 0);
+}
+
+/* A few letters only, so searches hit and compares run long */
+static char rand_char(void) {
+	return "abcd"[rng() % 4];
+}
+
+static void rand_str(char *s, unsigned int len) {
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		s[i] = rand_char();
+	s[len] = '\0';
+}
+
+static uint8_t *map_guarded(void) {
+	long page = sysconf(_SC_PAGESIZE);
+	size_t size = (3 * MAX_LEN + page - 1) / page * page;
+	uint8_t *mem = mmap(NULL, size + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (mem == MAP_FAILED || mprotect(mem + size, page, PROT_NONE)) {
+		perror("mmap");
+		exit(1);
+	}
+	return mem + size;
+}
+
+/* Guard pages of two independent buffers, tail(g, n) is the last n bytes before one */
+static uint8_t *guard_a, *guard_b;
+
+static inline char *tail(uint8_t *guard, unsigned int n) {
+	return (char *) guard - n;
+}
+
+/* A random string of len characters, its terminator is the last byte before the guard */
+static char *guarded_str(uint8_t *guard, unsigned int len) {
+	char *s = tail(guard, len + 1);
+
+	rand_str(s, len);
+	return s;
+}
+
+/* Start of a len byte buffer at the given offset in a word, ending less than a word before the guard */
+static uint8_t *place(uint8_t *guard, unsigned int len, unsigned int offset) {
+	uint8_t *p = guard - len;
+
+	return p - (((uintptr_t) p - offset) & (MAX_OFFSET - 1));
+}
+
+static unsigned int rand_len(void) {
+	/* Short strings are the common case, long ones cover the word loops */
+	return (rng() & 1) ? rng() % 64 : rng() % (MAX_LEN - MAX_OFFSET);
+}
+
+static void test_strlen(void) {
+	unsigned int len, i, n;
+	char *s;
+
+	for (len = 0; len < 3 * MAX_OFFSET; len++) {
+		s = guarded_str(guard_a, len);
+		CHECK(sk_strlen(s) == len, "strlen %u", len);
+		CHECK(strlen_generic(s) == len, "strlen_generic %u", len);
+		for (n = 0; n <= len + 2; n++)
+			CHECK(sk_strnlen(s, n) == strnlen(s, n), "strnlen %u %u", len, n);
+	}
+
+	for (i = 0; i < RANDOM_ROUNDS; i++) {
+		len = rand_len();
+		s = guarded_str(guard_a, len);
+		n = rng() % (len + 16);
+		CHECK(sk_strlen(s) == len, "strlen %u", len);
+		CHECK(strlen_generic(s) == len, "strlen_generic %u", len);
+		CHECK(sk_strnlen(s, n) == strnlen(s, n), "strnlen %u %u", len, n);
+	}
+}
+
+static void test_strchr(void) {
+	unsigned int i, len;
+	char *s;
+	int c;
+
+	for (i = 0; i < RANDOM_ROUNDS; i++) {
+		len = rand_len();
+		s = guarded_str(guard_a, len);
+		/* Mostly letters that do occur, sometimes one that does not or the terminator */
+		c = (rng() % 8 == 0) ? (rng() & 1 ? 'e' : '\0') : rand_char();
+		/* A long run without c makes the word loop do the work */
+		if (len > 8 && rng() % 4 == 0)
+			memset(s, 'z', len - 1 - rng() % 8);
+
+		CHECK(sk_strchr(s, c) == strchr(s, c), "strchr len %u c 0x%x", len, c);
+		CHECK(sk_strrchr(s, c) == strrchr(s, c), "strrchr len %u c 0x%x", len, c);
+	}
+}
+
+static void test_memchr(void) {
+	unsigned int i, len;
+	uint8_t *p;
+	int c;
+
+	for (i = 0; i < RANDOM_ROUNDS; i++) {
+		len = rand_len();
+		/* No terminator, the buffer simply stops at the guard page */
+		p = (uint8_t *) tail(guard_a, len);
+		memset(p, 'z', len);
+		if (len && rng() % 2)
+			p[rng() % len] = 'a';
+		c = (rng() % 4) ? 'a' : 0x100 + 'a';
+
+		CHECK(sk_memchr(p, c, len) == memchr(p, c, len), "memchr len %u", len);
+		CHECK(memchr_generic(p, c, len) == memchr(p, c, len), "memchr_generic len %u", len);
+	}
+}
+
+static void test_strcmp(void) {
+	unsigned int o1, o2, i, len, diff, n;
+	char *s1, *s2;
+
+	for (o1 = 0; o1 < MAX_OFFSET; o1++) {
+		for (o2 = 0; o2 < MAX_OFFSET; o2++) {
+			for (i = 0; i < RANDOM_ROUNDS / 64; i++) {
+				len = rand_len();
+				s1 = (char *) place(guard_a, len + 1, o1);
+				s2 = (char *) place(guard_b, len + 1, o2);
+				rand_str(s1, len);
+				memcpy(s2, s1, len + 1);
+
+				/* Equal, differing at a random byte, or one a prefix of the other */
+				diff = len ? rng() % len : 0;
+				switch (rng() % 3) {
+					case 1:
+						if (len)
+							s2[diff] = rand_char() + (rng() & 1 ? 0x80 : 0);
+						break;
+					case 2:
+						s2[diff] = '\0';
+						break;
+				}
+				n = rng() % (len + 16);
+
+				CHECK(sign(sk_strcmp(s1, s2)) == sign(strcmp(s1, s2)), "strcmp offsets %u %u len %u", o1, o2, len);
+				CHECK(sign(sk_strcmp(s2, s1)) == sign(strcmp(s2, s1)), "strcmp offsets %u %u len %u", o2, o1, len);
+				CHECK(sign(sk_strncmp(s1, s2, n)) == sign(strncmp(s1, s2, n)), "strncmp offsets %u %u len %u n %u", o1, o2, len, n);
+			}
+		}
+	}
+}
+
+static void test_strstr(void) {
+	unsigned int i, len, nlen;
+	char needle[16];
+	char *s;
+
+	for (i = 0; i < RANDOM_ROUNDS; i++) {
+		len = rand_len();
+		s = guarded_str(guard_a, len);
+		nlen = rng() % sizeof(needle);
+		/* Half the needles are cut from the haystack, the tail end included */
+		if (nlen <= len && rng() % 2)
+			memcpy(needle, s + rng() % (len - nlen + 1), nlen);
+		else
+			rand_str(needle, nlen);
+		needle[nlen] = '\0';
+
+		CHECK(sk_strstr(s, needle) == strstr(s, needle), "strstr len %u needle %s", len, needle);
+	}
+}
+
+static void test_memmove(void) {
+	static uint8_t ref[3 * MAX_LEN];
+	unsigned int so, doff, i, len, gap, span;
+	uint8_t *high, *low, *src, *dst;
+	bool forward;
+
+	for (so = 0; so < MAX_OFFSET; so++) {
+		for (doff = 0; doff < MAX_OFFSET; doff++) {
+			for (i = 0; i < RANDOM_ROUNDS / 64; i++) {
+				len = rand_len();
+				/* dst below src copies forward, above it backward */
+				forward = rng() & 1;
+				high = place(guard_a, len, forward ? so : doff);
+
+				/* Overlapping by up to 64 bytes, or disjoint */
+				gap = (rng() & 1) ? rng() % 64 : len + rng() % 64;
+				gap += ((uintptr_t) high - gap - (forward ? doff : so)) & (MAX_OFFSET - 1);
+				low = high - gap;
+				src = forward ? high : low;
+				dst = forward ? low : high;
+
+				span = guard_a - low;
+				for (unsigned int k = 0; k < span; k++)
+					low[k] = rng();
+				memcpy(ref, low, span);
+				memmove(ref + (dst - low), ref + (src - low), len);
+
+				CHECK(sk_memmove(dst, src, len) == dst, "memmove return");
+				CHECK(memcmp(low, ref, span) == 0, "memmove offsets %u %u gap %u len %u", so, doff, gap, len);
+			}
+		}
+	}
+}
+
+static void test_memcmp(void) {
+	unsigned int o1, o2, i, len;
+	uint8_t *p1, *p2;
+
+	for (o1 = 0; o1 < MAX_OFFSET; o1++) {
+		for (o2 = 0; o2 < MAX_OFFSET; o2++) {
+			for (i = 0; i < RANDOM_ROUNDS / 64; i++) {
+				len = rand_len();
+				p1 = place(guard_a, len, o1);
+				p2 = place(guard_b, len, o2);
+				for (unsigned int k = 0; k < len; k++)
+					p1[k] = rng();
+				memcpy(p2, p1, len);
+				if (len && rng() % 4)
+					p2[rng() % len] ^= 1 << (rng() % 8);
+
+				CHECK(sign(sk_memcmp(p1, p2, len)) == sign(memcmp(p1, p2, len)), "memcmp offsets %u %u len %u", o1, o2, len);
+				CHECK(sign(sk_memcmp(p2, p1, len)) == sign(memcmp(p2, p1, len)), "memcmp offsets %u %u len %u", o2, o1, len);
+			}
+		}
+	}
+}
+
+static void test_copy(void) {
+	char a[MAX_LEN], b[2 * MAX_LEN];
+	unsigned int i, len, n;
+	char *s;
+
+	for (i = 0; i < RANDOM_ROUNDS / 16; i++) {
+		len = rand_len();
+		s = guarded_str(guard_a, len);
+		n = rng() % (len + 16);
+
+		CHECK(sk_strcpy(a, s) == a && strcmp(a, s) == 0, "strcpy len %u", len);
+
+		memset(a, 'x', sizeof(a));
+		memset(b, 'x', sizeof(b));
+		CHECK(sk_strncpy(a, s, n) == a, "strncpy return");
+		strncpy(b, s, n);
+		CHECK(memcmp(a, b, n + 1) == 0, "strncpy len %u n %u", len, n);
+
+		strcpy(b, "head");
+		strcpy(a, "head");
+		CHECK(sk_strcat(a, s) == a && strcmp(a, strcat(b, s)) == 0, "strcat len %u", len);
+	}
+}
+
+static double now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile uintptr_t sink;
+
+#define BENCH(name, bytes, expr)                                                           \
+	do {                                                                                  \
+		double t = now();                                                                 \
+		unsigned int r;                                                                   \
+		for (r = 0; r < rounds; r++) {                                                    \
+			sink += (uintptr_t) (expr);                                                   \
+			__asm__ volatile("" ::: "memory");                                            \
+		}                                                                                 \
+		t = now() - t;                                                                    \
+		printf("  %-16s %6u bytes %8.2f GB/s\n", name, bytes, (double) (bytes) *rounds / t / 1e9); \
+	} while (0)
+
+/* Throughput of each routine next to glibc, only meaningful from the unsanitized string_bench */
+static void bench(void) {
+	static const unsigned int sizes[] = {16, 256, 4000};
+	unsigned int i, len, rounds;
+	char *s1, *s2;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		len = sizes[i];
+		rounds = 200000000 / (len + 32);
+		/* Clear of the guard page, glibc reads ahead with masked loads that are slow next to it */
+		s1 = tail(guard_a, len + 1 + 64);
+		s2 = tail(guard_b, len + 1 + 64);
+		rand_str(s1, len);
+		memcpy(s2, s1, len + 1);
+
+		BENCH("strlen", len, sk_strlen(s1));
+		BENCH("glibc strlen", len, strlen(s1));
+		BENCH("strcmp", len, sk_strcmp(s1, s2));
+		BENCH("glibc strcmp", len, strcmp(s1, s2));
+		BENCH("memchr", len, sk_memchr(s1, 'z', len));
+		BENCH("glibc memchr", len, memchr(s1, 'z', len));
+		BENCH("memcmp", len, sk_memcmp(s1, s2, len));
+		BENCH("glibc memcmp", len, memcmp(s1, s2, len));
+		BENCH("memmove", len, sk_memmove(s2 - 8, s2, len));
+		BENCH("glibc memmove", len, memmove(s2 - 8, s2, len));
+	}
+}
+
+int main(int argc, char **argv) {
+	guard_a = map_guarded();
+	guard_b = map_guarded();
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench();
+		return 0;
+	}
+
+	test_strlen();
+	test_strchr();
+	test_memchr();
+	test_strcmp();
+	test_strstr();
+	test_memmove();
+	test_memcmp();
+	test_copy();
+
+	if (failed) {
+		printf("string_test: %d checks failed\n", failed);
+		return 1;
+	}
+
+	printf("string_test: ok\n");
+	return 0;
+}
@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __TYPES_H__
+#define __TYPES_H__
+
+/* Host stand-in for the arch types.h, the string routines only need the C99 types */
+#include <stddef.h>
+#include <stdint.h>
+
+#endif// __TYPES_H__
@@ -0,0 +1,9 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __BARRIER_H__
+#define __BARRIER_H__
+
+/* Host stand-in for the arch barrier.h */
+#define wmb() __sync_synchronize()
+
+#endif// __BARRIER_H__
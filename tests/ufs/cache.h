@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+/* Host stand-in for the arch cache.h, the mock controller shares the CPU view of memory */
+#include <stdint.h>
+
+static inline void flush_dcache_range(uint64_t start, uint64_t end) {
+}
+
+static inline void invalidate_dcache_range(uint64_t start, uint64_t end) {
+}
+
+#endif// __CACHE_H__
@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __IO_H__
+#define __IO_H__
+
+/* Host stand-in for the arch io.h, every access lands in the mock register file of ufs_test.c */
+#include <stdint.h>
+
+#include "types.h"
+
+uint32_t read32(virtual_addr_t addr);
+
+void write32(virtual_addr_t addr, uint32_t value);
+
+#endif// __IO_H__
@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __LOG_H__
+#define __LOG_H__
+
+/* Host stand-in for include/log.h, errors and warnings are printed, the rest is dropped */
+#include <stdio.h>
+
+#define LOG_LEVEL_MUTE 0
+
+#define printk(level, fmt, ...) ((void) 0)
+#define printk_debug(fmt, ...) ((void) 0)
+#define printk_info(fmt, ...) ((void) 0)
+#define printk_warning(fmt, ...) printf("  " fmt, ##__VA_ARGS__)
+#define printk_error(fmt, ...) printf("  " fmt, ##__VA_ARGS__)
+
+#endif// __LOG_H__
@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __SMALLOC_H__
+#define __SMALLOC_H__
+
+/*
+ * Host stand-in for include/smalloc.h. The driver stores descriptor and
+ * buffer addresses in 32-bit fields, so ufs_test.c serves them from memory
+ * mapped below 4GB.
+ */
+#include <stdint.h>
+
+void *smalloc(uint32_t size);
+
+#endif// __SMALLOC_H__
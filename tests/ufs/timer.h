@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+/* Host stand-in for the arch timer.h, ufs_test.c runs a fake clock so timeouts expire at once */
+#include <stdint.h>
+
+uint32_t time_ms(void);
+
+void mdelay(uint32_t ms);
+
+#endif// __TIMER_H__
@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#ifndef __TYPES_H__
+#define __TYPES_H__
+
+/* Host stand-in for the arch types.h, register addresses stay 64-bit like riscv64 */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef uint64_t u64_t;
+
+typedef uint64_t virtual_addr_t;
+
+#endif// __TYPES_H__
@@ -0,0 +1,441 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+/*
+ * Host test of the UFS host controller driver in src/drivers/ufs.
+ *
+ * read32() and write32() land in a mock register file. The mock decodes
+ * the transfer request list the driver sets up and answers NOP OUT, query
+ * requests and READ(10) like a device would. Slots complete one per
+ * doorbell read, highest slot first, so queued commands finish out of order.
+ * A slot can be stalled to let the doorbell time out.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <byteorder.h>
+#include <ufs/ufs.h>
+
+#include "io.h"
+#include "smalloc.h"
+#include "timer.h"
+
+#define MOCK_BASE 0x04e00000
+#define MOCK_REG_SPACE 0x400
+
+#define MOCK_BLOCK_SIZE 4096
+#define MOCK_HS_GEAR_LOCAL 4
+#define MOCK_HS_GEAR_PEER 3
+#define MOCK_LANES 2
+
+/* fDeviceInit reads that still return 1 before the device reports it is done */
+#define MOCK_DEVICE_INIT_READS 3
+
+/* Attempts ufshcd_verify_dev_init() makes, UFS_NOP_OUT_RETRIES in ufs.c */
+#define NOP_OUT_RETRIES 10
+
+#define ARENA_SIZE (16 * 1024 * 1024)
+#define READ_BLOCKS 1024
+
+static int failed;
+
+#define CHECK(cond, ...)                               \
+	do {                                               \
+		if (!(cond)) {                                 \
+			printf("FAIL %s:%d: ", __func__, __LINE__); \
+			printf(__VA_ARGS__);                       \
+			printf("\n");                              \
+			failed++;                                  \
+		}                                              \
+	} while (0)
+
+static struct {
+	uint32_t regs[MOCK_REG_SPACE / 4];
+	/* Slots the mock never completes */
+	uint32_t stall_mask;
+	uint32_t fdeviceinit;
+	uint32_t fdeviceinit_reads;
+	uint32_t pwr_mode;
+	uint32_t last_clear;
+	uint32_t max_inflight;
+	uint32_t rings;
+	uint32_t nop_outs;
+	uint32_t queries;
+	uint32_t reads;
+} mock;
+
+static uint32_t fake_ms;
+
+static uint8_t *arena;
+static uint32_t arena_used;
+
+uint32_t time_ms(void) {
+	return ++fake_ms;
+}
+
+void mdelay(uint32_t ms) {
+	fake_ms += ms;
+}
+
+void *smalloc(uint32_t size) {
+	void *p;
+
+	if (arena_used + size > ARENA_SIZE)
+		return NULL;
+
+	p = arena + arena_used;
+	arena_used += (size + 63) & ~63;
+	return p;
+}
+
+static inline uint32_t *reg(uint32_t offset) {
+	return &mock.regs[offset / 4];
+}
+
+static uint8_t pattern(uint64_t pos) {
+	return (uint8_t) (pos ^ (pos >> 8) ^ (pos >> 16) ^ 0x5a);
+}
+
+static void mock_reset(void) {
+	memset(&mock, 0, sizeof(mock));
+	*reg(REG_CONTROLLER_CAPABILITIES) = MASK_TRANSFER_REQUESTS_SLOTS;
+	*reg(REG_UFS_VERSION) = UFSHCI_VERSION_21;
+	fake_ms = 0;
+}
+
+static uint32_t mock_attr(uint32_t attr, int peer) {
+	switch (attr) {
+		case PA_CONNECTEDRXDATALANES:
+		case PA_CONNECTEDTXDATALANES:
+			return MOCK_LANES;
+		case PA_MAXRXHSGEAR:
+			return peer ? MOCK_HS_GEAR_PEER : MOCK_HS_GEAR_LOCAL;
+		default:
+			return 0;
+	}
+}
+
+static void mock_uic_command(uint32_t cmd) {
+	uint32_t attr = UIC_GET_ATTR_ID(*reg(REG_UIC_COMMAND_ARG_1));
+
+	switch (cmd) {
+		case UIC_CMD_DME_LINK_STARTUP:
+			*reg(REG_CONTROLLER_STATUS) |= DEVICE_PRESENT | UTP_TRANSFER_REQ_LIST_READY | UTP_TASK_REQ_LIST_READY;
+			break;
+		case UIC_CMD_DME_GET:
+		case UIC_CMD_DME_PEER_GET:
+			*reg(REG_UIC_COMMAND_ARG_3) = mock_attr(attr, cmd == UIC_CMD_DME_PEER_GET);
+			break;
+		case UIC_CMD_DME_SET:
+			if (attr == PA_PWRMODE) {
+				mock.pwr_mode = *reg(REG_UIC_COMMAND_ARG_3);
+				*reg(REG_CONTROLLER_STATUS) = (*reg(REG_CONTROLLER_STATUS) & ~(0x7 << 8)) | (PWR_LOCAL << 8);
+				*reg(REG_INTERRUPT_STATUS) |= UIC_POWER_MODE;
+			}
+			break;
+		default:
+			break;
+	}
+
+	*reg(REG_UIC_COMMAND_ARG_2) = UIC_CMD_RESULT_SUCCESS;
+	*reg(REG_INTERRUPT_STATUS) |= UIC_COMMAND_COMPL;
+}
+
+/* Copy READ(10) data into the PRDT of a slot, returns the OCS */
+static uint32_t mock_read10(utp_transfer_req_desc_t *utrd, utp_transfer_cmd_desc_t *ucd, utp_upiu_req_t *req) {
+	ufshcd_sg_entry_t *prd = (ufshcd_sg_entry_t *) ((uint8_t *) ucd + le16_to_cpu(utrd->prd_table_offset) * 4);
+	uint32_t lba = (req->sc.cdb[2] << 24) | (req->sc.cdb[3] << 16) | (req->sc.cdb[4] << 8) | req->sc.cdb[5];
+	uint32_t blocks = (req->sc.cdb[7] << 8) | req->sc.cdb[8];
+	uint64_t pos = (uint64_t) lba * MOCK_BLOCK_SIZE;
+	uint32_t len = blocks * MOCK_BLOCK_SIZE;
+	uint32_t i, n, size;
+	uint8_t *buf;
+
+	if (be32_to_cpu(req->sc.exp_data_transfer_len) != len)
+		return OCS_MISMATCH_DATA_BUF_SIZE;
+	if ((le32_to_cpu(utrd->header.dword_0) & UTP_DEVICE_TO_HOST) == 0)
+		return OCS_INVALID_CMD_TABLE_ATTR;
+
+	for (i = 0; i < le16_to_cpu(utrd->prd_table_length); i++) {
+		buf = (uint8_t *) (uintptr_t) le32_to_cpu(prd[i].base_addr);
+		size = le32_to_cpu(prd[i].size) + 1;
+		if (size > len)
+			return OCS_MISMATCH_DATA_BUF_SIZE;
+		for (n = 0; n < size; n++)
+			buf[n] = pattern(pos++);
+		len -= size;
+	}
+
+	mock.reads++;
+	return len ? OCS_MISMATCH_DATA_BUF_SIZE : OCS_SUCCESS;
+}
+
+/* Act on the request in a slot like the device would, then clear its doorbell bit */
+static void mock_complete(int tag) {
+	utp_transfer_req_desc_t *utrd = (utp_transfer_req_desc_t *) (uintptr_t) *reg(REG_UTP_TRANSFER_REQ_LIST_BASE_L) + tag;
+	utp_transfer_cmd_desc_t *ucd = (utp_transfer_cmd_desc_t *) (uintptr_t) le32_to_cpu(utrd->command_desc_base_addr_lo);
+	utp_upiu_req_t *req = (utp_upiu_req_t *) ucd->command_upiu;
+	utp_upiu_rsp_t *rsp = (utp_upiu_rsp_t *) ((uint8_t *) ucd + le16_to_cpu(utrd->response_upiu_offset) * 4);
+	uint32_t trans = be32_to_cpu(req->header.dword_0) >> 24;
+	uint32_t ocs = OCS_SUCCESS;
+	uint32_t value = 0;
+
+	CHECK(le32_to_cpu(utrd->header.dword_0) >> UPIU_COMMAND_TYPE_OFFSET == UTP_CMD_TYPE_UFS_STORAGE, "slot %d command type", tag);
+	CHECK((be32_to_cpu(req->header.dword_0) & 0xff) == tag, "slot %d task tag", tag);
+
+	switch (trans) {
+		case UPIU_TRANSACTION_NOP_OUT:
+			mock.nop_outs++;
+			rsp->header.dword_0 = UPIU_HEADER_DWORD(UPIU_TRANSACTION_NOP_IN, 0, 0, tag);
+			break;
+		case UPIU_TRANSACTION_QUERY_REQ:
+			mock.queries++;
+			if (req->qr.idn == QUERY_FLAG_IDN_FDEVICEINIT && req->qr.opcode == UPIU_QUERY_OPCODE_SET_FLAG) {
+				mock.fdeviceinit = 1;
+				mock.fdeviceinit_reads = 0;
+			} else if (req->qr.idn == QUERY_FLAG_IDN_FDEVICEINIT && req->qr.opcode == UPIU_QUERY_OPCODE_READ_FLAG) {
+				value = mock.fdeviceinit;
+				if (mock.fdeviceinit && ++mock.fdeviceinit_reads >= MOCK_DEVICE_INIT_READS)
+					mock.fdeviceinit = 0;
+			}
+			rsp->header.dword_0 = UPIU_HEADER_DWORD(UPIU_TRANSACTION_QUERY_RSP, 0, 0, tag);
+			rsp->header.dword_1 = UPIU_HEADER_DWORD(0, 0, QUERY_RESULT_SUCCESS, 0);
+			rsp->qr.opcode = req->qr.opcode;
+			rsp->qr.idn = req->qr.idn;
+			rsp->qr.value = cpu_to_be32(value);
+			break;
+		case UPIU_TRANSACTION_COMMAND:
+			if (req->sc.cdb[0] == SCSI_READ10)
+				ocs = mock_read10(utrd, ucd, req);
+			rsp->header.dword_0 = UPIU_HEADER_DWORD(UPIU_TRANSACTION_RESPONSE, 0, 0, tag);
+			rsp->header.dword_1 = UPIU_HEADER_DWORD(0, 0, 0, S_GOOD);
+			rsp->sr.residual_transfer_count = 0;
+			break;
+		default:
+			ocs = OCS_INVALID_CMD_TABLE_ATTR;
+			break;
+	}
+
+	utrd->header.dword_2 = cpu_to_le32(ocs);
+	*reg(REG_UTP_TRANSFER_REQ_DOOR_BELL) &= ~(1 << tag);
+	*reg(REG_INTERRUPT_STATUS) |= UTP_TRANSFER_REQ_COMPL;
+}
+
+uint32_t read32(virtual_addr_t addr) {
+	uint32_t offset = addr - MOCK_BASE;
+	uint32_t pending;
+
+	if (addr < MOCK_BASE || offset >= MOCK_REG_SPACE) {
+		printf("FAIL read32: address 0x%llx outside the controller\n", (unsigned long long) addr);
+		exit(1);
+	}
+
+	/* The device makes progress while the driver polls the doorbell */
+	if (offset == REG_UTP_TRANSFER_REQ_DOOR_BELL) {
+		pending = *reg(offset) & ~mock.stall_mask;
+		if (pending)
+			mock_complete(31 - __builtin_clz(pending));
+	}
+
+	return *reg(offset);
+}
+
+void write32(virtual_addr_t addr, uint32_t value) {
+	uint32_t offset = addr - MOCK_BASE;
+	uint32_t inflight;
+
+	if (addr < MOCK_BASE || offset >= MOCK_REG_SPACE) {
+		printf("FAIL write32: address 0x%llx outside the controller\n", (unsigned long long) addr);
+		exit(1);
+	}
+
+	switch (offset) {
+		case REG_INTERRUPT_STATUS:
+			*reg(offset) &= ~value;
+			break;
+		case REG_CONTROLLER_ENABLE:
+			*reg(offset) = value & CONTROLLER_ENABLE;
+			*reg(REG_CONTROLLER_STATUS) = (value & CONTROLLER_ENABLE) ? UIC_COMMAND_READY : 0;
+			break;
+		case REG_UIC_COMMAND:
+			*reg(offset) = value;
+			mock_uic_command(value);
+			break;
+		case REG_UTP_TRANSFER_REQ_DOOR_BELL:
+			CHECK(*reg(REG_UTP_TRANSFER_REQ_LIST_RUN_STOP) & UTP_TRANSFER_REQ_LIST_RUN_STOP_BIT, "doorbell rung with the list stopped");
+			CHECK((*reg(offset) & value) == 0, "doorbell 0x%x rung again", value);
+			*reg(offset) |= value;
+			mock.rings++;
+			inflight = __builtin_popcount(*reg(offset));
+			if (inflight > mock.max_inflight)
+				mock.max_inflight = inflight;
+			break;
+		case REG_UTP_TRANSFER_REQ_LIST_CLEAR:
+			mock.last_clear = value;
+			*reg(REG_UTP_TRANSFER_REQ_DOOR_BELL) &= value;
+			break;
+		default:
+			*reg(offset) = value;
+			break;
+	}
+}
+
+static void dev_init(ufs_device_t *dev, blk_desc_t *bd) {
+	memset(dev, 0, sizeof(*dev));
+	memset(bd, 0, sizeof(*bd));
+	dev->sc_plat.base = MOCK_BASE;
+	dev->bd = bd;
+	bd->blksz = MOCK_BLOCK_SIZE;
+	bd->lba = 1 << 20;
+}
+
+static void setup_read10(scsi_cmd_t *pccb, uint8_t *buf, uint32_t lba, uint32_t blocks) {
+	memset(pccb, 0, sizeof(*pccb));
+	pccb->cmd[0] = SCSI_READ10;
+	pccb->cmd[2] = lba >> 24;
+	pccb->cmd[3] = lba >> 16;
+	pccb->cmd[4] = lba >> 8;
+	pccb->cmd[5] = lba;
+	pccb->cmd[7] = blocks >> 8;
+	pccb->cmd[8] = blocks;
+	pccb->cmdlen = 10;
+	pccb->pdata = buf;
+	pccb->datalen = blocks * MOCK_BLOCK_SIZE;
+	pccb->dma_dir = DMA_FROM_DEVICE;
+}
+
+static uint32_t check_data(const uint8_t *buf, uint32_t lba, uint32_t blocks) {
+	uint64_t pos = (uint64_t) lba * MOCK_BLOCK_SIZE;
+	uint32_t i, bad = 0;
+
+	for (i = 0; i < blocks * MOCK_BLOCK_SIZE; i++) {
+		if (buf[i] != pattern(pos + i))
+			bad++;
+	}
+	return bad;
+}
+
+/* Bring-up: HCE, link startup, NOP OUT, fDeviceInit set and poll, power mode change */
+static void test_init(void) {
+	static ufs_device_t dev;
+	static blk_desc_t bd;
+	ufs_hba_t *hba = &dev.ufs_hba;
+
+	mock_reset();
+	dev_init(&dev, &bd);
+
+	CHECK(ufs_init(&dev) == 0, "ufs_init");
+	CHECK(hba->nutrs == UFS_QUEUE_DEPTH, "nutrs %u", hba->nutrs);
+	CHECK(mock.nop_outs == 1, "%u NOP OUT", mock.nop_outs);
+	CHECK(mock.queries == 2 + MOCK_DEVICE_INIT_READS, "%u queries", mock.queries);
+	CHECK(mock.fdeviceinit == 0, "fDeviceInit still set");
+	CHECK(mock.pwr_mode == (FAST_MODE << 4 | FAST_MODE), "power mode 0x%x", mock.pwr_mode);
+	CHECK(hba->pwr_info.gear_rx == MOCK_HS_GEAR_LOCAL && hba->pwr_info.gear_tx == MOCK_HS_GEAR_PEER, "gear rx %u tx %u", hba->pwr_info.gear_rx, hba->pwr_info.gear_tx);
+	CHECK(hba->outstanding_reqs == 0, "outstanding 0x%x", hba->outstanding_reqs);
+	CHECK(*reg(REG_UTP_TRANSFER_REQ_DOOR_BELL) == 0, "doorbell 0x%x", *reg(REG_UTP_TRANSFER_REQ_DOOR_BELL));
+}
+
+/* READ(10) through scsi_read(), which keeps one request in flight per slot */
+static void test_read_queued(void) {
+	static ufs_device_t dev;
+	static blk_desc_t bd;
+	uint8_t *buf = smalloc(READ_BLOCKS * MOCK_BLOCK_SIZE);
+	uint64_t done;
+
+	mock_reset();
+	dev_init(&dev, &bd);
+	CHECK(ufs_init(&dev) == 0, "ufs_init");
+
+	memset(buf, 0, READ_BLOCKS * MOCK_BLOCK_SIZE);
+	done = scsi_read(&dev, 100, READ_BLOCKS, buf);
+
+	CHECK(done == READ_BLOCKS, "read %llu blocks", (unsigned long long) done);
+	CHECK(mock.reads == READ_BLOCKS * MOCK_BLOCK_SIZE / (512 * 1024), "%u READ(10)", mock.reads);
+	CHECK(mock.max_inflight == UFS_QUEUE_DEPTH, "queue depth %u", mock.max_inflight);
+	CHECK(check_data(buf, 100, READ_BLOCKS) == 0, "data mismatch");
+	CHECK(dev.ufs_hba.outstanding_reqs == 0, "outstanding 0x%x", dev.ufs_hba.outstanding_reqs);
+}
+
+/* A slot whose doorbell never clears is discarded through UTRLCLR, the others still complete */
+static void test_doorbell_timeout(void) {
+	static ufs_device_t dev;
+	static blk_desc_t bd;
+	static scsi_cmd_t cmd[2];
+	ufs_hba_t *hba = &dev.ufs_hba;
+	uint8_t *buf = smalloc(2 * 8 * MOCK_BLOCK_SIZE);
+	uint64_t done;
+
+	mock_reset();
+	dev_init(&dev, &bd);
+	CHECK(ufs_init(&dev) == 0, "ufs_init");
+
+	printf("ufs_test: expect slot 1 to be busy, then to time out\n");
+	mock.stall_mask = 1 << 1;
+	setup_read10(&cmd[0], buf, 0, 8);
+	setup_read10(&cmd[1], buf + 8 * MOCK_BLOCK_SIZE, 8, 8);
+	CHECK(ufshcd_queue_scsi(hba, &cmd[0], 0) == 0, "queue slot 0");
+	CHECK(ufshcd_queue_scsi(hba, &cmd[1], 1) == 0, "queue slot 1");
+	CHECK(ufshcd_queue_scsi(hba, &cmd[1], 1) == -1, "slot 1 queued twice");
+
+	CHECK(ufshcd_complete_scsi(hba, 0, UFS_SCSI_TIMEOUT) == 0, "complete slot 0");
+	CHECK(check_data(buf, 0, 8) == 0, "slot 0 data mismatch");
+	CHECK(ufshcd_complete_scsi(hba, 1, UFS_SCSI_TIMEOUT) == -1, "slot 1 did not time out");
+	CHECK(cmd[1].contr_stat == SCSI_SEL_TIME_OUT, "contr_stat 0x%llx", (unsigned long long) cmd[1].contr_stat);
+	CHECK(mock.last_clear == ~(1u << 1), "UTRLCLR 0x%08x", mock.last_clear);
+	CHECK(*reg(REG_UTP_TRANSFER_REQ_DOOR_BELL) == 0, "doorbell 0x%x", *reg(REG_UTP_TRANSFER_REQ_DOOR_BELL));
+	CHECK(hba->outstanding_reqs == 0, "outstanding 0x%x", hba->outstanding_reqs);
+
+	/* The cleared slot is usable again */
+	mock.stall_mask = 0;
+	CHECK(ufshcd_queue_scsi(hba, &cmd[1], 1) == 0, "requeue slot 1");
+	CHECK(ufshcd_complete_scsi(hba, 1, UFS_SCSI_TIMEOUT) == 0, "complete slot 1");
+	CHECK(check_data(buf + 8 * MOCK_BLOCK_SIZE, 8, 8) == 0, "slot 1 data mismatch");
+
+	/* scsi_read() stops at the stalled slot and drains the rest */
+	printf("ufs_test: expect a timeout on slot 2\n");
+	mock.stall_mask = 1 << 2;
+	done = scsi_read(&dev, 0, READ_BLOCKS, smalloc(READ_BLOCKS * MOCK_BLOCK_SIZE));
+	CHECK(done < READ_BLOCKS, "read %llu blocks past a stalled slot", (unsigned long long) done);
+	CHECK(hba->outstanding_reqs == 0, "outstanding 0x%x", hba->outstanding_reqs);
+	CHECK(*reg(REG_UTP_TRANSFER_REQ_DOOR_BELL) == 0, "doorbell 0x%x", *reg(REG_UTP_TRANSFER_REQ_DOOR_BELL));
+}
+
+/* A device that never answers NOP OUT fails the bring-up after the retries */
+static void test_nop_out_timeout(void) {
+	static ufs_device_t dev;
+	static blk_desc_t bd;
+
+	mock_reset();
+	dev_init(&dev, &bd);
+	mock.stall_mask = 1 << 0;
+
+	printf("ufs_test: expect NOP OUT timeouts\n");
+	CHECK(ufs_init(&dev) == -1, "ufs_init with a silent device");
+	CHECK(mock.rings == NOP_OUT_RETRIES, "%u doorbell rings", mock.rings);
+	CHECK(mock.nop_outs == 0, "%u NOP OUT answered", mock.nop_outs);
+	CHECK(*reg(REG_UTP_TRANSFER_REQ_DOOR_BELL) == 0, "doorbell 0x%x", *reg(REG_UTP_TRANSFER_REQ_DOOR_BELL));
+}
+
+int main(void) {
+	arena = mmap(NULL, ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+	if (arena == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+
+	test_init();
+	test_read_queued();
+	test_doorbell_timeout();
+	test_nop_out_timeout();
+
+	if (failed) {
+		printf("ufs_test: %d checks failed\n", failed);
+		return 1;
+	}
+
+	printf("ufs_test: ok\n");
+	return 0;
+}
@@ -0,0 +1,207 @@
+import argparse
+import html
+import os
+import re
+import struct
+import sys
+
+# Render the SyterKit boot timeline as a flame style SVG, or as text.
+#
+# The marks come from any of:
+#   - the FDT the kernel booted with, /sys/firmware/fdt on the target
+#   - the /proc/device-tree/bootstage directory
+#   - a capture of the "bootstage" shell command
+#
+#   python3 bootstage.py fdt.dtb -o boot.svg
+#   python3 bootstage.py bootstage.txt --text
+#
+# Each mark ends a stage that started at the previous mark, the first one
+# starts at power on. The top row is the whole boot, the middle row merges
+# neighbouring marks of the same kind, e.g. all file loads, and the bottom
+# row has one box per mark.
+
+FDT_MAGIC = 0xD00DFEED
+FDT_BEGIN_NODE = 1
+FDT_END_NODE = 2
+FDT_PROP = 3
+FDT_NOP = 4
+FDT_END = 9
+
+STAGE_NAMES = ["start", "clock", "pmu", "dram", "storage", "load", "fdt", "handoff", "user"]
+STAGE_COLORS = {
+    "start": "#9e9e9e",
+    "clock": "#f6c343",
+    "pmu": "#f0a030",
+    "dram": "#e8743b",
+    "storage": "#5aa0d8",
+    "load": "#4caf7a",
+    "fdt": "#a77bd1",
+    "handoff": "#d9534f",
+    "user": "#c0c0c0",
+}
+
+REPORT_LINE = re.compile(r"^\s*(\d+)\s+(\d+)\s+(\w+)\s+(.*?)\s*$")
+
+
+# Walk the structure block of a flattened device tree, yield (path, props)
+def fdt_nodes(blob):
+    magic, _, off_struct, off_strings = struct.unpack_from(">IIII", blob, 0)
+    if magic != FDT_MAGIC:
+        raise ValueError("not a device tree blob")
+
+    stack = []
+    pos = off_struct
+    while True:
+        token, = struct.unpack_from(">I", blob, pos)
+        pos += 4
+        if token == FDT_BEGIN_NODE:
+            end = blob.index(b"\0", pos)
+            stack.append((blob[pos:end].decode(), {}))
+            pos = (end + 4) & ~3
+        elif token == FDT_END_NODE:
+            yield "/".join(name for name, _ in stack), stack[-1][1]
+            stack.pop()
+        elif token == FDT_PROP:
+            size, name_off = struct.unpack_from(">II", blob, pos)
+            pos += 8
+            end = blob.index(b"\0", off_strings + name_off)
+            stack[-1][1][blob[off_strings + name_off:end].decode()] = blob[pos:pos + size]
+            pos = (pos + size + 3) & ~3
+        elif token == FDT_NOP:
+            continue
+        elif token == FDT_END:
+            return
+        else:
+            raise ValueError(f"bad FDT token {token:#x}")
+
+
+def stage_name(stage_id):
+    return STAGE_NAMES[stage_id] if 0 <= stage_id < len(STAGE_NAMES) else "user"
+
+
+def record_from_props(props):
+    name = props.get("name", b"").rstrip(b"\0").decode("utf-8", "replace")
+    stage_id = struct.unpack(">I", props["id"])[0] if "id" in props else len(STAGE_NAMES) - 1
+    return struct.unpack(">I", props["mark"])[0], stage_name(stage_id), name
+
+
+def read_dtb(path):
+    with open(path, "rb") as file:
+        blob = file.read()
+
+    records = {}
+    for node, props in fdt_nodes(blob):
+        parts = node.split("/")
+        if len(parts) == 3 and parts[1] == "bootstage" and "mark" in props:
+            records[int(parts[2])] = record_from_props(props)
+    return [records[i] for i in sorted(records)]
+
+
+def read_dir(path):
+    records = {}
+    for entry in os.listdir(path):
+        node = os.path.join(path, entry)
+        if not entry.isdigit() or not os.path.isdir(node):
+            continue
+        props = {}
+        for prop in ("name", "id", "mark"):
+            if os.path.exists(os.path.join(node, prop)):
+                with open(os.path.join(node, prop), "rb") as file:
+                    props[prop] = file.read()
+        if "mark" in props:
+            records[int(entry)] = record_from_props(props)
+    return [records[i] for i in sorted(records)]
+
+
+def read_report(path):
+    records = []
+    with open(path, "r", errors="replace") as file:
+        for line in file:
+            match = REPORT_LINE.match(line)
+            if match:
+                records.append((int(match.group(1)), match.group(3), match.group(4)))
+    return records
+
+
+def read_records(path):
+    if os.path.isdir(path):
+        return read_dir(path)
+    with open(path, "rb") as file:
+        magic = file.read(4)
+    if len(magic) == 4 and struct.unpack(">I", magic)[0] == FDT_MAGIC:
+        return read_dtb(path)
+    return read_report(path)
+
+
+# Rows of (start, end, label, stage) boxes, outermost first
+def build_rows(records):
+    segments = []
+    start = 0
+    for mark, stage, name in records:
+        segments.append((start, mark, name, stage))
+        start = mark
+
+    groups = []
+    for segment in segments:
+        if groups and groups[-1][3] == segment[3]:
+            groups[-1] = (groups[-1][0], segment[1], groups[-1][2], segment[3])
+        else:
+            groups.append((segment[0], segment[1], segment[3], segment[3]))
+
+    return [[(0, start, "boot", "user")], groups, segments]
+
+
+def render_text(rows, out, width=60):
+    total = max(rows[0][0][1], 1)
+    for start, end, label, stage in rows[2]:
+        left = start * width // total
+        size = max((end - start) * width // total, 1)
+        out.write("%-20.20s %10u %10u  %s%s\n" % (label, end, end - start, " " * left, "#" * size))
+    out.write("%-20s %10u\n" % ("total", total))
+
+
+def render_svg(rows, out, width=1200, row_height=24):
+    total = max(rows[0][0][1], 1)
+    height = row_height * len(rows) + 40
+    scale = (width - 20) / total
+
+    out.write(f'<svg xmlns="http://www.w3.org/2000/svg" width="{width}" height="{height}" font-family="monospace" font-size="11">\n')
+    out.write(f'<text x="10" y="16">SyterKit boot, {total} us from power on</text>\n')
+    for depth, row in enumerate(rows):
+        y = 24 + depth * row_height
+        for start, end, label, stage in row:
+            x = 10 + start * scale
+            w = max((end - start) * scale, 1)
+            color = STAGE_COLORS.get(stage, STAGE_COLORS["user"])
+            text = html.escape(f"{label} {end - start} us")
+            out.write(f'<g><title>{text}, {start}-{end} us</title>')
+            out.write(f'<rect x="{x:.1f}" y="{y}" width="{w:.1f}" height="{row_height - 2}" fill="{color}" stroke="white"/>')
+            if w > len(text) * 7:
+                out.write(f'<text x="{x + 3:.1f}" y="{y + row_height - 8}">{text}</text>')
+            out.write("</g>\n")
+    out.write("</svg>\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Render the SyterKit boot timeline")
+    parser.add_argument("input", help="DTB (/sys/firmware/fdt), /proc/device-tree/bootstage or a bootstage command capture")
+    parser.add_argument("-o", "--output", help="SVG file to write, stdout if omitted")
+    parser.add_argument("--text", action="store_true", help="print a text chart instead of SVG")
+    args = parser.parse_args()
+
+    records = read_records(args.input)
+    if not records:
+        sys.exit(f"{args.input}: no bootstage marks found")
+
+    rows = build_rows(records)
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.text:
+        render_text(rows, out)
+    else:
+        render_svg(rows, out)
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,209 @@
+import argparse
+import json
+import re
+import struct
+import sys
+from collections import defaultdict
+
+# Convert a function trace of an ENABLE_FUNC_TRACE build into Chrome trace
+# JSON, which chrome://tracing and ui.perfetto.dev open, or a summary.
+#
+#   python3 ftrace.py build/board/xxx/app/app.elf capture.txt -o trace.json
+#   python3 ftrace.py build/board/xxx/app/app.elf ring.bin --summary
+#
+# The input is either a capture of the "ftrace dump" shell command, the last
+# dump in it is used, or a raw copy of the ring buffer, e.g.
+# "xfel read 0x<ring> <size> ring.bin" with the address the dump prints.
+# The layout is described in include/ftrace.h.
+
+FTRACE_MAGIC = 0x43525446
+FTRACE_EXIT = 1
+HEADER_SIZE = 16
+
+DUMP_HEADER = re.compile(r"ftrace: (\d+) events, (\d+) lost, (\d+) MHz")
+DUMP_LINE = re.compile(r"^\s*([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})\s*$")
+
+SHT_SYMTAB = 2
+STT_NOTYPE = 0
+STT_FUNC = 2
+
+
+# Function symbols of a little endian ELF32/ELF64 file, by address
+def read_symbols(elf_path):
+    with open(elf_path, "rb") as file:
+        elf = file.read()
+
+    if elf[:4] != b"\x7fELF" or elf[5] != 1:
+        raise ValueError(f"{elf_path}: not a little endian ELF file")
+
+    is64 = elf[4] == 2
+    if is64:
+        shoff, = struct.unpack_from("<Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x3A)
+        section_format = "<IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from("<I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+        section_format = "<IIIIIIIIII"
+
+    sections = [struct.unpack_from(section_format, elf, shoff + i * shentsize) for i in range(shnum)]
+
+    symbols = {}
+    for _, sh_type, _, _, offset, size, link, _, _, entsize in sections:
+        if sh_type != SHT_SYMTAB:
+            continue
+        strtab = sections[link][4]
+        for pos in range(offset, offset + size, entsize):
+            if is64:
+                name, info, _, shndx, value, _ = struct.unpack_from("<IBBHQQ", elf, pos)
+            else:
+                name, value, _, info, _, shndx = struct.unpack_from("<IIIBBH", elf, pos)
+            if shndx == 0 or (info & 0xF) not in (STT_FUNC, STT_NOTYPE):
+                continue
+            end = elf.index(b"\0", strtab + name)
+            label = elf[strtab + name:end].decode("utf-8", "replace")
+            # ARM mapping symbols and local labels
+            if not label or label.startswith("$") or label.startswith(".L"):
+                continue
+            if (info & 0xF) == STT_NOTYPE and value in symbols:
+                continue
+            # The hooks get Thumb addresses with bit 0 cleared
+            symbols[(value & ~1) & 0xFFFFFFFF] = label
+
+    return symbols
+
+
+# (mhz, [(cycles, fn)]) oldest first
+def read_raw(data):
+    magic, entries, head, mhz = struct.unpack_from("<IIII", data, 0)
+    if magic != FTRACE_MAGIC:
+        return None
+    first = head - entries if head > entries else 0
+    events = []
+    for i in range(first, head):
+        events.append(struct.unpack_from("<II", data, HEADER_SIZE + (i & (entries - 1)) * 8))
+    return mhz, events
+
+
+def read_dump(text):
+    mhz = None
+    events = []
+    for line in text.splitlines():
+        match = DUMP_HEADER.search(line)
+        if match:
+            mhz = int(match.group(3))
+            events = []
+            continue
+        match = DUMP_LINE.match(line)
+        if match and mhz is not None:
+            events.append((int(match.group(1), 16), int(match.group(2), 16)))
+    return (mhz, events) if mhz is not None else None
+
+
+def read_trace(path):
+    with open(path, "rb") as file:
+        data = file.read()
+    trace = read_raw(data) if len(data) >= HEADER_SIZE else None
+    if trace is None:
+        trace = read_dump(data.decode("utf-8", "replace"))
+    return trace
+
+
+# Pair up entries and exits: [(start, end, self, depth, fn)], times in cycles
+def build_calls(events):
+    calls = []
+    stack = []
+    now = 0
+    last = None
+
+    def close():
+        entry, start, child = stack.pop()
+        calls.append((start, now, now - start - child, len(stack), entry))
+        if stack:
+            stack[-1][2] += now - start
+        return entry
+
+    for cycles, fn in events:
+        # 32-bit counter, assume less than one wrap between events
+        if last is not None:
+            now += (cycles - last) & 0xFFFFFFFF
+        last = cycles
+        addr = fn & ~FTRACE_EXIT
+        if not fn & FTRACE_EXIT:
+            stack.append([addr, now, 0])
+            continue
+        # Exits of calls entered before the oldest event kept are dropped
+        if not any(entry == addr for entry, _, _ in stack):
+            continue
+        while close() != addr:
+            pass
+    # Calls still running at the end of the trace
+    while stack:
+        close()
+    return calls
+
+
+def write_json(calls, names, mhz, out):
+    trace = []
+    for start, end, _, _, fn in sorted(calls):
+        trace.append({
+            "name": names(fn),
+            "ph": "X",
+            "ts": start / mhz,
+            "dur": (end - start) / mhz,
+            "pid": 1,
+            "tid": 1,
+        })
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, out)
+    out.write("\n")
+
+
+def write_summary(calls, names, mhz, out):
+    stats = defaultdict(lambda: [0, 0, 0, 0])
+    for start, end, self_time, _, fn in calls:
+        entry = stats[fn]
+        entry[0] += 1
+        entry[1] += end - start
+        entry[2] += self_time
+        entry[3] = max(entry[3], end - start)
+
+    out.write(f"{'calls':>8} {'total us':>12} {'self us':>12} {'max us':>12}  function\n")
+    for fn, (count, total, self_time, longest) in sorted(stats.items(), key=lambda item: -item[1][1]):
+        out.write(f"{count:8d} {total / mhz:12.1f} {self_time / mhz:12.1f} {longest / mhz:12.1f}  {names(fn)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a SyterKit function trace to Chrome trace JSON")
+    parser.add_argument("elf", help="the app ELF the trace was taken with")
+    parser.add_argument("input", help="capture of \"ftrace dump\" or a raw copy of the ring")
+    parser.add_argument("-o", "--output", help="JSON file to write, stdout if omitted")
+    parser.add_argument("--summary", action="store_true", help="print calls, total, self and max time per function instead")
+    parser.add_argument("--mhz", type=int, help="cycle counter rate, if the trace does not have it")
+    args = parser.parse_args()
+
+    trace = read_trace(args.input)
+    if trace is None:
+        sys.exit(f"{args.input}: no function trace found")
+
+    mhz, events = trace
+    mhz = args.mhz or mhz
+    if not mhz:
+        sys.exit(f"{args.input}: cycle counter rate unknown, pass --mhz")
+
+    symbols = read_symbols(args.elf)
+
+    def names(addr):
+        return symbols.get(addr, f"0x{addr:08x}")
+
+    calls = build_calls(events)
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.summary:
+        write_summary(calls, names, mhz, out)
+    else:
+        write_json(calls, names, mhz, out)
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
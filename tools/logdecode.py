@@ -0,0 +1,213 @@
+import argparse
+import re
+import struct
+import sys
+
+# Decode the binary log of an ENABLE_BINARY_LOG build back into printk() text.
+#
+#   python3 logdecode.py build/board/xxx/app/app.elf < capture.bin
+#   python3 logdecode.py build/board/xxx/app/app.elf capture.bin
+#
+# The record layout is described in include/log_binary.h. Everything that is
+# not a valid record, like the shell or printk(LOG_LEVEL_MUTE, ...), is passed
+# through unchanged.
+
+LOG_BINARY_SYNC = 0xA5
+LOG_BINARY_HEAD_SIZE = 14
+LOG_ARG_BITS = 3
+LOG_ARG_MAX = 8
+LOG_ARG_LEVEL_SHIFT = 28
+
+LOG_ARG_W32 = 1
+LOG_ARG_W64 = 2
+LOG_ARG_STR = 3
+LOG_ARG_DOUBLE = 4
+
+LEVEL_NAMES = {1: "E", 2: "W", 3: "I", 4: "D", 5: "T", 6: "B"}
+LEVEL_COLORS = {1: "31", 2: "33", 3: "36", 4: "32", 5: "30", 6: "38;5;214"}
+
+FORMAT_SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXcspfeEgG%])")
+
+
+# Read the .logfmt section out of a little endian ELF32/ELF64 file
+def read_logfmt(elf_path):
+    with open(elf_path, "rb") as file:
+        elf = file.read()
+
+    if elf[:4] != b"\x7fELF" or elf[5] != 1:
+        raise ValueError(f"{elf_path}: not a little endian ELF file")
+
+    is64 = elf[4] == 2
+    if is64:
+        shoff, = struct.unpack_from("<Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x3A)
+        section_format = "<IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from("<I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+        section_format = "<IIIIIIIIII"
+
+    sections = [struct.unpack_from(section_format, elf, shoff + i * shentsize) for i in range(shnum)]
+    strtab_offset = sections[shstrndx][4]
+
+    for name, _, _, addr, offset, size, *_ in sections:
+        end = elf.index(b"\0", strtab_offset + name)
+        if elf[strtab_offset + name:end] == b".logfmt":
+            return addr, elf[offset:offset + size], is64
+
+    raise ValueError(f"{elf_path}: no .logfmt section, was it built with ENABLE_BINARY_LOG?")
+
+
+# Format one argument like xformat does for the given conversion
+def format_arg(flags, width, precision, length, conv, value, long_bits):
+    bits = {"hh": 8, "h": 16, "l": long_bits, "ll": 64, "j": 64, "z": long_bits, "t": long_bits}.get(length, 32)
+
+    if conv == "p":
+        bits, conv, flags = long_bits, "x", flags + "#"
+
+    if conv in "di":
+        value &= (1 << bits) - 1
+        if value >> (bits - 1):
+            value -= 1 << bits
+        conv = "d"
+    elif conv in "ouxX":
+        value &= (1 << bits) - 1
+    elif conv == "c":
+        value = chr(value & 0xFF)
+
+    spec = "%" + flags
+    if width is not None:
+        spec += str(width)
+    if precision is not None:
+        spec += "." + str(precision)
+    return (spec + conv) % value
+
+
+# Render a format string with the decoded arguments
+def render(fmt, args, long_bits):
+    out = []
+    pos = 0
+    args = list(args)
+
+    for match in FORMAT_SPEC.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, width, precision, length, conv = match.groups()
+
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = args.pop(0) if args else 0
+        if precision == "*":
+            precision = args.pop(0) if args else 0
+        if not args:
+            out.append("<?>")
+            continue
+
+        value = args.pop(0)
+        try:
+            out.append(format_arg(flags, width, precision, length, conv, value, long_bits))
+        except (TypeError, ValueError):
+            out.append(str(value))
+
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, base, strings, is64, color):
+        self.base = base
+        self.strings = strings
+        self.long_bits = 64 if is64 else 32
+        self.color = color
+
+    def format_string(self, fmt_id):
+        offset = fmt_id - self.base
+        if offset < 0 or offset >= len(self.strings):
+            return None
+        end = self.strings.find(b"\0", offset)
+        return self.strings[offset:end].decode("utf-8", "replace")
+
+    # Try to decode a record at data[0:], return (text, length) or None
+    def record(self, data):
+        if len(data) < LOG_BINARY_HEAD_SIZE:
+            return None
+
+        length = data[1]
+        fmt_id, timestamp, types = struct.unpack_from("<III", data, 2)
+        level = types >> LOG_ARG_LEVEL_SHIFT
+        fmt = self.format_string(fmt_id)
+        if level not in LEVEL_NAMES or fmt is None or len(data) < LOG_BINARY_HEAD_SIZE + length:
+            return None
+
+        payload = data[LOG_BINARY_HEAD_SIZE:LOG_BINARY_HEAD_SIZE + length]
+        args = []
+        pos = 0
+        for i in range(LOG_ARG_MAX):
+            kind = (types >> (LOG_ARG_BITS * i)) & ((1 << LOG_ARG_BITS) - 1)
+            if kind == 0 or pos >= len(payload):
+                break
+            if kind == LOG_ARG_W32:
+                args.append(struct.unpack_from("<I", payload, pos)[0])
+                pos += 4
+            elif kind == LOG_ARG_W64:
+                args.append(struct.unpack_from("<Q", payload, pos)[0])
+                pos += 8
+            elif kind == LOG_ARG_DOUBLE:
+                args.append(struct.unpack_from("<d", payload, pos)[0])
+                pos += 8
+            elif kind == LOG_ARG_STR:
+                size = payload[pos]
+                args.append(payload[pos + 1:pos + 1 + size].decode("utf-8", "replace"))
+                pos += 1 + size
+            else:
+                return None
+
+        if pos != len(payload):
+            return None
+
+        name = LEVEL_NAMES[level]
+        if self.color:
+            name = f"\033[{LEVEL_COLORS[level]}m{name}\033[37m"
+        prefix = "[%5u.%06u][%s] " % (timestamp // 1000000, timestamp % 1000000, name)
+        return prefix + render(fmt, args, self.long_bits), LOG_BINARY_HEAD_SIZE + length
+
+    def decode(self, data, out):
+        pos = 0
+        text_start = 0
+        while True:
+            pos = data.find(bytes([LOG_BINARY_SYNC]), pos)
+            if pos < 0:
+                break
+            result = self.record(data[pos:])
+            if result is None:
+                pos += 1
+                continue
+            out.write(data[text_start:pos].decode("utf-8", "replace"))
+            out.write(result[0])
+            pos += result[1]
+            text_start = pos
+        out.write(data[text_start:].decode("utf-8", "replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode an ENABLE_BINARY_LOG console capture")
+    parser.add_argument("elf", help="ELF file of the running image")
+    parser.add_argument("capture", nargs="?", help="raw console capture, stdin if omitted")
+    parser.add_argument("--color", action="store_true", help="color the level like printk() does")
+    args = parser.parse_args()
+
+    base, strings, is64 = read_logfmt(args.elf)
+
+    if args.capture:
+        with open(args.capture, "rb") as file:
+            data = file.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    Decoder(base, strings, is64, args.color).decode(data, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
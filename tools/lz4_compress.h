@@ -0,0 +1,99 @@
+#ifndef __LZ4_COMPRESS_H__
+#define __LZ4_COMPRESS_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5 /* the last 5 bytes are always literals */
+#define LZ4_MF_LIMIT 12		/* a match can not start within the last 12 bytes */
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 16
+
+static uint32_t lz4_read32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t lz4_hash(uint32_t v) {
+	return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t *lz4_put_length(uint8_t *op, uint32_t len) {
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = len;
+	return op;
+}
+
+static uint8_t *lz4_put_sequence(uint8_t *op, const uint8_t *lit, uint32_t lit_len, uint32_t offset, uint32_t match_len) {
+	uint8_t *token = op++;
+
+	*token = (lit_len >= 15 ? 15 : lit_len) << 4;
+	if (lit_len >= 15)
+		op = lz4_put_length(op, lit_len - 15);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+
+	/* Last sequence, literals only */
+	if (match_len == 0)
+		return op;
+
+	*op++ = offset & 0xff;
+	*op++ = offset >> 8;
+	match_len -= LZ4_MIN_MATCH;
+	*token |= match_len >= 15 ? 15 : match_len;
+	if (match_len >= 15)
+		op = lz4_put_length(op, match_len - 15);
+
+	return op;
+}
+
+/*
+ * Greedy LZ4 block compressor. It follows the end of block rules of the
+ * reference implementation so the stream can be decompressed in place with
+ * LZ4_DECOMPRESS_INPLACE_MARGIN bytes of slack.
+ * dst must hold at least len + len / 255 + 16 bytes.
+ */
+static uint32_t lz4_compress(const uint8_t *src, uint32_t len, uint8_t *dst) {
+	uint32_t *table;
+	uint32_t ip = 0, anchor = 0, ref, seq, match_len;
+	uint8_t *op = dst;
+
+	table = calloc(1 << LZ4_HASH_BITS, sizeof(uint32_t));
+	if (table == NULL)
+		return 0;
+
+	if (len > LZ4_MF_LIMIT) {
+		while (ip < len - LZ4_MF_LIMIT) {
+			seq = lz4_read32(src + ip);
+			ref = table[lz4_hash(seq)];
+			table[lz4_hash(seq)] = ip + 1;
+
+			if (ref == 0 || ip - (ref - 1) > LZ4_MAX_OFFSET || lz4_read32(src + ref - 1) != seq) {
+				ip++;
+				continue;
+			}
+			ref--;
+
+			match_len = LZ4_MIN_MATCH;
+			while (ip + match_len < len - LZ4_LAST_LITERALS && src[ref + match_len] == src[ip + match_len])
+				match_len++;
+
+			op = lz4_put_sequence(op, src + anchor, ip - anchor, ip - ref, match_len);
+			ip += match_len;
+			anchor = ip;
+		}
+	}
+
+	op = lz4_put_sequence(op, src + anchor, len - anchor, 0, 0);
+
+	free(table);
+	return op - dst;
+}
+
+#endif// __LZ4_COMPRESS_H__
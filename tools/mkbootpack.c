@@ -0,0 +1,262 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz4_compress.h"
+
+#define __ALIGN_MASK(x, mask) (((x) + (mask)) & ~(mask))
+#define ALIGN(x, a) __ALIGN_MASK((x), (typeof(x)) (a) -1)
+
+/* Keep in sync with include/image/bootpack.h */
+#define BOOTPACK_MAGIC "SKBPACK"
+#define BOOTPACK_VERSION 1
+#define BOOTPACK_NAME_LEN 16
+#define BOOTPACK_MAX_ENTRIES 20
+
+#define BOOTPACK_FLAG_LZ4 (1 << 0)
+#define BOOTPACK_FLAG_CRC32 (1 << 1)
+
+struct bootpack_entry_t {
+	char name[BOOTPACK_NAME_LEN];
+	uint32_t offset;
+	uint32_t size;
+	uint32_t raw_size;
+	uint32_t load_addr;
+	uint32_t flags;
+	uint32_t crc32;
+	uint32_t reserved[2];
+};
+
+struct bootpack_head_t {
+	uint8_t magic[8];
+	uint32_t version;
+	uint32_t head_size;
+	uint32_t total_size;
+	uint32_t align;
+	uint32_t entry_count;
+	uint32_t head_crc32;
+};
+
+struct bootpack_t {
+	struct bootpack_head_t head;
+	struct bootpack_entry_t entry[BOOTPACK_MAX_ENTRIES];
+};
+
+struct payload_t {
+	uint8_t *data;
+	uint32_t len;
+};
+
+static struct bootpack_t pack;
+static struct payload_t payload[BOOTPACK_MAX_ENTRIES];
+
+static uint32_t crc32(uint32_t crc, const uint8_t *p, uint32_t len) {
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc & 1) ? (0xedb88320 ^ (crc >> 1)) : (crc >> 1);
+	}
+	return ~crc;
+}
+
+static uint8_t *read_file(const char *name, uint32_t *len) {
+	FILE *fp;
+	uint8_t *buffer;
+
+	fp = fopen(name, "rb");
+	if (fp == NULL) {
+		printf("Open %s error\n", name);
+		return NULL;
+	}
+	fseek(fp, 0L, SEEK_END);
+	*len = ftell(fp);
+	fseek(fp, 0L, SEEK_SET);
+
+	buffer = malloc(*len + 1);
+	if (buffer == NULL || fread(buffer, 1, *len, fp) != *len) {
+		printf("Can't read %s\n", name);
+		free(buffer);
+		fclose(fp);
+		return NULL;
+	}
+
+	fclose(fp);
+	return buffer;
+}
+
+/* <name>:<load addr>:<file>[:lz4][:crc32] */
+static int add_entry(char *spec) {
+	struct bootpack_entry_t *e;
+	struct payload_t *p;
+	char *name, *addr, *file, *opt;
+	uint8_t *raw;
+	uint32_t raw_len;
+
+	if (pack.head.entry_count >= BOOTPACK_MAX_ENTRIES) {
+		printf("Too many payloads, max %d\n", BOOTPACK_MAX_ENTRIES);
+		return -1;
+	}
+
+	name = strtok(spec, ":");
+	addr = strtok(NULL, ":");
+	file = strtok(NULL, ":");
+	if (name == NULL || addr == NULL || file == NULL || strlen(name) >= BOOTPACK_NAME_LEN) {
+		printf("Bad payload description, expect <name>:<load addr>:<file>[:lz4][:crc32]\n");
+		return -1;
+	}
+
+	e = &pack.entry[pack.head.entry_count];
+	p = &payload[pack.head.entry_count];
+
+	strcpy(e->name, name);
+	e->load_addr = strtoul(addr, NULL, 0);
+	while ((opt = strtok(NULL, ":")) != NULL) {
+		if (strcmp(opt, "lz4") == 0) {
+			e->flags |= BOOTPACK_FLAG_LZ4;
+		} else if (strcmp(opt, "crc32") == 0) {
+			e->flags |= BOOTPACK_FLAG_CRC32;
+		} else {
+			printf("Unknown option %s for %s\n", opt, name);
+			return -1;
+		}
+	}
+
+	raw = read_file(file, &raw_len);
+	if (raw == NULL)
+		return -1;
+
+	e->raw_size = raw_len;
+	if (e->flags & BOOTPACK_FLAG_CRC32)
+		e->crc32 = crc32(0, raw, raw_len);
+
+	if ((e->flags & BOOTPACK_FLAG_LZ4) && raw_len > 0) {
+		p->data = malloc(raw_len + raw_len / 255 + 16);
+		if (p->data == NULL)
+			return -1;
+		p->len = lz4_compress(raw, raw_len, p->data);
+		free(raw);
+		if (p->len == 0) {
+			printf("Compress %s error\n", file);
+			return -1;
+		}
+	} else {
+		e->flags &= ~BOOTPACK_FLAG_LZ4;
+		p->data = raw;
+		p->len = raw_len;
+	}
+	e->size = p->len;
+
+	printf("  %-16s 0x%08x %8u bytes", e->name, e->load_addr, e->raw_size);
+	if (e->flags & BOOTPACK_FLAG_LZ4)
+		printf(" -> %u bytes lz4", e->size);
+	if (e->flags & BOOTPACK_FLAG_CRC32)
+		printf(" crc32 0x%08x", e->crc32);
+	printf("\n");
+
+	pack.head.entry_count++;
+	return 0;
+}
+
+static int add_list(const char *name) {
+	FILE *fp;
+	char line[512];
+	char *p, *end;
+
+	fp = fopen(name, "r");
+	if (fp == NULL) {
+		printf("Open %s error\n", name);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		p = line + strspn(line, " \t");
+		end = p + strcspn(p, "#\r\n");
+		while (end > p && (end[-1] == ' ' || end[-1] == '\t'))
+			end--;
+		*end = '\0';
+		if (*p == '\0')
+			continue;
+		if (add_entry(p)) {
+			fclose(fp);
+			return -1;
+		}
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+static void usage(void) {
+	printf("Usage: mkbootpack [-a align] [-f list] -o <output> [<name>:<load addr>:<file>[:lz4][:crc32] ...]\n");
+	printf("       -a align   payload alignment, default 512\n");
+	printf("       -f list    read payload descriptions from a file, one per line\n");
+}
+
+int main(int argc, char *argv[]) {
+	const char *output = NULL;
+	uint32_t align = 512, offset, i;
+	uint8_t *buffer;
+	FILE *fp;
+	int n;
+
+	memcpy(pack.head.magic, BOOTPACK_MAGIC, sizeof(BOOTPACK_MAGIC));
+	pack.head.version = BOOTPACK_VERSION;
+
+	for (n = 1; n < argc; n++) {
+		if (strcmp(argv[n], "-a") == 0 && n + 1 < argc) {
+			align = strtoul(argv[++n], NULL, 0);
+		} else if (strcmp(argv[n], "-o") == 0 && n + 1 < argc) {
+			output = argv[++n];
+		} else if (strcmp(argv[n], "-f") == 0 && n + 1 < argc) {
+			if (add_list(argv[++n]))
+				return -1;
+		} else if (argv[n][0] == '-') {
+			usage();
+			return -1;
+		} else if (add_entry(argv[n])) {
+			return -1;
+		}
+	}
+
+	if (output == NULL || pack.head.entry_count == 0 || align < 4 || (align & (align - 1))) {
+		usage();
+		return -1;
+	}
+
+	/* The loader reads the full TOC area in one go, payloads start behind it */
+	pack.head.align = align;
+	pack.head.head_size = ALIGN((uint32_t) sizeof(pack), align);
+
+	offset = pack.head.head_size;
+	for (i = 0; i < pack.head.entry_count; i++) {
+		pack.entry[i].offset = offset;
+		offset = ALIGN(offset + pack.entry[i].size, align);
+	}
+	pack.head.total_size = offset;
+	pack.head.head_crc32 = crc32(0, (uint8_t *) &pack, sizeof(pack.head) + pack.head.entry_count * sizeof(pack.entry[0]));
+
+	buffer = calloc(1, pack.head.total_size);
+	if (buffer == NULL)
+		return -1;
+	memcpy(buffer, &pack, sizeof(pack));
+	for (i = 0; i < pack.head.entry_count; i++)
+		memcpy(buffer + pack.entry[i].offset, payload[i].data, payload[i].len);
+
+	fp = fopen(output, "wb");
+	if (fp == NULL || fwrite(buffer, 1, pack.head.total_size, fp) != pack.head.total_size) {
+		printf("Write %s error\n", output);
+		free(buffer);
+		if (fp)
+			fclose(fp);
+		return -1;
+	}
+
+	fclose(fp);
+	free(buffer);
+	printf("Boot pack %s: %u payloads, %u bytes\n", output, pack.head.entry_count, pack.head.total_size);
+	return 0;
+}
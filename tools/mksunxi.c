@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "lz4_compress.h"
+
 #define __ALIGN_MASK(x, mask) (((x) + (mask)) & ~(mask))
 #define ALIGN(x, a) __ALIGN_MASK((x), (typeof(x)) (a) -1)
 
@@ -20,27 +22,188 @@ struct boot_head_t {
 	uint32_t string_pool[13];
 };
 
-int main(int argc, char *argv[]) {
+/* Keep in sync with lz4_stub_info_t and LZ4_DECOMPRESS_INPLACE_MARGIN in include/lz4.h */
+#define LZ4_STUB_MAGIC "SKLZ4INF"
+#define LZ4_DECOMPRESS_INPLACE_MARGIN(comp_size) (((comp_size) >> 8) + 32)
+
+struct lz4_stub_info_t {
+	uint8_t magic[8];
+	uint32_t stub_size;
+	uint32_t comp_size;
+	uint32_t raw_size;
+	uint32_t reserved;
+};
+
+static void *read_file(const char *name, int *len) {
+	FILE *fp;
+	char *buffer;
+
+	fp = fopen(name, "rb");
+	if (fp == NULL) {
+		printf("Open %s error\n", name);
+		return NULL;
+	}
+	fseek(fp, 0L, SEEK_END);
+	*len = ftell(fp);
+	fseek(fp, 0L, SEEK_SET);
+
+	buffer = malloc(*len);
+	if (buffer == NULL || fread(buffer, 1, *len, fp) != *len) {
+		printf("Can't read %s\n", name);
+		free(buffer);
+		fclose(fp);
+		return NULL;
+	}
+
+	fclose(fp);
+	return buffer;
+}
+
+static int check_padding(int padding) {
+	printf("padding: %d\n", padding);
+
+	if (padding != 512 && padding != 8192) {
+		printf("padding must be 512 (block devices) or 8192 (flash)\n");
+		return -1;
+	}
+	return 0;
+}
+
+/* Align the length recorded in the head to padding and fix the checksum */
+static int fix_head(char *buffer, int padding) {
+	struct boot_head_t *h = (struct boot_head_t *) buffer;
+	uint32_t *p = (uint32_t *) h;
+	uint32_t sum = 0;
+	int i = 0, l = 0, loop = 0;
+
+	l = (h->length);
+	printf("len: %u\n", l);
+	l = ALIGN(l, padding);
+	h->length = (l);
+	h->checksum = (0x5F0A6C39);
+	loop = l >> 2;
+	for (i = 0, sum = 0; i < loop; i++) sum += (p[i]);
+	h->checksum = (sum);
+
+	return l;
+}
+
+/*
+ * Pack a self-decompressing boot0: the stub first, padded to the size it
+ * reserves for itself, then the LZ4 compressed payload.
+ */
+static int pack_lz4(const char *stub_name, const char *payload_name, int padding) {
 	struct boot_head_t *h;
+	struct lz4_stub_info_t *info = NULL;
+	FILE *fp;
+	char *stub, *payload, *buffer;
+	int stub_len, payload_len, buflen, i, l;
+	uint32_t comp_len;
+
+	if (check_padding(padding))
+		return -1;
+
+	stub = read_file(stub_name, &stub_len);
+	if (stub == NULL)
+		return -1;
+
+	payload = read_file(payload_name, &payload_len);
+	if (payload == NULL || payload_len == 0) {
+		printf("Payload %s is empty\n", payload_name);
+		free(stub);
+		free(payload);
+		return -1;
+	}
+
+	for (i = 0; i + (int) sizeof(*info) <= stub_len; i += 4) {
+		if (memcmp(stub + i, LZ4_STUB_MAGIC, 8) == 0) {
+			info = (struct lz4_stub_info_t *) (stub + i);
+			break;
+		}
+	}
+
+	if (stub_len <= sizeof(struct boot_head_t) || info == NULL || stub_len > info->stub_size) {
+		printf("%s is not a valid decompression stub\n", stub_name);
+		free(stub);
+		free(payload);
+		return -1;
+	}
+
+	buflen = ALIGN((int) (info->stub_size + payload_len + payload_len / 255 + 16), padding);
+	buffer = calloc(1, buflen);
+	if (buffer == NULL) {
+		free(stub);
+		free(payload);
+		return -1;
+	}
+
+	comp_len = lz4_compress((uint8_t *) payload, payload_len, (uint8_t *) buffer + info->stub_size);
+	if (comp_len == 0) {
+		printf("Compress %s error\n", payload_name);
+		free(stub);
+		free(payload);
+		free(buffer);
+		return -1;
+	}
+
+	/*
+	 * The stub moves the stream up to end at the in-place margin behind the
+	 * output. A stream longer than the output plus that margin would have to
+	 * move down over the stub itself.
+	 */
+	if (comp_len > payload_len + LZ4_DECOMPRESS_INPLACE_MARGIN(comp_len)) {
+		printf("Payload %s does not compress, %u bytes from %d, use the uncompressed image\n", payload_name, comp_len, payload_len);
+		free(stub);
+		free(payload);
+		free(buffer);
+		return -1;
+	}
+
+	info->comp_size = comp_len;
+	info->raw_size = payload_len;
+	memcpy(buffer, stub, stub_len);
+
+	h = (struct boot_head_t *) buffer;
+	h->length = info->stub_size + comp_len;
+	l = fix_head(buffer, padding);
+
+	free(stub);
+	free(payload);
+
+	fp = fopen(stub_name, "wb");
+	if (fp == NULL || fwrite(buffer, 1, l, fp) != l) {
+		printf("Write bootloader error\n");
+		free(buffer);
+		if (fp)
+			fclose(fp);
+		return -1;
+	}
+
+	fclose(fp);
+	free(buffer);
+	printf("Payload %d bytes compressed to %u bytes (%d%%), spl size is %d bytes.\n", payload_len, comp_len,
+		   (int) (comp_len * 100ULL / payload_len), l);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
 	FILE *fp;
 	char *buffer;
 	int buflen, filelen;
-	uint32_t *p;
-	uint32_t sum = 0;
-	int i = 0, l = 0, loop = 0, padding = 0;
+	int l = 0, padding = 0;
+
+	if (argc == 5 && strcmp(argv[1], "-z") == 0)
+		return pack_lz4(argv[2], argv[3], atoi(argv[4]));
 
 	if (argc != 3) {
 		printf("Usage: mksunxi <bootloader> <padding>\n");
+		printf("       mksunxi -z <stub> <payload> <padding>\n");
 		return -1;
 	}
 
 	padding = atoi(argv[2]);
-	printf("padding: %d\n", padding);
-
-	if (padding != 512 && padding != 8192) {
-		printf("padding must be 512 (block devices) or 8192 (flash)\n");
+	if (check_padding(padding))
 		exit(1);
-	}
 
 	fp = fopen(argv[1], "r+b");
 	if (fp == NULL) {
@@ -67,16 +230,7 @@ int main(int argc, char *argv[]) {
 		return -1;
 	}
 
-	h = (struct boot_head_t *) buffer;
-	p = (uint32_t *) h;
-	l = (h->length);
-	printf("len: %u\n", l);
-	l = ALIGN(l, padding);
-	h->length = (l);
-	h->checksum = (0x5F0A6C39);
-	loop = l >> 2;
-	for (i = 0, sum = 0; i < loop; i++) sum += (p[i]);
-	h->checksum = (sum);
+	l = fix_head(buffer, padding);
 
 	fseek(fp, 0L, SEEK_SET);
 	if (fwrite(buffer, 1, buflen, fp) != buflen) {
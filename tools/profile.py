@@ -0,0 +1,164 @@
+import argparse
+import bisect
+import re
+import struct
+import sys
+from collections import Counter, defaultdict
+
+# Resolve a "profile dump" of the sampling profiler (ENABLE_PROFILE) against
+# the app ELF and print where the time went.
+#
+#   python3 profile.py build/board/xxx/app/app.elf capture.txt
+#   python3 profile.py build/board/xxx/app/app.elf < /sys/fs/pstore/console-ramoops-0
+#
+# The capture may hold anything else around the dump, the last dump in it is
+# used. Samples are counted per function the PC was in (self), --callers adds
+# the functions the return address register pointed into, which is only
+# reliable for leaf functions, and --pcs lists the hottest addresses.
+
+DUMP_HEADER = re.compile(r"profile: (\d+) samples at (\d+) Hz, (\d+) entries, (\d+) dropped")
+DUMP_LINE = re.compile(r"^\s*0x([0-9a-fA-F]+) 0x([0-9a-fA-F]+) (\d+)\s*$")
+
+SHT_SYMTAB = 2
+STT_NOTYPE = 0
+STT_FUNC = 2
+
+
+# Function symbols of a little endian ELF32/ELF64 file, sorted by address
+def read_symbols(elf_path):
+    with open(elf_path, "rb") as file:
+        elf = file.read()
+
+    if elf[:4] != b"\x7fELF" or elf[5] != 1:
+        raise ValueError(f"{elf_path}: not a little endian ELF file")
+
+    is64 = elf[4] == 2
+    if is64:
+        shoff, = struct.unpack_from("<Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x3A)
+        section_format = "<IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from("<I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+        section_format = "<IIIIIIIIII"
+
+    sections = [struct.unpack_from(section_format, elf, shoff + i * shentsize) for i in range(shnum)]
+
+    symbols = {}
+    for _, sh_type, _, _, offset, size, link, _, _, entsize in sections:
+        if sh_type != SHT_SYMTAB:
+            continue
+        strtab = sections[link][4]
+        for pos in range(offset, offset + size, entsize):
+            if is64:
+                name, info, _, shndx, value, sym_size = struct.unpack_from("<IBBHQQ", elf, pos)
+            else:
+                name, value, sym_size, info, _, shndx = struct.unpack_from("<IIIBBH", elf, pos)
+            if shndx == 0 or (info & 0xF) not in (STT_FUNC, STT_NOTYPE):
+                continue
+            end = elf.index(b"\0", strtab + name)
+            label = elf[strtab + name:end].decode("utf-8", "replace")
+            # ARM mapping symbols and local labels
+            if not label or label.startswith("$") or label.startswith(".L"):
+                continue
+            if (info & 0xF) == STT_NOTYPE and sym_size == 0 and value in symbols:
+                continue
+            # Thumb functions have bit 0 set
+            symbols[value & ~1] = (label, sym_size)
+
+    addresses = sorted(symbols)
+    return addresses, [symbols[addr] for addr in addresses]
+
+
+class Symbolizer:
+    def __init__(self, elf_path):
+        self.addresses, self.symbols = read_symbols(elf_path)
+
+    # (function, offset), function is None outside of any symbol
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addresses, addr) - 1
+        if i < 0:
+            return None, addr
+        name, size = self.symbols[i]
+        offset = addr - self.addresses[i]
+        if size and offset >= size:
+            return None, addr
+        return name, offset
+
+    def function(self, addr):
+        name, _ = self.lookup(addr)
+        return name if name else f"0x{addr:08x}"
+
+    def location(self, addr):
+        name, offset = self.lookup(addr)
+        return f"{name}+0x{offset:x}" if name else f"0x{addr:08x}"
+
+
+def read_dump(stream):
+    header = None
+    entries = []
+    for line in stream:
+        match = DUMP_HEADER.search(line)
+        if match:
+            header = tuple(int(value) for value in match.groups())
+            entries = []
+            continue
+        match = DUMP_LINE.match(line)
+        if match and header:
+            entries.append((int(match.group(1), 16), int(match.group(2), 16), int(match.group(3))))
+    return header, entries
+
+
+def percent(count, total):
+    return 100.0 * count / total if total else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Print the top functions of a SyterKit profile dump")
+    parser.add_argument("elf", help="the app ELF the dump was taken with")
+    parser.add_argument("capture", nargs="?", help="UART capture or pstore console with the dump, stdin if omitted")
+    parser.add_argument("-n", "--top", type=int, default=20, help="number of functions shown (default 20)")
+    parser.add_argument("--callers", action="store_true", help="show the top callers of each function")
+    parser.add_argument("--pcs", action="store_true", help="also list the hottest addresses")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, "r", errors="replace") as file:
+            header, entries = read_dump(file)
+    else:
+        header, entries = read_dump(sys.stdin)
+
+    if not header:
+        sys.exit("no profile dump found")
+
+    samples, hz, _, dropped = header
+    total = sum(count for _, _, count in entries)
+    symbolizer = Symbolizer(args.elf)
+
+    functions = Counter()
+    callers = defaultdict(Counter)
+    pcs = Counter()
+    for pc, ra, count in entries:
+        function = symbolizer.function(pc)
+        functions[function] += count
+        callers[function][symbolizer.function(ra)] += count
+        pcs[pc] += count
+
+    print(f"{samples} samples at {hz} Hz, {samples / hz if hz else 0:.2f} s, {dropped} dropped")
+    print()
+    print(f"{'samples':>8} {'%':>6}  function")
+    for function, count in functions.most_common(args.top):
+        print(f"{count:8d} {percent(count, total):5.1f}%  {function}")
+        if args.callers:
+            for caller, caller_count in callers[function].most_common(3):
+                print(f"{'':16}  {percent(caller_count, count):5.1f}%  <- {caller}")
+
+    if args.pcs:
+        print()
+        print(f"{'samples':>8} {'%':>6}  address")
+        for pc, count in pcs.most_common(args.top):
+            print(f"{count:8d} {percent(count, total):5.1f}%  0x{pc:08x} {symbolizer.location(pc)}")
+
+
+if __name__ == "__main__":
+    main()
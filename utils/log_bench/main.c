@@ -0,0 +1,207 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <types.h>
+
+#include <config.h>
+#include <log.h>
+#include <timer.h>
+
+#include <common.h>
+#include <string.h>
+#include <xformat.h>
+
+#include "sys-clk.h"
+
+#if defined(__arm__)
+#include <jmp.h>
+#endif
+
+extern sunxi_serial_t uart_dbg;
+
+/* xformat.c as it was before, built by xformat_ref.c */
+unsigned xvformat_ref(void (*outchar)(void *arg, char), void *arg, const char *fmt, va_list args);
+
+#define BENCH_LOOPS 1000
+#define BENCH_SINK_SIZE 256
+
+/*
+ * Output goes to RAM so that only the cost of printk() itself is measured,
+ * at 115200 baud the UART would hide everything else.
+ */
+static char sink[BENCH_SINK_SIZE];
+static unsigned sink_len;
+
+static void sink_putchar(void *arg, char c) {
+	if (c == '\n')
+		sink[sink_len++ & (BENCH_SINK_SIZE - 1)] = '\r';
+	sink[sink_len++ & (BENCH_SINK_SIZE - 1)] = c;
+}
+
+static void sink_copy(const char *s, unsigned len) {
+	if (sink_len + len > BENCH_SINK_SIZE)
+		sink_len = 0;
+	memcpy(sink + sink_len, s, len);
+	sink_len += len;
+}
+
+/* Same split into runs as uart_log_write() */
+static void sink_write(void *arg, const char *s, unsigned len) {
+	unsigned start = 0, i;
+
+	for (i = 0; i < len; i++) {
+		if (s[i] == '\n') {
+			sink_copy(s + start, i - start);
+			sink_copy("\r", 1);
+			start = i;
+		}
+	}
+	sink_copy(s + start, len - start);
+}
+
+static void ref_printf(const char *fmt, ...) {
+	va_list args;
+
+	va_start(args, fmt);
+	xvformat_ref(sink_putchar, NULL, fmt, args);
+	va_end(args);
+}
+
+static void span_printf(const char *fmt, ...) {
+	va_list args;
+
+	va_start(args, fmt);
+	xvformat_span(sink_write, NULL, fmt, args);
+	va_end(args);
+}
+
+/* CPU clocks: the PMU cycle counter on arm32, mcycle on the C906 and E907 */
+static void cycles_init(void) {
+#if defined(__arm__)
+	uint32_t pmcr;
+
+	asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+	asm volatile("mcr p15, 0, %0, c9, c12, 0" : : "r"(pmcr | (1 << 2) | (1 << 0)));
+	asm volatile("mcr p15, 0, %0, c9, c12, 1" : : "r"(1U << 31));
+#endif
+}
+
+static inline uint32_t cycles(void) {
+#if defined(__arm__)
+	uint32_t val;
+
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(val));
+	return val;
+#elif defined(__riscv)
+	unsigned long val;
+
+	asm volatile("csrr %0, mcycle" : "=r"(val));
+	return (uint32_t) val;
+#else
+	return (uint32_t) get_arch_counter();
+#endif
+}
+
+/*
+ * What printk() did per line before: division and modulo, one call per char,
+ * and the 64-bit division time_us() used on 32-bit cores. The C906 divides
+ * in one instruction, so there its time_us() did not change.
+ */
+static void line_before(int n) {
+	uint32_t now_timestamp = (uint32_t) (get_arch_counter() / (uint64_t) 24) - get_init_timestamp();
+	uint32_t seconds = now_timestamp / (1000 * 1000);
+	uint32_t milliseconds = now_timestamp % (1000 * 1000);
+
+	ref_printf("[%5lu.%06lu][\033[36mI\033[37m] ", seconds, milliseconds);
+	ref_printf("DRAM: %s clk %uMHz size %uMB, block %d of %d at 0x%08x\n", "DDR3", 792, 512, n, BENCH_LOOPS, 0x40000000 + n);
+}
+
+/* And now: 16-bit step division on 32-bit cores, multiply-shift, spans */
+static void line_after(int n) {
+	uint32_t now_timestamp = time_us() - get_init_timestamp();
+	uint32_t seconds = (uint32_t) (((uint64_t) now_timestamp * 1125899907U) >> 50);
+	uint32_t milliseconds = now_timestamp - seconds * (1000 * 1000);
+
+	span_printf("[%5lu.%06lu][\033[36mI\033[37m] ", seconds, milliseconds);
+	span_printf("DRAM: %s clk %uMHz size %uMB, block %d of %d at 0x%08x\n", "DDR3", 792, 512, n, BENCH_LOOPS, 0x40000000 + n);
+}
+
+static uint32_t bench_run(void (*line)(int n)) {
+	uint32_t start;
+	int i;
+
+	sink_len = 0;
+	start = cycles();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		line(i);
+
+	return (cycles() - start) / BENCH_LOOPS;
+}
+
+/* Both paths have to produce the same text */
+static int bench_check(void) {
+	char ref[64];
+
+	sink_len = 0;
+	ref_printf("%u %lu %llu %06lu %.8u|", 0, 99UL, 18446744073709551615ULL, 12345UL, 42);
+	memcpy(ref, sink, sink_len);
+	ref[sink_len] = '\0';
+
+	sink_len = 0;
+	span_printf("%u %lu %llu %06lu %.8u|", 0, 99UL, 18446744073709551615ULL, 12345UL, 42);
+	sink[sink_len] = '\0';
+
+	if (strcmp(ref, sink) != 0) {
+		printk_error("log bench: '%s' != '%s'\n", sink, ref);
+		return -1;
+	}
+
+	return 0;
+}
+
+int main(void) {
+	uint32_t before, after, start, i;
+	uint64_t sum = 0;
+
+	sunxi_clk_pre_init();
+
+	sunxi_serial_init(&uart_dbg);
+
+	show_banner();
+
+	sunxi_clk_init();
+
+	cycles_init();
+
+	if (bench_check())
+		goto _fel;
+
+	/* Warm the caches */
+	bench_run(line_before);
+	bench_run(line_after);
+
+	before = bench_run(line_before);
+	after = bench_run(line_after);
+	printk_info("log bench: %u cycles per line before, %u after\n", before, after);
+
+	start = cycles();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		sum += get_arch_counter() / (uint64_t) 24;
+	before = (cycles() - start) / BENCH_LOOPS;
+
+	start = cycles();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		sum += time_us();
+	after = (cycles() - start) / BENCH_LOOPS;
+	printk_info("log bench: time_us() %u cycles before, %u after (%u)\n", before, after, (uint32_t) sum & 1);
+
+_fel:
+#if defined(__arm__)
+	jmp_to_fel();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+
+/*
+ * The formatter as printk() used it before the span output and the two digit
+ * decimal conversion, for the "before" numbers of log_bench.
+ */
+
+#define XCFG_FORMAT_FAST_DECIMAL 0
+#define xformat xformat_ref
+#define xvformat xvformat_ref
+#define xvformat_span xvformat_span_ref
+
+#include "../../src/log/xformat.c"